@@ -33,6 +33,8 @@ size_t server_threads_count = dariadb::net::SERVER_IO_THREADS_DEFAULT;
 size_t clients_count = 5;
 bool dont_clean = false;
 bool http_benchmark = false;
+bool http_keep_alive = true;
+size_t server_http_workers = dariadb::net::SERVER_HTTP_WORKERS_DEFAULT;
 IEngine_Ptr engine = nullptr;
 dariadb::net::Server *server_instance = nullptr;
 
@@ -46,6 +48,7 @@ void run_server() {
 
   dariadb::net::Server::Param server_param(server_port, server_http_port,
                                            server_threads_count);
+  server_param.http_workers = server_http_workers;
   server_instance = new dariadb::net::Server(server_param);
   server_instance->set_storage(engine);
 
@@ -85,9 +88,10 @@ void write_http_thread(size_t thread_num) {
   boost::asio::io_service test_service;
   dariadb::Time t = dariadb::MIN_TIME;
 
+  // queries are prepared before, to measure only the server side.
+  std::vector<std::string> queries(SEND_COUNT);
   dariadb::MeasArray ma;
   ma.resize(MEASES_SIZE);
-  dariadb::utils::ElapsedTime et;
   for (size_t i = 0; i < SEND_COUNT; ++i) {
 
     for (size_t j = 0; j < MEASES_SIZE; ++j) {
@@ -118,11 +122,24 @@ void write_http_thread(size_t thread_num) {
     js_query[std::to_string(thread_num)] = ids_value;
 
     js["append_values"] = js_query;
-    std::string query = js.dump();
+    queries[i] = js.dump();
+  }
 
-    auto post_result = net::http::POST(test_service, http_port, query);
-    if (post_result.code != 200) {
-      THROW_EXCEPTION("http result is not ok.");
+  dariadb::utils::ElapsedTime et;
+  if (http_keep_alive) {
+    net::http::session s(test_service, http_port);
+    for (auto &query : queries) {
+      auto post_result = s.POST(query);
+      if (post_result.code != 200) {
+        THROW_EXCEPTION("http result is not ok.");
+      }
+    }
+  } else {
+    for (auto &query : queries) {
+      auto post_result = net::http::POST(test_service, http_port, query);
+      if (post_result.code != 200) {
+        THROW_EXCEPTION("http result is not ok.");
+      }
     }
   }
   auto el = et.elapsed();
@@ -140,12 +157,20 @@ int main(int argc, char **argv) {
   aos("io-threads",
       po::value<size_t>(&server_threads_count)->default_value(server_threads_count),
       "server threads for query processing.");
+  aos("http-workers",
+      po::value<size_t>(&server_http_workers)->default_value(server_http_workers),
+      "server threads for http requests handling.");
   aos("clients-count", po::value<size_t>(&clients_count)->default_value(clients_count),
       "clients count.");
   aos("dont-clean", po::value<bool>(&dont_clean)->default_value(dont_clean),
       "dont clean folder with storage if exists.");
   aos("extern-server", "dont run server.");
   aos("http-benchmark", "benchmark for http query engine.");
+  aos("http-no-keep-alive", "open new connection for each http query.");
+  aos("batch-size", po::value<size_t>(&MEASES_SIZE)->default_value(MEASES_SIZE),
+      "values in one query.");
+  aos("send-count", po::value<size_t>(&SEND_COUNT)->default_value(SEND_COUNT),
+      "queries from one client.");
 
   po::variables_map vm;
   try {
@@ -173,6 +198,10 @@ int main(int argc, char **argv) {
     SEND_COUNT = 100;*/
   }
 
+  if (vm.count("http-no-keep-alive")) {
+    http_keep_alive = false;
+  }
+
   elapsed.resize(clients_count);
   threads.resize(clients_count);
   clients.resize(clients_count);
@@ -193,6 +222,7 @@ int main(int argc, char **argv) {
       clients[i]->connect();
     }
   }
+  auto write_start = std::chrono::steady_clock::now();
   for (size_t i = 0; i < clients_count; ++i) {
     if (http_benchmark) {
       auto t = std::thread{write_http_thread, i};
@@ -213,6 +243,9 @@ int main(int argc, char **argv) {
     }
   }
 
+  std::chrono::duration<double> write_elapsed =
+      std::chrono::steady_clock::now() - write_start;
+
   std::cout << "write end. create binary client for reading" << std::endl;
   dariadb::net::client::Client_Ptr c{new dariadb::net::client::Client(p)};
   c->connect();
@@ -282,6 +315,12 @@ int main(int argc, char **argv) {
   std::cout << "average speed: " << count_per_thread / (float)(average_time)
             << " per sec." << std::endl;
   std::cout << "summary speed: " << summary_speed << " per sec." << std::endl;
+  if (http_benchmark) {
+    std::cout << "http append: " << total_writed / write_elapsed.count() << " values/s."
+              << std::endl;
+    std::cout << "http append: " << SEND_COUNT * clients_count / write_elapsed.count()
+              << " queries/s." << std::endl;
+  }
   std::cout << "read speed: "
             << result.size() / (((float)read_end - read_start) / CLOCKS_PER_SEC)
             << " per sec." << std::endl;
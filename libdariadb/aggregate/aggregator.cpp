@@ -109,8 +109,9 @@ public:
     for (size_t i = 0; i < all_intervals.size() - 1; ++i) { /// chech each interval
       auto interval_from = all_intervals[i];
       auto interval_to = all_intervals[i + 1];
+      auto period_to = timeutil::period_from_string(interval_to);
 
-      auto currentInterval = timeutil::target_interval(interval_to, currentTime);
+      auto currentInterval = timeutil::target_interval(period_to, currentTime);
       logger_info("agregator:  current - [", timeutil::to_string(currentInterval.first),
                   "-", timeutil::to_string(currentInterval.second), "]");
 
@@ -130,7 +131,7 @@ public:
           }
 
           if (fromMaxTime > toMaxTime) {
-            auto targetInterval = timeutil::target_interval(interval_to, toMaxTime);
+            auto targetInterval = timeutil::target_interval(period_to, toMaxTime);
             if (targetInterval.second <= currentInterval.second) {
               /// if 'to' interval less the 'from'
 
@@ -138,11 +139,12 @@ public:
               auto values = _storage->readInterval(qi);
 
               /// split by interval
-              std::set<std::pair<Time, Time>> intervals;
-              for (auto v : values) {
-                auto i = timeutil::target_interval(interval_to, v.time);
-                intervals.insert(i);
+              std::vector<Time> times(values.size());
+              for (size_t j = 0; j < values.size(); ++j) {
+                times[j] = values[j].time;
               }
+              auto buckets = timeutil::bucketize(period_to, times.data(), times.size());
+              std::set<std::pair<Time, Time>> intervals(buckets.begin(), buckets.end());
               for (auto i : intervals) {
                 logger_info("agregator: write #", kv.first, " to #", linkedKv.first,
                             " intervals: [", timeutil::to_string(i.first), "-",
@@ -0,0 +1,515 @@
+#include <libdariadb/compression/codecs.h>
+#include <libdariadb/compression/xor.h>
+#include <libdariadb/utils/cz.h>
+#include <libdariadb/utils/exception.h>
+#include <libdariadb/utils/utils.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+using namespace dariadb;
+using namespace dariadb::compression;
+
+namespace {
+
+void check_size(const uint8_t *in, const uint8_t *end, size_t need) {
+  if (in > end || size_t(end - in) < need) {
+    THROW_EXCEPTION("codecs: unexpected end of column.");
+  }
+}
+
+void put_varint(std::vector<uint8_t> &out, uint64_t v) {
+  while (v >= 0x80) {
+    out.push_back(uint8_t(v | 0x80));
+    v >>= 7;
+  }
+  out.push_back(uint8_t(v));
+}
+
+uint64_t get_varint(const uint8_t *&in, const uint8_t *end) {
+  uint64_t result = 0;
+  for (unsigned shift = 0; shift < 64; shift += 7) {
+    check_size(in, end, 1);
+    auto b = *in++;
+    result |= uint64_t(b & 0x7f) << shift;
+    if ((b & 0x80) == 0) {
+      return result;
+    }
+  }
+  THROW_EXCEPTION("codecs: bad varint.");
+}
+
+uint64_t zigzag(uint64_t delta) {
+  auto s = int64_t(delta);
+  return (uint64_t(s) << 1) ^ uint64_t(s >> 63);
+}
+
+uint64_t unzigzag(uint64_t z) {
+  return (z >> 1) ^ (uint64_t(0) - (z & 1));
+}
+
+uint8_t bits_count(uint64_t v) {
+  return v == 0 ? uint8_t(0) : uint8_t(64 - utils::clz(v));
+}
+
+uint64_t low_mask(uint8_t width) {
+  return width >= 64 ? std::numeric_limits<uint64_t>::max() : (uint64_t(1) << width) - 1;
+}
+
+/// not zero bytes of v after header with count of leading and trailing zero bytes.
+void put_word(std::vector<uint8_t> &out, uint64_t v) {
+  if (v == 0) {
+    out.push_back(0);
+    return;
+  }
+  auto lead = utils::clz(v) / 8;
+  auto tail = utils::ctz(v) / 8;
+  out.push_back(uint8_t(((lead << 4) | tail) + 1));
+  v >>= tail * 8;
+  for (int i = 0; i < 8 - lead - tail; ++i) {
+    out.push_back(uint8_t(v));
+    v >>= 8;
+  }
+}
+
+uint64_t get_word(const uint8_t *&in, const uint8_t *end) {
+  check_size(in, end, 1);
+  uint8_t hdr = *in++;
+  if (hdr == 0) {
+    return 0;
+  }
+  hdr--;
+  auto lead = hdr >> 4;
+  auto tail = hdr & 0xf;
+  if (lead + tail > 7) {
+    THROW_EXCEPTION("codecs: bad word header.");
+  }
+  size_t bytes = size_t(8 - lead - tail);
+  check_size(in, end, bytes);
+  uint64_t v = 0;
+  for (size_t i = 0; i < bytes; ++i) {
+    v |= uint64_t(in[i]) << (8 * i);
+  }
+  in += bytes;
+  return v << (tail * 8);
+}
+
+void pack_bits(const std::vector<uint64_t> &values, uint8_t width,
+               std::vector<uint8_t> &out) {
+  if (width == 0) {
+    return;
+  }
+  auto flush = [&out](uint64_t acc, size_t bytes) {
+    for (size_t i = 0; i < bytes; ++i) {
+      out.push_back(uint8_t(acc));
+      acc >>= 8;
+    }
+  };
+  auto mask = low_mask(width);
+  uint64_t acc = 0;
+  unsigned filled = 0;
+  for (auto v : values) {
+    v &= mask;
+    acc |= v << filled;
+    if (filled + width >= 64) {
+      flush(acc, 8);
+      acc = filled == 0 ? 0 : v >> (64 - filled);
+      filled = filled + width - 64;
+    } else {
+      filled += width;
+    }
+  }
+  flush(acc, (filled + 7) / 8);
+}
+
+const uint8_t *unpack_bits(const uint8_t *in, const uint8_t *end, size_t count,
+                           uint8_t width, uint64_t *out) {
+  if (width == 0) {
+    std::fill_n(out, count, uint64_t(0));
+    return in;
+  }
+  size_t bytes = (count * width + 7) / 8;
+  check_size(in, end, bytes);
+  auto mask = low_mask(width);
+  size_t bit = 0;
+  for (size_t i = 0; i < count; ++i) {
+    auto byte = bit / 8;
+    auto shift = unsigned(bit % 8);
+    uint64_t word = 0;
+    if (byte + 8 <= bytes) {
+      std::memcpy(&word, in + byte, sizeof(word));
+    } else {
+      for (size_t j = 0; byte + j < bytes; ++j) {
+        word |= uint64_t(in[byte + j]) << (8 * j);
+      }
+    }
+    auto v = word >> shift;
+    if (shift + width > 64) {
+      v |= uint64_t(in[byte + 8]) << (64 - shift);
+    }
+    out[i] = v & mask;
+    bit += width;
+  }
+  return in + bytes;
+}
+
+/**
+first value and zigzag deltas minus min delta (frame of reference), packed by
+width, which is minimal for the most of deltas. high bits of bigger deltas are
+stored as exceptions (patched FOR).
+*/
+void encode_for(const Column &c, std::vector<uint8_t> &out) {
+  if (c.empty()) {
+    return;
+  }
+  put_word(out, c.front());
+  if (c.size() == 1) {
+    return;
+  }
+  std::vector<uint64_t> deltas(c.size() - 1);
+  auto min_delta = std::numeric_limits<uint64_t>::max();
+  for (size_t i = 1; i < c.size(); ++i) {
+    deltas[i - 1] = zigzag(c[i] - c[i - 1]);
+    min_delta = std::min(min_delta, deltas[i - 1]);
+  }
+  std::array<size_t, 65> by_bits{};
+  for (auto &d : deltas) {
+    d -= min_delta;
+    by_bits[bits_count(d)]++;
+  }
+
+  uint8_t width = 64;
+  auto best_cost = std::numeric_limits<size_t>::max();
+  for (uint8_t w = 0; w <= 64; ++w) {
+    size_t cost = (deltas.size() * w + 7) / 8;
+    for (uint8_t b = w + 1; b <= 64; ++b) {
+      cost += by_bits[b] * (1 + (b - w + 6) / 7);
+    }
+    if (cost < best_cost) {
+      best_cost = cost;
+      width = w;
+    }
+  }
+
+  put_varint(out, min_delta);
+  out.push_back(width);
+  pack_bits(deltas, width, out);
+
+  std::vector<size_t> exceptions;
+  if (width < 64) {
+    for (size_t i = 0; i < deltas.size(); ++i) {
+      if ((deltas[i] >> width) != 0) {
+        exceptions.push_back(i);
+      }
+    }
+  }
+  put_varint(out, exceptions.size());
+  size_t prev = 0;
+  for (auto i : exceptions) {
+    put_varint(out, i - prev);
+    put_varint(out, deltas[i] >> width);
+    prev = i;
+  }
+}
+
+const uint8_t *decode_for(const uint8_t *in, const uint8_t *end, size_t count,
+                          uint64_t *out) {
+  if (count == 0) {
+    return in;
+  }
+  out[0] = get_word(in, end);
+  if (count == 1) {
+    return in;
+  }
+  auto min_delta = get_varint(in, end);
+  check_size(in, end, 1);
+  auto width = *in++;
+  if (width > 64) {
+    THROW_EXCEPTION("codecs: bad width ", int(width));
+  }
+  auto deltas = out + 1;
+  auto deltas_count = count - 1;
+  in = unpack_bits(in, end, deltas_count, width, deltas);
+  auto exceptions = get_varint(in, end);
+  size_t pos = 0;
+  for (uint64_t i = 0; i < exceptions; ++i) {
+    pos += size_t(get_varint(in, end));
+    if (pos >= deltas_count || width >= 64) {
+      THROW_EXCEPTION("codecs: bad exception position.");
+    }
+    deltas[pos] |= get_varint(in, end) << width;
+  }
+  for (size_t i = 1; i < count; ++i) {
+    out[i] = out[i - 1] + unzigzag(out[i] + min_delta);
+  }
+  return in;
+}
+
+class RleCodec : public IColumnCodec {
+public:
+  CODEC kind() const override { return CODEC::RLE; }
+  const char *name() const override { return "rle"; }
+
+  bool encode(const Column &c, std::vector<uint8_t> &out) const override {
+    size_t i = 0;
+    while (i < c.size()) {
+      auto j = i + 1;
+      while (j < c.size() && c[j] == c[i]) {
+        ++j;
+      }
+      put_varint(out, j - i);
+      put_word(out, c[i]);
+      i = j;
+    }
+    return true;
+  }
+
+  const uint8_t *decode(const uint8_t *begin, const uint8_t *end, size_t count,
+                        uint64_t *out) const override {
+    size_t filled = 0;
+    while (filled < count) {
+      auto run = get_varint(begin, end);
+      auto v = get_word(begin, end);
+      if (run == 0 || run > count - filled) {
+        THROW_EXCEPTION("codecs: bad run length.");
+      }
+      std::fill_n(out + filled, size_t(run), v);
+      filled += size_t(run);
+    }
+    return begin;
+  }
+};
+
+class RegularCodec : public IColumnCodec {
+public:
+  CODEC kind() const override { return CODEC::REGULAR; }
+  const char *name() const override { return "regular"; }
+
+  bool encode(const Column &c, std::vector<uint8_t> &out) const override {
+    if (c.empty()) {
+      return true;
+    }
+    uint64_t step = c.size() > 1 ? c[1] - c[0] : 0;
+    for (size_t i = 2; i < c.size(); ++i) {
+      if (c[i] - c[i - 1] != step) {
+        return false;
+      }
+    }
+    put_word(out, c.front());
+    if (c.size() > 1) {
+      put_varint(out, zigzag(step));
+    }
+    return true;
+  }
+
+  const uint8_t *decode(const uint8_t *begin, const uint8_t *end, size_t count,
+                        uint64_t *out) const override {
+    if (count == 0) {
+      return begin;
+    }
+    out[0] = get_word(begin, end);
+    if (count > 1) {
+      auto step = unzigzag(get_varint(begin, end));
+      for (size_t i = 1; i < count; ++i) {
+        out[i] = out[i - 1] + step;
+      }
+    }
+    return begin;
+  }
+};
+
+class DeltaForCodec : public IColumnCodec {
+public:
+  CODEC kind() const override { return CODEC::DELTA_FOR; }
+  const char *name() const override { return "delta_for"; }
+
+  bool encode(const Column &c, std::vector<uint8_t> &out) const override {
+    encode_for(c, out);
+    return true;
+  }
+
+  const uint8_t *decode(const uint8_t *begin, const uint8_t *end, size_t count,
+                        uint64_t *out) const override {
+    return decode_for(begin, end, count, out);
+  }
+};
+
+class ScaledForCodec : public IColumnCodec {
+public:
+  static const uint8_t MAX_SCALE = 9;
+
+  CODEC kind() const override { return CODEC::SCALED_FOR; }
+  const char *name() const override { return "scaled_for"; }
+
+  bool encode(const Column &c, std::vector<uint8_t> &out) const override {
+    const double max_exact = 9007199254740992.0; // 2^53
+    Column scaled(c.size());
+    for (uint8_t k = 0; k <= MAX_SCALE; ++k) {
+      auto p = scale(k);
+      bool ok = true;
+      for (size_t i = 0; i < c.size() && ok; ++i) {
+        auto v = inner::flat_int_to_double(int64_t(c[i])) * p;
+        if (!(std::fabs(v) < max_exact)) {
+          ok = false;
+          break;
+        }
+        auto n = std::llround(v);
+        // exactly the same bits after decoding, -0.0 and nan are not scaled.
+        ok = uint64_t(inner::flat_double_to_int(double(n) / p)) == c[i];
+        scaled[i] = uint64_t(n);
+      }
+      if (ok) {
+        out.push_back(k);
+        encode_for(scaled, out);
+        return true;
+      }
+    }
+    return false;
+  }
+
+  const uint8_t *decode(const uint8_t *begin, const uint8_t *end, size_t count,
+                        uint64_t *out) const override {
+    if (count == 0) {
+      return begin;
+    }
+    check_size(begin, end, 1);
+    auto k = *begin++;
+    if (k > MAX_SCALE) {
+      THROW_EXCEPTION("codecs: bad scale ", int(k));
+    }
+    auto result = decode_for(begin, end, count, out);
+    auto p = scale(k);
+    for (size_t i = 0; i < count; ++i) {
+      out[i] = uint64_t(inner::flat_double_to_int(double(int64_t(out[i])) / p));
+    }
+    return result;
+  }
+
+private:
+  static double scale(uint8_t k) {
+    double result = 1;
+    for (uint8_t i = 0; i < k; ++i) {
+      result *= 10;
+    }
+    return result;
+  }
+};
+
+class XorCodec : public IColumnCodec {
+public:
+  CODEC kind() const override { return CODEC::XOR; }
+  const char *name() const override { return "xor"; }
+
+  bool encode(const Column &c, std::vector<uint8_t> &out) const override {
+    uint64_t prev = 0;
+    for (auto v : c) {
+      put_word(out, v ^ prev);
+      prev = v;
+    }
+    return true;
+  }
+
+  const uint8_t *decode(const uint8_t *begin, const uint8_t *end, size_t count,
+                        uint64_t *out) const override {
+    uint64_t prev = 0;
+    for (size_t i = 0; i < count; ++i) {
+      prev ^= get_word(begin, end);
+      out[i] = prev;
+    }
+    return begin;
+  }
+};
+
+const std::vector<const IColumnCodec *> &all_codecs() {
+  static const RleCodec rle;
+  static const RegularCodec regular;
+  static const DeltaForCodec delta_for;
+  static const ScaledForCodec scaled_for;
+  static const XorCodec xor_codec;
+  static const std::vector<const IColumnCodec *> result{&rle, &regular, &delta_for,
+                                                        &scaled_for, &xor_codec};
+  return result;
+}
+} // namespace
+
+const IColumnCodec *CodecRegistry::get(CODEC kind) {
+  for (auto c : all_codecs()) {
+    if (c->kind() == kind) {
+      return c;
+    }
+  }
+  THROW_EXCEPTION("unknown codec: ", int(kind));
+}
+
+std::vector<const IColumnCodec *> CodecRegistry::codecs() {
+  return all_codecs();
+}
+
+CODEC CodecRegistry::encodeBest(const Column &c, std::vector<uint8_t> &out) {
+  const IColumnCodec *best = nullptr;
+  std::vector<uint8_t> best_out, trial;
+  for (auto codec : all_codecs()) {
+    trial.clear();
+    if (!codec->encode(c, trial)) {
+      continue;
+    }
+    if (best == nullptr || trial.size() < best_out.size()) {
+      best = codec;
+      std::swap(best_out, trial);
+    }
+  }
+  if (best == nullptr) {
+    THROW_EXCEPTION("codecs: column can`t be encoded.");
+  }
+  out.push_back(uint8_t(best->kind()));
+  out.insert(out.end(), best_out.begin(), best_out.end());
+  return best->kind();
+}
+
+void dariadb::compression::packColumns(const MeasArray &ma, std::vector<uint8_t> &out) {
+  auto start = out.size();
+  Column times(ma.size()), values(ma.size()), flags(ma.size());
+  for (size_t i = 0; i < ma.size(); ++i) {
+    times[i] = ma[i].time;
+    values[i] = uint64_t(inner::flat_double_to_int(ma[i].value));
+    flags[i] = ma[i].flag;
+  }
+  CodecRegistry::encodeBest(times, out);
+  CodecRegistry::encodeBest(values, out);
+  CodecRegistry::encodeBest(flags, out);
+
+  auto size = uint32_t(out.size() - start + sizeof(uint32_t));
+  uint8_t size_bytes[sizeof(uint32_t)];
+  std::memcpy(size_bytes, &size, sizeof(size));
+  out.insert(out.end(), size_bytes, size_bytes + sizeof(size));
+}
+
+MeasArray dariadb::compression::unpackColumns(Id id, const uint8_t *begin,
+                                               const uint8_t *end, size_t count) {
+  uint32_t size = 0;
+  check_size(begin, end, sizeof(size));
+  std::memcpy(&size, end - sizeof(size), sizeof(size));
+  if (size < sizeof(size) || size > size_t(end - begin)) {
+    THROW_EXCEPTION("codecs: bad columns size ", size);
+  }
+  auto in = end - size;
+  auto columns_end = end - sizeof(size);
+  Column times(count), values(count), flags(count);
+  for (auto c : {&times, &values, &flags}) {
+    check_size(in, columns_end, 1);
+    auto kind = CODEC(*in++);
+    in = CodecRegistry::get(kind)->decode(in, columns_end, count, c->data());
+  }
+
+  MeasArray result(count);
+  for (size_t i = 0; i < count; ++i) {
+    result[i].id = id;
+    result[i].time = times[i];
+    result[i].value = inner::flat_int_to_double(int64_t(values[i]));
+    result[i].flag = Flag(flags[i]);
+  }
+  return result;
+}
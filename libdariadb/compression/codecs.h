@@ -0,0 +1,58 @@
+#pragma once
+
+#include <libdariadb/meas.h>
+#include <libdariadb/st_exports.h>
+#include <cstdint>
+#include <vector>
+
+namespace dariadb {
+namespace compression {
+
+/// format of chunk buffer, stored in ChunkHeader::codec.
+enum class CHUNK_CODEC : uint8_t {
+  DELTA_XOR = 0, /// streaming CopmressedWriter. all chunks, writed before codecs.
+  COLUMNS = 1    /// closed chunk: times, values and flags packed by column codecs.
+};
+
+/// codec of one column of closed chunk.
+enum class CODEC : uint8_t {
+  RLE = 1,        /// runs of equal values.
+  REGULAR = 2,    /// first value and step, nothing per value.
+  DELTA_FOR = 3,  /// zigzag deltas, bit-packed with frame of reference and exceptions.
+  SCALED_FOR = 4, /// decimal values as scaled integers, packed like DELTA_FOR.
+  XOR = 5         /// xor with previous value, zero bytes are skipped.
+};
+
+/// times, flags or bits of values.
+using Column = std::vector<uint64_t>;
+
+class IColumnCodec {
+public:
+  virtual ~IColumnCodec() {}
+  virtual CODEC kind() const = 0;
+  virtual const char *name() const = 0;
+  /// return false, if codec is not applicable to the column.
+  virtual bool encode(const Column &c, std::vector<uint8_t> &out) const = 0;
+  /// return pointer to the first byte after the column.
+  virtual const uint8_t *decode(const uint8_t *begin, const uint8_t *end, size_t count,
+                                uint64_t *out) const = 0;
+};
+
+class CodecRegistry {
+public:
+  EXPORT static const IColumnCodec *get(CODEC kind);
+  EXPORT static std::vector<const IColumnCodec *> codecs();
+  /// trial compression by all codecs. writes kind of the smallest one and column.
+  EXPORT static CODEC encodeBest(const Column &c, std::vector<uint8_t> &out);
+};
+
+/**
+columns layout: [times][values][flags][uint32 size of all];
+each column starts with CODEC byte. size is in the tail, so columns can be read
+from the end of not compacted chunk buffer.
+*/
+EXPORT void packColumns(const MeasArray &ma, std::vector<uint8_t> &out);
+EXPORT MeasArray unpackColumns(Id id, const uint8_t *begin, const uint8_t *end,
+                               size_t count);
+}
+}
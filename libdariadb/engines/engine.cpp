@@ -8,12 +8,14 @@
 #include <libdariadb/storage/memstorage/memstorage.h>
 #include <libdariadb/storage/pages/page_manager.h>
 #include <libdariadb/storage/subscribe.h>
+#include <libdariadb/storage/versions.h>
 #include <libdariadb/timeutil.h>
 #include <libdariadb/utils/async/locker.h>
 #include <libdariadb/utils/async/thread_manager.h>
 #include <libdariadb/utils/exception.h>
 #include <libdariadb/utils/fs.h>
 #include <libdariadb/utils/logger.h>
+#include <libdariadb/utils/metrics.h>
 #include <libdariadb/utils/strings.h>
 #include <libdariadb/utils/utils.h>
 #include <algorithm>
@@ -37,9 +39,17 @@ public:
     _settings = settings;
     _strategy = _settings->strategy.value();
     _min_max_map = std::make_shared<Id2MinMax>();
+    if (_settings->metrics.value()) {
+      utils::metrics::enable(true);
+    }
+    auto registry = utils::metrics::Registry::instance();
+    _append_latency = registry->histogram("engine.append_ns");
+    _appended = registry->counter("engine.appended");
 
     _engine_env = EngineEnvironment::create();
     _engine_env->addResource(EngineEnvironment::Resource::SETTINGS, _settings.get());
+    _versions = _engine_env->getResourceObject<VersionManager>(
+        EngineEnvironment::Resource::VERSIONS);
 
     logger_info("engine", _settings->alias, ": project version - ", version());
     logger_info("engine", _settings->alias, ": storage format - ", format());
@@ -78,7 +88,7 @@ public:
         _manifest->set_format(std::to_string(format()));
       } else { // open exists
         check_storage_version();
-        Dropper::cleanStorage(_settings->raw_path.value());
+        Dropper::cleanStorage(_settings->raw_path.value(), _manifest.get());
       }
     }
 
@@ -210,27 +220,9 @@ public:
     }
   }
 
-  bool try_lock_storage() {
-    std::lock_guard<std::mutex> lock(_lock_locker);
-    if (_dropper != nullptr && _memstorage != nullptr) {
-      auto dl = _dropper->getLocker();
-      auto lp = _memstorage->getLockers();
-      return std::try_lock(*dl, *lp) == -1;
-    }
-
-    if (_dropper == nullptr && _memstorage != nullptr) {
-      auto lp = _memstorage->getLockers();
-      return lp->try_lock();
-    }
-
-    if (_dropper != nullptr && _memstorage == nullptr) {
-      auto dl = _dropper->getLocker();
-      return dl->try_lock();
-    }
-    THROW_EXCEPTION("engine", _settings->alias, ": try_lock - bad engine configuration.");
-  }
-
-  void lock_storage() {
+  /// stops drops to disk. readers do not need it (see VersionManager), only
+  /// maintenance (compaction, fsck...), which changes pages written by drops.
+  void lock_drops() {
     std::lock_guard<std::mutex> lock(_lock_locker);
     if (_dropper != nullptr && _memstorage != nullptr) {
       auto dl = _dropper->getLocker();
@@ -252,7 +244,7 @@ public:
     }
   }
 
-  void unlock_storage() {
+  void unlock_drops() {
     if (_dropper != nullptr && _memstorage != nullptr) {
       auto dl = _dropper->getLocker();
       auto lp = _memstorage->getLockers();
@@ -275,41 +267,44 @@ public:
   }
 
   Time minTime() {
-    lock_storage();
-
-    Time pmin = MAX_TIME;
-    if (_page_manager != nullptr) {
-      pmin = _page_manager->minTime();
-    }
-
-    if (_strategy == STRATEGY::CACHE) {
-      auto amin = this->_wal_manager->minTime();
-      pmin = std::min(pmin, amin);
-    }
-    Time amin = _top_level_storage->minTime();
+    return _versions->read([this]() {
+      Time pmin = MAX_TIME;
+      if (_page_manager != nullptr) {
+        pmin = _page_manager->minTime();
+      }
 
-    unlock_storage();
-    return std::min(pmin, amin);
+      if (_strategy == STRATEGY::CACHE) {
+        auto amin = this->_wal_manager->minTime();
+        pmin = std::min(pmin, amin);
+      }
+      Time amin = _top_level_storage->minTime();
+      return std::min(pmin, amin);
+    });
   }
 
   Time maxTime() {
-    lock_storage();
-
-    Time pmax = MIN_TIME;
-    if (_page_manager != nullptr) {
-      pmax = _page_manager->maxTime();
-    }
-    if (_strategy == STRATEGY::CACHE) {
-      auto amax = this->_wal_manager->maxTime();
-      pmax = std::max(pmax, amax);
-    }
-    Time amax = _top_level_storage->maxTime();
-
-    unlock_storage();
-    return std::max(pmax, amax);
+    return _versions->read([this]() {
+      Time pmax = MIN_TIME;
+      if (_page_manager != nullptr) {
+        pmax = _page_manager->maxTime();
+      }
+      if (_strategy == STRATEGY::CACHE) {
+        auto amax = this->_wal_manager->maxTime();
+        pmax = std::max(pmax, amax);
+      }
+      Time amax = _top_level_storage->maxTime();
+      return std::max(pmax, amax);
+    });
   }
 
   bool minMaxTime(dariadb::Id id, dariadb::Time *minResult, dariadb::Time *maxResult) {
+    return _versions->read([this, id, minResult, maxResult]() {
+      return minMaxTime_logic(id, minResult, maxResult);
+    });
+  }
+
+  bool minMaxTime_logic(dariadb::Id id, dariadb::Time *minResult,
+                        dariadb::Time *maxResult) {
     dariadb::Time subMin1 = dariadb::MAX_TIME, subMax1 = dariadb::MIN_TIME;
     dariadb::Time subMin3 = dariadb::MAX_TIME, subMax3 = dariadb::MIN_TIME;
 
@@ -332,8 +327,6 @@ public:
       return false;
     };
 
-    lock_storage();
-
     utils::async::TaskResult_Ptr pm_async = nullptr;
     if (!_settings->is_memory_only_mode) {
       pm_async = ThreadManager::instance()->post(THREAD_KINDS::COMMON, AT(pm_at));
@@ -358,7 +351,6 @@ public:
       *minResult = subMinW;
       *maxResult = subMaxW;
     }
-    unlock_storage();
 
     *minResult = std::min(subMin1, subMin3);
     *maxResult = std::max(subMax1, subMax3);
@@ -366,7 +358,10 @@ public:
   }
 
   Id2MinMax_Ptr loadMinMax() {
-    this->lock_storage();
+    return _versions->read([this]() { return loadMinMax_logic(); });
+  }
+
+  Id2MinMax_Ptr loadMinMax_logic() {
     Id2MinMax_Ptr result = std::make_shared<Id2MinMax>();
 
     if (_page_manager != nullptr) {
@@ -384,18 +379,17 @@ public:
     auto t_mm = this->_top_level_storage->loadMinMax();
 
     minmax_append(result, t_mm);
-
-    this->unlock_storage();
-
     return result;
   }
 
   Status append(const Meas &value) {
+    utils::metrics::ScopedTimer timer(_append_latency);
     Status result{};
 
     result = _top_level_storage->append(value);
 
     if (result.writed == 1) {
+      _appended->add();
       _subscribe_notify.on_append(value);
       auto insert_fres = _min_max_map->find_bucket(value.id);
       insert_fres.v->second.updateMax(value);
@@ -414,10 +408,12 @@ public:
   }
 
   Id2Meas currentValue(const IdArray &ids, const Flag &flag) {
-    lock_storage();
     Id2Meas a_result;
     if (_min_max_map->empty()) {
-      readMinMaxFromStorages();
+      _versions->read([this]() {
+        readMinMaxFromStorages();
+        return true;
+      });
     }
 
     auto f = [&a_result, &ids, flag](const Id2MinMax::value_type &v) {
@@ -436,13 +432,14 @@ public:
       }
     };
     _min_max_map->apply(f);
-
-    unlock_storage();
     return a_result;
   }
 
   void flush() {
     std::lock_guard<std::mutex> lg(_flush_locker);
+    if (_thread_pool_owner) {
+      _subscribe_notify.flush();
+    }
 
     if (_wal_manager != nullptr) {
       _wal_manager->flush();
@@ -596,21 +593,16 @@ public:
     Id2Cursor result;
     AsyncTask pm_at = [q, this, &result](const ThreadInfo &ti) {
       TKIND_CHECK(THREAD_KINDS::COMMON, ti.kind);
-      if (!try_lock_storage()) {
-        return true;
-      }
-
-      Id2Cursor r;
-      if (this->strategy() == STRATEGY::CACHE) {
-        r = interval_readers_when_cache(q);
-      } else {
-        r = internal_readers_two_level(q);
-      }
-
-      this->unlock_storage();
+      auto r = _versions->read([this, &q]() {
+        if (this->strategy() == STRATEGY::CACHE) {
+          return interval_readers_when_cache(q);
+        } else {
+          return internal_readers_two_level(q);
+        }
+      });
 
       for (auto kv : r) {
-        result[kv.first] = kv.second;
+        result[kv.first] = downsample(kv.first, kv.second, q);
       }
       return false;
     };
@@ -619,6 +611,16 @@ public:
     at->wait();
     return result;
   }
+
+  /// one bucket per q.step, if it is set.
+  Cursor_Ptr downsample(Id id, const Cursor_Ptr &c, const QueryInterval &q) {
+    if (q.step == Time(0) || q.from > q.to) {
+      return c;
+    }
+    QueryInterval local_q = q;
+    local_q.ids = IdArray{id};
+    return Cursor_Ptr{new DownsampleCursor(c, local_q)};
+  }
   Statistic stat_from_cache(const Id id, Time from, Time to) {
     auto memory_mm = _memstorage->loadMinMax();
     auto sync_map = _memstorage->getSyncMap();
@@ -659,21 +661,19 @@ public:
 
     AsyncTask pm_at = [id, from, to, this, &result](const ThreadInfo &ti) {
       TKIND_CHECK(THREAD_KINDS::COMMON, ti.kind);
-      if (!try_lock_storage()) {
-        return true;
-      }
-      if (strategy() != STRATEGY::CACHE) {
-        result.update(stat_from_disk(id, from, to));
+      result = _versions->read([this, id, from, to]() {
+        Statistic st;
+        if (strategy() != STRATEGY::CACHE) {
+          st.update(stat_from_disk(id, from, to));
 
-        if (_memstorage != nullptr) {
-          result.update(_memstorage->stat(id, from, to));
+          if (_memstorage != nullptr) {
+            st.update(_memstorage->stat(id, from, to));
+          }
+        } else {
+          st.update(stat_from_cache(id, from, to));
         }
-      } else {
-        result.update(stat_from_cache(id, from, to));
-      }
-
-      this->unlock_storage();
-
+        return st;
+      });
       return false;
     };
     auto at = ThreadManager::instance()->post(THREAD_KINDS::COMMON, AT(pm_at));
@@ -703,51 +703,67 @@ public:
 
   Id2Meas readTimePoint(const QueryTimePoint &q) {
     Id2Meas result;
-    result.reserve(q.ids.size());
-    for (auto id : q.ids) {
-      result[id].flag = FLAGS::_NO_DATA;
-    }
-
     auto pm = _page_manager.get();
     auto mm = _top_level_storage.get();
     auto am = _wal_manager.get();
     AsyncTask pm_at = [&result, &q, this, pm, mm, am](const ThreadInfo &ti) {
       TKIND_CHECK(THREAD_KINDS::COMMON, ti.kind);
-      if (!try_lock_storage()) {
-        return true;
-      }
-      for (auto id : q.ids) {
+      result = _versions->read([&q, this, pm, mm, am]() {
+        return readTimePoint_logic(q, pm, mm, am);
+      });
+      return false;
+    };
 
+    auto pm_async = ThreadManager::instance()->post(THREAD_KINDS::COMMON, AT(pm_at));
+    pm_async->wait();
+    return result;
+  }
+
+  Id2Meas readTimePoint_logic(const QueryTimePoint &q, PageManager *pm, IMeasStorage *mm,
+                              WALManager *am) {
+    Id2Meas result;
+    result.reserve(q.ids.size());
+    for (auto id : q.ids) {
+      result[id].flag = FLAGS::_NO_DATA;
+    }
+
+    // ids, which values are not in memory, are readed from disk by one query.
+    QueryTimePoint disk_q = q;
+    disk_q.ids.clear();
+    for (auto id : q.ids) {
+      dariadb::Time minT, maxT;
+
+      if (mm->minMaxTime(id, &minT, &maxT) &&
+          (minT < q.time_point || maxT < q.time_point)) {
         QueryTimePoint local_q = q;
         local_q.ids.clear();
         local_q.ids.push_back(id);
+        auto subres = mm->readTimePoint(local_q);
+        result[id] = subres[id];
+      } else {
+        disk_q.ids.push_back(id);
+      }
+    }
 
-        dariadb::Time minT, maxT;
-
-        if (mm->minMaxTime(id, &minT, &maxT) &&
-            (minT < q.time_point || maxT < q.time_point)) {
-          auto subres = mm->readTimePoint(local_q);
-          result[id] = subres[id];
+    if (!disk_q.ids.empty() && this->strategy() == STRATEGY::CACHE) {
+      auto subres = am->readTimePoint(disk_q);
+      IdArray not_in_wal;
+      for (auto id : disk_q.ids) {
+        auto fres = subres.find(id);
+        if (fres != subres.end() && fres->second.flag != FLAGS::_NO_DATA) {
+          result[id] = fres->second;
         } else {
-          bool in_wal_level = false;
-          if (this->strategy() == STRATEGY::CACHE) {
-            auto subres = am->readTimePoint(local_q);
-            auto value = subres[id];
-            result[id] = value;
-            in_wal_level = value.flag != FLAGS::_NO_DATA;
-          }
-          if (!in_wal_level && _page_manager != nullptr) {
-            auto subres = _page_manager->valuesBeforeTimePoint(local_q);
-            result[id] = subres[id];
-          }
+          not_in_wal.push_back(id);
         }
       }
-      unlock_storage();
-      return false;
-    };
-
-    auto pm_async = ThreadManager::instance()->post(THREAD_KINDS::COMMON, AT(pm_at));
-    pm_async->wait();
+      disk_q.ids = not_in_wal;
+    }
+    if (!disk_q.ids.empty() && pm != nullptr) {
+      auto subres = pm->valuesBeforeTimePoint(disk_q);
+      for (auto id : disk_q.ids) {
+        result[id] = subres[id];
+      }
+    }
     return result;
   }
 
@@ -768,23 +784,31 @@ public:
       }
     }
   }
-  void fsck() {
+  void fsck(bool online) {
     logger_info("engine", _settings->alias, ": fsck ", _settings->storage_path.value());
-    this->lock_storage();
-    _page_manager->fsck();
-    this->unlock_storage();
+    if (_page_manager == nullptr) {
+      return;
+    }
+    // pages are immutable and checked without the storage lock in online mode.
+    if (online) {
+      _page_manager->fsck(true);
+      return;
+    }
+    this->lock_drops();
+    _page_manager->fsck(false);
+    this->unlock_drops();
   }
 
   void eraseOld(const Id id, const Time t) {
     logger_info("engine", _settings->alias, ": eraseOld to ", timeutil::to_string(t));
-    this->lock_storage();
+    this->lock_drops();
     if (_page_manager != nullptr) {
       _page_manager->eraseOld(id, t);
     }
     if (_memstorage != nullptr) {
       this->_memstorage->dropOld(id, t);
     }
-    this->unlock_storage();
+    this->unlock_drops();
   }
 
   STRATEGY strategy() const {
@@ -793,23 +817,23 @@ public:
   }
 
   void repack(dariadb::Id id) {
-    this->lock_storage();
+    this->lock_drops();
     logger_info("engine", _settings->alias, ": repack...");
     if (_wal_manager != nullptr) {
       _wal_manager->flush(id);
     }
     _page_manager->repack(id);
-    this->unlock_storage();
+    this->unlock_drops();
   }
 
   void compact(ICompactionController *logic) {
-    this->lock_storage();
+    this->lock_drops();
     logger_info("engine", _settings->alias, ": compact...");
     if (_wal_manager != nullptr && logic != nullptr) {
       _wal_manager->flush(logic->targetId);
     }
     _page_manager->compact(logic);
-    this->unlock_storage();
+    this->unlock_drops();
   }
 
   storage::Settings_ptr settings() { return _settings; }
@@ -825,6 +849,7 @@ protected:
 
   EngineEnvironment_ptr _engine_env;
   Settings_ptr _settings;
+  VersionManager *_versions;
   STRATEGY _strategy;
   Manifest_ptr _manifest;
   bool _stoped;
@@ -835,6 +860,9 @@ protected:
   bool _thread_pool_owner;
   bool _eraseActionIsStoped;
   bool _beginStoping;
+
+  utils::metrics::Histogram *_append_latency;
+  utils::metrics::Counter *_appended;
 };
 
 Engine::Engine(Settings_ptr settings, bool init_threadpool, bool ignore_lock_file)
@@ -904,8 +932,8 @@ void Engine::wait_all_asyncs() {
   return _impl->wait_all_asyncs();
 }
 
-void Engine::fsck() {
-  _impl->fsck();
+void Engine::fsck(bool online) {
+  _impl->fsck(online);
 }
 
 void Engine::eraseOld(const Id id, const Time t) {
@@ -50,7 +50,7 @@ public:
                         const ReaderCallback_ptr &clbk) override;
   EXPORT void wait_all_asyncs() override;
 
-  EXPORT void fsck() override;
+  EXPORT void fsck(bool online = false) override;
 
   EXPORT void eraseOld(const Id id, const Time t) override;
 
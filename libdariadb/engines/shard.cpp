@@ -6,7 +6,12 @@
 #include <libdariadb/utils/async/thread_manager.h>
 #include <libdariadb/utils/fs.h>
 #include <libdariadb/utils/utils.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
 #include <shared_mutex>
+#include <unordered_set>
 
 #include <fstream>
 
@@ -21,6 +26,48 @@ using namespace dariadb::utils::async;
 
 using json = nlohmann::json;
 
+namespace shard_inner {
+/// immutable copy of id=>shard map for lock-free reading.
+struct RoutingTable {
+  std::unordered_map<Id, IEngine_Ptr> id2shard;
+  uint64_t version = 0;
+};
+using RoutingTable_Ptr = std::shared_ptr<const RoutingTable>;
+
+/// last routed id of the current thread. removed shard is not kept alive by it.
+struct RouteCache {
+  const void *owner = nullptr;
+  uint64_t version = 0;
+  Id id = MAX_ID;
+  std::weak_ptr<IEngine> shard;
+};
+thread_local RouteCache route_cache;
+
+/// versions are unique for all engines, so a cache can't be valid for a new engine.
+std::atomic<uint64_t> routes_version_counter{0};
+
+/// shared by a query and its sub-queries, which can outlive a timed out query.
+template <class T> struct GatherState {
+  std::mutex locker;
+  std::condition_variable cond;
+  size_t pending = 0;
+  T result{};
+  std::exception_ptr error;
+};
+
+template <class T> using SubQuery = std::function<T()>;
+template <class T> using MergeFunc = std::function<void(T &, T &)>;
+
+template <class K, class V>
+void merge_maps(std::unordered_map<K, V> &result, std::unordered_map<K, V> &part) {
+  for (auto &kv : part) {
+    result[kv.first] = std::move(kv.second);
+  }
+}
+} // namespace shard_inner
+
+using namespace shard_inner;
+
 class ShardEngine::Private : public IEngine {
   struct ShardRef {
     std::string path;
@@ -30,7 +77,14 @@ class ShardEngine::Private : public IEngine {
 public:
   Private(const std::string &path, bool force_unlock) {
     _stoped = false;
+    _routes_version = 0;
+    _not_published_routes = 0;
+    _routes = std::make_shared<RoutingTable>();
     _settings = Settings::create(path);
+    ThreadPool::Params query_params(
+        std::max(size_t(1), _settings->threads_in_shard_query.value()),
+        (ThreadKind)THREAD_KINDS::SHARD_QUERY);
+    _query_pool = std::make_unique<ThreadPool>(query_params);
     _force_unlock = force_unlock;
     auto fname = shardFileName();
     if (!utils::fs::file_exists(fname)) {
@@ -50,7 +104,14 @@ public:
     if (!_stoped) {
       logger_info("shards: stopping");
       _subscribe_notify.stop();
-      _id2shard.clear();
+      _query_pool->stop();
+      {
+        std::lock_guard<std::shared_mutex> lg(_locker);
+        _id2shard.clear();
+        _default_routed.clear();
+        _default_shard = nullptr;
+        publish_routes();
+      }
       for (auto s : _sub_storages) {
         s.storage->stop();
       }
@@ -82,6 +143,7 @@ public:
         shardAdd_inner(d);
       }
     }
+    publish_routes();
   }
 
   void saveShardFile() {
@@ -110,6 +172,7 @@ public:
   void shardAdd(const ShardEngine::Shard &d) {
     std::lock_guard<std::shared_mutex> lg(_locker);
     shardAdd_inner(d);
+    publish_routes();
     saveShardFile();
   }
 
@@ -119,9 +182,11 @@ public:
 
     auto f_iter = _shards.find(alias);
     if (f_iter != _shards.end()) {
+      IEngine_Ptr removed = nullptr;
       for (auto iter = _sub_storages.begin(); iter != _sub_storages.end(); ++iter) {
         auto ss = iter->storage;
         if (iter->path == f_iter->second.path) {
+          removed = ss;
           ss->stop();
           _sub_storages.erase(iter);
           if (_default_shard.get() == ss.get()) {
@@ -137,7 +202,17 @@ public:
       for (auto id : f_iter->second.ids) {
         _id2shard.erase(id);
       }
+      // routes, cached by get_shard_for_id.
+      for (auto it = _id2shard.begin(); it != _id2shard.end();) {
+        if (it->second.get() == removed.get()) {
+          _default_routed.erase(it->first);
+          it = _id2shard.erase(it);
+        } else {
+          ++it;
+        }
+      }
       _shards.erase(f_iter);
+      publish_routes();
       saveShardFile();
     } else {
       logger_info("shards: rm - shard with alias={", alias, "} not found.");
@@ -197,7 +272,7 @@ public:
 
       } else {
         for (auto id : d.ids) {
-          if (_id2shard.count(id) == 0) {
+          if (_id2shard.count(id) == 0 || _default_routed.erase(id) != 0) {
             _id2shard[id] = shard_ptr;
           }
         }
@@ -267,42 +342,114 @@ public:
     return new_shard;
   }
 
+  /// replace the routing table, used by readers. _locker must be locked.
+  void publish_routes() {
+    auto table = std::make_shared<RoutingTable>();
+    table->id2shard = _id2shard;
+    table->version = ++routes_version_counter;
+    std::atomic_store(&_routes, RoutingTable_Ptr(table));
+    _routes_version = table->version;
+    _not_published_routes = 0;
+  }
+
   IEngine_Ptr get_shard_for_id(Id id) {
-    IEngine_Ptr target_shard = _default_shard;
+    if (route_cache.owner == this && route_cache.id == id &&
+        route_cache.version == _routes_version.load(std::memory_order_relaxed)) {
+      auto cached = route_cache.shard.lock();
+      if (cached != nullptr) {
+        return cached;
+      }
+    }
 
-    _locker.lock();
-    auto fres = this->_id2shard.find(id);
-    if (fres != this->_id2shard.end()) {
+    auto routes = std::atomic_load(&_routes);
+    IEngine_Ptr target_shard = nullptr;
+    auto fres = routes->id2shard.find(id);
+    if (fres != routes->id2shard.end()) {
       target_shard = fres->second;
     } else {
-      if (this->_scheme != nullptr) {
-        auto d = _scheme->descriptionFor(id);
-        if (d.id != MAX_ID && !d.interval.empty()) {
-
-          auto fiter = this->_interval2shard.find(d.interval);
-          if (fiter == _interval2shard.end()) {
-            target_shard = createShardForInterval(d.interval);
-          } else {
-            target_shard = fiter->second;
-          }
-          _id2shard[id] = target_shard;
-        } else {
-          if (_default_shard == nullptr) {
-            _default_shard = createShardForInterval("default");
-            target_shard = _default_shard;
-          }
-        }
-      }
+      target_shard = route_slow(id);
     }
-    _locker.unlock();
 
     if (target_shard == nullptr) {
       logger_fatal("shard: shard for id:", id, " not found. default shard is nullptr.");
       return nullptr;
     }
+    route_cache.owner = this;
+    route_cache.version = routes->version;
+    route_cache.id = id;
+    route_cache.shard = target_shard;
     return target_shard;
   }
 
+  /// id is not in the routing table.
+  IEngine_Ptr route_slow(Id id) {
+    {
+      std::shared_lock<std::shared_mutex> lg(_locker);
+      auto fres = this->_id2shard.find(id);
+      if (fres != this->_id2shard.end()) {
+        return fres->second;
+      }
+      if (this->_scheme == nullptr && _default_shard != nullptr) {
+        return _default_shard;
+      }
+    }
+
+    std::lock_guard<std::shared_mutex> lg(_locker);
+    auto fres = this->_id2shard.find(id);
+    if (fres != this->_id2shard.end()) {
+      return fres->second;
+    }
+    IEngine_Ptr target_shard = _default_shard;
+    if (this->_scheme != nullptr) {
+      auto d = _scheme->descriptionFor(id);
+      if (d.id != MAX_ID && !d.interval.empty()) {
+
+        auto fiter = this->_interval2shard.find(d.interval);
+        if (fiter == _interval2shard.end()) {
+          target_shard = createShardForInterval(d.interval);
+        } else {
+          target_shard = fiter->second;
+        }
+        _id2shard[id] = target_shard;
+      } else {
+        if (_default_shard == nullptr) {
+          _default_shard = createShardForInterval("default");
+          target_shard = _default_shard;
+        }
+        _id2shard[id] = target_shard;
+        _default_routed.insert(id);
+      }
+      // the table is copied, when enough new routes are collected.
+      _not_published_routes++;
+      if (_not_published_routes > std::max(size_t(64), _id2shard.size() / 4)) {
+        publish_routes();
+      }
+    }
+    return target_shard;
+  }
+
+  /// split values to batches for each shard.
+  std::unordered_map<IEngine_Ptr, MeasArray>
+  route(const MeasArray::const_iterator &begin, const MeasArray::const_iterator &end,
+        Status *not_routed) {
+    std::unordered_map<IEngine_Ptr, MeasArray> result;
+    IEngine_Ptr last_shard = nullptr;
+    MeasArray *last_batch = nullptr;
+    for (auto it = begin; it != end; ++it) {
+      auto target_shard = get_shard_for_id(it->id);
+      if (target_shard == nullptr) {
+        *not_routed = *not_routed + Status(1, APPEND_ERROR::bad_shard);
+        continue;
+      }
+      if (target_shard != last_shard) {
+        last_shard = target_shard;
+        last_batch = &result[target_shard];
+      }
+      last_batch->push_back(*it);
+    }
+    return result;
+  }
+
   Status append(const Meas &value) override {
     IEngine_Ptr target_shard = get_shard_for_id(value.id);
 
@@ -317,6 +464,21 @@ public:
     }
   }
 
+  Status append(const MeasArray::const_iterator &begin,
+                const MeasArray::const_iterator &end) override {
+    Status result{};
+    auto shard2values = route(begin, end, &result);
+    for (auto &kv : shard2values) {
+      // subscribers get every writed value, even if a part of batch is ignored.
+      auto &values = kv.second;
+      result = result + kv.first->append(values.cbegin(), values.cend(),
+                                         [this](const Meas &v) {
+                                           _subscribe_notify.on_append(v);
+                                         });
+    }
+    return result;
+  }
+
   Time minTime() override {
     std::shared_lock<std::shared_mutex> lg(_locker);
     Time result = MAX_TIME;
@@ -338,16 +500,21 @@ public:
   }
 
   Id2MinMax_Ptr loadMinMax() {
-    std::shared_lock<std::shared_mutex> lg(_locker);
-    Id2MinMax_Ptr result = std::make_shared<Id2MinMax>();
-    for (auto &s : this->_sub_storages) {
-      auto subres = s.storage->loadMinMax();
+    std::vector<SubQuery<Id2MinMax_Ptr>> subqueries;
+    for (auto &s : subStorages()) {
+      subqueries.push_back([s]() { return s->loadMinMax(); });
+    }
+    MergeFunc<Id2MinMax_Ptr> merge = [](Id2MinMax_Ptr &result, Id2MinMax_Ptr &part) {
+      if (result == nullptr) {
+        result = std::make_shared<Id2MinMax>();
+      }
       auto f = [&result](const Id2MinMax::value_type &v) {
         result->insert(v.first, v.second);
       };
-      subres->apply(f);
-    }
-    return result;
+      part->apply(f);
+    };
+    auto result = scatter_gather(subqueries, merge, 0);
+    return result != nullptr ? result : std::make_shared<Id2MinMax>();
   }
 
   bool minMaxTime(Id id, Time *minResult, Time *maxResult) override {
@@ -359,69 +526,123 @@ public:
     }
   }
 
-  std::unordered_map<IEngine_Ptr, IdSet> makeStorage2iset(const IdArray &ids) {
-    std::unordered_map<IEngine_Ptr, IdSet> result;
+  std::unordered_map<IEngine_Ptr, IdArray> makeStorage2ids(const IdArray &ids) {
+    std::unordered_map<IEngine_Ptr, IdArray> result;
+    IdSet uniq_ids;
     for (auto id : ids) {
+      if (!uniq_ids.insert(id).second) {
+        continue;
+      }
       auto target_shard = get_shard_for_id(id);
       if (target_shard != nullptr) {
-        result[target_shard].insert(id);
+        result[target_shard].push_back(id);
       }
     }
+    return result;
+  }
 
-    ENSURE(result.size() <= this->_sub_storages.size());
+  std::list<IEngine_Ptr> subStorages() const {
+    std::shared_lock<std::shared_mutex> lg(_locker);
+    std::list<IEngine_Ptr> result;
+    for (auto &s : _sub_storages) {
+      result.push_back(s.storage);
+    }
     return result;
   }
 
-  Id2Cursor intervalReader(const QueryInterval &q) override {
-    Id2Cursor result;
-    std::unordered_map<IEngine_Ptr, IdSet> storage2iset = makeStorage2iset(q.ids);
+  /**
+  run sub-queries in the query pool and merge results, as they complete.
+  throw exception, if all sub-queries are not completed before the deadline.
+  */
+  template <class T>
+  T scatter_gather(const std::vector<SubQuery<T>> &subqueries, const MergeFunc<T> &merge,
+                   uint64_t timeout) {
+    if (timeout == 0) {
+      timeout = _settings->shard_query_timeout.value();
+    }
+    T result{};
+    if (subqueries.empty()) {
+      return result;
+    }
+    if (subqueries.size() == 1 && timeout == 0) {
+      auto part = subqueries.front()();
+      merge(result, part);
+      return result;
+    }
 
-    for (auto kv : storage2iset) {
-      auto target_shard = kv.first;
-      for (auto id : kv.second) {
-        QueryInterval local_q = q;
-        local_q.ids.resize(1);
-        local_q.ids[0] = id;
-        auto subresult = target_shard->intervalReader(local_q);
-        for (auto id2cursor : subresult) {
-          result[id2cursor.first] = id2cursor.second;
+    auto state = std::make_shared<GatherState<T>>();
+    state->pending = subqueries.size();
+    for (auto &sq : subqueries) {
+      AsyncTask at = [state, sq, merge](const ThreadInfo &) {
+        try {
+          auto part = sq();
+          std::lock_guard<std::mutex> lg(state->locker);
+          merge(state->result, part);
+        } catch (...) {
+          std::lock_guard<std::mutex> lg(state->locker);
+          if (state->error == nullptr) {
+            state->error = std::current_exception();
+          }
         }
+        std::lock_guard<std::mutex> lg(state->locker);
+        state->pending--;
+        state->cond.notify_all();
+        return false;
+      };
+      if (_query_pool->post(AT(at)) == nullptr) { // pool is stopped.
+        at(ThreadInfo{(ThreadKind)THREAD_KINDS::SHARD_QUERY, 0});
       }
     }
+
+    std::unique_lock<std::mutex> lk(state->locker);
+    auto all_done = [&state]() { return state->pending == 0; };
+    if (timeout == 0) {
+      state->cond.wait(lk, all_done);
+    } else if (!state->cond.wait_for(lk, std::chrono::milliseconds(timeout), all_done)) {
+      THROW_EXCEPTION("shard: query deadline exceeded. ", state->pending, " of ",
+                      subqueries.size(), " sub-queries are not completed.");
+    }
+    if (state->error != nullptr) {
+      std::rethrow_exception(state->error);
+    }
+    std::swap(result, state->result);
     return result;
   }
 
+  Id2Cursor intervalReader(const QueryInterval &q) override {
+    std::vector<SubQuery<Id2Cursor>> subqueries;
+    for (auto &kv : makeStorage2ids(q.ids)) {
+      auto target_shard = kv.first;
+      QueryInterval local_q = q;
+      local_q.ids = kv.second;
+      subqueries.push_back(
+          [target_shard, local_q]() { return target_shard->intervalReader(local_q); });
+    }
+    return scatter_gather<Id2Cursor>(subqueries, merge_maps<Id, Cursor_Ptr>, q.timeout);
+  }
+
   Id2Meas readTimePoint(const QueryTimePoint &q) override {
-    Id2Meas result;
-    std::unordered_map<IEngine_Ptr, IdSet> storage2iset = makeStorage2iset(q.ids);
-    for (auto kv : storage2iset) {
+    std::vector<SubQuery<Id2Meas>> subqueries;
+    for (auto &kv : makeStorage2ids(q.ids)) {
       auto target_shard = kv.first;
-      for (auto id : kv.second) {
-        QueryTimePoint local_q = q;
-        local_q.ids.resize(1);
-        local_q.ids[0] = id;
-        auto subresult = target_shard->readTimePoint(local_q);
-        for (auto id2time : subresult) {
-          result[id2time.first] = id2time.second;
-        }
-      }
+      QueryTimePoint local_q = q;
+      local_q.ids = kv.second;
+      subqueries.push_back(
+          [target_shard, local_q]() { return target_shard->readTimePoint(local_q); });
     }
-    return result;
+    return scatter_gather<Id2Meas>(subqueries, merge_maps<Id, Meas>, q.timeout);
   }
 
   Id2Meas currentValue(const IdArray &ids, const Flag &flag) override {
-    Id2Meas result;
-    std::unordered_map<IEngine_Ptr, IdSet> storage2iset = makeStorage2iset(ids);
-    for (auto kv : storage2iset) {
+    std::vector<SubQuery<Id2Meas>> subqueries;
+    for (auto &kv : makeStorage2ids(ids)) {
       auto target_shard = kv.first;
-      for (auto id : kv.second) {
-        auto subresult = target_shard->currentValue({id}, flag);
-        for (auto id2time : subresult) {
-          result[id2time.first] = id2time.second;
-        }
-      }
+      auto local_ids = kv.second;
+      subqueries.push_back([target_shard, local_ids, flag]() {
+        return target_shard->currentValue(local_ids, flag);
+      });
     }
-    return result;
+    return scatter_gather<Id2Meas>(subqueries, merge_maps<Id, Meas>, 0);
   }
 
   Statistic stat(const Id id, Time from, Time to) override {
@@ -433,10 +654,9 @@ public:
     }
   }
 
-  void fsck() override {
-    std::shared_lock<std::shared_mutex> lg(_locker);
-    for (auto &s : _sub_storages) {
-      s.storage->fsck();
+  void fsck(bool online) override {
+    for (auto &s : subStorages()) {
+      s->fsck(online);
     }
   }
 
@@ -472,6 +692,14 @@ public:
     return result;
   }
 
+  void flush() override {
+    _subscribe_notify.flush();
+    std::shared_lock<std::shared_mutex> lg(_locker);
+    for (auto s : _sub_storages) {
+      s.storage->flush();
+    }
+  }
+
   void wait_all_asyncs() override { ThreadManager::instance()->flush(); }
 
   void compress_all() override {
@@ -494,13 +722,18 @@ public:
   bool _stoped;
   bool _force_unlock;
   std::unordered_map<Id, IEngine_Ptr> _id2shard;
+  std::unordered_set<Id> _default_routed; // ids from _id2shard, routed to default shard.
   std::unordered_map<std::string, ShardEngine::Shard> _shards; // alias => shard
   std::unordered_map<std::string, IEngine_Ptr> _interval2shard;
 
   std::list<ShardRef> _sub_storages;
   IEngine_Ptr _default_shard;
+  RoutingTable_Ptr _routes; // read without _locker.
+  std::atomic<uint64_t> _routes_version;
+  size_t _not_published_routes;
   Settings_ptr _settings;
   mutable std::shared_mutex _locker;
+  std::unique_ptr<ThreadPool> _query_pool; // runs sub-queries of one query in parallel.
 
   SubscribeNotificator _subscribe_notify;
 };
@@ -516,6 +749,10 @@ void dariadb::ShardEngine::compress_all() {
   _impl->compress_all();
 }
 
+void ShardEngine::flush() {
+  _impl->flush();
+}
+
 void dariadb::ShardEngine::wait_all_asyncs() {
   _impl->wait_all_asyncs();
 }
@@ -536,6 +773,11 @@ std::list<ShardEngine::Shard> ShardEngine::shardList() {
   return _impl->shardList();
 }
 
+Status ShardEngine::append(const MeasArray::const_iterator &begin,
+                           const MeasArray::const_iterator &end) {
+  return _impl->append(begin, end);
+}
+
 Status ShardEngine::append(const Meas &value) {
   return _impl->append(value);
 }
@@ -572,8 +814,8 @@ Statistic ShardEngine::stat(const Id id, Time from, Time to) {
   return _impl->stat(id, from, to);
 }
 
-void ShardEngine::fsck() {
-  _impl->fsck();
+void ShardEngine::fsck(bool online) {
+  _impl->fsck(online);
 }
 
 void ShardEngine::eraseOld(const Id id, const Time t) {
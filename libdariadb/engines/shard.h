@@ -25,7 +25,12 @@ public:
   EXPORT std::list<Shard> shardList();
   EXPORT void shardRm(const std::string &alias, bool rm_shard_folder);
 
+  using IEngine::append;
   EXPORT Status append(const Meas &value) override;
+  /// values are splitted by shards and each shard gets one batch.
+  EXPORT Status append(const MeasArray::const_iterator &begin,
+                       const MeasArray::const_iterator &end) override;
+  EXPORT void flush() override;
   EXPORT Time minTime() override;
   EXPORT Time maxTime() override;
   EXPORT Id2MinMax_Ptr loadMinMax() override;
@@ -35,7 +40,7 @@ public:
   EXPORT Id2Meas currentValue(const IdArray &ids, const Flag &flag) override;
   EXPORT Statistic stat(const Id id, Time from, Time to) override;
 
-  EXPORT void fsck() override;
+  EXPORT void fsck(bool online = false) override;
   EXPORT void eraseOld(const Id id, const Time t) override;
   EXPORT void repack(dariadb::Id id) override;
   EXPORT void compact(ICompactionController *logic) override;
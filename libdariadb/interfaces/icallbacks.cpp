@@ -14,6 +14,12 @@ void IReadCallback::is_end() {
   is_end_called = true;
 }
 
+void IReadCallback::apply_batch(const MeasArray &ma) {
+  for (const auto &m : ma) {
+    apply(m);
+  }
+}
+
 void IReadCallback::wait() {
   while (!is_end_called) {
     utils::sleep_mls(300);
@@ -17,6 +17,7 @@ public:
   EXPORT void cancel();                  // called by user if want to stop operation.
   EXPORT bool is_canceled() const;       // true - if  `cancel` was called.
   virtual void apply(const Meas &m) = 0; // must be thread safety.
+  EXPORT virtual void apply_batch(const MeasArray &ma); // calls 'apply' for each value.
 protected:
   bool is_end_called;
   bool is_cancel;
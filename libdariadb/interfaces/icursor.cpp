@@ -41,4 +41,8 @@ Meas dariadb::ICursor::read_time_point(const QueryTimePoint &q) {
     }
   }
   return result;
-}
\ No newline at end of file
+}
+
+bool dariadb::ICursor::read_summary(Time, Time, Statistic *, Meas *, Meas *) {
+  return false;
+}
@@ -4,6 +4,7 @@
 #include <libdariadb/meas.h>
 #include <libdariadb/query.h>
 #include <libdariadb/st_exports.h>
+#include <libdariadb/stat.h>
 #include <libdariadb/utils/utils.h>
 #include <memory>
 #include <unordered_map>
@@ -30,6 +31,12 @@ public:
   EXPORT virtual void apply(IReadCallback *clbk);
   EXPORT virtual void apply(IReadCallback *clbk, const QueryInterval &q);
   EXPORT virtual Meas read_time_point(const QueryTimePoint &q);
+  /**
+  if the next values are a whole closed chunk inside [from, to], returns its
+  statistic, first and last values without unpacking and skips them.
+  */
+  EXPORT virtual bool read_summary(Time from, Time to, Statistic *st, Meas *first,
+                                   Meas *last);
 };
 
 using Id2Cursor = std::unordered_map<Id, Cursor_Ptr>;
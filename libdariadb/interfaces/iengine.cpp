@@ -69,4 +69,18 @@ void IEngine::repack(const scheme::IScheme_Ptr s) {
       this->repack(kv.first);
     }
   }
-}
\ No newline at end of file
+}
+utils::metrics::Snapshot IEngine::metrics() const {
+  auto d = description();
+  auto registry = utils::metrics::Registry::instance();
+  registry->gauge("engine.wal_files")->set(int64_t(d.wal_count));
+  registry->gauge("engine.pages")->set(int64_t(d.pages_count));
+  registry->gauge("engine.active_works")->set(int64_t(d.active_works));
+  registry->gauge("dropper.wal_queue")->set(int64_t(d.dropper.wal));
+  registry->gauge("memstorage.allocated_bytes")
+      ->set(int64_t(d.memstorage.allocated_bytes));
+  registry->gauge("memstorage.cached_bytes")->set(int64_t(d.memstorage.cached_bytes));
+  registry->gauge("memstorage.capacity_bytes")
+      ->set(int64_t(d.memstorage.allocator_capacity_bytes));
+  return registry->snapshot();
+}
@@ -5,6 +5,7 @@
 #include <libdariadb/storage/dropper_description.h>
 #include <libdariadb/storage/memstorage/description.h>
 #include <libdariadb/storage/settings.h>
+#include <libdariadb/utils/metrics.h>
 #include <memory>
 namespace dariadb {
 
@@ -35,10 +36,21 @@ public:
       dropper.wal += other.dropper.wal;
       memstorage.allocated += other.memstorage.allocated;
       memstorage.allocator_capacity = other.memstorage.allocator_capacity;
+      memstorage.allocated_bytes += other.memstorage.allocated_bytes;
+      memstorage.cached_bytes += other.memstorage.cached_bytes;
+      memstorage.allocator_capacity_bytes = other.memstorage.allocator_capacity_bytes;
+      memstorage.slab_size = other.memstorage.slab_size;
+      memstorage.slabs_used += other.memstorage.slabs_used;
+      memstorage.slabs_count += other.memstorage.slabs_count;
+      memstorage.occupancy = other.memstorage.occupancy;
+      memstorage.fragmentation = other.memstorage.fragmentation;
     }
   };
   virtual Description description() const = 0;
-  virtual void fsck() = 0;
+  /// process-wide metrics registry with gauges from description().
+  EXPORT virtual utils::metrics::Snapshot metrics() const;
+  /// online - check pages without lock of storage.
+  virtual void fsck(bool online = false) = 0;
   virtual void eraseOld(const Id id, const Time t) = 0;
   virtual void repack(dariadb::Id id) = 0;
   virtual void compact(ICompactionController *logic) = 0;
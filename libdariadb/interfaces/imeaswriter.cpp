@@ -16,4 +16,19 @@ Status IMeasWriter::append(const MeasArray::const_iterator &begin,
   return ar;
 }
 
+Status IMeasWriter::append(const MeasArray::const_iterator &begin,
+                           const MeasArray::const_iterator &end,
+                           const WritedCallback &on_writed) {
+  dariadb::Status ar{};
+
+  for (auto it = begin; it != end; ++it) {
+    auto subresult = this->append(*it);
+    if (subresult.writed == 1) {
+      on_writed(*it);
+    }
+    ar = ar + subresult;
+  }
+  return ar;
+}
+
 IMeasWriter::~IMeasWriter() {}
@@ -4,11 +4,14 @@
 #include <libdariadb/query.h>
 #include <libdariadb/st_exports.h>
 #include <libdariadb/status.h>
+#include <functional>
 #include <memory>
 
 namespace dariadb {
 class IMeasWriter {
 public:
+  typedef std::function<void(const Meas &)> WritedCallback;
+
   EXPORT Status append(Id i, Time t, Flag f, Value v) {
     Meas m;
     m.id = i;
@@ -25,6 +28,10 @@ public:
   EXPORT virtual void flush(Id id);
   EXPORT virtual Status append(const MeasArray::const_iterator &begin,
                                const MeasArray::const_iterator &end);
+  /// same as batch append, but 'on_writed' is called for each writed value.
+  EXPORT virtual Status append(const MeasArray::const_iterator &begin,
+                               const MeasArray::const_iterator &end,
+                               const WritedCallback &on_writed);
   EXPORT virtual ~IMeasWriter();
 };
 
@@ -1,7 +1,70 @@
 #include <libdariadb/query.h>
+#include <libdariadb/utils/exception.h>
+#include <libdariadb/utils/strings.h>
+#include <sstream>
 
-namespace dariadb {
-namespace query_inner {
-void empty_func_to_disable_warnings() {}
+std::istream &dariadb::operator>>(std::istream &in, DOWNSAMPLE &ds) {
+  std::string token;
+  in >> token;
+
+  token = utils::strings::to_upper(token);
+
+  if (token == "AVG") {
+    ds = DOWNSAMPLE::AVG;
+    return in;
+  }
+  if (token == "MIN") {
+    ds = DOWNSAMPLE::MIN;
+    return in;
+  }
+  if (token == "MAX") {
+    ds = DOWNSAMPLE::MAX;
+    return in;
+  }
+  if (token == "FIRST") {
+    ds = DOWNSAMPLE::FIRST;
+    return in;
+  }
+  if (token == "LAST") {
+    ds = DOWNSAMPLE::LAST;
+    return in;
+  }
+  if (token == "M4") {
+    ds = DOWNSAMPLE::M4;
+    return in;
+  }
+  THROW_EXCEPTION("query: bad downsample name - ", token);
 }
+
+std::ostream &dariadb::operator<<(std::ostream &stream, const DOWNSAMPLE &ds) {
+  switch (ds) {
+  case DOWNSAMPLE::AVG:
+    stream << "AVG";
+    break;
+  case DOWNSAMPLE::MIN:
+    stream << "MIN";
+    break;
+  case DOWNSAMPLE::MAX:
+    stream << "MAX";
+    break;
+  case DOWNSAMPLE::FIRST:
+    stream << "FIRST";
+    break;
+  case DOWNSAMPLE::LAST:
+    stream << "LAST";
+    break;
+  case DOWNSAMPLE::M4:
+    stream << "M4";
+    break;
+  default:
+    THROW_EXCEPTION("query: bad downsample - ", (uint16_t)ds);
+    break;
+  };
+  return stream;
+}
+
+std::string dariadb::to_string(const DOWNSAMPLE &ds) {
+  std::stringstream ss;
+  ss << ds;
+  return ss.str();
 }
@@ -1,26 +1,49 @@
 #pragma once
 
 #include <libdariadb/meas.h>
+#include <libdariadb/st_exports.h>
 #include <algorithm>
 #include <functional>
+#include <istream>
+#include <ostream>
+#include <string>
 
 namespace dariadb {
 
+/// value of one bucket, when QueryInterval::step != 0.
+enum class DOWNSAMPLE : uint8_t {
+  AVG = 0,
+  MIN,
+  MAX,
+  FIRST,
+  LAST,
+  M4 /// first, min, max and last values of bucket with their times (for charts).
+};
+
+EXPORT std::istream &operator>>(std::istream &in, DOWNSAMPLE &ds);
+EXPORT std::ostream &operator<<(std::ostream &stream, const DOWNSAMPLE &ds);
+EXPORT std::string to_string(const DOWNSAMPLE &ds);
+
 struct QueryParam {
   IdArray ids;
   Flag flag;
-  QueryParam(const IdArray &_ids, Flag _flag) : ids(_ids), flag(_flag) {}
+  uint64_t timeout; /// deadline in ms, used by shards. 0 - value from settings.
+  QueryParam(const IdArray &_ids, Flag _flag) : ids(_ids), flag(_flag), timeout(0) {}
 };
 
 struct QueryInterval : public QueryParam {
   Time from;
   Time to;
-  Time step; /// ignored in disk operations
+  Time step;             /// if not 0, engine returns one bucket per step.
+  DOWNSAMPLE downsample; /// value of bucket.
   QueryInterval(const IdArray &_ids, Flag _flag, Time _from, Time _to)
-      : QueryParam(_ids, _flag), from(_from), to(_to), step(0) {}
+      : QueryParam(_ids, _flag), from(_from), to(_to), step(0),
+        downsample(DOWNSAMPLE::AVG) {}
 
-  QueryInterval(const IdArray &_ids, Flag _flag, Time _from, Time _to, Time _step)
-      : QueryParam(_ids, _flag), from(_from), to(_to), step(_step) {}
+  QueryInterval(const IdArray &_ids, Flag _flag, Time _from, Time _to, Time _step,
+                DOWNSAMPLE _downsample = DOWNSAMPLE::AVG)
+      : QueryParam(_ids, _flag), from(_from), to(_to), step(_step),
+        downsample(_downsample) {}
 };
 
 struct QueryTimePoint : public QueryParam {
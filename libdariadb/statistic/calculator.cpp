@@ -67,12 +67,26 @@ MeasArray Calculator::apply(const Id id, Time from, Time to, Flag flag,
     }
   }
 
+  bool any_fused = false;
+  bool with_sigma = false;
+  for (auto f : all_functions) {
+    if (f != nullptr && f->is_fused()) {
+      any_fused = true;
+      with_sigma = with_sigma || f->need_sigma();
+    }
+  }
+  // one pass over values for average, minimum, maximum, count and sigma.
+  Summary summary;
+  if (any_fused) {
+    summary = summarize(ma, with_sigma);
+  }
+
   MeasArray result;
   result.reserve(functions.size());
   for (auto f : all_functions) {
     Meas m;
     if (f != nullptr) {
-      m = f->apply(ma);
+      m = f->is_fused() ? f->result(summary) : f->apply(ma);
     }
     m.id = id;
     m.flag = m.flag | FLAGS::_STATS;
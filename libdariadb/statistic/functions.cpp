@@ -1,5 +1,4 @@
 #include <libdariadb/statistic/functions.h>
-#include <cmath>
 
 using namespace dariadb;
 using namespace dariadb::statistic;
@@ -7,59 +6,51 @@ using namespace dariadb::statistic;
 Average::Average(const std::string &s) : IFunction(s) {}
 
 Meas Average::apply(const MeasArray &ma) {
-  Meas result;
-  size_t count = 0;
-  for (auto m : ma) {
-    result.id = m.id;
-    result.value += m.value;
-    result.time = std::max(result.time, m.time);
-    count++;
-  }
-  if (count == 0) {
+  return result(summarize(ma, false));
+}
+
+Meas Average::result(const Summary &s) {
+  if (s.count == 0) {
     return Meas();
   }
-  Meas m = result;
-  m.value = m.value / count;
-  return m;
+  Meas result;
+  result.id = s.last_id;
+  result.value = s.sum / s.count;
+  result.time = s.newest;
+  return result;
 }
 
 Minimum::Minimum(const std::string &s) : IFunction(s) {}
 
 Meas Minimum::apply(const MeasArray &ma) {
-  if (ma.size() == 0) {
+  return result(summarize(ma, false));
+}
+
+Meas Minimum::result(const Summary &s) {
+  if (s.count == 0) {
     return Meas();
   }
   Meas result;
-  result.value = MAX_VALUE;
-  result.time = MIN_TIME;
-  for (auto m : ma) {
-    result.id = m.id;
-    if (result.value >= m.value) {
-      result.value = m.value;
-      result.time = m.time;
-    }
-  }
-
+  result.id = s.last_id;
+  result.value = s.min;
+  result.time = s.min_time;
   return result;
 }
 
 Maximum::Maximum(const std::string &s) : IFunction(s) {}
 
 Meas Maximum::apply(const MeasArray &ma) {
-  if (ma.size() == 0) {
+  return result(summarize(ma, false));
+}
+
+Meas Maximum::result(const Summary &s) {
+  if (s.count == 0) {
     return Meas();
   }
   Meas result;
-  result.value = MIN_VALUE;
-  result.time = MIN_TIME;
-  for (auto m : ma) {
-    result.id = m.id;
-    if (result.value <= m.value) {
-      result.value = m.value;
-      result.time = m.time;
-    }
-  }
-
+  result.id = s.last_id;
+  result.value = s.max;
+  result.time = s.max_time;
   return result;
 }
 
@@ -74,28 +65,25 @@ Meas Count::apply(const MeasArray &ma) {
   return result;
 }
 
+Meas Count::result(const Summary &s) {
+  Meas result;
+  result.value = Value(s.count);
+  result.time = s.last_time;
+  return result;
+}
+
 StandartDeviation::StandartDeviation(const std::string &s) : IFunction(s) {}
 
 Meas StandartDeviation::apply(const MeasArray &ma) {
-  if (ma.empty()) {
-    return Meas();
-  }
-  auto collection_size = ma.size();
-
-  Value average_value = Value();
-  Time maxtime = MIN_TIME;
-  for (auto m : ma) {
-    average_value += m.value;
-    maxtime = std::max(maxtime, m.time);
-  }
-  average_value = average_value / collection_size;
+  return result(summarize(ma, true));
+}
 
-  Value sum_value = Value();
-  for (auto m : ma) {
-    sum_value += std::pow(m.value - average_value, 2);
+Meas StandartDeviation::result(const Summary &s) {
+  if (s.count == 0) {
+    return Meas();
   }
   Meas result;
-  result.value = std::sqrt(sum_value / collection_size);
-  result.time = maxtime;
+  result.value = s.sigma;
+  result.time = s.newest;
   return result;
 }
@@ -10,30 +10,41 @@ class Average : public IFunction {
 public:
   EXPORT Average(const std::string &s);
   EXPORT Meas apply(const MeasArray &ma) override;
+  bool is_fused() const override { return true; }
+  EXPORT Meas result(const Summary &s) override;
 };
 
 class Minimum : public IFunction {
 public:
   EXPORT Minimum(const std::string &s);
   EXPORT Meas apply(const MeasArray &ma) override;
+  bool is_fused() const override { return true; }
+  EXPORT Meas result(const Summary &s) override;
 };
 
 class Maximum : public IFunction {
 public:
   EXPORT Maximum(const std::string &s);
   EXPORT Meas apply(const MeasArray &ma) override;
+  bool is_fused() const override { return true; }
+  EXPORT Meas result(const Summary &s) override;
 };
 
 class Count : public IFunction {
 public:
   EXPORT Count(const std::string &s);
   EXPORT Meas apply(const MeasArray &ma) override;
+  bool is_fused() const override { return true; }
+  EXPORT Meas result(const Summary &s) override;
 };
 
 class StandartDeviation : public IFunction {
 public:
   EXPORT StandartDeviation(const std::string &s);
   EXPORT Meas apply(const MeasArray &ma) override;
+  bool is_fused() const override { return true; }
+  bool need_sigma() const override { return true; }
+  EXPORT Meas result(const Summary &s) override;
 };
 
 template <int percentile> class Percentile : public IFunction {
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <libdariadb/meas.h>
+#include <libdariadb/statistic/kernels.h>
 #include <memory>
 #include <string>
 
@@ -10,6 +11,10 @@ class IFunction {
 public:
   IFunction(const std::string &s) : _kindname(s) {}
   virtual Meas apply(const MeasArray &ma) = 0;
+  /// result can be taken from Summary, so one pass is shared by all such functions.
+  virtual bool is_fused() const { return false; }
+  virtual bool need_sigma() const { return false; }
+  virtual Meas result(const Summary &) { return Meas(); }
   std::string kind() const { return _kindname; };
 
 protected:
@@ -0,0 +1,218 @@
+#include <libdariadb/statistic/kernels.h>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define DARIADB_STATISTIC_AVX
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <immintrin.h>
+#endif
+#endif
+
+using namespace dariadb;
+using namespace dariadb::statistic;
+
+namespace {
+/// four independent accumulators: no dependency between neighbour values.
+void sum_min_max_generic(const Value *v, size_t count, Value *sum, Value *min,
+                         Value *max) {
+  Value s[4] = {0, 0, 0, 0};
+  Value mn[4] = {v[0], v[0], v[0], v[0]};
+  Value mx[4] = {v[0], v[0], v[0], v[0]};
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    for (size_t k = 0; k < 4; ++k) {
+      s[k] += v[i + k];
+      mn[k] = std::min(mn[k], v[i + k]);
+      mx[k] = std::max(mx[k], v[i + k]);
+    }
+  }
+  for (; i < count; ++i) {
+    s[0] += v[i];
+    mn[0] = std::min(mn[0], v[i]);
+    mx[0] = std::max(mx[0], v[i]);
+  }
+  *sum = (s[0] + s[1]) + (s[2] + s[3]);
+  *min = std::min(std::min(mn[0], mn[1]), std::min(mn[2], mn[3]));
+  *max = std::max(std::max(mx[0], mx[1]), std::max(mx[2], mx[3]));
+}
+
+Value squared_deviations_generic(const Value *v, size_t count, Value mean) {
+  Value s1[4] = {0, 0, 0, 0};
+  Value s2[4] = {0, 0, 0, 0};
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    for (size_t k = 0; k < 4; ++k) {
+      auto d = v[i + k] - mean;
+      s1[k] += d;
+      s2[k] += d * d;
+    }
+  }
+  for (; i < count; ++i) {
+    auto d = v[i] - mean;
+    s1[0] += d;
+    s2[0] += d * d;
+  }
+  auto sum_d = (s1[0] + s1[1]) + (s1[2] + s1[3]);
+  auto sum_d2 = (s2[0] + s2[1]) + (s2[2] + s2[3]);
+  return sum_d2 - sum_d * sum_d / count;
+}
+
+#ifdef DARIADB_STATISTIC_AVX
+#ifndef _MSC_VER
+__attribute__((target("avx")))
+#endif
+Value hsum(__m256d x) {
+  alignas(32) Value lanes[4];
+  _mm256_store_pd(lanes, x);
+  return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+}
+
+#ifndef _MSC_VER
+__attribute__((target("avx")))
+#endif
+void sum_min_max_avx(const Value *v, size_t count, Value *sum, Value *min, Value *max) {
+  // two sums hide latency of addition.
+  auto s0 = _mm256_setzero_pd();
+  auto s1 = _mm256_setzero_pd();
+  auto mn = _mm256_set1_pd(v[0]);
+  auto mx = mn;
+  size_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    auto a = _mm256_loadu_pd(v + i);
+    auto b = _mm256_loadu_pd(v + i + 4);
+    s0 = _mm256_add_pd(s0, a);
+    s1 = _mm256_add_pd(s1, b);
+    mn = _mm256_min_pd(mn, _mm256_min_pd(a, b));
+    mx = _mm256_max_pd(mx, _mm256_max_pd(a, b));
+  }
+  alignas(32) Value lanes_min[4], lanes_max[4];
+  _mm256_store_pd(lanes_min, mn);
+  _mm256_store_pd(lanes_max, mx);
+  Value s = hsum(_mm256_add_pd(s0, s1));
+  Value vmin = std::min(std::min(lanes_min[0], lanes_min[1]),
+                        std::min(lanes_min[2], lanes_min[3]));
+  Value vmax = std::max(std::max(lanes_max[0], lanes_max[1]),
+                        std::max(lanes_max[2], lanes_max[3]));
+  for (; i < count; ++i) {
+    s += v[i];
+    vmin = std::min(vmin, v[i]);
+    vmax = std::max(vmax, v[i]);
+  }
+  *sum = s;
+  *min = vmin;
+  *max = vmax;
+}
+
+#ifndef _MSC_VER
+__attribute__((target("avx")))
+#endif
+Value squared_deviations_avx(const Value *v, size_t count, Value mean) {
+  auto m = _mm256_set1_pd(mean);
+  auto s1 = _mm256_setzero_pd();
+  auto s2 = _mm256_setzero_pd();
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    auto d = _mm256_sub_pd(_mm256_loadu_pd(v + i), m);
+    s1 = _mm256_add_pd(s1, d);
+    s2 = _mm256_add_pd(s2, _mm256_mul_pd(d, d));
+  }
+  Value sum_d = hsum(s1);
+  Value sum_d2 = hsum(s2);
+  for (; i < count; ++i) {
+    auto d = v[i] - mean;
+    sum_d += d;
+    sum_d2 += d * d;
+  }
+  return sum_d2 - sum_d * sum_d / count;
+}
+
+bool cpu_has_avx() {
+#ifdef _MSC_VER
+  int info[4];
+  __cpuid(info, 1);
+  const int osxsave_and_avx = (1 << 27) | (1 << 28);
+  return (info[2] & osxsave_and_avx) == osxsave_and_avx;
+#else
+  return __builtin_cpu_supports("avx");
+#endif
+}
+#endif
+
+bool use_avx() {
+#ifdef DARIADB_STATISTIC_AVX
+  static const bool result = cpu_has_avx();
+  return result;
+#else
+  return false;
+#endif
+}
+}
+
+void kernels::sum_min_max(const Value *values, size_t count, Value *sum, Value *min,
+                          Value *max) {
+#ifdef DARIADB_STATISTIC_AVX
+  if (use_avx()) {
+    sum_min_max_avx(values, count, sum, min, max);
+    return;
+  }
+#endif
+  sum_min_max_generic(values, count, sum, min, max);
+}
+
+Value kernels::squared_deviations(const Value *values, size_t count, Value mean) {
+#ifdef DARIADB_STATISTIC_AVX
+  if (use_avx()) {
+    return squared_deviations_avx(values, count, mean);
+  }
+#endif
+  return squared_deviations_generic(values, count, mean);
+}
+
+const char *kernels::isa() {
+  return use_avx() ? "avx" : "generic";
+}
+
+Summary dariadb::statistic::summarize(const MeasArray &ma, bool with_sigma) {
+  Summary result;
+  if (ma.empty()) {
+    return result;
+  }
+  auto count = ma.size();
+  // values of packed measurements to contiguous array for kernels.
+  std::vector<Value> values(count);
+  Time newest = MIN_TIME;
+  for (size_t i = 0; i < count; ++i) {
+    values[i] = ma[i].value;
+    newest = std::max(newest, ma[i].time);
+  }
+  result.count = count;
+  result.newest = newest;
+  result.last_time = ma.back().time;
+  result.last_id = ma.back().id;
+  kernels::sum_min_max(values.data(), count, &result.sum, &result.min, &result.max);
+
+  // the last of equal extremums, like a sequential scan does.
+  bool min_found = false;
+  bool max_found = false;
+  for (size_t i = count; i > 0 && !(min_found && max_found); --i) {
+    if (!min_found && values[i - 1] == result.min) {
+      result.min_time = ma[i - 1].time;
+      min_found = true;
+    }
+    if (!max_found && values[i - 1] == result.max) {
+      result.max_time = ma[i - 1].time;
+      max_found = true;
+    }
+  }
+
+  if (with_sigma) {
+    auto mean = result.sum / count;
+    auto m2 = kernels::squared_deviations(values.data(), count, mean);
+    result.sigma = std::sqrt(std::max(m2, Value()) / count);
+  }
+  return result;
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <libdariadb/meas.h>
+#include <libdariadb/st_exports.h>
+
+namespace dariadb {
+namespace statistic {
+
+/// fused functions of values: Calculator computes them by one pass for all.
+struct Summary {
+  size_t count;
+  Value sum;
+  Value min;
+  Value max;
+  Value sigma;    /// population standard deviation. only if requested.
+  Time min_time;  /// time of the last minimum.
+  Time max_time;  /// time of the last maximum.
+  Time last_time; /// time of the last value.
+  Time newest;    /// maximum of times.
+  Id last_id;
+
+  Summary() {
+    count = size_t(0);
+    sum = min = max = sigma = Value();
+    min_time = max_time = last_time = newest = Time();
+    last_id = Id();
+  }
+};
+
+EXPORT Summary summarize(const MeasArray &ma, bool with_sigma);
+
+namespace kernels {
+/// sum, min and max of contiguous values. count must be greater than 0.
+EXPORT void sum_min_max(const Value *values, size_t count, Value *sum, Value *min,
+                        Value *max);
+/// sum of (value - mean)^2, corrected by the rounding error of mean (two-pass
+/// algorithm with compensation).
+EXPORT Value squared_deviations(const Value *values, size_t count, Value mean);
+/// name of implementation, selected for this cpu: "avx" or "generic".
+EXPORT const char *isa();
+} // namespace kernels
+} // namespace statistic
+} // namespace dariadb
@@ -21,6 +21,7 @@ struct Status {
   }
 
   Status(size_t ig, APPEND_ERROR err) {
+    writed = size_t(0);
     ignored = ig;
     error = err;
   }
@@ -11,6 +11,20 @@ using namespace dariadb::utils;
 using namespace dariadb::storage;
 using namespace dariadb::compression;
 
+namespace {
+/// values of sorted chunk inside [from, to] are described by its header.
+bool chunk_summary(const ChunkHeader *hdr, Time from, Time to, Statistic *st,
+                   Meas *first, Meas *last) {
+  if (!hdr->is_sorted || hdr->stat.minTime < from || hdr->stat.maxTime > to) {
+    return false;
+  }
+  *st = hdr->stat;
+  *first = hdr->first();
+  *last = hdr->last();
+  return true;
+}
+}
+
 class ChunkReader : public ICursor {
 public:
   ChunkReader() = delete;
@@ -68,6 +82,19 @@ public:
 
   Time maxTime() override { return _chunk->header->stat.maxTime; }
 
+  bool read_summary(Time from, Time to, Statistic *st, Meas *first,
+                    Meas *last) override {
+    // chunk of memstorage can be appended after the reader was created.
+    if (!_top_value_exists || _count + 1 != _values_count ||
+        _chunk->header->stat.count != _values_count ||
+        !chunk_summary(_chunk->header, from, to, st, first, last)) {
+      return false;
+    }
+    _count = 0;
+    _top_value_exists = false;
+    return true;
+  }
+
   size_t _values_count;
   bool _top_value_exists;
   Meas _top_value;
@@ -77,6 +104,24 @@ public:
   std::shared_ptr<CopmressedReader> _compressed_rdr;
 };
 
+/// unpacked columns of closed chunk.
+class ColumnsChunkReader : public FullCursor {
+public:
+  ColumnsChunkReader(MeasArray &ma, const Chunk_Ptr &c) : FullCursor(ma), _chunk(c) {}
+
+  bool read_summary(Time from, Time to, Statistic *st, Meas *first,
+                    Meas *last) override {
+    if (_index != size_t(0) ||
+        !chunk_summary(_chunk->header, from, to, st, first, last)) {
+      return false;
+    }
+    _index = _ma.size();
+    return true;
+  }
+
+  Chunk_Ptr _chunk;
+};
+
 Chunk_Ptr Chunk::create(ChunkHeader *hdr, uint8_t *buffer, uint32_t _size,
                         const Meas &first_m) {
   return Chunk_Ptr{new Chunk(hdr, buffer, _size, first_m)};
@@ -112,6 +157,8 @@ Chunk::Chunk(ChunkHeader *hdr, uint8_t *buffer, uint32_t _size, const Meas &firs
   header->stat.update(first_m);
 
   header->is_sorted = uint8_t(1);
+  header->checksum_kind = uint8_t(CHECKSUM_DEFAULT);
+  header->codec = uint8_t(CHUNK_CODEC::DELTA_XOR);
 
   std::fill(_buffer_t, _buffer_t + header->size, 0);
   is_owner = false;
@@ -155,14 +202,45 @@ bool Chunk::checkChecksum() {
   return exists == calculated;
 }
 
-void Chunk::close() {}
+void Chunk::close() {
+  // compacted or already closed chunk.
+  if (header->bw_pos == 0 || CHUNK_CODEC(header->codec) != CHUNK_CODEC::DELTA_XOR) {
+    return;
+  }
+  MeasArray values(header->stat.count);
+  values[0] = header->first();
+  auto b_ptr = std::make_shared<compression::ByteBuffer>(this->bw->get_range());
+  CopmressedReader rdr(b_ptr, header->first());
+  for (size_t i = 1; i < values.size(); ++i) {
+    values[i] = rdr.read();
+  }
+
+  std::vector<uint8_t> packed;
+  compression::packColumns(values, packed);
+  auto used_space = header->size - header->bw_pos + 1;
+  if (packed.size() >= used_space) {
+    return;
+  }
+  // columns are in the tail of buffer, like a data of streaming writer.
+  std::fill(_buffer_t, _buffer_t + header->size, uint8_t(0));
+  auto packed_begin = header->size - uint32_t(packed.size());
+  std::copy(packed.begin(), packed.end(), _buffer_t + packed_begin);
+  header->bw_pos = packed_begin + 1;
+  header->codec = uint8_t(CHUNK_CODEC::COLUMNS);
+}
 
 void Chunk::updateChecksum(ChunkHeader &hdr, u8vector buff) {
-  hdr.crc = utils::crc32(buff, hdr.size);
+  hdr.crc = calcChecksum(hdr, buff);
 }
 
 uint32_t Chunk::calcChecksum(ChunkHeader &hdr, u8vector buff) {
-  return utils::crc32(buff, hdr.size);
+  switch (CHECKSUM_KIND(hdr.checksum_kind)) {
+  case CHECKSUM_KIND::CRC32:
+    return utils::crc32(buff, hdr.size);
+  case CHECKSUM_KIND::CRC32C:
+    return utils::crc32c(buff, hdr.size);
+  }
+  THROW_EXCEPTION("unknown checksum kind: ", int(hdr.checksum_kind));
 }
 uint32_t Chunk::calcChecksum() {
   return Chunk::calcChecksum(*header, this->_buffer_t);
@@ -192,7 +270,6 @@ bool Chunk::append(const Meas &m) {
   auto t_f = this->c_writer.append(m);
 
   if (!t_f) {
-    this->close();
     ENSURE(c_writer.isFull());
     return false;
   } else {
@@ -209,6 +286,23 @@ bool Chunk::append(const Meas &m) {
 }
 
 Cursor_Ptr Chunk::getReader() {
+  if (CHUNK_CODEC(header->codec) == CHUNK_CODEC::COLUMNS) {
+    auto all = compression::unpackColumns(header->meas_id, _buffer_t,
+                                          _buffer_t + header->size, header->stat.count);
+    // like a ChunkReader: first of values with equal time.
+    MeasArray ma;
+    ma.reserve(all.size());
+    for (const auto &m : all) {
+      if (ma.empty() || ma.back().time != m.time) {
+        ma.push_back(m);
+      }
+    }
+    if (!header->is_sorted) {
+      std::sort(ma.begin(), ma.end(), meas_time_compare_less());
+    }
+    return Cursor_Ptr{new ColumnsChunkReader(ma, shared_from_this())};
+  }
+
   auto b_ptr = std::make_shared<compression::ByteBuffer>(this->bw->get_range());
   auto raw_res =
       new ChunkReader(this->header->stat.count - 1, shared_from_this(), b_ptr,
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <libdariadb/compression/bytebuffer.h>
+#include <libdariadb/compression/codecs.h>
 #include <libdariadb/compression/compression.h>
 #include <libdariadb/interfaces/icursor.h>
 #include <libdariadb/meas.h>
@@ -17,6 +18,14 @@
 
 namespace dariadb {
 namespace storage {
+/// algorithm of ChunkHeader::crc.
+enum class CHECKSUM_KIND : uint8_t {
+  CRC32 = 0, /// all chunks, writed before CHECKSUM_KIND was added.
+  CRC32C = 1
+};
+/// for new chunks.
+const CHECKSUM_KIND CHECKSUM_DEFAULT = CHECKSUM_KIND::CRC32C;
+
 #pragma pack(push, 1)
 struct MeasData {
   Id id;
@@ -32,12 +41,14 @@ struct ChunkHeader {
   uint32_t bw_pos;                /// needed for unpack.
 
   uint32_t size; /// size of buffer with values.
-  uint32_t crc;  /// checksum.
+  uint32_t crc;  /// checksum, algorithm is in checksum_kind.
 
   uint64_t offset_in_page; /// pos in page file.
 
   Statistic stat;
-  uint8_t is_sorted;
+  uint8_t is_sorted : 1;
+  uint8_t checksum_kind : 3; /// CHECKSUM_KIND. was a part of is_sorted byte.
+  uint8_t codec : 4;         /// compression::CHUNK_CODEC. zero in old pages.
   Meas first() const {
     Meas m(meas_id);
     m.flag = data_first.flag;
@@ -88,6 +99,7 @@ public:
   EXPORT bool append(const Meas &m);
   EXPORT bool isFull() const;
   EXPORT Cursor_Ptr getReader();
+  /// select codec by trial compression. closed chunk can`t be appended.
   EXPORT void close();
   EXPORT uint32_t calcChecksum();
   EXPORT uint32_t getChecksum();
@@ -105,6 +117,8 @@ public:
   compression::ByteBuffer_Ptr bw;
   compression::CopmressedWriter c_writer;
   bool is_owner; // true - dealloc memory for header and buffer.
+  /// keeps alive memory of header and buffer, if chunk is not owner (mapped page).
+  std::shared_ptr<const void> memory_holder;
 };
 
 typedef std::list<Chunk_Ptr> ChunksList;
@@ -4,6 +4,12 @@ using namespace dariadb;
 
 IChunkStorage::~IChunkStorage() {}
 
+void IChunkStorage::appendChunksAndPublish(const std::vector<storage::Chunk *> &a,
+                                           const std::function<void()> &on_publish) {
+  appendChunks(a);
+  on_publish();
+}
+
 ChunkContainer::ChunkContainer() {}
 ChunkContainer::~ChunkContainer() {}
 
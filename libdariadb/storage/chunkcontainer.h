@@ -6,6 +6,7 @@
 #include <libdariadb/query.h>
 #include <libdariadb/st_exports.h>
 #include <libdariadb/storage/chunk.h>
+#include <functional>
 
 namespace dariadb {
 
@@ -23,6 +24,9 @@ using ChunkLinkList = std::list<ChunkLink>;
 class IChunkStorage {
 public:
   virtual void appendChunks(const std::vector<storage::Chunk *> &a) = 0;
+  /// on_publish is called in the version, where chunks become visible.
+  EXPORT virtual void appendChunksAndPublish(const std::vector<storage::Chunk *> &a,
+                                             const std::function<void()> &on_publish);
   EXPORT ~IChunkStorage();
 };
 
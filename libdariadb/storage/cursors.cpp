@@ -1,15 +1,20 @@
 #include <libdariadb/flags.h>
 #include <libdariadb/storage/cursors.h>
+#include <libdariadb/utils/metrics.h>
 #include <libdariadb/utils/utils.h>
 #include <algorithm>
-#include <map>
-#include <set>
 
 using namespace dariadb;
 using namespace dariadb::storage;
 
 namespace cursors_inner {
 
+utils::metrics::Histogram *merge_fanin() {
+  static auto result =
+      utils::metrics::Registry::instance()->histogram("cursors.merge_fanin");
+  return result;
+}
+
 Time get_top_time(ICursor *r) {
   if (r->is_end()) {
     return MAX_TIME;
@@ -146,6 +151,8 @@ MergeSortCursor::MergeSortCursor(const CursorsList &readers) {
     _values_count += r->count();
   }
 
+  cursors_inner::merge_fanin()->record(_readers.size());
+
   _top_times.resize(_readers.size());
   _is_end_status.resize(_top_times.size());
   cursors_inner::fill_top_times(_top_times, _readers);
@@ -277,54 +284,198 @@ size_t LinearCursor::count() const {
   return _values_count;
 }
 
-Cursor_Ptr CursorWrapperFactory::colapseCursors(const CursorsList &readers_list) {
-  std::vector<Cursor_Ptr> readers_vector{readers_list.begin(), readers_list.end()};
-  typedef std::set<size_t> positions_set;
-  std::map<size_t, positions_set> overlapped;
-  positions_set processed_pos;
+bool LinearCursor::read_summary(Time from, Time to, Statistic *st, Meas *first,
+                                Meas *last) {
+  if (is_end() || !_readers.front()->read_summary(from, to, st, first, last)) {
+    return false;
+  }
+  if (_readers.front()->is_end()) {
+    _readers.pop_front();
+  }
+  return true;
+}
 
-  CursorsList result_readers;
-  for (size_t i = 0; i < readers_vector.size(); ++i) {
-    bool have_overlap = false;
-    for (size_t j = 0; j < readers_vector.size(); ++j) {
-      if (i != j) {
-        bool is_not_processed = processed_pos.find(j) == processed_pos.end();
-        if (!is_linear_readers(readers_vector[i], readers_vector[j]) &&
-            is_not_processed) {
-          processed_pos.insert(i);
-          processed_pos.insert(j);
-
-          // i - can be already in list, because i overlapped with other reader.
-          bool already_in_list = false;
-          for (auto &kv : overlapped) {
-            if (kv.second.find(i) != kv.second.end()) {
-              already_in_list = true;
-              kv.second.insert(j);
-              break;
-            }
-          }
-          if (!already_in_list) {
-            overlapped[i].insert(j);
-          }
-          have_overlap = true;
-        }
+DownsampleCursor::DownsampleCursor(const Cursor_Ptr &source, const QueryInterval &q)
+    : _source(source), _q(q) {
+  ENSURE(_q.step != Time(0));
+  ENSURE(_q.from <= _q.to);
+  _bucket_empty = true;
+  fill();
+}
+
+void DownsampleCursor::add(const Meas &m) {
+  if (_bucket_empty) {
+    _bucket_empty = false;
+    _bucket.stat = Statistic();
+    _bucket.first = _bucket.min = _bucket.max = m;
+  }
+  _bucket.stat.update(m);
+  _bucket.last = m;
+  if (m.value < _bucket.min.value) {
+    _bucket.min = m;
+  }
+  if (m.value > _bucket.max.value) {
+    _bucket.max = m;
+  }
+}
+
+void DownsampleCursor::flush() {
+  if (_bucket_empty) {
+    return;
+  }
+  _bucket_empty = true;
+  if (_q.downsample == DOWNSAMPLE::M4) {
+    std::vector<Meas> points{_bucket.first, _bucket.min, _bucket.max, _bucket.last};
+    std::sort(points.begin(), points.end(), meas_time_compare_less());
+    for (auto &p : points) {
+      if (_output.empty() || _output.back().time != p.time) {
+        _output.push_back(p);
+      }
+    }
+    return;
+  }
+  auto result = _bucket.first;
+  result.time = _bucket.begin;
+  switch (_q.downsample) {
+  case DOWNSAMPLE::AVG:
+    result.value = _bucket.stat.sum / _bucket.stat.count;
+    break;
+  case DOWNSAMPLE::MIN:
+    result.value = _bucket.stat.minValue;
+    break;
+  case DOWNSAMPLE::MAX:
+    result.value = _bucket.stat.maxValue;
+    break;
+  case DOWNSAMPLE::FIRST:
+    break;
+  case DOWNSAMPLE::LAST:
+    result.value = _bucket.last.value;
+    result.flag = _bucket.last.flag;
+    break;
+  default:
+    THROW_EXCEPTION("downsample: unknown kind - ", (uint16_t)_q.downsample);
+  }
+  _output.push_back(result);
+}
+
+void DownsampleCursor::fill() {
+  // M4 needs times of min and max, they are not in chunk statistic.
+  const bool use_summary = _q.downsample != DOWNSAMPLE::M4 && _q.flag == Flag(0);
+  while (_output.empty() && !_source->is_end()) {
+    auto t = _source->top().time;
+    if (t > _q.to) {
+      break;
+    }
+    if (t < _q.from) {
+      _source->readNext();
+      continue;
+    }
+    auto begin = _q.from + ((t - _q.from) / _q.step) * _q.step;
+    if (!_bucket_empty && begin != _bucket.begin) {
+      flush();
+    }
+    _bucket.begin = begin;
+    // bucket ends at begin + step - 1, but not after the end of query.
+    auto end = (_q.to - begin) < _q.step ? _q.to : begin + _q.step - 1;
+
+    Statistic st;
+    Meas first, last;
+    if (use_summary && _source->read_summary(begin, end, &st, &first, &last)) {
+      if (_bucket_empty) {
+        _bucket_empty = false;
+        _bucket.stat = st;
+        _bucket.first = first;
+      } else {
+        _bucket.stat.update(st);
       }
+      _bucket.last = last;
+      continue;
     }
-    if (processed_pos.find(i) == processed_pos.end() && !have_overlap) {
-      result_readers.emplace_back(readers_vector[i]);
+
+    auto m = _source->readNext();
+    if (m.inQuery(_q.ids, _q.flag)) {
+      add(m);
     }
   }
+  if (_output.empty()) {
+    flush();
+  }
+}
+
+Meas DownsampleCursor::readNext() {
+  ENSURE(!is_end());
+  auto result = _output.front();
+  _output.pop_front();
+  if (_output.empty()) {
+    fill();
+  }
+  return result;
+}
+
+bool DownsampleCursor::is_end() const {
+  return _output.empty();
+}
+
+Meas DownsampleCursor::top() {
+  ENSURE(!is_end());
+  return _output.front();
+}
+
+Time DownsampleCursor::minTime() {
+  return std::max(_source->minTime(), _q.from);
+}
+
+Time DownsampleCursor::maxTime() {
+  return std::min(_source->maxTime(), _q.to);
+}
+
+size_t DownsampleCursor::count() const {
+  auto per_bucket = _q.downsample == DOWNSAMPLE::M4 ? size_t(4) : size_t(1);
+  auto buckets = (_q.to - _q.from) / _q.step + 1;
+  auto source_count = _source->count();
+  if (buckets >= source_count) {
+    return source_count;
+  }
+  return std::min(source_count, size_t(buckets) * per_bucket);
+}
 
-  for (auto kv : overlapped) {
-    CursorsList rs;
-    rs.emplace_back(readers_vector[kv.first]);
-    for (size_t pos : kv.second) {
-      rs.emplace_back(readers_vector[pos]);
+Cursor_Ptr CursorWrapperFactory::colapseCursors(const CursorsList &readers_list) {
+  // sweep line: readers sorted by minTime, a group is closed when next reader
+  // starts after the end of the group. groups are not overlapped and ordered by time.
+  struct Interval {
+    Time minTime;
+    Time maxTime;
+    Cursor_Ptr reader;
+  };
+  std::vector<Interval> intervals;
+  intervals.reserve(readers_list.size());
+  for (auto &r : readers_list) {
+    intervals.push_back(Interval{r->minTime(), r->maxTime(), r});
+  }
+  std::stable_sort(intervals.begin(), intervals.end(),
+                   [](const Interval &l, const Interval &r) {
+                     return l.minTime < r.minTime;
+                   });
+
+  CursorsList result_readers;
+  CursorsList group;
+  Time group_max = MIN_TIME;
+  auto close_group = [&result_readers, &group]() {
+    if (group.size() == size_t(1)) {
+      result_readers.emplace_back(group.front());
+    } else if (!group.empty()) {
+      result_readers.emplace_back(Cursor_Ptr{new MergeSortCursor(group)});
+    }
+    group.clear();
+  };
+  for (auto &i : intervals) {
+    if (!group.empty() && i.minTime > group_max) {
+      close_group();
     }
-    MergeSortCursor *msr = new MergeSortCursor(rs);
-    Cursor_Ptr rptr{msr};
-    result_readers.emplace_back(rptr);
+    group_max = group.empty() ? i.maxTime : std::max(group_max, i.maxTime);
+    group.emplace_back(i.reader);
   }
+  close_group();
 
   LinearCursor *lsr = new LinearCursor(result_readers);
   Cursor_Ptr rptr{lsr};
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <libdariadb/interfaces/icursor.h>
+#include <deque>
 #include <list>
 #include <vector>
 
@@ -62,6 +63,8 @@ public:
   EXPORT Time minTime() override;
   EXPORT Time maxTime() override;
   EXPORT size_t count() const override;
+  EXPORT bool read_summary(Time from, Time to, Statistic *st, Meas *first,
+                           Meas *last) override;
 
   size_t _values_count;
   std::list<Cursor_Ptr> _readers;
@@ -69,6 +72,39 @@ public:
   Time _maxTime;
 };
 
+/**
+One value (or four for M4) per QueryInterval::step, computed while streaming.
+bucket of aggregate modes has time of its begin; whole chunks inside a bucket
+are taken from chunk statistic without unpacking.
+*/
+class DownsampleCursor : public ICursor {
+public:
+  EXPORT DownsampleCursor(const Cursor_Ptr &source, const QueryInterval &q);
+  EXPORT virtual Meas readNext() override;
+  EXPORT bool is_end() const override;
+  EXPORT Meas top() override;
+  EXPORT Time minTime() override;
+  EXPORT Time maxTime() override;
+  EXPORT size_t count() const override;
+
+protected:
+  struct Bucket {
+    Time begin;
+    Statistic stat;
+    Meas first, last, min, max;
+  };
+
+  void fill();
+  void add(const Meas &m);
+  void flush();
+
+  Cursor_Ptr _source;
+  QueryInterval _q;
+  bool _bucket_empty;
+  Bucket _bucket;
+  std::deque<Meas> _output;
+};
+
 /**
 make LinearCursor or MergSortCursor
 */
@@ -4,6 +4,7 @@
 #include <libdariadb/storage/settings.h>
 #include <libdariadb/utils/async/thread_manager.h>
 #include <ctime>
+#include <set>
 
 using namespace dariadb;
 using namespace dariadb::storage;
@@ -18,6 +19,10 @@ Dropper::Dropper(EngineEnvironment_ptr engine_env, PageManager_ptr page_manager,
   _is_stoped = false;
   _settings =
       _engine_env->getResourceObject<Settings>(EngineEnvironment::Resource::SETTINGS);
+  auto registry = metrics::Registry::instance();
+  _read_latency = registry->histogram("dropper.read_ns");
+  _sort_latency = registry->histogram("dropper.sort_ns");
+  _write_latency = registry->histogram("dropper.write_ns");
   _thread_handle = std::thread(&Dropper::drop_wal_internal, this);
 }
 
@@ -59,12 +64,23 @@ void Dropper::dropWAL(const std::string &fname) {
   }
 }
 
-void Dropper::cleanStorage(const std::string &storagePath) {
+void Dropper::cleanStorage(const std::string &storagePath, Manifest *manifest) {
   logger_info("engine: dropper - check storage ", storagePath);
   auto wals_lst = fs::ls(storagePath, WAL_FILE_EXT);
   auto page_lst = fs::ls(storagePath, PAGE_FILE_EXT);
 
+  std::set<std::string> wals_in_manifest;
+  for (auto &w : manifest->wal_list()) {
+    wals_in_manifest.insert(w.fname);
+  }
+
   for (auto &wal : wals_lst) {
+    // removing of dropped wal is delayed, while old storage versions are used.
+    if (wals_in_manifest.find(fs::extract_filename(wal)) == wals_in_manifest.end()) {
+      logger_info("engine: fsck rm dropped wal ", wal);
+      fs::rm(wal);
+      continue;
+    }
     auto wal_fname = fs::filename(wal);
     for (auto &pagef : page_lst) {
       auto page_fname = fs::filename(pagef);
@@ -148,6 +164,7 @@ void Dropper::drop_stage_read(std::string fname) {
     ENSURE(_active_operations == 1);
     logger_info("engine", _settings->alias, ": compressing ", fname);
     auto start_time = clock();
+    metrics::ScopedTimer timer(_read_latency);
 
     auto storage_path = _settings->raw_path.value();
     auto full_path = fs::append_path(storage_path, fname);
@@ -174,7 +191,10 @@ void Dropper::drop_stage_sort(std::string fname, clock_t start_time,
                               std::shared_ptr<MeasArray> ma) {
   try {
     ENSURE(_active_operations == 1);
-    std::sort(ma->begin(), ma->end(), meas_time_compare_less());
+    {
+      metrics::ScopedTimer timer(_sort_latency);
+      std::sort(ma->begin(), ma->end(), meas_time_compare_less());
+    }
 
     AsyncTask write_at = [this, start_time, fname, ma](const ThreadInfo &ti) {
       TKIND_CHECK(THREAD_KINDS::DISK_IO, ti.kind);
@@ -197,7 +217,12 @@ void Dropper::drop_stage_compress(std::string fname, clock_t start_time,
     auto without_path = fs::extract_filename(fname);
     auto page_fname = fs::filename(without_path);
 
-    on_create_complete_callback callback = [this, fname, start_time](const Page_Ptr &) {
+    auto write_start = metrics::enabled() ? metrics::now_ns() : uint64_t(0);
+    on_create_complete_callback callback = [this, fname, start_time,
+                                            write_start](const Page_Ptr &) {
+      if (write_start != uint64_t(0)) {
+        _write_latency->record(metrics::now_ns() - write_start);
+      }
       this->_wal_manager->erase(fname);
       auto end = clock();
       auto elapsed = double(end - start_time) / CLOCKS_PER_SEC;
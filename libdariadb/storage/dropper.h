@@ -2,8 +2,10 @@
 
 #include <libdariadb/storage/dropper_description.h>
 #include <libdariadb/storage/engine_environment.h>
+#include <libdariadb/storage/manifest.h>
 #include <libdariadb/storage/pages/page_manager.h>
 #include <libdariadb/storage/wal/wal_manager.h>
+#include <libdariadb/utils/metrics.h>
 #include <condition_variable>
 #include <list>
 #include <mutex>
@@ -24,10 +26,12 @@ public:
   void dropWAL(const std::string &fname) override;
 
   void flush();
-  // 1. rm PAGE files with name exists WAL file.
-  static void cleanStorage(const std::string &storagePath);
+  // 1. rm WAL files, which are not in manifest (dropped, but not removed).
+  // 2. rm PAGE files with name exists WAL file.
+  static void cleanStorage(const std::string &storagePath, Manifest *manifest);
 
   DropperDescription description() const;
+  /// readers do not need it. used to stop drops while compaction.
   std::mutex *getLocker() { return &_dropper_lock; }
 
 private:
@@ -54,6 +58,10 @@ private:
   std::condition_variable _dropper_cond_var;
   std::atomic_int _active_operations;
   DROPPER_STATE _state;
+
+  utils::metrics::Histogram *_read_latency;
+  utils::metrics::Histogram *_sort_latency;
+  utils::metrics::Histogram *_write_latency; // from compress stage to page callback.
 };
 } // namespace storage
 } // namespace dariadb
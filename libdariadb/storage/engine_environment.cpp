@@ -1,11 +1,14 @@
 #include <libdariadb/storage/engine_environment.h>
+#include <libdariadb/storage/versions.h>
 #include <libdariadb/utils/exception.h>
 #include <unordered_map>
 using namespace dariadb;
 using namespace dariadb::storage;
 
 struct EngineEnvironment::Private {
-  Private() {}
+  Private() : _versions(new VersionManager()) {
+    addResource(Resource::VERSIONS, _versions.get());
+  }
 
   ~Private() {}
 
@@ -20,6 +23,7 @@ struct EngineEnvironment::Private {
   }
 
   std::unordered_map<Resource, void *> _resource_map;
+  std::unique_ptr<VersionManager> _versions;
 };
 
 EngineEnvironment_ptr EngineEnvironment::create() {
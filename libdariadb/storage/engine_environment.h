@@ -14,7 +14,8 @@ public:
   enum class Resource {
     // LOCK_MANAGER,
     SETTINGS,
-    MANIFEST
+    MANIFEST,
+    VERSIONS // created by environment.
   };
 
 public:
@@ -7,6 +7,8 @@ namespace storage {
 //"dariadb."
 const uint64_t MAGIC_NUMBER_DARIADB = 0x2E62646169726164;
 const uint8_t MAGIC_NUMBER_INDEXFTR = 0xAA;
+// index with reccords, sorted by (id, minTime), and sparse block index.
+const uint8_t MAGIC_NUMBER_INDEXFTR_SORTED = 0xAB;
 const uint8_t MAGIC_NUMBER_PAGEFTR = 0x55;
 }
 }
\ No newline at end of file
@@ -1,23 +1,67 @@
 #include <libdariadb/storage/memstorage/allocators.h>
+#include <libdariadb/utils/fs.h>
+#include <libdariadb/utils/logger.h>
+#include <libdariadb/utils/strings.h>
+#include <algorithm>
 #include <cstring>
+#include <functional>
+#include <limits>
 #include <memory>
+#include <mutex>
+#include <thread>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sched.h>
+#include <sys/mman.h>
+#endif
 
 using namespace dariadb;
 using namespace dariadb::storage;
 
-UnlimitMemoryAllocator::UnlimitMemoryAllocator(uint32_t bufferSize) {
+namespace {
+const size_t OS_PAGE = 4096;
+const size_t MIN_SLAB_SIZE = 64 * 1024;
+const size_t MAX_SLAB_SIZE = 2 * 1024 * 1024; // size of huge page.
+const size_t MIN_SLABS = 64;
+const size_t CACHE_BATCH = 16;
+}
+
+void IMemoryAllocator::describe(memstorage::Description &d) const {
+  d.allocated = _allocated;
+  d.allocated_bytes = _allocated_bytes;
+}
+
+size_t IMemoryAllocator::size_class(uint32_t size) const {
+  ENSURE(!_size_classes.empty());
+  auto it = std::lower_bound(_size_classes.begin(), _size_classes.end(), size);
+  if (it == _size_classes.end()) {
+    return _size_classes.size() - 1;
+  }
+  return size_t(std::distance(_size_classes.begin(), it));
+}
+
+UnlimitMemoryAllocator::UnlimitMemoryAllocator(uint32_t bufferSize)
+    : UnlimitMemoryAllocator(std::vector<uint32_t>{bufferSize}, bufferSize) {}
+
+UnlimitMemoryAllocator::UnlimitMemoryAllocator(const std::vector<uint32_t> &size_classes,
+                                               uint32_t bufferSize) {
   _allocated = size_t(0);
   _chunkSize = bufferSize;
+  _size_classes = size_classes;
 }
 
 UnlimitMemoryAllocator::~UnlimitMemoryAllocator() {}
 
-UnlimitMemoryAllocator::AllocatedData UnlimitMemoryAllocator::allocate() {
+UnlimitMemoryAllocator::AllocatedData UnlimitMemoryAllocator::allocate(uint32_t size) {
   try {
+    auto buffer_size = _size_classes[size_class(size)];
     auto v = _allocated.fetch_add(1);
-    auto buffer = new uint8_t[_chunkSize];
-    std::fill_n(buffer, _chunkSize, uint8_t());
-    return AllocatedData(new ChunkHeader, buffer, v);
+    auto buffer = new uint8_t[buffer_size];
+    std::fill_n(buffer, buffer_size, uint8_t());
+    _allocated_bytes += sizeof(ChunkHeader) + buffer_size;
+    return AllocatedData(new ChunkHeader, buffer, v, buffer_size);
   } catch (std::bad_alloc) {
     return EMPTY;
   }
@@ -32,63 +76,465 @@ void UnlimitMemoryAllocator::free(const UnlimitMemoryAllocator::AllocatedData &d
 
 #ifdef DOUBLE_CHECKS
   memset(header, 0, sizeof(ChunkHeader));
-  memset(buffer, 0, _chunkSize);
+  memset(buffer, 0, d.size);
 #endif
 
   delete header;
   delete[] buffer;
 
+  _allocated_bytes -= sizeof(ChunkHeader) + d.size;
   _allocated--;
 }
 
-RegionChunkAllocator::RegionChunkAllocator(size_t maxSize, uint32_t bufferSize)
-    : _one_chunk_size(sizeof(ChunkHeader) + bufferSize),
-      _capacity((int)(float(maxSize) / _one_chunk_size)), _free_list(_capacity) {
-  _maxSize = maxSize;
-  _chunkSize = bufferSize;
-  _allocated = size_t(0);
+struct SlabChunkAllocator::Private {
+  static const uint32_t NO_SLOT = std::numeric_limits<uint32_t>::max();
+  static const int NO_CLASS = -1;
+
+  struct Slab {
+    int cls = NO_CLASS;
+    size_t node = 0;
+    uint32_t used = 0;            /// slots out of slab, cached too.
+    uint32_t cut = 0;             /// slots after it were never touched.
+    uint32_t free_head = NO_SLOT; /// returned slots, index of next is in the slot.
+    bool in_partial = false;
+  };
+
+  struct SizeClass {
+    std::mutex locker;
+    size_t slot_size;
+    uint32_t slots_per_slab;
+    std::vector<std::vector<size_t>> partial; /// slabs with free slots, per node.
+  };
+
+  struct Cache {
+    std::mutex locker;
+    std::vector<std::vector<size_t>> slots; /// per class.
+  };
+
+  Private(SlabChunkAllocator *parent, size_t maxSize, bool hugepages) {
+    _parent = parent;
+    _slabs_used = size_t(0);
+    _cached_bytes = size_t(0);
+    _hugetlb = false;
+    init_numa();
+
+    size_t biggest_slot = sizeof(ChunkHeader) + _parent->_size_classes.back();
+    // small limits (tests) are not rounded up to the whole slab.
+    _slab_size = std::max(std::min(MIN_SLAB_SIZE, maxSize) / OS_PAGE, size_t(1));
+    _slab_size *= OS_PAGE;
+    while (_slab_size * 2 <= MAX_SLAB_SIZE && _slab_size * 2 * MIN_SLABS <= maxSize) {
+      _slab_size *= 2;
+    }
+    if (hugepages) {
+      _slab_size = MAX_SLAB_SIZE;
+    }
+    while (_slab_size < biggest_slot) {
+      _slab_size *= 2;
+    }
+    _slabs.resize(std::max(maxSize / _slab_size, size_t(1)));
+    _region_size = _slabs.size() * _slab_size;
+    map_region(hugepages);
+
+    for (auto sz : _parent->_size_classes) {
+      std::unique_ptr<SizeClass> c{new SizeClass};
+      c->slot_size = sizeof(ChunkHeader) + sz;
+      c->slots_per_slab = uint32_t(_slab_size / c->slot_size);
+      c->partial.resize(_nodes);
+      _classes.push_back(std::move(c));
+    }
+    auto caches = std::max(size_t(std::thread::hardware_concurrency()), size_t(1)) * 2;
+    for (size_t i = 0; i < caches; ++i) {
+      std::unique_ptr<Cache> c{new Cache};
+      c->slots.resize(_classes.size());
+      _caches.push_back(std::move(c));
+    }
+    _free_slabs.reserve(_slabs.size());
+    for (size_t i = _slabs.size(); i > 0; --i) {
+      _free_slabs.push_back(i - 1);
+    }
+  }
+
+  ~Private() {
+#ifdef _WIN32
+    VirtualFree(_region, 0, MEM_RELEASE);
+#else
+    munmap(_region, _region_size);
+#endif
+  }
+
+  void map_region(bool hugepages) {
+#ifdef _WIN32
+    (void)hugepages;
+    // pages are zeroed and commited by the first touch.
+    _region = static_cast<uint8_t *>(
+        VirtualAlloc(nullptr, _region_size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE));
+    if (_region == nullptr) {
+      THROW_EXCEPTION("memstorage: can`t reserve ", _region_size, " bytes.");
+    }
+#else
+    const int flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE;
+    void *ptr = MAP_FAILED;
+#ifdef MAP_HUGETLB
+    if (hugepages) {
+      ptr = mmap(nullptr, _region_size, PROT_READ | PROT_WRITE, flags | MAP_HUGETLB, -1,
+                 0);
+      _hugetlb = ptr != MAP_FAILED;
+      if (!_hugetlb) {
+        logger_info("memstorage: huge pages are not reserved, transparent are used.");
+      }
+    }
+#endif
+    if (ptr == MAP_FAILED) {
+      ptr = mmap(nullptr, _region_size, PROT_READ | PROT_WRITE, flags, -1, 0);
+      if (ptr == MAP_FAILED) {
+        THROW_EXCEPTION("memstorage: can`t reserve ", _region_size, " bytes.");
+      }
+#ifdef MADV_HUGEPAGE
+      if (hugepages) {
+        madvise(ptr, _region_size, MADV_HUGEPAGE);
+      }
+#endif
+    }
+    _region = static_cast<uint8_t *>(ptr);
+#endif
+  }
+
+  /// cpu to node from /sys/devices/system/node/nodeN/cpulist ("0-3,8-11").
+  void init_numa() {
+    _nodes = 1;
+#ifdef __linux__
+    for (size_t node = 0;; ++node) {
+      auto cpulist = "/sys/devices/system/node/node" + std::to_string(node) + "/cpulist";
+      if (!utils::fs::file_exists(cpulist)) {
+        break;
+      }
+      std::string content;
+      try {
+        content = utils::fs::read_file(cpulist);
+      } catch (...) {
+        break;
+      }
+      auto words = utils::strings::tokens(content);
+      auto ranges = words.empty() ? words : utils::strings::split(words.front(), ',');
+      for (auto &range : ranges) {
+        auto bounds = utils::strings::split(range, '-');
+        if (bounds.empty()) {
+          continue;
+        }
+        auto first = size_t(std::stoul(bounds.front()));
+        auto last = bounds.size() > 1 ? size_t(std::stoul(bounds.back())) : first;
+        if (_cpu_to_node.size() <= last) {
+          _cpu_to_node.resize(last + 1, 0);
+        }
+        for (auto cpu = first; cpu <= last; ++cpu) {
+          _cpu_to_node[cpu] = node;
+        }
+      }
+      _nodes = node + 1;
+    }
+#endif
+  }
+
+  size_t current_node() const {
+#ifdef __linux__
+    if (_nodes > 1) {
+      auto cpu = sched_getcpu();
+      if (cpu >= 0 && size_t(cpu) < _cpu_to_node.size()) {
+        return _cpu_to_node[cpu];
+      }
+    }
+#endif
+    return 0;
+  }
+
+  Cache &current_cache() {
+    auto h = std::hash<std::thread::id>()(std::this_thread::get_id());
+    return *_caches[h % _caches.size()];
+  }
+
+  uint8_t *slot_ptr(size_t position) { return _region + position; }
+
+  /// new slab for class or NO_SLOT, if memory limit is reached.
+  size_t take_free_slab(int cls, size_t node) {
+    std::lock_guard<std::mutex> lg(_slabs_locker);
+    if (_free_slabs.empty()) {
+      return NO_SLOT;
+    }
+    auto result = _free_slabs.back();
+    _free_slabs.pop_back();
+    auto &slab = _slabs[result];
+    slab = Slab();
+    slab.cls = cls;
+    slab.node = node;
+    _slabs_used++;
+    return result;
+  }
 
-  size_t buffers_size = _capacity * (_chunkSize + sizeof(ChunkHeader));
+  void release_slab(size_t index) {
+    auto ptr = _region + index * _slab_size;
+#ifdef _WIN32
+    VirtualAlloc(ptr, _slab_size, MEM_RESET, PAGE_READWRITE);
+#else
+    madvise(ptr, _slab_size, MADV_DONTNEED);
+#endif
+    std::lock_guard<std::mutex> lg(_slabs_locker);
+    _slabs[index] = Slab();
+    _free_slabs.push_back(index);
+    _slabs_used--;
+  }
+
+  /// slab of class with free slots: local partial, new local, partial of other node.
+  size_t partial_slab(size_t cls) {
+    auto &c = *_classes[cls];
+    auto node = current_node();
+    if (!c.partial[node].empty()) {
+      return c.partial[node].back();
+    }
+    auto slab = take_free_slab(int(cls), node);
+    if (slab != NO_SLOT) {
+      c.partial[node].push_back(slab);
+      _slabs[slab].in_partial = true;
+      return slab;
+    }
+    for (auto &other : c.partial) {
+      if (!other.empty()) {
+        return other.back();
+      }
+    }
+    return NO_SLOT;
+  }
+
+  void take_slots(size_t cls, size_t count, std::vector<size_t> &out) {
+    auto &c = *_classes[cls];
+    std::lock_guard<std::mutex> lg(c.locker);
+    while (out.size() < count) {
+      auto index = partial_slab(cls);
+      if (index == NO_SLOT) {
+        break;
+      }
+      auto &slab = _slabs[index];
+      auto slab_begin = index * _slab_size;
+      while (out.size() < count && slab.used < c.slots_per_slab) {
+        uint32_t slot;
+        if (slab.free_head != NO_SLOT) {
+          slot = slab.free_head;
+          std::memcpy(&slab.free_head, slot_ptr(slab_begin + slot * c.slot_size),
+                      sizeof(uint32_t));
+        } else {
+          slot = slab.cut++;
+        }
+        slab.used++;
+        out.push_back(slab_begin + slot * c.slot_size);
+      }
+      if (slab.used == c.slots_per_slab) {
+        auto &lst = c.partial[slab.node];
+        lst.erase(std::find(lst.begin(), lst.end(), index));
+        slab.in_partial = false;
+      }
+    }
+  }
+
+  void release_slots(size_t cls, const std::vector<size_t> &positions) {
+    auto &c = *_classes[cls];
+    std::lock_guard<std::mutex> lg(c.locker);
+    for (auto pos : positions) {
+      auto index = pos / _slab_size;
+      auto &slab = _slabs[index];
+      ENSURE(slab.cls == int(cls));
+      auto slot = uint32_t((pos - index * _slab_size) / c.slot_size);
+      std::memcpy(slot_ptr(pos), &slab.free_head, sizeof(uint32_t));
+      slab.free_head = slot;
+      slab.used--;
+      auto &lst = c.partial[slab.node];
+      if (slab.used == 0) {
+        if (slab.in_partial) {
+          lst.erase(std::find(lst.begin(), lst.end(), index));
+        }
+        release_slab(index);
+      } else if (!slab.in_partial) {
+        lst.push_back(index);
+        slab.in_partial = true;
+      }
+    }
+  }
 
-  _region = new uint8_t[buffers_size];
-  _headers = reinterpret_cast<ChunkHeader *>(_region);
-  _buffers = _region + _capacity * sizeof(ChunkHeader);
+  AllocatedData make(size_t position, size_t cls) {
+    auto buffer_size = _parent->_size_classes[cls];
+    _parent->_allocated++;
+    _parent->_allocated_bytes += sizeof(ChunkHeader) + buffer_size;
+    auto slot = slot_ptr(position);
+    // buffer is cleared by Chunk, header has a link of slots list.
+    std::memset(static_cast<void *>(slot), 0, sizeof(ChunkHeader));
+    return AllocatedData(reinterpret_cast<ChunkHeader *>(slot),
+                         slot + sizeof(ChunkHeader), position, buffer_size);
+  }
+
+  AllocatedData allocate(size_t cls) {
+    auto &cache = current_cache();
+    auto slot_size = _classes[cls]->slot_size;
+    {
+      std::lock_guard<std::mutex> lg(cache.locker);
+      auto &slots = cache.slots[cls];
+      if (!slots.empty()) {
+        auto pos = slots.back();
+        slots.pop_back();
+        _cached_bytes -= slot_size;
+        return make(pos, cls);
+      }
+    }
+    std::vector<size_t> taken;
+    taken.reserve(CACHE_BATCH);
+    take_slots(cls, CACHE_BATCH, taken);
+    if (!taken.empty()) {
+      auto pos = taken.back();
+      taken.pop_back();
+      if (!taken.empty()) {
+        std::lock_guard<std::mutex> lg(cache.locker);
+        auto &slots = cache.slots[cls];
+        slots.insert(slots.end(), taken.begin(), taken.end());
+        _cached_bytes += taken.size() * slot_size;
+      }
+      return make(pos, cls);
+    }
+    // limit is reached: bigger classes first, than smaller.
+    std::vector<size_t> order;
+    for (size_t i = cls + 1; i < _classes.size(); ++i) {
+      order.push_back(i);
+    }
+    for (size_t i = cls; i > 0; --i) {
+      order.push_back(i - 1);
+    }
+    order.insert(order.begin(), cls);
+    // free slots may be parked in caches of other threads.
+    for (auto flushed = false;; flushed = true) {
+      for (auto other : order) {
+        take_slots(other, 1, taken);
+        if (!taken.empty()) {
+          return make(taken.front(), other);
+        }
+      }
+      if (flushed || _cached_bytes.load() == size_t(0)) {
+        break;
+      }
+      flush_caches();
+    }
+    return _parent->EMPTY;
+  }
+
+  void free(size_t cls, size_t position) {
+    std::vector<size_t> to_release;
+    {
+      auto &cache = current_cache();
+      std::lock_guard<std::mutex> lg(cache.locker);
+      auto &slots = cache.slots[cls];
+      slots.push_back(position);
+      _cached_bytes += _classes[cls]->slot_size;
+      if (slots.size() > CACHE_BATCH * 2) {
+        to_release.assign(slots.begin(), slots.begin() + CACHE_BATCH);
+        slots.erase(slots.begin(), slots.begin() + CACHE_BATCH);
+        _cached_bytes -= CACHE_BATCH * _classes[cls]->slot_size;
+      }
+    }
+    if (!to_release.empty()) {
+      release_slots(cls, to_release);
+    }
+  }
 
-  memset(_region, 0, buffers_size);
-  for (size_t i = 0; i < _capacity; ++i) {
-    auto res = _free_list.push(i);
-    if (!res) {
-      THROW_EXCEPTION("engine: MemChunkAllocator::ctor - bad capacity.");
+  void flush_caches() {
+    for (auto &cache : _caches) {
+      std::vector<std::vector<size_t>> slots(_classes.size());
+      {
+        std::lock_guard<std::mutex> lg(cache->locker);
+        std::swap(slots, cache->slots);
+        cache->slots.resize(_classes.size());
+      }
+      for (size_t cls = 0; cls < slots.size(); ++cls) {
+        if (!slots[cls].empty()) {
+          _cached_bytes -= slots[cls].size() * _classes[cls]->slot_size;
+          release_slots(cls, slots[cls]);
+        }
+      }
     }
   }
+
+  SlabChunkAllocator *_parent;
+  uint8_t *_region;
+  size_t _region_size;
+  size_t _slab_size;
+  bool _hugetlb;
+  size_t _nodes;
+  std::vector<size_t> _cpu_to_node;
+
+  std::mutex _slabs_locker;
+  std::vector<Slab> _slabs;
+  std::vector<size_t> _free_slabs;
+  std::atomic_size_t _slabs_used;
+  std::atomic_size_t _cached_bytes; /// slots in caches, with headers.
+
+  std::vector<std::unique_ptr<SizeClass>> _classes;
+  std::vector<std::unique_ptr<Cache>> _caches;
+};
+
+SlabChunkAllocator::SlabChunkAllocator(size_t maxSize,
+                                       const std::vector<uint32_t> &size_classes,
+                                       uint32_t bufferSize, bool hugepages) {
+  _chunkSize = bufferSize;
+  _size_classes = size_classes;
+  _impl.reset(new Private(this, maxSize, hugepages));
 }
 
-RegionChunkAllocator::~RegionChunkAllocator() {
-  delete[] _region;
+SlabChunkAllocator::~SlabChunkAllocator() {
+  _impl = nullptr;
 }
 
-RegionChunkAllocator::AllocatedData RegionChunkAllocator::allocate() {
-  size_t pos;
-  if (!_free_list.pop(pos)) {
-    return EMPTY;
-  }
-  _allocated++;
-  return AllocatedData(&_headers[pos], &_buffers[pos * _chunkSize], pos);
+SlabChunkAllocator::AllocatedData SlabChunkAllocator::allocate(uint32_t size) {
+  return _impl->allocate(size_class(size));
 }
 
-void RegionChunkAllocator::free(const RegionChunkAllocator::AllocatedData &d) {
+void SlabChunkAllocator::free(const SlabChunkAllocator::AllocatedData &d) {
   ENSURE(d.header != nullptr);
   ENSURE(d.buffer != nullptr);
   ENSURE(d.position != EMPTY.position);
-  auto header = d.header;
-  auto buffer = d.buffer;
-  auto position = d.position;
-  memset(header, 0, sizeof(ChunkHeader));
-  memset(buffer, 0, _chunkSize);
-
+  _allocated_bytes -= sizeof(ChunkHeader) + d.size;
   _allocated--;
-  auto res = _free_list.push(position);
-  if (!res) {
-    THROW_EXCEPTION("engine: MemChunkAllocator::free - bad capacity.");
+  _impl->free(size_class(d.size), d.position);
+}
+
+size_t SlabChunkAllocator::capacity_bytes() const {
+  return _impl->_region_size;
+}
+
+void SlabChunkAllocator::describe(memstorage::Description &d) const {
+  IMemoryAllocator::describe(d);
+  d.allocator_capacity_bytes = _impl->_region_size;
+  d.allocator_capacity = _impl->_region_size / (sizeof(ChunkHeader) + _chunkSize);
+  d.slab_size = _impl->_slab_size;
+  d.slabs_count = _impl->_slabs.size();
+  d.slabs_used = _impl->_slabs_used;
+  d.cached_bytes = _impl->_cached_bytes;
+  auto used_bytes = d.slabs_used * d.slab_size;
+  d.occupancy = float(double(used_bytes) / _impl->_region_size);
+  if (used_bytes != 0) {
+    d.fragmentation = float(1.0 - double(d.allocated_bytes) / used_bytes);
   }
 }
+
+void SlabChunkAllocator::flush_caches() {
+  _impl->flush_caches();
+}
+
+size_t SlabChunkAllocator::used_bytes() const {
+  return _allocated_bytes.load() + _impl->_cached_bytes.load();
+}
+
+size_t SlabChunkAllocator::slab_size() const {
+  return _impl->_slab_size;
+}
+
+size_t SlabChunkAllocator::slabs_used() const {
+  return _impl->_slabs_used;
+}
+
+size_t SlabChunkAllocator::numa_nodes() const {
+  return _impl->_nodes;
+}
@@ -2,11 +2,11 @@
 
 #include <libdariadb/st_exports.h>
 #include <libdariadb/storage/chunk.h>
+#include <libdariadb/storage/memstorage/description.h>
 #include <libdariadb/utils/async/locker.h>
 #include <libdariadb/utils/utils.h>
 #include <memory>
-
-#include <boost/lockfree/queue.hpp>
+#include <vector>
 
 namespace dariadb {
 namespace storage {
@@ -15,57 +15,91 @@ struct IMemoryAllocator {
     ChunkHeader *header;
     uint8_t *buffer;
     size_t position;
-    AllocatedData(ChunkHeader *h, uint8_t *buf, size_t pos) {
+    uint32_t size; /// size of buffer.
+    AllocatedData(ChunkHeader *h, uint8_t *buf, size_t pos, uint32_t sz) {
       header = h;
       buffer = buf;
       position = pos;
+      size = sz;
     }
     AllocatedData() {
       header = nullptr;
       buffer = nullptr;
       position = std::numeric_limits<size_t>::max();
+      size = 0;
     }
   };
 
   const AllocatedData EMPTY =
-      AllocatedData(nullptr, nullptr, std::numeric_limits<size_t>::max());
+      AllocatedData(nullptr, nullptr, std::numeric_limits<size_t>::max(), 0);
 
-  std::atomic_size_t _allocated; /// already allocated count of chunks.
-  uint32_t _chunkSize;           /// size of chunk
+  std::atomic_size_t _allocated;       /// already allocated count of chunks.
+  std::atomic_size_t _allocated_bytes; /// size of allocated chunks with headers.
+  uint32_t _chunkSize;                 /// default size of chunk
+  std::vector<uint32_t> _size_classes; /// sizes of chunk buffers, ascending.
 
-  IMemoryAllocator() { _allocated = size_t(0); }
+  IMemoryAllocator() {
+    _allocated = size_t(0);
+    _allocated_bytes = size_t(0);
+  }
   virtual ~IMemoryAllocator() {}
-  virtual AllocatedData allocate() = 0;
+  /// size is rounded up to size class.
+  virtual AllocatedData allocate(uint32_t size) = 0;
+  AllocatedData allocate() { return allocate(_chunkSize); }
   virtual void free(const AllocatedData &d) = 0;
+  /// limit of allocated bytes. 0 - unlimited.
+  virtual size_t capacity_bytes() const { return 0; }
+  /// bytes, which are not available for other threads: allocated and cached.
+  virtual size_t used_bytes() const { return _allocated_bytes.load(); }
+  /// return cached slots, so they can be used by any thread.
+  virtual void flush_caches() {}
+  EXPORT virtual void describe(memstorage::Description &d) const;
+
+  /// index of the smallest class, which is not less than size.
+  EXPORT size_t size_class(uint32_t size) const;
 };
 using IMemoryAllocator_Ptr = std::shared_ptr<IMemoryAllocator>;
 
 struct UnlimitMemoryAllocator : public utils::NonCopy, public IMemoryAllocator {
-  size_t _one_chunk_size;
-
   EXPORT UnlimitMemoryAllocator(uint32_t bufferSize);
+  EXPORT UnlimitMemoryAllocator(const std::vector<uint32_t> &size_classes,
+                                uint32_t bufferSize);
   UnlimitMemoryAllocator(const UnlimitMemoryAllocator &) = delete;
   EXPORT ~UnlimitMemoryAllocator();
-  EXPORT AllocatedData allocate() override;
+  using IMemoryAllocator::allocate;
+  EXPORT AllocatedData allocate(uint32_t size) override;
   EXPORT void free(const AllocatedData &d) override;
 };
 
-struct RegionChunkAllocator : public utils::NonCopy, public IMemoryAllocator {
-  size_t _one_chunk_size;
-  size_t _maxSize; /// max size in bytes)
-
-  ChunkHeader *_headers;
-  uint8_t *_buffers;
-  uint8_t *_region;
-  size_t _capacity; /// max size in chunks
+/**
+memory_limit is reserved as virtual memory: pages are commited by the first
+touch and released with the empty slab, nothing is zeroed up front.
+slab is cut into slots of one size class. threads take and return slots through
+striped caches, which exchange slots with partial slabs by batches.
+if there are several numa nodes, slabs of the current node are preferred.
+*/
+struct SlabChunkAllocator : public utils::NonCopy, public IMemoryAllocator {
+  /// hugepages - MAP_HUGETLB (or transparent hugepages, if not reserved).
+  EXPORT SlabChunkAllocator(size_t maxSize, const std::vector<uint32_t> &size_classes,
+                            uint32_t bufferSize, bool hugepages = false);
+  SlabChunkAllocator(const SlabChunkAllocator &) = delete;
+  EXPORT ~SlabChunkAllocator();
+  using IMemoryAllocator::allocate;
+  EXPORT AllocatedData allocate(uint32_t size) override;
+  EXPORT void free(const AllocatedData &d) override;
+  EXPORT size_t capacity_bytes() const override;
+  EXPORT void describe(memstorage::Description &d) const override;
+  EXPORT size_t used_bytes() const override;
+  /// return cached slots to slabs, so the empty slabs are released.
+  EXPORT void flush_caches() override;
 
-  boost::lockfree::queue<size_t> _free_list;
+  EXPORT size_t slab_size() const;
+  EXPORT size_t slabs_used() const;
+  EXPORT size_t numa_nodes() const;
 
-  EXPORT RegionChunkAllocator(size_t maxSize, uint32_t bufferSize);
-  RegionChunkAllocator(const RegionChunkAllocator &) = delete;
-  EXPORT ~RegionChunkAllocator();
-  EXPORT AllocatedData allocate() override;
-  EXPORT void free(const AllocatedData &d) override;
+protected:
+  struct Private;
+  std::unique_ptr<Private> _impl;
 };
 }
 }
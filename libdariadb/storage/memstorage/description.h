@@ -1,12 +1,26 @@
 #pragma once
+#include <cstddef>
 namespace dariadb {
 namespace storage {
 namespace memstorage {
 struct Description {
-  size_t allocated;
-  size_t allocator_capacity;
-  Description() { allocated = allocator_capacity = size_t(0); }
+  size_t allocated;          /// chunks.
+  size_t allocator_capacity; /// chunks of default size.
+  size_t allocated_bytes;
+  size_t cached_bytes; /// free slots in thread caches.
+  size_t allocator_capacity_bytes;
+  size_t slab_size;
+  size_t slabs_used;
+  size_t slabs_count;
+  float occupancy;     /// part of capacity in used slabs.
+  float fragmentation; /// free part of used slabs.
+  Description() {
+    allocated = allocator_capacity = size_t(0);
+    allocated_bytes = cached_bytes = allocator_capacity_bytes = size_t(0);
+    slab_size = slabs_used = slabs_count = size_t(0);
+    occupancy = fragmentation = float(0);
+  }
 };
 }
 }
-}
\ No newline at end of file
+}
@@ -6,10 +6,14 @@
 #include <libdariadb/storage/memstorage/memstorage.h>
 #include <libdariadb/storage/memstorage/timetrack.h>
 #include <libdariadb/storage/settings.h>
+#include <libdariadb/storage/versions.h>
 #include <libdariadb/timeutil.h>
 #include <libdariadb/utils/async/thread_manager.h>
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <cstring>
+#include <map>
 #include <memory>
 #include <set>
 #include <shared_mutex>
@@ -19,6 +23,15 @@ using namespace dariadb;
 using namespace dariadb::storage;
 using namespace dariadb::utils::async;
 
+namespace {
+/// drop thread checks watermarks at least so often.
+const std::chrono::milliseconds EVICTION_PERIOD(100);
+/// writer rechecks memory, if eviction did not wake it.
+const std::chrono::milliseconds ADMISSION_TIMEOUT(50);
+/// writer gets bad_alloc, if memory was not freed after so many evictions.
+const size_t ADMISSION_RETRIES = 100;
+}
+
 /**
 Map:
   Meas.id -> TimeTrack{ MemChunkList[MemChunk{data}]}
@@ -26,7 +39,9 @@ Map:
 struct MemStorage::Private : public IMeasStorage, public MemoryChunkContainer {
   Private(const EngineEnvironment_ptr &env, size_t id_count)
       : _env(env), _settings(_env->getResourceObject<Settings>(
-                       EngineEnvironment::Resource::SETTINGS)) {
+                       EngineEnvironment::Resource::SETTINGS)),
+        _versions(_env->getResourceObject<VersionManager>(
+            EngineEnvironment::Resource::VERSIONS)) {
     _chunks_count.store(uint64_t());
     allocator_init();
     _stoped = false;
@@ -34,6 +49,8 @@ struct MemStorage::Private : public IMeasStorage, public MemoryChunkContainer {
     _disk_storage = nullptr;
     _drop_stop = false;
     _drop_is_stoped = false;
+    _evicting = false;
+    _evict_requested = false;
     if (!_settings->is_memory_only_mode) {
       _drop_thread = std::thread{std::bind(&MemStorage::Private::drop_thread_func, this)};
     }
@@ -73,23 +90,20 @@ struct MemStorage::Private : public IMeasStorage, public MemoryChunkContainer {
 
   void allocator_init() {
     IMemoryAllocator *alloc_ptr;
+    auto size_classes = _settings->chunk_size_classes();
     if (_settings->is_memory_only_mode) {
-      alloc_ptr = new UnlimitMemoryAllocator(_settings->chunk_size.value());
+      alloc_ptr = new UnlimitMemoryAllocator(size_classes, _settings->chunk_size.value());
     } else {
-      alloc_ptr = new RegionChunkAllocator(_settings->memory_limit.value(),
-                                           _settings->chunk_size.value());
+      alloc_ptr = new SlabChunkAllocator(_settings->memory_limit.value(), size_classes,
+                                         _settings->chunk_size.value(),
+                                         _settings->memory_hugepages.value());
     }
 
     _chunk_allocator = IMemoryAllocator_Ptr(alloc_ptr);
   }
   memstorage::Description description() const {
     memstorage::Description result;
-    auto region_allocator_ptr =
-        dynamic_cast<RegionChunkAllocator *>(_chunk_allocator.get());
-    if (region_allocator_ptr != nullptr) {
-      result.allocator_capacity = region_allocator_ptr->_capacity;
-    }
-    result.allocated = _chunk_allocator->_allocated;
+    _chunk_allocator->describe(result);
     return result;
   }
 
@@ -100,7 +114,8 @@ struct MemStorage::Private : public IMeasStorage, public MemoryChunkContainer {
 
       if (iterator.v->second == nullptr) {
         auto new_tr =
-            std::make_shared<TimeTrack>(this, Time(0), value.id, _chunk_allocator);
+            std::make_shared<TimeTrack>(this, Time(0), value.id, _chunk_allocator,
+                                        _settings->chunk_time_span.value());
         iterator.v->second = new_tr;
         track = new_tr;
       } else {
@@ -108,17 +123,32 @@ struct MemStorage::Private : public IMeasStorage, public MemoryChunkContainer {
       }
     }
 
+    size_t retries = 0;
     while (true) {
       auto st = track->append(value);
-      if (st != Status(1) && !_drop_stop) {
-        if (_settings->is_memory_only_mode) {
+      if (st != Status(1)) {
+        if (_settings->is_memory_only_mode || _drop_stop) {
           return st;
         }
+        if (retries++ == ADMISSION_RETRIES) {
+          logger_fatal("engine", _settings->alias, ": memstorage - no memory for #",
+                       value.id, " after eviction.");
+          return st;
+        }
+        // admission control: writer sleeps until eviction frees memory.
+        // allocation can fail below the high watermark (fragmented size
+        // classes), so the writer requests eviction explicitly.
+        std::unique_lock<std::mutex> ul(_admission_locker);
+        _evict_requested.store(true);
         _drop_cond.notify_all();
+        _admission_cond.wait_for(ul, ADMISSION_TIMEOUT);
         continue;
       }
       break;
     }
+    if (!_evicting.load() && is_time_to_drop()) {
+      _drop_cond.notify_all();
+    }
 
     if (_disk_storage != nullptr) {
       _disk_storage->append(value);
@@ -134,6 +164,7 @@ struct MemStorage::Private : public IMeasStorage, public MemoryChunkContainer {
     auto chunks_to_delete = (size_t)(cur_chunk_count * chunk_percent_to_free);
 
     std::list<MemChunk_Ptr> all_chunks;
+    std::unordered_map<Id, TimeTrack_ptr> frozen_tracks;
     size_t pos = 0;
 
     std::list<TimeTrack_ptr> tracks;
@@ -151,6 +182,9 @@ struct MemStorage::Private : public IMeasStorage, public MemoryChunkContainer {
       to_drop = to_drop == size_t(0) ? 1 : to_drop;
 
       auto dropped = v->drop_N(to_drop);
+      if (!dropped.empty()) {
+        frozen_tracks[v->_meas_id] = v;
+      }
 
       for (auto d : dropped) {
         all_chunks.push_back(d);
@@ -166,28 +200,78 @@ struct MemStorage::Private : public IMeasStorage, public MemoryChunkContainer {
     if (pos != 0) {
       logger_info("engine", _settings->alias, ": memstorage - drop begin ", pos,
                   " chunks of ", cur_chunk_count);
-      if (_down_level_storage != nullptr) {
-        auto chunks_per_page = _settings->max_chunks_per_page.value();
+      write_frozen(all_chunks, frozen_tracks);
+      logger_info("engine", _settings->alias, ": memstorage - drop end.");
+    }
+  }
 
-        AsyncTask at = [this, &all_chunks, chunks_per_page](const ThreadInfo &ti) {
-          TKIND_CHECK(THREAD_KINDS::DISK_IO, ti.kind);
-          this->drop_logic(chunks_per_page, all_chunks);
-          return false;
-        };
+  /// write frozen chunks to pages (or forget them in cache mode).
+  void write_frozen(std::list<MemChunk_Ptr> &all_chunks,
+                    std::unordered_map<Id, TimeTrack_ptr> &frozen_tracks) {
+    if (_down_level_storage != nullptr) {
+      auto chunks_per_page = _settings->max_chunks_per_page.value();
+
+      AsyncTask at = [this, &all_chunks, &frozen_tracks,
+                      chunks_per_page](const ThreadInfo &ti) {
+        TKIND_CHECK(THREAD_KINDS::DISK_IO, ti.kind);
+        this->drop_logic(chunks_per_page, all_chunks, frozen_tracks);
+        return false;
+      };
+
+      auto at_res = ThreadManager::instance()->post(THREAD_KINDS::DISK_IO, AT(at));
+      at_res->wait();
+    } else {
+      if (_settings->strategy.value() != STRATEGY::CACHE) {
+        logger_info("engine", _settings->alias,
+                    ": memstorage _down_level_storage == nullptr");
+      }
+      _versions->publish([&frozen_tracks]() {
+        for (auto &kv : frozen_tracks) {
+          kv.second->release_frozen();
+        }
+      });
+    }
+  }
 
-        auto at_res = ThreadManager::instance()->post(THREAD_KINDS::DISK_IO, AT(at));
-        at_res->wait();
-      } else {
-        if (_settings->strategy.value() != STRATEGY::CACHE) {
-          logger_info("engine", _settings->alias,
-                      ": memstorage _down_level_storage == nullptr");
+  /// one step of eviction: up to max_chunks oldest sealed chunks of all tracks
+  /// go to one small page write. return count of checked chunks, 0 - nothing to evict.
+  size_t evict_oldest(size_t max_chunks) {
+    std::vector<MemChunk_Ptr> candidates;
+    candidates.reserve(max_chunks);
+    {
+      std::lock_guard<std::mutex> lg(_sealed_locker);
+      while (!_sealed.empty() && candidates.size() < max_chunks) {
+        auto c = _sealed.begin()->second.lock();
+        _sealed.erase(_sealed.begin());
+        // expired, if chunk was replaced by write to past or dropped.
+        if (c != nullptr) {
+          candidates.push_back(c);
         }
       }
-      logger_info("engine", _settings->alias, ": memstorage - drop end.");
     }
+    if (candidates.empty()) {
+      return size_t(0);
+    }
+
+    std::list<MemChunk_Ptr> all_chunks;
+    std::unordered_map<Id, TimeTrack_ptr> frozen_tracks;
+    for (auto &c : candidates) {
+      TimeTrack_ptr track = nullptr;
+      if (_id2track.find(c->header->meas_id, &track) && track->freeze(c)) {
+        frozen_tracks[track->_meas_id] = track;
+        all_chunks.push_back(c);
+      }
+    }
+    auto result = candidates.size();
+    candidates.clear();
+    if (!all_chunks.empty()) {
+      write_frozen(all_chunks, frozen_tracks);
+    }
+    return result;
   }
 
-  void drop_logic(size_t, std::list<MemChunk_Ptr> &all_chunks) {
+  void drop_logic(size_t, std::list<MemChunk_Ptr> &all_chunks,
+                  std::unordered_map<Id, TimeTrack_ptr> &frozen_tracks) {
     std::unordered_map<dariadb::Id, std::vector<Chunk *>> c2i;
     std::unordered_map<dariadb::Id, std::vector<MemChunk_Ptr>> c2i_to_drop;
     std::vector<Chunk *> raw_ptrs(all_chunks.size());
@@ -198,7 +282,10 @@ struct MemStorage::Private : public IMeasStorage, public MemoryChunkContainer {
     }
     all_chunks.clear();
     for (auto kv : c2i) {
-      this->_down_level_storage->appendChunks(kv.second);
+      // page of id replaces its frozen chunks in one version.
+      auto track = frozen_tracks[kv.first];
+      _down_level_storage->appendChunksAndPublish(
+          kv.second, [&track]() { track->release_frozen(); });
       for (auto mc : c2i_to_drop[kv.first]) {
         freeChunk(mc);
       }
@@ -357,31 +444,82 @@ struct MemStorage::Private : public IMeasStorage, public MemoryChunkContainer {
 
   void freeChunk(MemChunk_Ptr &) { _chunks_count.fetch_sub(uint64_t(1)); }
 
+  void sealChunk(MemChunk_Ptr &c) override {
+    std::lock_guard<std::mutex> lg(_sealed_locker);
+    _sealed.emplace(c->header->stat.maxTime, c);
+    // writes to past and drops leave expired entries.
+    if (_sealed.size() > 2 * _chunks_count.load() + 1024) {
+      for (auto it = _sealed.begin(); it != _sealed.end();) {
+        if (it->second.expired()) {
+          it = _sealed.erase(it);
+        } else {
+          ++it;
+        }
+      }
+    }
+  }
+
   std::mutex *getLockers() { return &_drop_locker; }
 
+  /// chunks have different sizes, so the limit is in bytes.
+  bool is_above(float percent) {
+    auto capacity = _chunk_allocator->capacity_bytes();
+    auto limit = capacity * percent;
+    return capacity != 0 && _chunk_allocator->used_bytes() >= limit;
+  }
+
+  /// high watermark.
   bool is_time_to_drop() {
-    auto region_allocator_ptr =
-        dynamic_cast<RegionChunkAllocator *>(_chunk_allocator.get());
-    if (region_allocator_ptr != nullptr) {
-      return _chunks_count.load() >= (region_allocator_ptr->_capacity *
-                                      _settings->percent_when_start_droping.value());
-    }
-    return false;
+    return is_above(_settings->percent_when_start_droping.value());
   }
 
+  /// low watermark.
+  bool is_time_to_stop_drop() {
+    auto low = _settings->percent_when_start_droping.value() -
+               _settings->percent_to_drop.value();
+    return !is_above(std::max(low, float(0)));
+  }
+
+  /**
+  eviction runs from the high watermark down to the low one by small steps
+  (chunks_per_page oldest chunks), so writers are blocked only while the
+  memory is really over, not for the whole drop.
+  */
   void drop_thread_func() {
+    auto chunks_per_page = size_t(_settings->max_chunks_per_page.value());
     while (!_drop_stop) {
       std::unique_lock<std::mutex> ul(_drop_locker);
-      _drop_cond.wait(ul);
-      if (_drop_stop) {
-        break;
+      if (!_evicting.load()) {
+        if (!_evict_requested.load()) {
+          _drop_cond.wait_for(ul, EVICTION_PERIOD);
+        }
+        if (_drop_stop) {
+          break;
+        }
+        if (!_evict_requested.load() && !is_time_to_drop()) {
+          continue;
+        }
+        // cached free slots are counted too, they are returned before eviction.
+        _chunk_allocator->flush_caches();
+        if (!_evict_requested.load() && !is_time_to_drop()) {
+          continue;
+        }
+        _evicting.store(true);
       }
 
-      if (!is_time_to_drop()) {
-        continue;
+      auto requested = _evict_requested.exchange(false);
+      auto checked = evict_oldest(chunks_per_page);
+      if (checked == size_t(0) && requested) {
+        // not sealed chunks are not in the eviction queue.
+        drop_by_limit(_settings->percent_to_drop.value());
+      }
+      {
+        std::lock_guard<std::mutex> lg(_admission_locker);
+        _admission_cond.notify_all();
+      }
+      if (checked == size_t(0) || is_time_to_stop_drop()) {
+        _evicting.store(false);
       }
-
-      drop_by_limit(_settings->percent_to_drop.value());
     }
     _drop_is_stoped = true;
     logger_info("engine", _settings->alias, ": memstorage - dropping thread stoped.");
@@ -390,6 +528,7 @@ struct MemStorage::Private : public IMeasStorage, public MemoryChunkContainer {
   Id2Track _id2track;
   EngineEnvironment_ptr _env;
   storage::Settings *_settings;
+  VersionManager *_versions;
   IMemoryAllocator_Ptr _chunk_allocator;
   IChunkStorage *_down_level_storage;
   IMeasWriter *_disk_storage;
@@ -402,6 +541,15 @@ struct MemStorage::Private : public IMeasStorage, public MemoryChunkContainer {
   bool _drop_is_stoped;
   std::mutex _drop_locker;
   std::condition_variable _drop_cond;
+  std::atomic_bool _evicting;
+  std::atomic_bool _evict_requested; // writer got bad_alloc.
+
+  std::mutex _admission_locker;
+  std::condition_variable _admission_cond;
+
+  std::mutex _sealed_locker;
+  /// max time of chunk -> chunk. oldest chunks of all tracks are evicted first.
+  std::multimap<Time, std::weak_ptr<MemChunk>> _sealed;
 };
 
 MemStorage_ptr MemStorage::create(const EngineEnvironment_ptr &env, size_t id_count) {
@@ -34,10 +34,11 @@ struct MemTrackCursor : dariadb::ICursor {
 };
 
 TimeTrack::TimeTrack(MemoryChunkContainer *mcc, const Time step, Id meas_id,
-                     IMemoryAllocator_Ptr allocator) {
+                     IMemoryAllocator_Ptr allocator, Time chunk_time_span) {
   _allocator = allocator;
   _meas_id = meas_id;
   _step = step;
+  _chunk_time_span = chunk_time_span;
   _min_max.min.time = MAX_TIME;
   _min_max.max.time = MIN_TIME;
   _max_sync_time = MIN_TIME;
@@ -55,7 +56,7 @@ void TimeTrack::updateMinMax(const Meas &value) {
 
 Status TimeTrack::append(const Meas &value) {
   std::lock_guard<std::mutex> lg(_locker);
-  if (_cur_chunk == nullptr || _cur_chunk->isFull()) {
+  if (_cur_chunk == nullptr || _cur_chunk->isFull() || is_time_to_seal(value)) {
     if (!create_new_chunk(value)) {
       return Status(1, APPEND_ERROR::bad_alloc);
     } else {
@@ -147,6 +148,7 @@ void TimeTrack::append_to_past(const Meas &value) {
     _cur_chunk = new_chunk;
   } else {
     _index.insert(std::make_pair(new_chunk->header->stat.maxTime, new_chunk));
+    _mcc->sealChunk(new_chunk);
   }
 }
 
@@ -215,6 +217,10 @@ bool TimeTrack::minMaxTime(dariadb::Id id, dariadb::Time *minResult,
     *minResult = std::min(c->header->stat.minTime, *minResult);
     *maxResult = std::max(c->header->stat.maxTime, *maxResult);
   }
+  for (auto &c : _frozen) {
+    *minResult = std::min(c->header->stat.minTime, *minResult);
+    *maxResult = std::max(c->header->stat.maxTime, *maxResult);
+  }
   if (_cur_chunk != nullptr) {
     *minResult = std::min(_cur_chunk->header->stat.minTime, *minResult);
     *maxResult = std::max(_cur_chunk->header->stat.maxTime, *maxResult);
@@ -257,6 +263,11 @@ Id2Cursor TimeTrack::intervalReader(const QueryInterval &q) {
       readers.push_back(rdr);
     }
   }
+  for (auto &c : _frozen) {
+    if (chunkInQuery(q, c)) {
+      readers.push_back(c->getReader());
+    }
+  }
   if (_cur_chunk != nullptr && chunkInQuery(q, _cur_chunk)) {
     auto rdr = _cur_chunk->getReader();
     readers.push_back(rdr);
@@ -290,6 +301,11 @@ Statistic TimeTrack::stat(const Id id, Time from, Time to) {
       result.update(st);
     }
   }
+  for (auto &c : _frozen) {
+    if (chunkInQuery(from, to, c)) {
+      result.update(c->stat(from, to));
+    }
+  }
 
   if (_cur_chunk != nullptr && chunkInQuery(from, to, _cur_chunk)) {
     auto st = _cur_chunk->stat(from, to);
@@ -323,12 +339,7 @@ Id2Meas TimeTrack::readTimePoint(const QueryTimePoint &q) {
     ++end;
   }
 
-  for (auto it = begin; it != end; ++it) {
-    if (it == _index.end()) {
-      break;
-    }
-    auto c = it->second;
-
+  auto from_chunk = [this, &q, &result](const MemChunk_Ptr &c) {
     if (c->header->stat.minTime <= q.time_point &&
         c->header->stat.maxTime >= q.time_point) {
       auto rdr = c->getReader();
@@ -337,6 +348,16 @@ Id2Meas TimeTrack::readTimePoint(const QueryTimePoint &q) {
         result[this->_meas_id] = m;
       }
     }
+  };
+
+  for (auto it = begin; it != end; ++it) {
+    if (it == _index.end()) {
+      break;
+    }
+    from_chunk(it->second);
+  }
+  for (auto &c : _frozen) {
+    from_chunk(c);
   }
 
   if (_cur_chunk != nullptr && _cur_chunk->header->stat.maxTime <= q.time_point) {
@@ -389,17 +410,43 @@ void TimeTrack::rereadMinMax() {
   }
 }
 
+bool TimeTrack::is_time_to_seal(const Meas &value) const {
+  if (_chunk_time_span == Time(0) || _cur_chunk == nullptr) {
+    return false;
+  }
+  auto hdr = _cur_chunk->header;
+  return hdr->stat.maxTime < value.time &&
+         value.time - hdr->stat.minTime >= _chunk_time_span;
+}
+
+uint32_t TimeTrack::next_chunk_size() const {
+  if (_cur_chunk == nullptr || _chunk_time_span == Time(0)) {
+    return _allocator->_chunkSize;
+  }
+  auto hdr = _cur_chunk->header;
+  auto biggest = _allocator->_size_classes.back();
+  auto span = hdr->stat.maxTime - hdr->stat.minTime;
+  if (span == Time(0)) {
+    return biggest;
+  }
+  auto used = hdr->size - hdr->bw_pos;
+  auto predicted = double(used) * _chunk_time_span / span;
+  return uint32_t(std::min(predicted, double(biggest)));
+}
+
 bool TimeTrack::create_new_chunk(const Meas &value) {
+  auto chunk_size = next_chunk_size();
   if (_cur_chunk != nullptr) {
     this->_index.insert(std::make_pair(_cur_chunk->header->stat.maxTime, _cur_chunk));
+    this->_mcc->sealChunk(_cur_chunk);
     _cur_chunk = nullptr;
   }
-  auto new_chunk_data = _allocator->allocate();
+  auto new_chunk_data = _allocator->allocate(chunk_size);
   if (new_chunk_data.header == nullptr) {
     return false;
   }
   auto mc = MemChunk_Ptr{new MemChunk{true, new_chunk_data.header, new_chunk_data.buffer,
-                                      _allocator->_chunkSize, value, this->_allocator}};
+                                      new_chunk_data.size, value, this->_allocator}};
   mc->_track = this;
   mc->_a_data = new_chunk_data;
   this->_mcc->addChunk(mc);
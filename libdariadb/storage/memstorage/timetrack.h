@@ -14,6 +14,8 @@ class MemoryChunkContainer {
 public:
   virtual void addChunk(MemChunk_Ptr &c) = 0;
   virtual void freeChunk(MemChunk_Ptr &c) = 0;
+  /// chunk is full or replaced and will not be changed by appends.
+  virtual void sealChunk(MemChunk_Ptr &) {}
   virtual ~MemoryChunkContainer() {}
 };
 
@@ -24,7 +26,7 @@ using Id2Track = utils::stripped_map<Id, TimeTrack_ptr>;
 
 struct TimeTrack : public IMeasStorage, public std::enable_shared_from_this<TimeTrack> {
   TimeTrack(MemoryChunkContainer *mcc, const Time step, Id meas_id,
-            IMemoryAllocator_Ptr allocator);
+            IMemoryAllocator_Ptr allocator, Time chunk_time_span = Time(0));
   ~TimeTrack();
   void updateMinMax(const Meas &value);
   virtual Status append(const Meas &value) override;
@@ -44,12 +46,17 @@ struct TimeTrack : public IMeasStorage, public std::enable_shared_from_this<Time
 
   void rereadMinMax();
   bool create_new_chunk(const Meas &value);
+  /// current chunk covers chunk_time_span.
+  bool is_time_to_seal(const Meas &value) const;
+  /// enough to cover chunk_time_span with rate and compression of current chunk.
+  uint32_t next_chunk_size() const;
 
   size_t chunks_count() {
     std::lock_guard<std::mutex> lg(_locker);
     return _index.size();
   }
 
+  /// chunks stay visible to readers until release_frozen().
   std::vector<MemChunk_Ptr> drop_N(size_t n) {
     std::vector<MemChunk_Ptr> result;
     result.reserve(n);
@@ -60,6 +67,7 @@ struct TimeTrack : public IMeasStorage, public std::enable_shared_from_this<Time
       while (!_index.empty()) {
         auto front = _index.begin();
         result.push_back(front->second);
+        _frozen.push_back(front->second);
         _index.erase(front);
         --cnt;
         if (cnt == size_t(0)) {
@@ -67,10 +75,30 @@ struct TimeTrack : public IMeasStorage, public std::enable_shared_from_this<Time
         }
       }
     }
-    rereadMinMax();
     return result;
   }
 
+  /// like drop_N, but for the one chunk. false, if it was replaced or dropped.
+  bool freeze(const MemChunk_Ptr &c) {
+    std::lock_guard<std::mutex> lg(_locker);
+    auto it = _index.find(c->header->stat.maxTime);
+    if (it == _index.end() || it->second != c) {
+      return false;
+    }
+    _frozen.push_back(c);
+    _index.erase(it);
+    return true;
+  }
+
+  /// when dropped chunks are in a page.
+  void release_frozen() {
+    {
+      std::lock_guard<std::mutex> lg(_locker);
+      _frozen.clear();
+    }
+    rereadMinMax();
+  }
+
   size_t drop_Old(Time t) {
     std::lock_guard<std::mutex> lg(_locker);
     size_t erased = 0;
@@ -102,10 +130,12 @@ struct TimeTrack : public IMeasStorage, public std::enable_shared_from_this<Time
   MeasMinMax _min_max;
   Time _max_sync_time;
   Time _step;
+  Time _chunk_time_span;
   MemChunk_Ptr _cur_chunk;
   std::mutex _locker;
   // stx::btree_map<Time, MemChunk_Ptr> _index;
   std::map<Time, MemChunk_Ptr> _index;
+  std::vector<MemChunk_Ptr> _frozen; // dropped, but page is not published yet.
   MemoryChunkContainer *_mcc;
 };
 } // namespace storage
@@ -36,59 +36,50 @@ bool have_overlap(const std::vector<ChunkLink> &links) {
 
 std::shared_ptr<std::list<HdrAndBuffer>>
 compressValues(const MeasArray &to_compress, PageFooter &phdr, uint32_t max_chunk_size) {
-  using namespace dariadb::utils::async;
+  // runs in the caller thread: the caller is a DISK_IO task and waiting for a COMMON
+  // task here can deadlock with readers, which wait for DISK_IO from COMMON.
   auto results = std::make_shared<std::list<HdrAndBuffer>>();
-
-  utils::async::AsyncTask at = [&results, &phdr, max_chunk_size,
-                                &to_compress](const utils::async::ThreadInfo &ti) {
-    using namespace dariadb::utils::async;
-    TKIND_CHECK(dariadb::utils::async::THREAD_KINDS::COMMON, ti.kind);
-    auto begin = to_compress.cbegin();
-    auto end = to_compress.cend();
-    auto it = begin;
+  auto begin = to_compress.cbegin();
+  auto end = to_compress.cend();
+  auto it = begin;
+  while (it != end) {
+    ChunkHeader hdr;
+    boost::shared_array<uint8_t> buffer_ptr{new uint8_t[max_chunk_size]};
+    memset(buffer_ptr.get(), 0, max_chunk_size);
+    auto ch = Chunk::create(&hdr, buffer_ptr.get(), max_chunk_size, *it);
+    ++it;
     while (it != end) {
-      ChunkHeader hdr;
-      boost::shared_array<uint8_t> buffer_ptr{new uint8_t[max_chunk_size]};
-      memset(buffer_ptr.get(), 0, max_chunk_size);
-      auto ch = Chunk::create(&hdr, buffer_ptr.get(), max_chunk_size, *it);
-      ++it;
-      while (it != end) {
-        if (!ch->append(*it)) {
-          break;
-        }
-        ++it;
+      if (!ch->append(*it)) {
+        break;
       }
-      ch->close();
+      ++it;
+    }
+    ch->close();
 
-      phdr.max_chunk_id++;
+    phdr.max_chunk_id++;
 
-      ch->header->id = phdr.max_chunk_id;
+    ch->header->id = phdr.max_chunk_id;
 
-      phdr.stat.update(ch->header->stat);
+    phdr.stat.update(ch->header->stat);
 
-      HdrAndBuffer subres;
-      subres.hdr = hdr;
-      subres.buffer = buffer_ptr;
+    HdrAndBuffer subres;
+    subres.hdr = hdr;
+    subres.buffer = buffer_ptr;
 
-      results->push_back(subres);
-    }
-    return false;
-  };
-  auto cur_async = ThreadManager::instance()->post(THREAD_KINDS::COMMON, AT(at));
-  cur_async->wait();
+    results->push_back(subres);
+  }
   return results;
 }
 
-uint64_t writeToFile(FILE *file, FILE *index_file, PageFooter &phdr, IndexFooter &ihdr,
+uint64_t writeToFile(PageWriter *file, std::vector<IndexReccord> &ireccords,
+                     PageFooter &phdr, IndexFooter &ihdr,
                      std::list<HdrAndBuffer> &compressed_results, uint64_t file_size) {
 
   using namespace dariadb::utils::async;
   uint64_t page_size = 0;
 
   uint64_t offset = file_size;
-  std::vector<IndexReccord> ireccords;
-  ireccords.resize(compressed_results.size());
-  size_t pos = 0;
+  ireccords.reserve(ireccords.size() + compressed_results.size());
   for (auto hb : compressed_results) {
     ChunkHeader chunk_header = hb.hdr;
     auto chunk_buffer_ptr = hb.buffer;
@@ -110,17 +101,13 @@ uint64_t writeToFile(FILE *file, FILE *index_file, PageFooter &phdr, IndexFooter
       ch->close();
     }
 #endif
-    std::fwrite(&(chunk_header), sizeof(ChunkHeader), 1, file);
-    std::fwrite(chunk_buffer_ptr.get() + skip_count, sizeof(uint8_t), chunk_header.size,
-                file);
+    file->write(chunk_header);
+    file->write(chunk_buffer_ptr.get() + skip_count, chunk_header.size);
 
     offset += sizeof(ChunkHeader) + chunk_header.size;
 
-    auto index_reccord = init_chunk_index_rec(chunk_header, &ihdr);
-    ireccords[pos] = index_reccord;
-    pos++;
+    ireccords.push_back(init_chunk_index_rec(chunk_header, &ihdr));
   }
-  std::fwrite(ireccords.data(), sizeof(IndexReccord), ireccords.size(), index_file);
   page_size = offset;
   ihdr.stat = phdr.stat;
   ENSURE(memcmp(&phdr.stat, &ihdr.stat, sizeof(Statistic)) == 0);
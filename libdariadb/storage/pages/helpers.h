@@ -3,6 +3,7 @@
 #include <libdariadb/storage/chunk.h>
 #include <libdariadb/storage/pages/index.h>
 #include <libdariadb/storage/pages/page.h>
+#include <libdariadb/storage/pages/page_writer.h>
 #include <fstream>
 #include <map>
 #include <tuple>
@@ -21,7 +22,9 @@ struct HdrAndBuffer {
 std::shared_ptr<std::list<HdrAndBuffer>>
 compressValues(const MeasArray &to_compress, PageFooter &phdr, uint32_t max_chunk_size);
 
-uint64_t writeToFile(FILE *file, FILE *index_file, PageFooter &phdr, IndexFooter &,
+/// ireccords - index reccords of writed chunks, will be writed by PageIndex::write.
+uint64_t writeToFile(PageWriter *file, std::vector<IndexReccord> &ireccords,
+                     PageFooter &phdr, IndexFooter &,
                      std::list<HdrAndBuffer> &compressed_results, uint64_t file_size = 0);
 
 IndexReccord init_chunk_index_rec(const ChunkHeader &cheader, IndexFooter *iheader);
@@ -12,7 +12,8 @@ using namespace dariadb;
 using namespace dariadb::storage;
 using dariadb::utils::inInterval;
 
-inline bool check_index_rec(IndexReccord &it, dariadb::Time from, dariadb::Time to) {
+inline bool check_index_rec(const IndexReccord &it, dariadb::Time from,
+                            dariadb::Time to) {
   return inInterval(from, to, it.stat.minTime) || inInterval(from, to, it.stat.maxTime) ||
          inInterval(it.stat.minTime, it.stat.maxTime, from) ||
          inInterval(it.stat.minTime, it.stat.maxTime, to);
@@ -30,32 +31,80 @@ inline bool check_blooms(const IndexReccord &_index_it, dariadb::Id id,
   return id_check_result && flag_bloom_result;
 }
 
+// (id, time) order of sorted index.
+inline bool key_less(uint64_t id1, dariadb::Time t1, uint64_t id2, dariadb::Time t2) {
+  return id1 < id2 || (id1 == id2 && t1 < t2);
+}
+
 PageIndex::~PageIndex() {}
 
-PageIndex_ptr PageIndex::open(const std::string &_filename) {
+size_t PageIndex::blocks_count(uint64_t reccords_count) {
+  // small index is searched without sparse index.
+  if (reccords_count <= INDEX_BLOCK_SIZE) {
+    return 0;
+  }
+  return (reccords_count + INDEX_BLOCK_SIZE - 1) / INDEX_BLOCK_SIZE;
+}
+
+void PageIndex::write(PageWriter *out, std::vector<IndexReccord> &reccords,
+                      IndexFooter &footer) {
+  std::sort(reccords.begin(), reccords.end(),
+            [](const IndexReccord &l, const IndexReccord &r) {
+              return key_less(l.target_id, l.stat.minTime, r.target_id, r.stat.minTime);
+            });
+  out->write(reccords.data(), sizeof(IndexReccord) * reccords.size());
+
+  std::vector<IndexBlock> blocks(blocks_count(reccords.size()));
+  for (size_t i = 0; i < blocks.size(); ++i) {
+    auto &first = reccords[i * INDEX_BLOCK_SIZE];
+    blocks[i].target_id = first.target_id;
+    blocks[i].minTime = first.stat.minTime;
+  }
+  out->write(blocks.data(), sizeof(IndexBlock) * blocks.size());
+
+  footer.recs_count = reccords.size();
+  footer.is_sorted = true;
+  footer.ftr_end = MAGIC_NUMBER_INDEXFTR_SORTED;
+  out->write(footer);
+}
+
+PageIndex_ptr PageIndex::open(const std::string &_filename, bool mmap_read) {
   PageIndex_ptr res = std::make_shared<PageIndex>();
   res->filename = _filename;
-  res->iheader = readIndexFooter(_filename);
+  if (!mmap_read) {
+    res->iheader = readIndexFooter(_filename);
+    return res;
+  }
+  // index is always scanned from begin to end.
+  res->_mapping = utils::fs::MappedFile::open(
+      _filename, utils::fs::MappedFile::ACCESS_PATTERN::SEQUENTIAL);
+  auto size = res->_mapping->size();
+  if (size < sizeof(IndexFooter)) {
+    THROW_EXCEPTION("IndexFooter magic number check.");
+  }
+  memcpy(&res->iheader, res->_mapping->data() + size - sizeof(IndexFooter),
+         sizeof(IndexFooter));
+  if (!res->iheader.check()) {
+    THROW_EXCEPTION("IndexFooter magic number check.");
+  }
+  uint64_t data_size = res->iheader.recs_count * sizeof(IndexReccord);
+  if (res->iheader.sorted()) {
+    data_size += blocks_count(res->iheader.recs_count) * sizeof(IndexBlock);
+  }
+  if (res->iheader.recs_count > size || data_size > size - sizeof(IndexFooter)) {
+    THROW_EXCEPTION("engine: index read error - ", _filename);
+  }
   return res;
 }
 
 ChunkLinkList PageIndex::get_chunks_links(const dariadb::IdArray &ids, dariadb::Time from,
                                           dariadb::Time to, dariadb::Flag flag) {
-  ChunkLinkList result;
-  IndexReccord *records = new IndexReccord[this->iheader.recs_count];
-  auto index_file = std::fopen(filename.c_str(), "rb");
-  if (index_file == nullptr) {
-    delete[] records;
-    THROW_EXCEPTION("can`t open file ", this->filename);
-  }
-
-  auto readed = std::fread(records, sizeof(IndexReccord), iheader.recs_count, index_file);
-  if (readed < iheader.recs_count) {
-    delete[] records;
-    THROW_EXCEPTION("engine: index read error - ", this->filename);
+  if (iheader.sorted() && !ids.empty()) {
+    return get_sorted_chunks_links(ids, from, to, flag);
   }
-  std::fclose(index_file);
-  for (uint32_t pos = 0; pos < this->iheader.recs_count; ++pos) {
+  ChunkLinkList result;
+  auto records = readReccords();
+  for (uint32_t pos = 0; pos < records.size(); ++pos) {
 
     auto _index_it = records[pos];
     if (check_index_rec(_index_it, from, to)) {
@@ -81,26 +130,103 @@ ChunkLinkList PageIndex::get_chunks_links(const dariadb::IdArray &ids, dariadb::
       }
     }
   }
-  delete[] records;
+  return result;
+}
 
+ChunkLinkList PageIndex::get_sorted_chunks_links(const dariadb::IdArray &ids,
+                                                 dariadb::Time from, dariadb::Time to,
+                                                 dariadb::Flag flag) {
+  ChunkLinkList result;
+  dariadb::IdArray sorted_ids(ids.begin(), ids.end());
+  std::sort(sorted_ids.begin(), sorted_ids.end());
+  sorted_ids.erase(std::unique(sorted_ids.begin(), sorted_ids.end()), sorted_ids.end());
+
+  auto blocks = readBlocks();
+  for (auto id : sorted_ids) {
+    // reccords of id with minTime<=to are in [first, last).
+    size_t first = 0;
+    size_t last = size_t(iheader.recs_count);
+    if (blocks.size() != 0) {
+      auto block_less = [](const IndexBlock &b, dariadb::Id v) {
+        return key_less(b.target_id, b.minTime, v, MIN_TIME);
+      };
+      auto less_block = [to](dariadb::Id v, const IndexBlock &b) {
+        return key_less(v, to, b.target_id, b.minTime);
+      };
+      auto lower = std::lower_bound(blocks.begin(), blocks.end(), id, block_less);
+      auto upper = std::upper_bound(blocks.begin(), blocks.end(), id, less_block);
+      auto first_block = size_t(std::distance(blocks.begin(), lower));
+      first = first_block == 0 ? 0 : (first_block - 1) * INDEX_BLOCK_SIZE;
+      last = std::min(last, size_t(std::distance(blocks.begin(), upper)) *
+                                INDEX_BLOCK_SIZE);
+    }
+    if (first >= last) {
+      continue;
+    }
+    auto records = readReccords(first, last - first);
+    // skip reccords of previous ids.
+    auto it = std::lower_bound(
+        records.begin(), records.end(), id,
+        [](const IndexReccord &r, dariadb::Id v) { return r.target_id < v; });
+    for (; it != records.end(); ++it) {
+      auto &rec = *it;
+      if (rec.target_id != id || rec.stat.minTime > to) {
+        break;
+      }
+      if (check_index_rec(rec, from, to) && check_blooms(rec, id, flag)) {
+        ChunkLink sub_result;
+        sub_result.id = rec.chunk_id;
+        sub_result.index_rec_number = first + std::distance(records.begin(), it);
+        sub_result.minTime = rec.stat.minTime;
+        sub_result.maxTime = rec.stat.maxTime;
+        sub_result.meas_id = rec.target_id;
+        result.push_back(sub_result);
+      }
+    }
+  }
   return result;
 }
 
-std::vector<IndexReccord> PageIndex::readReccords() {
-  std::vector<IndexReccord> records;
-  records.resize(iheader.recs_count);
+IndexReccords PageIndex::readReccords() {
+  return readReccords(0, size_t(iheader.recs_count));
+}
+
+IndexReccords PageIndex::readReccords(size_t first, size_t count) {
+  ENSURE(first + count <= iheader.recs_count);
+  if (_mapping != nullptr) {
+    auto begin = reinterpret_cast<const IndexReccord *>(_mapping->data()) + first;
+    return IndexReccords(begin, count, _mapping);
+  }
+  return IndexReccords(readArray<IndexReccord>(first * sizeof(IndexReccord), count));
+}
+
+IndexBlocks PageIndex::readBlocks() {
+  size_t count = iheader.sorted() ? blocks_count(iheader.recs_count) : 0;
+  auto offset = iheader.recs_count * sizeof(IndexReccord);
+  if (_mapping != nullptr) {
+    auto begin = reinterpret_cast<const IndexBlock *>(_mapping->data() + offset);
+    return IndexBlocks(begin, count, _mapping);
+  }
+  return IndexBlocks(readArray<IndexBlock>(offset, count));
+}
 
+template <class T>
+std::vector<T> PageIndex::readArray(uint64_t offset, size_t count) const {
+  std::vector<T> result(count);
+  if (count == 0) {
+    return result;
+  }
   auto index_file = std::fopen(filename.c_str(), "rb");
   if (index_file == nullptr) {
     THROW_EXCEPTION("can`t open file ", this->filename);
   }
-  auto readed =
-      std::fread(records.data(), sizeof(IndexReccord), iheader.recs_count, index_file);
-  if (readed < iheader.recs_count) {
+  std::fseek(index_file, long(offset), SEEK_SET);
+  auto readed = std::fread(result.data(), sizeof(T), count, index_file);
+  std::fclose(index_file);
+  if (readed < count) {
     THROW_EXCEPTION("engine: index read error - ", this->filename);
   }
-  std::fclose(index_file);
-  return records;
+  return result;
 }
 
 IndexFooter PageIndex::readIndexFooter(std::string ifile) {
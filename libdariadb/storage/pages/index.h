@@ -3,6 +3,7 @@
 #include <libdariadb/storage/chunk.h>
 #include <libdariadb/storage/chunkcontainer.h>
 #include <libdariadb/storage/magic.h>
+#include <libdariadb/storage/pages/page_writer.h>
 #include <libdariadb/utils/fs.h>
 
 namespace dariadb {
@@ -10,7 +11,7 @@ namespace storage {
 #pragma pack(push, 1)
 struct IndexFooter {
   uint64_t magic_number;
-  bool is_sorted; // items in index file sorted by time
+  bool is_sorted; // items in index file sorted by (id, minTime)
   Id target_id;   // measurement id
 
   Statistic stat;
@@ -38,11 +39,14 @@ struct IndexFooter {
     if (magic_number != MAGIC_NUMBER_DARIADB) {
       return false;
     }
-    if (ftr_end != MAGIC_NUMBER_INDEXFTR) {
+    if (ftr_end != MAGIC_NUMBER_INDEXFTR && ftr_end != MAGIC_NUMBER_INDEXFTR_SORTED) {
       return false;
     }
     return true;
   }
+
+  /// file has sorted reccords and sparse index (see PageIndex::write).
+  bool sorted() const { return ftr_end == MAGIC_NUMBER_INDEXFTR_SORTED; }
 };
 
 struct IndexReccord {
@@ -56,8 +60,41 @@ struct IndexReccord {
     offset = 0;
   }
 };
+
+/// sparse index: first reccord of each block of INDEX_BLOCK_SIZE reccords.
+struct IndexBlock {
+  uint64_t target_id;
+  Time minTime;
+};
 #pragma pack(pop)
 
+const size_t INDEX_BLOCK_SIZE = 64;
+
+/// items of index: view of mapped file or readed copy.
+template <class T> class IndexArray {
+public:
+  IndexArray(std::vector<T> &&copy)
+      : _copy(std::move(copy)), _begin(_copy.data()), _size(_copy.size()) {}
+  IndexArray(const T *begin, size_t size, const utils::fs::MappedFile_Ptr &mapping)
+      : _mapping(mapping), _begin(begin), _size(size) {}
+  IndexArray(IndexArray &&other) = default;
+  IndexArray(const IndexArray &) = delete;
+
+  const T &operator[](size_t pos) const { return _begin[pos]; }
+  size_t size() const { return _size; }
+  const T *begin() const { return _begin; }
+  const T *end() const { return _begin + _size; }
+
+private:
+  std::vector<T> _copy;
+  utils::fs::MappedFile_Ptr _mapping;
+  const T *_begin;
+  size_t _size;
+};
+
+using IndexReccords = IndexArray<IndexReccord>;
+using IndexBlocks = IndexArray<IndexBlock>;
+
 class PageIndex;
 typedef std::shared_ptr<PageIndex> PageIndex_ptr;
 class PageIndex {
@@ -67,16 +104,31 @@ public:
   IndexFooter iheader;
 
   ~PageIndex();
-  static PageIndex_ptr open(const std::string &filename);
+  /// mmap_read - map file to memory instead of reading on each query.
+  static PageIndex_ptr open(const std::string &filename, bool mmap_read = false);
 
   ChunkLinkList get_chunks_links(const dariadb::IdArray &ids, dariadb::Time from,
                                  dariadb::Time to, dariadb::Flag flag);
-  std::vector<IndexReccord> readReccords();
+  IndexReccords readReccords();
+  IndexReccords readReccords(size_t first, size_t count);
+  IndexBlocks readBlocks();
   static IndexFooter readIndexFooter(std::string ifile);
+  /// sort reccords by (id, minTime) and write them with sparse index and footer.
+  static void write(PageWriter *out, std::vector<IndexReccord> &reccords,
+                    IndexFooter &footer);
+  static size_t blocks_count(uint64_t reccords_count);
 
   static std::string index_name_from_page_name(const std::string &page_name) {
     return page_name + "i";
   }
+
+private:
+  /// binary search in sorted index.
+  ChunkLinkList get_sorted_chunks_links(const dariadb::IdArray &ids, dariadb::Time from,
+                                        dariadb::Time to, dariadb::Flag flag);
+  template <class T> std::vector<T> readArray(uint64_t offset, size_t count) const;
+
+  utils::fs::MappedFile_Ptr _mapping;
 };
 }
 } // namespace dariadb
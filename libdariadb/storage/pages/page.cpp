@@ -47,30 +47,36 @@ MeasArray applyFilter(MeasArray &inputValues, ICompactionController *logic) {
 
 void writeChunkToResultPage(std::unordered_map<std::string, ChunkLinkList> &fname2links,
                             std::unordered_map<std::string, Page_Ptr> &openned_pages,
-                            PageFooter &phdr, IndexFooter &ihdr, FILE *out_file,
-                            FILE *out_index_file) {
+                            PageFooter &phdr, IndexFooter &ihdr,
+                            PageWriter *out_file,
+                            std::vector<IndexReccord> &ireccords) {
   for (auto f2l : fname2links) {
     auto p = openned_pages[f2l.first];
-    auto chunk_callback = [&phdr, &ihdr, &out_index_file,
+    auto chunk_callback = [&phdr, &ihdr, &ireccords,
                            &out_file](const Chunk_Ptr &chunk) {
       // chunk->close();
-      chunk->is_owner = false;
       if (!chunk->checkChecksum()) {
         THROW_EXCEPTION("checksum error");
       }
       auto hdr_ptr = chunk->header;
       PageInner::HdrAndBuffer hab;
-      hab.buffer = boost::shared_array<uint8_t>(chunk->_buffer_t);
       hab.hdr = *(hdr_ptr);
+      if (chunk->is_owner) {
+        chunk->is_owner = false;
+        hab.buffer = boost::shared_array<uint8_t>(chunk->_buffer_t);
+        delete hdr_ptr;
+      } else { // view of mapped page.
+        hab.buffer = boost::shared_array<uint8_t>(new uint8_t[hab.hdr.size]);
+        memcpy(hab.buffer.get(), chunk->_buffer_t, hab.hdr.size);
+      }
       phdr.max_chunk_id++;
       hab.hdr.id = phdr.max_chunk_id;
 
       std::list<PageInner::HdrAndBuffer> compressed_results{hab};
-      auto page_size = PageInner::writeToFile(out_file, out_index_file, phdr, ihdr,
+      auto page_size = PageInner::writeToFile(out_file, ireccords, phdr, ihdr,
                                               compressed_results, phdr.filesize);
 
       phdr.filesize = page_size;
-      delete hdr_ptr;
       return false;
     };
     p->apply_to_chunks(f2l.second, chunk_callback);
@@ -87,13 +93,15 @@ Page::~Page() {
 struct page_create_write_description {
   PageFooter phdr;
   IndexFooter ihdr;
+  std::vector<IndexReccord> ireccords;
   page_create_write_description(uint16_t lvl, uint64_t chunk_id)
       : phdr(lvl, chunk_id), ihdr() {}
 };
 
 bool create_write_logic(
-    std::shared_ptr<std::list<PageInner::HdrAndBuffer>> compressed_results, FILE *file,
-    FILE *index_file, std::shared_ptr<page_create_write_description> d,
+    std::shared_ptr<std::list<PageInner::HdrAndBuffer>> compressed_results,
+    PageWriter_Ptr file, PageWriter_Ptr index_file,
+    std::shared_ptr<page_create_write_description> d,
     const std::string &file_name, on_create_complete_callback on_complete) {
   if (!compressed_results->empty()) {
     std::list<PageInner::HdrAndBuffer> subresult;
@@ -105,8 +113,8 @@ bool create_write_logic(
       compressed_results->pop_front();
     }
     if (!subresult.empty()) {
-      auto page_size = PageInner::writeToFile(file, index_file, d->phdr, d->ihdr,
-                                              subresult, d->phdr.filesize);
+      auto page_size = PageInner::writeToFile(file.get(), d->ireccords, d->phdr,
+                                              d->ihdr, subresult, d->phdr.filesize);
       d->phdr.filesize = page_size;
     }
     if (!compressed_results->empty()) {
@@ -115,11 +123,11 @@ bool create_write_logic(
   }
   d->ihdr.level = d->phdr.level;
   ENSURE(memcmp(&d->phdr.stat, &d->ihdr.stat, sizeof(Statistic)) == 0);
-  std::fwrite((char *)&d->phdr, sizeof(PageFooter), 1, file);
-  std::fclose(file);
+  file->write(d->phdr);
+  file->close();
 
-  std::fwrite(&d->ihdr, sizeof(IndexFooter), 1, index_file);
-  std::fclose(index_file);
+  PageIndex::write(index_file.get(), d->ireccords, d->ihdr);
+  index_file->close();
   auto result = Page::open(file_name, d->phdr);
   on_complete(result);
   return false;
@@ -127,7 +135,7 @@ bool create_write_logic(
 
 void Page::create(const std::string &file_name, uint16_t lvl, uint64_t chunk_id,
                   uint32_t max_chunk_size, const MeasArray &to_compress,
-                  on_create_complete_callback on_complete) {
+                  on_create_complete_callback on_complete, bool direct_io) {
   ENSURE(!to_compress.empty());
 #ifdef DOUBLE_CHECKS
   for (const auto &m : to_compress) {
@@ -138,18 +146,9 @@ void Page::create(const std::string &file_name, uint16_t lvl, uint64_t chunk_id,
   PageFooter phdr(lvl, chunk_id);
 
   auto compressed_results = PageInner::compressValues(to_compress, phdr, max_chunk_size);
-  auto file = std::fopen(file_name.c_str(), "ab");
-  if (file == nullptr) {
-    THROW_EXCEPTION("file is null");
-  }
-
-  IndexFooter ihdr;
-
-  auto index_file =
-      std::fopen(PageIndex::index_name_from_page_name(file_name).c_str(), "ab");
-  if (index_file == nullptr) {
-    THROW_EXCEPTION("can`t open file ", file_name);
-  }
+  auto file = std::make_shared<PageWriter>(file_name, direct_io);
+  auto index_file = std::make_shared<PageWriter>(
+      PageIndex::index_name_from_page_name(file_name), direct_io);
 
   auto d = std::make_shared<page_create_write_description>(0, 0);
   d->phdr = phdr;
@@ -165,7 +164,7 @@ void Page::create(const std::string &file_name, uint16_t lvl, uint64_t chunk_id,
 Page_Ptr Page::repackTo(const std::string &file_name, uint16_t lvl, uint64_t chunk_id,
                         uint32_t max_chunk_size,
                         const std::list<std::string> &pages_full_paths,
-                        ICompactionController *logic) {
+                        ICompactionController *logic, bool direct_io) {
   std::unordered_map<std::string, Page_Ptr> openned_pages;
   openned_pages.reserve(pages_full_paths.size());
 
@@ -194,16 +193,11 @@ Page_Ptr Page::repackTo(const std::string &file_name, uint16_t lvl, uint64_t chu
   ENSURE(phdr.max_chunk_id == chunk_id);
 
   IndexFooter ihdr;
+  std::vector<IndexReccord> ireccords;
 
-  auto out_file = std::fopen(file_name.c_str(), "ab");
-  if (out_file == nullptr) {
-    THROW_EXCEPTION("file is null");
-  }
   auto index_file_name = PageIndex::index_name_from_page_name(file_name);
-  auto out_index_file = std::fopen(index_file_name.c_str(), "ab");
-  if (out_index_file == nullptr) {
-    THROW_EXCEPTION("can`t open file ", file_name);
-  }
+  PageWriter out_file(file_name, direct_io);
+  PageWriter out_index_file(index_file_name, direct_io);
 
   for (auto &kv : links) {
     auto lst = kv.second;
@@ -218,8 +212,8 @@ Page_Ptr Page::repackTo(const std::string &file_name, uint16_t lvl, uint64_t chu
         fname2links[link.page_name].push_back(link);
       }
 
-      page_utils::writeChunkToResultPage(fname2links, openned_pages, phdr, ihdr, out_file,
-                                         out_index_file);
+      page_utils::writeChunkToResultPage(fname2links, openned_pages, phdr, ihdr,
+                                         &out_file, ireccords);
     } else {
       size_t stored_values_count = size_t(0);
 
@@ -256,7 +250,7 @@ Page_Ptr Page::repackTo(const std::string &file_name, uint16_t lvl, uint64_t chu
       if (!ma.empty()) {
         auto compressed_results = PageInner::compressValues(ma, phdr, max_chunk_size);
 
-        auto page_size = PageInner::writeToFile(out_file, out_index_file, phdr, ihdr,
+        auto page_size = PageInner::writeToFile(&out_file, ireccords, phdr, ihdr,
                                                 *compressed_results, phdr.filesize);
         phdr.filesize = page_size;
       }
@@ -265,12 +259,12 @@ Page_Ptr Page::repackTo(const std::string &file_name, uint16_t lvl, uint64_t chu
 
   ENSURE(memcmp(&phdr.stat, &ihdr.stat, sizeof(Statistic)) == 0);
 
-  std::fwrite((char *)&phdr, sizeof(PageFooter), 1, out_file);
-  std::fclose(out_file);
+  out_file.write(phdr);
+  out_file.close();
   ihdr.level = phdr.level;
 
-  std::fwrite(&ihdr, sizeof(IndexFooter), 1, out_index_file);
-  std::fclose(out_index_file);
+  PageIndex::write(&out_index_file, ireccords, ihdr);
+  out_index_file.close();
   if (phdr.stat.count == 0) {
     utils::fs::rm(file_name);
     utils::fs::rm(index_file_name);
@@ -281,23 +275,14 @@ Page_Ptr Page::repackTo(const std::string &file_name, uint16_t lvl, uint64_t chu
 
 // chunks from memstorage.
 Page_Ptr Page::create(const std::string &file_name, uint16_t lvl, uint64_t chunk_id,
-                      const std::vector<Chunk *> &a, size_t count) {
+                      const std::vector<Chunk *> &a, size_t count, bool direct_io) {
   using namespace dariadb::utils::async;
 
   PageFooter phdr(lvl, chunk_id);
-
-  auto file = std::fopen(file_name.c_str(), "ab");
-  if (file == nullptr) {
-    throw MAKE_EXCEPTION("WALFile: append error.");
-  }
-
   IndexFooter ihdr;
 
-  auto index_file =
-      std::fopen(PageIndex::index_name_from_page_name(file_name).c_str(), "ab");
-  if (index_file == nullptr) {
-    THROW_EXCEPTION("can`t open file ", file_name);
-  }
+  PageWriter file(file_name, direct_io);
+  PageWriter index_file(PageIndex::index_name_from_page_name(file_name), direct_io);
 
   uint64_t offset = 0;
   size_t page_size = 0;
@@ -306,8 +291,15 @@ Page_Ptr Page::create(const std::string &file_name, uint16_t lvl, uint64_t chunk
   size_t pos = 0;
 
   for (size_t i = 0; i < count; ++i) {
-    ChunkHeader *chunk_header = a[i]->header;
-    auto chunk_buffer_ptr = a[i]->_buffer_t;
+    // chunk of memstorage is readable until drop is published, so codec is
+    // selected on a copy.
+    ChunkHeader hdr_copy = *a[i]->header;
+    boost::shared_array<uint8_t> buffer_copy{new uint8_t[hdr_copy.size]};
+    memcpy(buffer_copy.get(), a[i]->_buffer_t, hdr_copy.size);
+    Chunk::open(&hdr_copy, buffer_copy.get())->close();
+
+    ChunkHeader *chunk_header = &hdr_copy;
+    auto chunk_buffer_ptr = buffer_copy.get();
 #ifdef DEBUG
     {
       auto ch = Chunk::open(chunk_header, chunk_buffer_ptr);
@@ -348,8 +340,8 @@ Page_Ptr Page::create(const std::string &file_name, uint16_t lvl, uint64_t chunk
     }
 #endif //  DEBUG
 
-    std::fwrite(chunk_header, sizeof(ChunkHeader), 1, file);
-    std::fwrite(chunk_buffer_ptr + skip_count, sizeof(uint8_t), chunk_header->size, file);
+    file.write(*chunk_header);
+    file.write(chunk_buffer_ptr + skip_count, chunk_header->size);
 
     offset += sizeof(ChunkHeader) + chunk_header->size;
 
@@ -361,26 +353,43 @@ Page_Ptr Page::create(const std::string &file_name, uint16_t lvl, uint64_t chunk
   ENSURE(memcmp(&phdr.stat, &ihdr.stat, sizeof(Statistic)) == 0);
   page_size = offset;
   phdr.filesize = page_size;
-  std::fwrite(&(phdr), sizeof(PageFooter), 1, file);
-  std::fclose(file);
+  file.write(phdr);
+  file.close();
 
-  std::fwrite(ireccords.data(), sizeof(IndexReccord), ireccords.size(), index_file);
   ihdr.level = phdr.level;
-  std::fwrite(&ihdr, sizeof(IndexFooter), 1, index_file);
-  std::fclose(index_file);
+  PageIndex::write(&index_file, ireccords, ihdr);
+  index_file.close();
 
   return Page::open(file_name, phdr);
 }
 
-Page_Ptr Page::open(const std::string &file_name) {
-  auto phdr = Page::readFooter(file_name);
-  auto res = new Page(phdr, file_name);
-
-  res->filename = file_name;
-  res->_index = PageIndex::open(PageIndex::index_name_from_page_name(file_name));
-
-  res->footer = phdr;
-  return Page_Ptr{res};
+Page_Ptr Page::open(const std::string &file_name, bool mmap_read) {
+  if (!mmap_read) {
+    auto phdr = Page::readFooter(file_name);
+    auto res = new Page(phdr, file_name);
+
+    res->filename = file_name;
+    res->_index = PageIndex::open(PageIndex::index_name_from_page_name(file_name));
+
+    res->footer = phdr;
+    return Page_Ptr{res};
+  }
+  // queries read only some chunks of page.
+  using utils::fs::MappedFile;
+  auto mapping = MappedFile::open(file_name, MappedFile::ACCESS_PATTERN::RANDOM);
+  PageFooter phdr(0, 0);
+  if (mapping->size() < sizeof(PageFooter)) {
+    THROW_EXCEPTION("PageFooter magic number check.");
+  }
+  memcpy(&phdr, mapping->data() + mapping->size() - sizeof(PageFooter),
+         sizeof(PageFooter));
+  if (!phdr.check()) {
+    THROW_EXCEPTION("PageFooter magic number check.");
+  }
+  auto res = Page_Ptr{new Page(phdr, file_name)};
+  res->_mapping = mapping;
+  res->_index = PageIndex::open(PageIndex::index_name_from_page_name(file_name), true);
+  return res;
 }
 
 Page_Ptr Page::open(const std::string &file_name, const PageFooter &phdr) {
@@ -431,53 +440,53 @@ bool Page::checksum() {
   using dariadb::timeutil::to_string;
   logger_info("engine: checksum page ", this->filename);
 
-  auto page_io = std::fopen(filename.c_str(), "rb");
-  if (page_io == nullptr) {
-    THROW_EXCEPTION("can`t open file ", this->filename);
+  if (_mapping != nullptr) {
+    _mapping->advise(utils::fs::MappedFile::ACCESS_PATTERN::SEQUENTIAL);
   }
+  auto page_io = openToRead();
   bool result = true;
   auto indexReccords = _index->readReccords();
-  for (auto it : indexReccords) {
-    Chunk_Ptr c = readChunkByOffset(page_io, it.offset);
+  for (auto &it : indexReccords) {
+    Chunk_Ptr c = readChunkAt(page_io, it.offset);
     if (!c->checkChecksum()) {
       result = false;
       break;
     }
   }
 
-  std::fclose(page_io);
+  closeAfterRead(page_io);
   return result;
 }
 
 void Page::update_index_recs(const PageFooter &phdr) {
-  auto index_file =
-      std::fopen(PageIndex::index_name_from_page_name(filename).c_str(), "ab");
-  if (index_file == nullptr) {
-    THROW_EXCEPTION("can`t open file ", this->filename);
-  }
   auto page_io = std::fopen(filename.c_str(), "rb");
   if (page_io == nullptr) {
     THROW_EXCEPTION("can`t open file ", this->filename);
   }
 
   IndexFooter ihdr;
+  std::vector<IndexReccord> ireccords;
+  ireccords.reserve(phdr.addeded_chunks);
 
   for (size_t i = 0; i < phdr.addeded_chunks; ++i) {
     ChunkHeader info;
     auto readed = std::fread(&info, sizeof(ChunkHeader), 1, page_io);
     if (readed < size_t(1)) {
+      std::fclose(page_io);
       THROW_EXCEPTION("engine: page read error - ", this->filename);
     }
     auto index_reccord = PageInner::init_chunk_index_rec(info, &ihdr);
     ENSURE(index_reccord.offset == info.offset_in_page);
-    std::fwrite(&index_reccord, sizeof(IndexReccord), 1, index_file);
+    ireccords.push_back(index_reccord);
 
     std::fseek(page_io, info.size, SEEK_CUR);
   }
-  ihdr.stat = phdr.stat;
-  std::fwrite(&ihdr, sizeof(IndexFooter), 1, index_file);
-  std::fclose(index_file);
   std::fclose(page_io);
+  ihdr.stat = phdr.stat;
+
+  PageWriter index_file(PageIndex::index_name_from_page_name(filename), false);
+  PageIndex::write(&index_file, ireccords, ihdr);
+  index_file.close();
 }
 
 bool Page::minMaxTime(dariadb::Id id, dariadb::Time *minTime, dariadb::Time *maxTime) {
@@ -500,6 +509,22 @@ bool Page::minMaxTime(dariadb::Id id, dariadb::Time *minTime, dariadb::Time *max
   return result;
 }
 
+Chunk_Ptr Page::readChunk(const std::string &file_name, uint64_t offset) {
+  auto page_io = std::fopen(file_name.c_str(), "rb");
+  if (page_io == nullptr) {
+    THROW_EXCEPTION("can`t open file ", file_name);
+  }
+  Chunk_Ptr result = nullptr;
+  try {
+    result = readChunkByOffset(page_io, (int)offset);
+  } catch (...) {
+    std::fclose(page_io);
+    throw;
+  }
+  std::fclose(page_io);
+  return result;
+}
+
 Chunk_Ptr Page::readChunkByOffset(FILE *page_io, int offset) {
   std::fseek(page_io, offset, SEEK_SET);
   ChunkHeader *cheader = new ChunkHeader;
@@ -529,6 +554,49 @@ Chunk_Ptr Page::readChunkByOffset(FILE *page_io, int offset) {
   return ptr;
 }
 
+FILE *Page::openToRead() {
+  if (_mapping != nullptr) {
+    return nullptr;
+  }
+  auto page_io = std::fopen(filename.c_str(), "rb");
+  if (page_io == nullptr) {
+    THROW_EXCEPTION("can`t open file ", this->filename);
+  }
+  return page_io;
+}
+
+void Page::closeAfterRead(FILE *page_io) {
+  if (page_io != nullptr) {
+    std::fclose(page_io);
+  }
+}
+
+Chunk_Ptr Page::readChunkAt(FILE *page_io, uint64_t offset) {
+  if (_mapping == nullptr) {
+    return readChunkByOffset(page_io, (int)offset);
+  }
+  // without copy: chunk is a view of mapping and keeps it alive.
+  auto data_size = _mapping->size() - sizeof(PageFooter);
+  if (offset + sizeof(ChunkHeader) > data_size) {
+    THROW_EXCEPTION("engine: page read error - ", this->filename);
+  }
+  auto ptr = const_cast<uint8_t *>(_mapping->data()) + offset;
+  auto cheader = reinterpret_cast<ChunkHeader *>(ptr);
+  if (offset + sizeof(ChunkHeader) + cheader->size > data_size) {
+    THROW_EXCEPTION("engine: page read error - ", this->filename);
+  }
+  Chunk_Ptr result = Chunk::open(cheader, ptr + sizeof(ChunkHeader));
+  result->memory_holder = _mapping;
+#ifdef DOUBLE_CHECKS
+  if (!result->checkChecksum()) {
+    logger_fatal("engine: bad checksum of chunk #", result->header->id,
+                 " for measurement id:", result->header->meas_id);
+    return nullptr;
+  }
+#endif
+  return result;
+}
+
 dariadb::Id2Meas Page::valuesBeforeTimePoint(const QueryTimePoint &q) {
   dariadb::Id2Meas result;
   dariadb::IdSet to_read{q.ids.begin(), q.ids.end()};
@@ -587,10 +655,7 @@ Statistic Page::stat(const Id id, Time from, Time to) {
   if (_ch_links_iterator == links.cend()) {
     return result;
   }
-  auto page_io = std::fopen(filename.c_str(), "rb");
-  if (page_io == nullptr) {
-    THROW_EXCEPTION("can`t open file ", this->filename);
-  }
+  auto page_io = openToRead();
   auto indexReccords = _index->readReccords();
   for (; _ch_links_iterator != links.cend(); ++_ch_links_iterator) {
     if (_ch_links_iterator->meas_id != id) {
@@ -601,7 +666,7 @@ Statistic Page::stat(const Id id, Time from, Time to) {
         utils::inInterval(from, to, _index_it.stat.maxTime)) {
       result.update(_index_it.stat);
     } else {
-      Chunk_Ptr c = readChunkByOffset(page_io, _index_it.offset);
+      Chunk_Ptr c = readChunkAt(page_io, _index_it.offset);
       if (c == nullptr) {
         continue;
       }
@@ -609,7 +674,7 @@ Statistic Page::stat(const Id id, Time from, Time to) {
       result.update(sub_result);
     }
   }
-  fclose(page_io);
+  closeAfterRead(page_io);
   return result;
 }
 
@@ -620,14 +685,11 @@ void Page::apply_to_chunks(const ChunkLinkList &links,
   if (_ch_links_iterator == links.cend()) {
     return;
   }
-  auto page_io = std::fopen(filename.c_str(), "rb");
-  if (page_io == nullptr) {
-    THROW_EXCEPTION("can`t open file ", this->filename);
-  }
+  auto page_io = openToRead();
   auto indexReccords = _index->readReccords();
   for (; _ch_links_iterator != links.cend(); ++_ch_links_iterator) {
-    auto _index_it = indexReccords[_ch_links_iterator->index_rec_number];
-    Chunk_Ptr c = readChunkByOffset(page_io, _index_it.offset);
+    auto &_index_it = indexReccords[_ch_links_iterator->index_rec_number];
+    Chunk_Ptr c = readChunkAt(page_io, _index_it.offset);
     if (c == nullptr) {
       continue;
     }
@@ -635,7 +697,7 @@ void Page::apply_to_chunks(const ChunkLinkList &links,
       break;
     }
   }
-  fclose(page_io);
+  closeAfterRead(page_io);
 }
 
 void Page::appendChunks(const std::vector<Chunk *> &) {
@@ -644,14 +706,14 @@ void Page::appendChunks(const std::vector<Chunk *> &) {
 
 Id2MinMax_Ptr Page::loadMinMax() {
   Id2MinMax_Ptr result = std::make_shared<Id2MinMax>();
-  auto page_io = std::fopen(filename.c_str(), "rb");
-  if (page_io == nullptr) {
-    THROW_EXCEPTION("can`t open file ", this->filename);
+  if (_mapping != nullptr) {
+    _mapping->advise(utils::fs::MappedFile::ACCESS_PATTERN::SEQUENTIAL);
   }
+  auto page_io = openToRead();
   auto indexReccords = _index->readReccords();
   for (uint32_t i = 0; i < footer.addeded_chunks; ++i) {
-    auto _index_it = indexReccords[i];
-    Chunk_Ptr search_res = readChunkByOffset(page_io, _index_it.offset);
+    auto &_index_it = indexReccords[i];
+    Chunk_Ptr search_res = readChunkAt(page_io, _index_it.offset);
     if (search_res == nullptr) {
       continue;
     }
@@ -660,6 +722,6 @@ Id2MinMax_Ptr Page::loadMinMax() {
     fres.v->second.updateMax(info->first());
     fres.v->second.updateMin(info->last());
   }
-  std::fclose(page_io);
+  closeAfterRead(page_io);
   return result;
 }
@@ -6,6 +6,7 @@
 #include <libdariadb/storage/chunkcontainer.h>
 #include <libdariadb/storage/magic.h>
 #include <libdariadb/storage/pages/index.h>
+#include <libdariadb/storage/pages/page_writer.h>
 #include <libdariadb/utils/fs.h>
 
 namespace dariadb {
@@ -60,9 +61,11 @@ class Page : public ChunkContainer {
 
 public:
   /// called by Dropper from Wal level.
+  /// direct_io - write page without page cache (see PageWriter).
   EXPORT static void create(const std::string &file_name, uint16_t lvl, uint64_t chunk_id,
                             uint32_t max_chunk_size, const MeasArray &ma,
-                            on_create_complete_callback on_complete);
+                            on_create_complete_callback on_complete,
+                            bool direct_io = false);
   /**
   used for repack many pages to one
   file_name - output page filename
@@ -71,16 +74,18 @@ public:
   max_chunk_size - maximum chunk size
   pages_full_paths - input pages.
   logic - if set, to control repacking.
+  direct_io - write page without page cache.
   */
   EXPORT static Page_Ptr repackTo(const std::string &file_name, uint16_t lvl,
                                   uint64_t chunk_id, uint32_t max_chunk_size,
                                   const std::list<std::string> &pages_full_paths,
-                                  ICompactionController *logic);
+                                  ICompactionController *logic, bool direct_io = false);
   /// called by dropper from MemoryStorage.
   EXPORT static Page_Ptr create(const std::string &file_name, uint16_t lvl,
                                 uint64_t chunk_id, const std::vector<Chunk *> &a,
-                                size_t count);
-  EXPORT static Page_Ptr open(const std::string &file_name);
+                                size_t count, bool direct_io = false);
+  /// mmap_read - map page and index to memory. chunks will be views of mapping.
+  EXPORT static Page_Ptr open(const std::string &file_name, bool mmap_read = false);
 
   EXPORT static PageFooter readFooter(std::string file_name);
   EXPORT static IndexFooter readIndexFooter(std::string page_file_name);
@@ -106,11 +111,18 @@ public:
                               std::function<bool(const Chunk_Ptr &)> callback);
 
   EXPORT static Page_Ptr open(const std::string &file_name, const PageFooter &phdr);
+  /// read one chunk without reading of page index.
+  EXPORT static Chunk_Ptr readChunk(const std::string &file_name, uint64_t offset);
 
 private:
   void update_index_recs(const PageFooter &phdr);
 
   static Chunk_Ptr readChunkByOffset(FILE *page_io, int offset);
+  /// open file for reading. nullptr if page is mapped.
+  FILE *openToRead();
+  /// chunk from mapping, if page is mapped, else from page_io.
+  Chunk_Ptr readChunkAt(FILE *page_io, uint64_t offset);
+  void closeAfterRead(FILE *page_io);
 
   ChunkLinkList linksByIterval(const QueryInterval &qi);
 
@@ -120,6 +132,7 @@ public:
 
 protected:
   PageIndex_ptr _index;
+  utils::fs::MappedFile_Ptr _mapping;
 };
 }
 }
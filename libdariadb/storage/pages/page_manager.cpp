@@ -8,13 +8,17 @@
 #include <libdariadb/storage/pages/page.h>
 #include <libdariadb/storage/pages/page_manager.h>
 #include <libdariadb/storage/settings.h>
+#include <libdariadb/storage/snapshot.h>
+#include <libdariadb/storage/versions.h>
 #include <libdariadb/timeutil.h>
 #include <libdariadb/utils/async/locker.h>
 #include <libdariadb/utils/async/thread_manager.h>
 #include <libdariadb/utils/fs.h>
+#include <libdariadb/utils/metrics.h>
 #include <libdariadb/utils/utils.h>
 
 #include <atomic>
+#include <chrono>
 #include <cstring>
 #include <fstream>
 #include <functional>
@@ -22,7 +26,9 @@
 #include <memory>
 #include <mutex>
 #include <queue>
+#include <set>
 #include <shared_mutex>
+#include <sstream>
 #include <thread>
 
 #include <stx/btree_multimap.h>
@@ -38,6 +44,40 @@ struct PageFooterDescription {
 
 using File2PageFooter = stx::btree_multimap<dariadb::Time, PageFooterDescription>;
 
+/// result of Page::loadMinMax.
+using PageMinMax = std::vector<std::pair<dariadb::Id, MeasMinMax>>;
+
+namespace {
+const std::string PAGES_SNAPSHOT_FILE = "pages.snapshot";
+const std::string PAGES_SNAPSHOT_KIND = "pages";
+
+/// page description from snapshot.
+struct PageSnapshot {
+  IndexFooter hdr;
+  bool has_minmax = false;
+  PageMinMax minmax;
+};
+}
+
+/// chunks of one id for fast time-point queries.
+struct TimePointIndex {
+  struct Position {
+    dariadb::Time minTime;
+    dariadb::Time maxTime;
+    uint64_t offset;
+    std::string page; // full path.
+  };
+  std::vector<Position> chunks;          // sorted by maxTime.
+  std::vector<dariadb::Time> suffix_min; // min(chunks[i..end].minTime)
+};
+using TimePointIndex_Ptr = std::shared_ptr<const TimePointIndex>;
+
+/// time interval of all pages of one id.
+struct PagesSummary {
+  dariadb::Time minTime = dariadb::MAX_TIME;
+  dariadb::Time maxTime = dariadb::MIN_TIME;
+};
+
 class PageManager::Private {
 public:
   Private(const EngineEnvironment_ptr env) : _cur_page(nullptr) {
@@ -45,19 +85,56 @@ public:
     _env = env;
     _settings = _env->getResourceObject<Settings>(EngineEnvironment::Resource::SETTINGS);
     _manifest = _env->getResourceObject<Manifest>(EngineEnvironment::Resource::MANIFEST);
+    _versions =
+        _env->getResourceObject<VersionManager>(EngineEnvironment::Resource::VERSIONS);
     last_id = 0;
-    reloadIndexFooters();
+    _pages_count = 0;
+    _tp_index_generation = 0;
+    _snapshot_changes = 0;
+    auto registry = utils::metrics::Registry::instance();
+    _opened = registry->counter("pages.opened");
+    _cur_page_hits = registry->counter("pages.cur_page_hits");
+    _interval_read_latency = registry->histogram("pages.interval_read_ns");
+    _interval_read_pages = registry->histogram("pages.interval_read_pages");
+    reloadIndexFooters(true);
   }
 
-  void reloadIndexFooters() {
+  /// if use_snapshot, pages from snapshot file are not readed from disk.
+  void reloadIndexFooters(bool use_snapshot) {
     if (utils::fs::path_exists(_settings->raw_path.value())) {
       {
         std::lock_guard<std::shared_mutex> lg(_file2footer_lock);
         _file2footer.clear();
+        _id2summary.clear();
+        _pages_min_times.clear();
+        _pages_max_times.clear();
+        _page2minmax.clear();
+        _pages_count = 0;
+      }
+      {
+        std::lock_guard<std::mutex> lg(_tp_index_lock);
+        _tp_index_generation++;
+        _tp_index.clear();
+        _id2last.clear();
+      }
+      std::unordered_map<std::string, PageSnapshot> snapshot;
+      if (use_snapshot) {
+        readSnapshot(&snapshot);
       }
       auto pages = _manifest->page_list();
 
+      size_t from_snapshot = 0;
       for (auto n : pages) {
+        auto sres = snapshot.find(n);
+        if (sres != snapshot.end()) {
+          insert_pagedescr_inner(n, sres->second.hdr);
+          if (sres->second.has_minmax) {
+            std::lock_guard<std::shared_mutex> lg(_file2footer_lock);
+            _page2minmax[n] = std::move(sres->second.minmax);
+          }
+          ++from_snapshot;
+          continue;
+        }
         auto file_name = utils::fs::append_path(_settings->raw_path.value(), n);
         auto phdr = Page::readFooter(file_name);
         last_id = std::max(phdr.max_chunk_id, last_id);
@@ -65,107 +142,266 @@ public:
         auto index_filename = PageIndex::index_name_from_page_name(file_name);
         if (utils::fs::file_exists(index_filename)) {
           auto ihdr = Page::readIndexFooter(index_filename);
-          insert_pagedescr(n, ihdr);
+          insert_pagedescr_inner(n, ihdr);
         }
       }
+      if (from_snapshot != snapshot.size() || from_snapshot != pages.size()) {
+        _snapshot_changes++;
+      }
+      logger_info("engine", _settings->alias, ": pages - ", pages.size(),
+                  ", from snapshot - ", from_snapshot);
     }
   }
 
-  ~Private() {
-    if (_cur_page != nullptr) {
-      _cur_page = nullptr;
+  std::string snapshotFileName() const {
+    return utils::fs::append_path(_settings->raw_path.value(), PAGES_SNAPSHOT_FILE);
+  }
+
+  /// read snapshot of page footers. last_id is updated.
+  void readSnapshot(std::unordered_map<std::string, PageSnapshot> *result) {
+    std::string body;
+    if (!snapshot::read(snapshotFileName(), PAGES_SNAPSHOT_KIND, &body)) {
+      return;
     }
+    snapshot::Reader reader(body);
+    uint64_t snapshot_last_id = 0;
+    uint64_t count = 0;
+    bool ok = reader.get(&snapshot_last_id) && reader.get(&count);
+    for (uint64_t i = 0; ok && i < count; ++i) {
+      std::string name;
+      PageSnapshot ps;
+      uint8_t has_minmax = 0;
+      ok = reader.get_string(&name) && reader.get(&ps.hdr) && reader.get(&has_minmax);
+      if (ok && has_minmax != 0) {
+        uint32_t mm_count = 0;
+        ok = reader.get(&mm_count);
+        for (uint32_t j = 0; ok && j < mm_count; ++j) {
+          std::pair<dariadb::Id, MeasMinMax> mm;
+          ok = reader.get(&mm.first) && reader.get(&mm.second);
+          ps.minmax.push_back(mm);
+        }
+        ps.has_minmax = true;
+      }
+      if (ok) {
+        result->emplace(name, std::move(ps));
+      }
+    }
+    if (!ok || !reader.eof()) {
+      logger_info("engine", _settings->alias, ": bad pages snapshot - ignored.");
+      result->clear();
+      return;
+    }
+    last_id = std::max(snapshot_last_id, last_id);
   }
 
-  void fsck() {
+  /// write page footers and min/max of pages to snapshot file.
+  void writeSnapshot() {
     if (!utils::fs::path_exists(_settings->raw_path.value())) {
       return;
     }
-
-    auto pages = _manifest->page_list();
-
-    for (auto n : pages) {
-      auto file_name = utils::fs::append_path(_settings->raw_path.value(), n);
-      try {
-        auto index_filename = PageIndex::index_name_from_page_name(n);
-        auto index_file_path =
-            utils::fs::append_path(_settings->raw_path.value(), index_filename);
-
-        if (!utils::fs::path_exists(index_file_path)) {
-          Page::restoreIndexFile(file_name);
-        } else {
-          auto ifooter = PageIndex::readIndexFooter(index_file_path);
-          if (!ifooter.check()) {
-            utils::fs::rm(index_file_path);
-            Page::restoreIndexFile(file_name);
+    std::lock_guard<std::mutex> slg(_snapshot_lock);
+    snapshot::Writer writer;
+    {
+      std::shared_lock<std::shared_mutex> lg(_file2footer_lock);
+      _snapshot_changes = 0;
+      writer.put(uint64_t(last_id));
+      writer.put(uint64_t(_pages_count.load()));
+      for (auto &kv : _file2footer) {
+        for (auto &f2h : kv.second) {
+          writer.put_string(f2h.second.path);
+          writer.put(f2h.second.hdr);
+          auto mm_it = _page2minmax.find(f2h.second.path);
+          if (mm_it == _page2minmax.end()) {
+            writer.put(uint8_t(0));
+            continue;
           }
-        }
-        Page_Ptr p{Page::open(file_name)};
-
-        if (!p->checksum()) {
-          logger_info("engine", _settings->alias, ": checksum of page ", file_name,
-                      " is wrong - removing.");
-          erase_page(file_name);
-        } else {
-          if (!p->footer.check()) {
-            logger_info("engine", _settings->alias, ": bad magic nums ", file_name);
-            erase_page(file_name);
+          writer.put(uint8_t(1));
+          writer.put(uint32_t(mm_it->second.size()));
+          for (auto &mm : mm_it->second) {
+            writer.put(mm.first);
+            writer.put(mm.second);
           }
         }
-      } catch (std::exception &ex) {
-        logger_fatal("engine", _settings->alias, ": error on check ", file_name, ": ",
-                     ex.what());
-        erase_page(file_name);
       }
     }
-    reloadIndexFooters();
+    snapshot::write(snapshotFileName(), PAGES_SNAPSHOT_KIND, writer.data);
   }
 
-  // PM
-  void flush() {}
+  /// periodical checkpoint.
+  void writeSnapshotIfNeeded() {
+    auto limit = std::max(size_t(64), _pages_count.load() / 8);
+    if (_snapshot_changes.load() >= limit) {
+      writeSnapshot();
+    }
+  }
 
-  bool minMaxTime(dariadb::Id id, dariadb::Time *minResult, dariadb::Time *maxResult) {
-    auto pages = pages_by_filter(IdArray{id}, [](const IndexFooter &ih) { return true; });
+  ~Private() {
+    if (_cur_page != nullptr) {
+      _cur_page = nullptr;
+    }
+    if (_snapshot_changes.load() != 0) {
+      writeSnapshot();
+    }
+  }
 
-    using MMRes = std::tuple<bool, dariadb::Time, dariadb::Time>;
-    std::vector<MMRes> results{pages.size()};
-    std::vector<TaskResult_Ptr> task_res{pages.size()};
-    size_t num = 0;
+  /// check pages in parallel. in online mode, descriptions of pages are updated one
+  /// by one, without full reload.
+  void fsck(bool online) {
+    if (!utils::fs::path_exists(_settings->raw_path.value())) {
+      return;
+    }
 
-    for (auto pname : pages) {
-      AsyncTask at = [pname, &results, num, this, id](const ThreadInfo &ti) {
-        /// by fact, reading from index.
-        TKIND_CHECK(THREAD_KINDS::DISK_IO, ti.kind);
-        Page_Ptr pg = open_page_to_read(pname);
-        dariadb::Time lmin, lmax;
-        if (pg->minMaxTime(id, &lmin, &lmax)) {
-          results[num] = MMRes(true, lmin, lmax);
-        } else {
-          results[num] = MMRes(false, lmin, lmax);
+    auto page_list = _manifest->page_list();
+    std::vector<std::string> pages{page_list.begin(), page_list.end()};
+    size_t threads = _settings->threads_in_fsck.value();
+    if (threads == 0) {
+      threads = std::max(size_t(std::thread::hardware_concurrency()), size_t(1));
+    }
+    threads = std::max(std::min(threads, pages.size()), size_t(1));
+    logger_info("engine", _settings->alias, ": fsck ", pages.size(), " pages in ",
+                threads, " threads", (online ? " online" : ""));
+
+    FsckState state;
+    state.total = pages.size();
+    state.start = std::chrono::steady_clock::now();
+
+    ThreadPool pool(ThreadPool::Params(threads, (ThreadKind)THREAD_KINDS::FSCK));
+    std::vector<TaskResult_Ptr> workers;
+    for (size_t i = 0; i < threads; ++i) {
+      AsyncTask at = [this, &pages, &state](const ThreadInfo &ti) {
+        TKIND_CHECK(THREAD_KINDS::FSCK, ti.kind);
+        for (auto pos = state.next++; pos < pages.size(); pos = state.next++) {
+          fsck_page(pages[pos], &state);
         }
         return false;
       };
-      task_res[num] = ThreadManager::instance()->post(THREAD_KINDS::DISK_IO, AT(at));
-      num++;
+      workers.push_back(pool.post(AT(at)));
     }
-
-    for (auto &tw : task_res) {
-      tw->wait();
+    for (auto &w : workers) {
+      w->wait();
     }
+    pool.stop();
 
-    bool res = false;
+    std::set<std::string> exists_pages;
+    if (online) { // pages can be removed by compaction, while fsck.
+      auto actual = _manifest->page_list();
+      exists_pages.insert(actual.begin(), actual.end());
+    }
+    for (auto &n : state.broken) {
+      if (!online || exists_pages.count(n) != 0) {
+        erase_broken_page(n);
+      }
+    }
+    if (online) {
+      for (auto &n : state.restored) {
+        if (exists_pages.count(n) != 0 && state.broken.count(n) == 0) {
+          auto file_name = utils::fs::append_path(_settings->raw_path.value(), n);
+          auto index_name = PageIndex::index_name_from_page_name(file_name);
+          auto footer = Page::readIndexFooter(index_name);
+          // readers never see the page missing.
+          _versions->publish([&]() {
+            remove_pagedescr(n);
+            insert_pagedescr_inner(n, footer);
+          });
+        }
+      }
+    } else {
+      reloadIndexFooters(false);
+    }
+    writeSnapshot();
+    logger_info("engine", _settings->alias, ": fsck done. ", state.progress(),
+                " broken: ", state.broken.size(), " restored indexes: ",
+                state.restored.size());
+  }
 
-    *minResult = dariadb::MAX_TIME;
-    *maxResult = dariadb::MIN_TIME;
-    for (auto &subRes : results) {
-      if (std::get<0>(subRes)) {
-        res = true;
-        *minResult = std::min(std::get<1>(subRes), *minResult);
-        *maxResult = std::max(std::get<2>(subRes), *maxResult);
+  struct FsckState {
+    size_t total = 0;
+    std::atomic<size_t> next{0};
+    std::atomic<size_t> checked{0};
+    std::atomic<uint64_t> bytes{0};
+    std::chrono::steady_clock::time_point start;
+
+    std::mutex locker;
+    std::set<std::string> broken;   // page names
+    std::set<std::string> restored; // pages with restored index.
+
+    std::string progress() const {
+      std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+      auto mb = double(bytes.load()) / (1024 * 1024);
+      auto speed = elapsed.count() > 0 ? mb / elapsed.count() : 0.0;
+      std::stringstream ss;
+      ss << checked.load() << "/" << total << " pages, " << size_t(mb) << " Mb, "
+         << size_t(speed) << " Mb/s, " << elapsed.count() << "s.";
+      return ss.str();
+    }
+  };
+
+  void fsck_page(const std::string &n, FsckState *state) {
+    auto file_name = utils::fs::append_path(_settings->raw_path.value(), n);
+    bool is_broken = false;
+    try {
+      auto index_file_path = PageIndex::index_name_from_page_name(file_name);
+      bool restore = !utils::fs::path_exists(index_file_path);
+      if (!restore && !PageIndex::readIndexFooter(index_file_path).check()) {
+        utils::fs::rm(index_file_path);
+        restore = true;
+      }
+      if (restore) {
+        Page::restoreIndexFile(file_name);
+        std::lock_guard<std::mutex> lg(state->locker);
+        state->restored.insert(n);
       }
+      Page_Ptr p{Page::open(file_name, _settings->page_mmap_read.value())};
+      state->bytes += p->footer.filesize;
+
+      if (!p->checksum()) {
+        logger_info("engine", _settings->alias, ": checksum of page ", file_name,
+                    " is wrong - removing.");
+        is_broken = true;
+      } else if (!p->footer.check()) {
+        logger_info("engine", _settings->alias, ": bad magic nums ", file_name);
+        is_broken = true;
+      }
+    } catch (std::exception &ex) {
+      logger_fatal("engine", _settings->alias, ": error on check ", file_name, ": ",
+                   ex.what());
+      is_broken = true;
+    }
+    if (is_broken) {
+      std::lock_guard<std::mutex> lg(state->locker);
+      state->broken.insert(n);
+    }
+
+    auto checked = ++state->checked;
+    // report every 10%
+    if (checked * 10 / state->total != (checked - 1) * 10 / state->total) {
+      logger_info("engine", _settings->alias, ": fsck ", state->progress());
+    }
+  }
+
+  void erase_broken_page(const std::string &n) {
+    auto file_name = utils::fs::append_path(_settings->raw_path.value(), n);
+    if (utils::fs::file_exists(file_name)) {
+      erase_page(file_name);
+    } else {
+      _manifest->page_rm(n);
+      remove_pagedescr(n);
+      utils::fs::rm(PageIndex::index_name_from_page_name(file_name));
     }
+  }
+
+  // PM
+  void flush() {}
 
-    return res;
+  bool minMaxTime(dariadb::Id id, dariadb::Time *minResult, dariadb::Time *maxResult) {
+    std::shared_lock<std::shared_mutex> lg(_file2footer_lock);
+    auto it = _id2summary.find(id);
+    if (it == _id2summary.end()) {
+      return false;
+    }
+    *minResult = it->second.minTime;
+    *maxResult = it->second.maxTime;
+    return true;
   }
 
   Page_Ptr open_page_to_read(const std::string &pname) const {
@@ -173,8 +409,10 @@ public:
     Page_Ptr pg = nullptr;
     if (_cur_page != nullptr && pname == _cur_page->filename) {
       pg = _cur_page;
+      _cur_page_hits->add();
     } else {
-      pg = Page_Ptr{Page::open(pname)};
+      pg = Page_Ptr{Page::open(pname, _settings->page_mmap_read.value())};
+      _opened->add();
     }
     return pg;
   }
@@ -203,7 +441,7 @@ public:
           pages_by_filter(IdArray{id}, std::function<bool(const IndexFooter &)>(pred));
 
       for (auto pname : page_list) {
-        auto p = Page::open(pname);
+        auto p = Page::open(pname, _settings->page_mmap_read.value());
         auto sub_result = p->stat(id, from, to);
         result.update(sub_result);
       }
@@ -230,6 +468,7 @@ public:
   }
 
   void callback_for_interval_readers(const QueryInterval &query, Id2CursorsList &result) {
+    utils::metrics::ScopedTimer timer(_interval_read_latency);
     auto pred = [&query](const IndexFooter &hdr) {
       auto interval_check(
           (hdr.stat.minTime >= query.from && hdr.stat.maxTime <= query.to) ||
@@ -250,9 +489,11 @@ public:
     };
     auto page_list =
         pages_by_filter(query.ids, std::function<bool(const IndexFooter &)>(pred));
+    _interval_read_pages->record(page_list.size());
+    _opened->add(page_list.size());
 
     for (auto pname : page_list) {
-      auto p = Page::open(pname);
+      auto p = Page::open(pname, _settings->page_mmap_read.value());
       auto sub_result = p->intervalReader(query);
       for (auto kv : sub_result) {
         result[kv.first].push_back(kv.second);
@@ -266,7 +507,11 @@ public:
     {
       std::shared_lock<std::shared_mutex> lg(_file2footer_lock);
       for (auto id : ids) {
-        for (auto f2h : _file2footer[id]) {
+        auto fres = _file2footer.find(id);
+        if (fres == _file2footer.end()) {
+          continue;
+        }
+        for (auto &f2h : fres->second) {
           auto hdr = f2h.second.hdr;
           if (pred(hdr)) {
 
@@ -304,6 +549,48 @@ public:
   }
 
   Id2Meas valuesBeforeTimePoint(const QueryTimePoint &query) {
+    if (query.flag != Flag(0)) {
+      // the time-point index does not know about flags.
+      Id2Meas result;
+      AsyncTask at = [&query, &result, this](const ThreadInfo &ti) {
+        TKIND_CHECK(THREAD_KINDS::DISK_IO, ti.kind);
+        result = scanTimePoint(query);
+        return false;
+      };
+      auto pm_async = ThreadManager::instance()->post(THREAD_KINDS::DISK_IO, AT(at));
+      pm_async->wait();
+      return result;
+    }
+
+    auto tasks_count = std::min(query.ids.size(), _settings->threads_in_diskio.value());
+    tasks_count = std::max(tasks_count, size_t(1));
+    std::vector<Id2Meas> results{tasks_count};
+    std::vector<TaskResult_Ptr> task_res{tasks_count};
+    for (size_t num = 0; num < tasks_count; ++num) {
+      AsyncTask at = [&query, &results, num, tasks_count, this](const ThreadInfo &ti) {
+        TKIND_CHECK(THREAD_KINDS::DISK_IO, ti.kind);
+        for (size_t i = num; i < query.ids.size(); i += tasks_count) {
+          auto id = query.ids[i];
+          results[num][id] = valueBeforeTimePoint(id, query.time_point);
+        }
+        return false;
+      };
+      task_res[num] = ThreadManager::instance()->post(THREAD_KINDS::DISK_IO, AT(at));
+    }
+
+    Id2Meas result;
+    result.reserve(query.ids.size());
+    for (size_t num = 0; num < tasks_count; ++num) {
+      task_res[num]->wait();
+      for (auto &kv : results[num]) {
+        result.insert(kv);
+      }
+    }
+    return result;
+  }
+
+  /// read pages from newest to oldest. must be called from DISK_IO pool.
+  Id2Meas scanTimePoint(const QueryTimePoint &query) {
     Id2Meas result;
 
     for (auto id : query.ids) {
@@ -311,78 +598,181 @@ public:
       result[id].time = query.time_point;
     }
 
-    AsyncTask at = [&query, &result, this](const ThreadInfo &ti) {
-      TKIND_CHECK(THREAD_KINDS::DISK_IO, ti.kind);
-      auto pred = [query](const IndexFooter &hdr) {
-        auto in_check =
-            utils::inInterval(hdr.stat.minTime, hdr.stat.maxTime, query.time_point) ||
-            (hdr.stat.maxTime < query.time_point);
-        if (in_check) {
-          for (auto id : query.ids) {
-            if (hdr.target_id == id) {
-              return true;
-            }
+    auto pred = [query](const IndexFooter &hdr) {
+      auto in_check =
+          utils::inInterval(hdr.stat.minTime, hdr.stat.maxTime, query.time_point) ||
+          (hdr.stat.maxTime < query.time_point);
+      if (in_check) {
+        for (auto id : query.ids) {
+          if (hdr.target_id == id) {
+            return true;
           }
         }
-        return false;
-      };
+      }
+      return false;
+    };
 
-      auto page_list = pages_by_filter(query.ids, std::function<bool(IndexFooter)>(pred));
+    auto page_list = pages_by_filter(query.ids, std::function<bool(IndexFooter)>(pred));
 
-      for (auto it = page_list.rbegin(); it != page_list.rend(); ++it) {
-        auto pname = *it;
-        auto pg = open_page_to_read(pname);
+    for (auto it = page_list.rbegin(); it != page_list.rend(); ++it) {
+      auto pname = *it;
+      auto pg = open_page_to_read(pname);
 
-        auto subres = pg->valuesBeforeTimePoint(query);
-        for (auto kv : subres) {
-          result[kv.first] = kv.second;
-        }
-        if (subres.size() == query.ids.size()) {
-          break;
-        }
+      auto subres = pg->valuesBeforeTimePoint(query);
+      for (auto kv : subres) {
+        result[kv.first] = kv.second;
       }
-      return false;
-    };
-    auto pm_async = ThreadManager::instance()->post(THREAD_KINDS::DISK_IO, AT(at));
-    pm_async->wait();
+      if (subres.size() == query.ids.size()) {
+        break;
+      }
+    }
     return result;
   }
 
-  size_t chunks_in_cur_page() const {
-    if (_cur_page == nullptr) {
-      return 0;
+  /// last value before time_point from the time-point index.
+  Meas valueBeforeTimePoint(Id id, Time time_point) {
+    try {
+      uint64_t generation = 0;
+      auto tpi = timePointIndex(id, &generation);
+      Meas last;
+      {
+        std::lock_guard<std::mutex> lg(_tp_index_lock);
+        auto fres = _id2last.find(id);
+        if (fres != _id2last.end()) {
+          last = fres->second;
+          if (last.time <= time_point) {
+            return last;
+          }
+        }
+      }
+
+      Meas result = Meas(id);
+      result.flag = FLAGS::_NO_DATA;
+      result.time = time_point;
+
+      const auto &chunks = tpi->chunks;
+      auto candidate = std::upper_bound(
+          chunks.begin(), chunks.end(), time_point,
+          [](Time t, const TimePointIndex::Position &pos) { return t < pos.maxTime; });
+      bool is_last = candidate == chunks.end();
+
+      // chunks with maxTime > time_point, but with values before time_point.
+      std::vector<const TimePointIndex::Position *> to_read;
+      for (auto i = size_t(std::distance(chunks.begin(), candidate));
+           i < chunks.size() && tpi->suffix_min[i] <= time_point; ++i) {
+        if (chunks[i].minTime <= time_point) {
+          to_read.push_back(&chunks[i]);
+        }
+      }
+      if (candidate != chunks.begin()) {
+        to_read.push_back(&*std::prev(candidate));
+      }
+
+      QueryTimePoint local_q({id}, Flag(0), time_point);
+      bool result_set = false;
+      for (auto pos : to_read) {
+        if (result_set && pos->maxTime <= result.time) {
+          continue;
+        }
+        auto c = Page::readChunk(pos->page, pos->offset);
+        if (c == nullptr) {
+          THROW_EXCEPTION("bad chunk in ", pos->page);
+        }
+        auto m = c->getReader()->read_time_point(local_q);
+        if (m.time <= time_point && (!result_set || m.time > result.time)) {
+          result = m;
+          result_set = true;
+        }
+      }
+
+      if (result_set && is_last) {
+        std::lock_guard<std::mutex> lg(_tp_index_lock);
+        if (generation == _tp_index_generation) {
+          _id2last[id] = result;
+        }
+      }
+      return result;
+    } catch (std::exception &ex) {
+      logger_info("engine", _settings->alias, ": time-point index for #", id,
+                  " - fallback to full scan. ", ex.what());
+      return scanTimePoint(QueryTimePoint({id}, Flag(0), time_point))[id];
     }
-    return _cur_page->footer.addeded_chunks;
   }
-  // PM
-  size_t files_count() const { return _manifest->page_list().size(); }
 
-  dariadb::Time minTime() {
+  TimePointIndex_Ptr timePointIndex(Id id, uint64_t *generation) {
+    {
+      std::lock_guard<std::mutex> lg(_tp_index_lock);
+      *generation = _tp_index_generation;
+      auto fres = _tp_index.find(id);
+      if (fres != _tp_index.end()) {
+        return fres->second;
+      }
+    }
 
-    auto pred = [](const IndexFooter &) { return true; };
-    auto page_list = pages_by_filter(all_ids(), std::function<bool(IndexFooter)>(pred));
+    std::list<std::string> pages;
+    {
+      std::shared_lock<std::shared_mutex> lg(_file2footer_lock);
+      auto fres = _file2footer.find(id);
+      if (fres != _file2footer.end()) {
+        for (auto &f2h : fres->second) {
+          pages.push_back(f2h.second.path);
+        }
+      }
+    }
 
-    dariadb::Time res = dariadb::MAX_TIME;
-    for (auto pname : page_list) {
-      auto ih = Page::readIndexFooter(PageIndex::index_name_from_page_name(pname));
-      res = std::min(ih.stat.minTime, res);
+    auto tpi = std::make_shared<TimePointIndex>();
+    for (auto &page : pages) {
+      auto page_path = utils::fs::append_path(_settings->raw_path.value(), page);
+      auto index = PageIndex::open(PageIndex::index_name_from_page_name(page_path),
+                                   _settings->page_mmap_read.value());
+      for (auto &rec : index->readReccords()) {
+        if (rec.target_id == id) {
+          tpi->chunks.push_back(
+              {rec.stat.minTime, rec.stat.maxTime, rec.offset, page_path});
+        }
+      }
+    }
+    std::sort(tpi->chunks.begin(), tpi->chunks.end(),
+              [](const auto &l, const auto &r) { return l.maxTime < r.maxTime; });
+    tpi->suffix_min.resize(tpi->chunks.size());
+    Time min_time = MAX_TIME;
+    for (size_t i = tpi->chunks.size(); i > 0; --i) {
+      min_time = std::min(min_time, tpi->chunks[i - 1].minTime);
+      tpi->suffix_min[i - 1] = min_time;
     }
 
-    return res;
+    std::lock_guard<std::mutex> lg(_tp_index_lock);
+    if (*generation == _tp_index_generation) {
+      _tp_index[id] = tpi;
+    }
+    return tpi;
   }
-  dariadb::Time maxTime() {
 
-    auto pred = [](const IndexFooter &) { return true; };
-
-    auto page_list = pages_by_filter(all_ids(), std::function<bool(IndexFooter)>(pred));
+  /// called, when pages of id are changed.
+  void invalidateTimePointIndex(Id id) {
+    std::lock_guard<std::mutex> lg(_tp_index_lock);
+    _tp_index_generation++;
+    _tp_index.erase(id);
+    _id2last.erase(id);
+  }
 
-    dariadb::Time res = dariadb::MIN_TIME;
-    for (auto pname : page_list) {
-      auto ih = Page::readIndexFooter(PageIndex::index_name_from_page_name(pname));
-      res = std::max(ih.stat.maxTime, res);
+  size_t chunks_in_cur_page() const {
+    if (_cur_page == nullptr) {
+      return 0;
     }
+    return _cur_page->footer.addeded_chunks;
+  }
+  // PM
+  size_t files_count() const { return _pages_count.load(); }
 
-    return res;
+  dariadb::Time minTime() {
+    std::shared_lock<std::shared_mutex> lg(_file2footer_lock);
+    return _pages_min_times.empty() ? dariadb::MAX_TIME : *_pages_min_times.begin();
+  }
+
+  dariadb::Time maxTime() {
+    std::shared_lock<std::shared_mutex> lg(_file2footer_lock);
+    return _pages_max_times.empty() ? dariadb::MIN_TIME : *_pages_max_times.rbegin();
   }
 
   // from wall
@@ -405,18 +795,23 @@ public:
         dariadb::utils::fs::append_path(_settings->raw_path.value(), page_name);
     on_create_complete_callback complete_callback = [this, page_name, file_name,
                                                      callback](const Page_Ptr &res) {
-      _manifest->page_append(page_name);
-      last_id = res->footer.max_chunk_id;
-
       auto index_fname = PageIndex::index_name_from_page_name(file_name);
       auto index_footer = Page::readIndexFooter(index_fname);
-      insert_pagedescr(page_name, index_footer);
-      callback(res);
+      _manifest->page_append(page_name);
+      // new page and changes of the caller (erase of wal) are one version.
+      _versions->publish([&]() {
+        last_id = res->footer.max_chunk_id;
+        insert_pagedescr(page_name, index_footer);
+        callback(res);
+      });
     };
-    Page::create(file_name, MIN_LEVEL, last_id, _settings->chunk_size.value(), ma,
-                 complete_callback);
+    Page::create(file_name, MIN_LEVEL, last_id, page_chunk_size(), ma,
+                 complete_callback, _settings->page_direct_io.value());
   }
 
+  /// chunks are compacted in page, so the biggest size class gives less index records.
+  uint32_t page_chunk_size() const { return _settings->chunk_size_classes().back(); }
+
   static void erase(const std::string &storage_path, const std::string &fname) {
     logger("pm: erase ", fname);
     auto full_file_name = utils::fs::append_path(storage_path, fname);
@@ -432,45 +827,35 @@ public:
     logger("pm: erase ", full_file_name);
     auto fname = utils::fs::extract_filename(full_file_name);
     auto ifull_name = PageIndex::index_name_from_page_name(full_file_name);
+    _versions->publish(
+        [&]() { erase_page_inner(fname, full_file_name, ifull_name); });
+  }
+
+  /// files are removed, when readers of older versions are done.
+  void erase_page_inner(const std::string &fname, const std::string &full_file_name,
+                        const std::string &ifull_name) {
     std::lock_guard<std::shared_mutex> lg(_file2footer_lock);
 #ifdef DOUBLE_CHECKS
 
     size_t pages_before = 0;
     for (auto &kv : _file2footer) {
       pages_before += kv.second.size();
-    }
-
-#endif
-    ENSURE(utils::fs::file_exists(full_file_name));
-    _manifest->page_rm(fname);
-
-    for (auto &kv : _file2footer) {
-      bool founded = false;
-      auto it = kv.second.begin();
-      for (; it != kv.second.end(); ++it) {
-#ifdef DOUBLE_CHECKS
+      for (auto &f2h : kv.second) {
         auto full_path =
-            utils::fs::append_path(_settings->raw_path.value(), it->second.path);
+            utils::fs::append_path(_settings->raw_path.value(), f2h.second.path);
         if (!utils::fs::file_exists(full_path)) {
           THROW_EXCEPTION("page no exists ", full_path);
         }
-#endif
-        if (it->second.path == fname) {
-          founded = true;
-          break;
-        }
-      }
-      if (founded) {
-        kv.second.erase(it);
-        break;
       }
     }
 
-    utils::fs::rm(full_file_name);
-    utils::fs::rm(ifull_name);
+#endif
+    ENSURE(utils::fs::file_exists(full_file_name));
+    _versions->afterPublish([this, fname]() { _manifest->page_rm(fname); });
+    remove_pagedescr_inner(fname);
 
-    ENSURE(!utils::fs::file_exists(full_file_name));
-    ENSURE(!utils::fs::file_exists(ifull_name));
+    _versions->removeLater(full_file_name);
+    _versions->removeLater(ifull_name);
 
 #ifdef DOUBLE_CHECKS
     size_t pages_after = 0;
@@ -481,6 +866,36 @@ public:
 #endif
   }
 
+  void remove_pagedescr(const std::string &fname) {
+    std::lock_guard<std::shared_mutex> lg(_file2footer_lock);
+    remove_pagedescr_inner(fname);
+  }
+
+  /// _file2footer_lock must be locked.
+  void remove_pagedescr_inner(const std::string &fname) {
+    for (auto kv_it = _file2footer.begin(); kv_it != _file2footer.end(); ++kv_it) {
+      auto &kv = *kv_it;
+      auto it = kv.second.begin();
+      for (; it != kv.second.end(); ++it) {
+        if (it->second.path == fname) {
+          break;
+        }
+      }
+      if (it != kv.second.end()) {
+        auto hdr = it->second.hdr;
+        kv.second.erase(it);
+        summary_erase(hdr);
+        _page2minmax.erase(fname);
+        _snapshot_changes++;
+        invalidateTimePointIndex(hdr.target_id);
+        if (kv.second.empty()) {
+          _file2footer.erase(kv_it);
+        }
+        break;
+      }
+    }
+  }
+
   void eraseOld(const dariadb::Id id, const Time t) {
     logger("pm: erase old");
     auto page_list = pagesOlderThan(id, t);
@@ -536,19 +951,13 @@ public:
     utils::ElapsedTime et;
     std::string file_name =
         dariadb::utils::fs::append_path(_settings->raw_path.value(), page_name);
-    res = Page::repackTo(file_name, out_lvl, last_id, _settings->chunk_size.value(), part,
-                         nullptr);
+    res = Page::repackTo(file_name, out_lvl, last_id, page_chunk_size(), part,
+                         nullptr, _settings->page_direct_io.value());
     _manifest->page_append(page_name);
     if (res != nullptr) {
       last_id = res->footer.max_chunk_id;
     }
-    for (auto erasedPage : part) {
-      this->erase_page(erasedPage);
-    }
-    if (res != nullptr) {
-      insert_pagedescr(page_name, Page::readIndexFooter(
-                                      PageIndex::index_name_from_page_name(file_name)));
-    }
+    replace_pages(part, res == nullptr ? std::string() : page_name);
 
     logger("engine", _settings->alias, ": repack end. elapsed ", et.elapsed(), "s");
   }
@@ -598,22 +1007,36 @@ public:
 
     std::string file_name =
         dariadb::utils::fs::append_path(_settings->raw_path.value(), page_name);
-    res = Page::repackTo(file_name, level, last_id, _settings->chunk_size.value(),
-                         page_list, logic);
+    res = Page::repackTo(file_name, level, last_id, page_chunk_size(),
+                         page_list, logic, _settings->page_direct_io.value());
     if (res != nullptr) {
       last_id = res->footer.max_chunk_id;
     }
-    for (auto erasedPage : page_list) {
-      this->erase_page(erasedPage);
-    }
-    if (res != nullptr) {
-      insert_pagedescr(page_name, Page::readIndexFooter(
-                                      PageIndex::index_name_from_page_name(file_name)));
-    }
+    replace_pages(page_list, res == nullptr ? std::string() : page_name);
     logger("engine", _settings->alias, ": compact end. elapsed ", et.elapsed());
   }
 
-  void appendChunks(const std::vector<Chunk *> &a) {
+  /// readers see old pages or new page, but never both or none of them.
+  void replace_pages(const std::list<std::string> &old_pages,
+                     const std::string &new_page) {
+    IndexFooter hdr;
+    if (!new_page.empty()) {
+      auto file_name = utils::fs::append_path(_settings->raw_path.value(), new_page);
+      hdr = Page::readIndexFooter(PageIndex::index_name_from_page_name(file_name));
+    }
+    _versions->publish([&]() {
+      for (auto erasedPage : old_pages) {
+        this->erase_page(erasedPage);
+      }
+      if (!new_page.empty()) {
+        insert_pagedescr(new_page, hdr);
+      }
+    });
+  }
+
+  /// pages are written before publish, which inserts all of them.
+  void appendChunks(const std::vector<Chunk *> &a,
+                    const std::function<void()> &on_publish) {
 #ifdef DOUBLE_CHECKS
     for (auto c : a) {
       ENSURE(c->header->meas_id == a.front()->header->meas_id);
@@ -625,6 +1048,7 @@ public:
     int64_t left = (int64_t)a.size();
     auto max_chunks = (int64_t)_settings->max_chunks_per_page.value();
     size_t pos_in_a = 0;
+    std::vector<std::pair<std::string, IndexFooter>> pages;
     while (left != 0) {
       std::string page_name = utils::fs::random_file_name(".page");
       logger_info("engine", _settings->alias, ": write chunks to ", page_name);
@@ -644,35 +1068,112 @@ public:
         tmp_buffer[i] = a[pos_in_a++];
       }
 
-      auto res = Page::create(file_name, MIN_LEVEL, last_id, tmp_buffer, to_write);
+      auto res = Page::create(file_name, MIN_LEVEL, last_id, tmp_buffer, to_write,
+                              _settings->page_direct_io.value());
       _manifest->page_append(page_name);
       last_id = res->footer.max_chunk_id;
 
-      insert_pagedescr(page_name, Page::readIndexFooter(
-                                      PageIndex::index_name_from_page_name(file_name)));
+      pages.emplace_back(page_name, Page::readIndexFooter(
+                                        PageIndex::index_name_from_page_name(file_name)));
     }
+    _versions->publish([&]() {
+      for (auto &p : pages) {
+        insert_pagedescr(p.first, p.second);
+      }
+      on_publish();
+    });
   }
 
   void insert_pagedescr(std::string page_name, IndexFooter hdr) {
+    _versions->publish([&]() {
+      insert_pagedescr_inner(page_name, hdr);
+      _snapshot_changes++;
+      _versions->afterPublish([this]() { writeSnapshotIfNeeded(); });
+    });
+  }
+
+  void insert_pagedescr_inner(std::string page_name, IndexFooter hdr) {
     std::lock_guard<std::shared_mutex> lg(_file2footer_lock);
     PageFooterDescription ph_d;
     ph_d.hdr = hdr;
     ph_d.path = page_name;
     _file2footer[hdr.target_id].insert(std::make_pair(ph_d.hdr.stat.maxTime, ph_d));
+    summary_insert(hdr);
+    invalidateTimePointIndex(hdr.target_id);
+  }
+
+  /// _file2footer_lock must be locked.
+  void summary_insert(const IndexFooter &hdr) {
+    auto &summary = _id2summary[hdr.target_id];
+    summary.minTime = std::min(summary.minTime, hdr.stat.minTime);
+    summary.maxTime = std::max(summary.maxTime, hdr.stat.maxTime);
+    _pages_min_times.insert(hdr.stat.minTime);
+    _pages_max_times.insert(hdr.stat.maxTime);
+    _pages_count++;
   }
 
+  /// _file2footer_lock must be locked. hdr already removed from _file2footer.
+  void summary_erase(const IndexFooter &hdr) {
+    _pages_min_times.erase(_pages_min_times.find(hdr.stat.minTime));
+    _pages_max_times.erase(_pages_max_times.find(hdr.stat.maxTime));
+    _pages_count--;
+
+    auto fres = _file2footer.find(hdr.target_id);
+    if (fres == _file2footer.end() || fres->second.empty()) {
+      _id2summary.erase(hdr.target_id);
+      return;
+    }
+    PagesSummary summary;
+    for (auto &f2h : fres->second) {
+      summary.minTime = std::min(summary.minTime, f2h.second.hdr.stat.minTime);
+      summary.maxTime = std::max(summary.maxTime, f2h.second.hdr.stat.maxTime);
+    }
+    _id2summary[hdr.target_id] = summary;
+  }
+
+  /// pages min/max are cached, only new pages are readed.
   Id2MinMax_Ptr loadMinMax() {
     auto result = std::make_shared<Id2MinMax>();
+    auto append = [&result](const PageMinMax &mm) {
+      for (auto &v : mm) {
+        auto fres = result->find_bucket(v.first);
+        fres.v->second.updateMax(v.second.max);
+        fres.v->second.updateMin(v.second.min);
+      }
+    };
 
-    auto pages = pages_by_filter(all_ids(), [](const IndexFooter &ih) { return true; });
+    std::list<std::string> pages;
+    {
+      std::shared_lock<std::shared_mutex> lg(_file2footer_lock);
+      for (auto &kv : _file2footer) {
+        for (auto &f2h : kv.second) {
+          auto mm_it = _page2minmax.find(f2h.second.path);
+          if (mm_it != _page2minmax.end()) {
+            append(mm_it->second);
+          } else {
+            pages.push_back(f2h.second.path);
+          }
+        }
+      }
+    }
+    if (pages.empty()) {
+      return result;
+    }
 
-    AsyncTask at = [&result, &pages, this](const ThreadInfo &ti) {
+    AsyncTask at = [&append, &pages, this](const ThreadInfo &ti) {
       TKIND_CHECK(THREAD_KINDS::DISK_IO, ti.kind);
       for (auto pname : pages) {
-        Page_Ptr pg = open_page_to_read(pname);
+        auto full_name = utils::fs::append_path(_settings->raw_path.value(), pname);
+        Page_Ptr pg = open_page_to_read(full_name);
+
+        PageMinMax page_mm;
+        pg->loadMinMax()->apply(
+            [&page_mm](const Id2MinMax::value_type &v) { page_mm.push_back(v); });
+        append(page_mm);
 
-        auto sub_results = pg->loadMinMax();
-        minmax_append(result, sub_results);
+        std::lock_guard<std::shared_mutex> lg(_file2footer_lock);
+        _page2minmax[pname] = std::move(page_mm);
+        _snapshot_changes++;
       }
       return false;
     };
@@ -684,6 +1185,7 @@ public:
   }
 
   IdArray all_ids() {
+    std::shared_lock<std::shared_mutex> lg(_file2footer_lock);
     IdArray result;
     result.reserve(this->_file2footer.size());
     for (auto &kv : _file2footer) {
@@ -699,11 +1201,33 @@ protected:
   uint64_t last_id;
   std::unordered_map<dariadb::Id, File2PageFooter> _file2footer;
 
+  // aggregates of _file2footer.
+  std::unordered_map<dariadb::Id, PagesSummary> _id2summary;
+  std::multiset<dariadb::Time> _pages_min_times;
+  std::multiset<dariadb::Time> _pages_max_times;
+  std::atomic<size_t> _pages_count;
+  std::unordered_map<std::string, PageMinMax> _page2minmax; // page name => min/max
+
   std::shared_mutex _file2footer_lock;
 
+  std::atomic<size_t> _snapshot_changes; // changes after last snapshot.
+  std::mutex _snapshot_lock;
+
+  // time-point index. locked after _file2footer_lock.
+  std::unordered_map<dariadb::Id, TimePointIndex_Ptr> _tp_index;
+  std::unordered_map<dariadb::Id, Meas> _id2last; // cached last values.
+  uint64_t _tp_index_generation;
+  std::mutex _tp_index_lock;
+
   EngineEnvironment_ptr _env;
   Settings *_settings;
   Manifest *_manifest;
+  VersionManager *_versions;
+
+  utils::metrics::Counter *_opened;
+  utils::metrics::Counter *_cur_page_hits;
+  utils::metrics::Histogram *_interval_read_latency;
+  utils::metrics::Histogram *_interval_read_pages;
 };
 
 PageManager_ptr PageManager::create(const EngineEnvironment_ptr env) {
@@ -757,8 +1281,8 @@ void PageManager::append_async(const std::string &file_prefix,
                                on_create_complete_callback callback) {
   return impl->append_async(file_prefix, ma, callback);
 }
-void PageManager::fsck() {
-  return impl->fsck();
+void PageManager::fsck(bool online) {
+  return impl->fsck(online);
 }
 
 void PageManager::eraseOld(const dariadb::Id id, const Time t) {
@@ -786,7 +1310,12 @@ void PageManager::compact(ICompactionController *logic) {
 }
 
 void PageManager::appendChunks(const std::vector<Chunk *> &a) {
-  impl->appendChunks(a);
+  impl->appendChunks(a, []() {});
+}
+
+void PageManager::appendChunksAndPublish(const std::vector<Chunk *> &a,
+                                         const std::function<void()> &on_publish) {
+  impl->appendChunks(a, on_publish);
 }
 
 dariadb::Id2MinMax_Ptr PageManager::loadMinMax() {
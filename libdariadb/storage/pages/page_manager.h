@@ -34,8 +34,11 @@ public:
   EXPORT void append_async(const std::string &file_prefix, const dariadb::MeasArray &ma,
                            on_create_complete_callback callback);
   EXPORT void appendChunks(const std::vector<Chunk *> &a) override;
+  EXPORT void appendChunksAndPublish(const std::vector<Chunk *> &a,
+                                     const std::function<void()> &on_publish) override;
 
-  EXPORT void fsck();
+  /// online - without full reload of pages descriptions.
+  EXPORT void fsck(bool online = false);
 
   EXPORT void eraseOld(const dariadb::Id id, const Time t);
   EXPORT void erase_page(const std::string &fname);
@@ -0,0 +1,169 @@
+#ifdef MSVC
+#define _CRT_SECURE_NO_WARNINGS // for fopen
+#endif
+#include <libdariadb/storage/pages/page_writer.h>
+#include <libdariadb/utils/exception.h>
+#include <libdariadb/utils/logger.h>
+
+#include <algorithm>
+#include <boost/align/aligned_alloc.hpp>
+#include <cerrno>
+#include <cstring>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace dariadb::storage;
+
+PageWriter::PageWriter(const std::string &fname, bool direct_io)
+    : _fname(fname), _direct(false), _buffer(nullptr), _buffer_pos(0), _offset(0) {
+  _buffer =
+      static_cast<uint8_t *>(boost::alignment::aligned_alloc(ALIGNMENT, BUFFER_SIZE));
+  if (_buffer == nullptr) {
+    THROW_EXCEPTION("PageWriter: can`t allocate buffer.");
+  }
+  try {
+    open(direct_io);
+  } catch (...) {
+    boost::alignment::aligned_free(_buffer);
+    throw;
+  }
+}
+
+PageWriter::~PageWriter() {
+  closeFile();
+  boost::alignment::aligned_free(_buffer);
+}
+
+#ifdef _WIN32
+void PageWriter::open(bool) {
+  _file = std::fopen(_fname.c_str(), "ab");
+  if (_file == nullptr) {
+    THROW_EXCEPTION("can`t open file ", _fname);
+  }
+  std::fseek(_file, 0, SEEK_END);
+  _offset = std::ftell(_file);
+}
+
+void PageWriter::writeBlock(const uint8_t *data, size_t size) {
+  if (std::fwrite(data, sizeof(uint8_t), size, _file) != size) {
+    THROW_EXCEPTION("PageWriter: write error ", _fname);
+  }
+  _offset += size;
+}
+
+void PageWriter::close() {
+  if (_file == nullptr) {
+    return;
+  }
+  writeBlock(_buffer, _buffer_pos);
+  _buffer_pos = 0;
+  std::fflush(_file);
+  _commit(_fileno(_file));
+  closeFile();
+}
+
+void PageWriter::closeFile() {
+  if (_file != nullptr) {
+    std::fclose(_file);
+    _file = nullptr;
+  }
+}
+#else
+void PageWriter::open(bool direct_io) {
+  int flags = O_WRONLY | O_CREAT;
+#ifdef O_DIRECT
+  if (direct_io) {
+    _fd = ::open(_fname.c_str(), flags | O_DIRECT, 0644);
+    if (_fd != -1) {
+      _offset = ::lseek(_fd, 0, SEEK_END);
+      if (_offset % ALIGNMENT == 0) {
+        _direct = true;
+        return;
+      }
+      // appending to not aligned tail is not possible with O_DIRECT.
+      ::close(_fd);
+    } else {
+      // tmpfs and some other filesystems does not support O_DIRECT.
+      logger_info("PageWriter: O_DIRECT is not supported for ", _fname);
+    }
+  }
+#else
+  (void)direct_io;
+#endif
+  _fd = ::open(_fname.c_str(), flags, 0644);
+  if (_fd == -1) {
+    THROW_EXCEPTION("can`t open file ", _fname, ": ", std::strerror(errno));
+  }
+  _offset = ::lseek(_fd, 0, SEEK_END);
+}
+
+void PageWriter::writeBlock(const uint8_t *data, size_t size) {
+  while (size != 0) {
+    auto writed = ::pwrite(_fd, data, size, _offset);
+    if (writed < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      THROW_EXCEPTION("PageWriter: write error ", _fname, ": ", std::strerror(errno));
+    }
+    data += writed;
+    size -= writed;
+    _offset += writed;
+  }
+}
+
+void PageWriter::close() {
+  if (_fd == -1) {
+    return;
+  }
+  if (_buffer_pos != 0) {
+    if (_direct) {
+      // O_DIRECT needs aligned size: write padded block and cut the padding.
+      auto tail = _buffer_pos % ALIGNMENT;
+      auto padding = tail == 0 ? 0 : ALIGNMENT - tail;
+      std::memset(_buffer + _buffer_pos, 0, padding);
+      writeBlock(_buffer, _buffer_pos + padding);
+      _offset -= padding;
+      if (::ftruncate(_fd, _offset) != 0) {
+        THROW_EXCEPTION("PageWriter: truncate error ", _fname, ": ",
+                        std::strerror(errno));
+      }
+    } else {
+      writeBlock(_buffer, _buffer_pos);
+    }
+    _buffer_pos = 0;
+  }
+  if (::fsync(_fd) != 0) {
+    THROW_EXCEPTION("PageWriter: fsync error ", _fname, ": ", std::strerror(errno));
+  }
+  closeFile();
+}
+
+void PageWriter::closeFile() {
+  if (_fd != -1) {
+    ::close(_fd);
+    _fd = -1;
+  }
+}
+#endif
+
+void PageWriter::write(const void *data, size_t size) {
+  auto ptr = static_cast<const uint8_t *>(data);
+  while (size != 0) {
+    auto to_copy = std::min(size, BUFFER_SIZE - _buffer_pos);
+    std::memcpy(_buffer + _buffer_pos, ptr, to_copy);
+    _buffer_pos += to_copy;
+    ptr += to_copy;
+    size -= to_copy;
+    if (_buffer_pos == BUFFER_SIZE) {
+      writeBlock(_buffer, BUFFER_SIZE);
+      _buffer_pos = 0;
+    }
+  }
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <libdariadb/st_exports.h>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+
+namespace dariadb {
+namespace storage {
+
+/**
+sequential writer for new page and index files.
+values are collected in an aligned staging buffer and writed by large blocks.
+if direct_io is set (and supported by os and filesystem), file is opened with
+O_DIRECT, so page creation does not push out of page cache the data of readers.
+close() writes the tail of buffer and calls fsync.
+*/
+class PageWriter {
+public:
+  static constexpr size_t ALIGNMENT = 4096;
+  static constexpr size_t BUFFER_SIZE = 1024 * 1024;
+
+  EXPORT PageWriter(const std::string &fname, bool direct_io);
+  /// without fsync, if close() was not called.
+  EXPORT ~PageWriter();
+  PageWriter(const PageWriter &) = delete;
+  PageWriter &operator=(const PageWriter &) = delete;
+
+  EXPORT void write(const void *data, size_t size);
+  template <class T> void write(const T &value) { write(&value, sizeof(T)); }
+  /// flush buffer, fsync and close file.
+  EXPORT void close();
+
+  /// bytes writed (include buffered).
+  uint64_t size() const { return _offset + _buffer_pos; }
+  bool isDirect() const { return _direct; }
+
+private:
+  void open(bool direct_io);
+  void writeBlock(const uint8_t *data, size_t size);
+  void closeFile();
+
+  std::string _fname;
+  bool _direct;
+#ifdef _WIN32
+  FILE *_file;
+#else
+  int _fd;
+#endif
+  uint8_t *_buffer;
+  size_t _buffer_pos;
+  uint64_t _offset; // writed to file.
+};
+
+using PageWriter_Ptr = std::shared_ptr<PageWriter>;
+}
+}
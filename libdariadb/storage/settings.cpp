@@ -20,10 +20,14 @@ namespace {
 const uint64_t WAL_CACHE_SIZE = 4096 / sizeof(dariadb::Meas) * 10;
 const uint64_t WAL_FILE_SIZE = (1024 * 1024) * 4 / sizeof(dariadb::Meas);
 const uint32_t CHUNK_SIZE = 1024;
+const uint32_t MIN_CHUNK_SIZE = 64;
+const dariadb::Time CHUNK_TIME_SPAN = HOUR_INTERVAL;
 const uint64_t MAX_CHUNKS_PER_PAGE = 10 * 1024;
 const size_t MAXIMUM_MEMORY_LIMIT = 100 * 1024 * 1024; // 100 mb
 const size_t THREADS_COMMON = 2;
 const size_t THREADS_DISKIO = 1;
+const size_t THREADS_SHARD_QUERY = 4;
+const size_t THREADS_FSCK = 0; // all cores
 
 const dariadb::Time LIFETIME_RAW = MINUTE_INTERVAL * 60;
 const dariadb::Time LIFETIME_MINUTE = HOUR_INTERVAL * 2;
@@ -46,13 +50,22 @@ const std::string c_wal_file_size = "wal_file_size";
 const std::string c_chunks_per_page = "chunks_per_page";
 const std::string c_wal_cache_size = "wal_cache_size";
 const std::string c_chunk_size = "chunk_size";
+const std::string c_chunk_size_adaptive = "chunk_size_adaptive";
+const std::string c_chunk_time_span = "chunk_time_span";
 const std::string c_strategy = "strategy";
 const std::string c_memory_limit = "memory_limit";
 const std::string c_percent_when_start_droping = "percent_when_start_droping";
 const std::string c_percent_to_drop = "percent_to_drop";
+const std::string c_memory_hugepages = "memory_hugepages";
 const std::string c_max_pages_per_level = "max_pages_per_level";
 const std::string c_threads_in_common = "threads_in_common";
 const std::string c_threads_in_diskio = "threads_in_diskio";
+const std::string c_threads_in_shard_query = "threads_in_shard_query";
+const std::string c_shard_query_timeout = "shard_query_timeout";
+const std::string c_threads_in_fsck = "threads_in_fsck";
+const std::string c_page_direct_io = "page_direct_io";
+const std::string c_page_mmap_read = "page_mmap_read";
+const std::string c_metrics = "metrics";
 const std::string c_lifetime_raw = "lifetime_raw";
 const std::string c_lifetime_minute = "lifetime_minute";
 const std::string c_lifetime_halfhour = "lifetime_halfhour";
@@ -107,13 +120,22 @@ Settings::Settings(const std::string &path_to_storage)
       wal_cache_size(this, c_wal_cache_size, WAL_CACHE_SIZE),
       max_chunks_per_page(this, c_chunks_per_page, MAX_CHUNKS_PER_PAGE),
       chunk_size(this, c_chunk_size, CHUNK_SIZE),
+      chunk_size_adaptive(this, c_chunk_size_adaptive, true),
+      chunk_time_span(this, c_chunk_time_span, CHUNK_TIME_SPAN),
       strategy(this, c_strategy, STRATEGY::COMPRESSED),
       memory_limit(this, c_memory_limit, MAXIMUM_MEMORY_LIMIT),
       percent_when_start_droping(this, c_percent_when_start_droping, float(0.75)),
       percent_to_drop(this, c_percent_to_drop, float(0.1)),
+      memory_hugepages(this, c_memory_hugepages, false),
       max_pages_in_level(this, c_max_pages_per_level, uint16_t(2)),
       threads_in_common(this, c_threads_in_common, THREADS_COMMON),
       threads_in_diskio(this, c_threads_in_diskio, THREADS_DISKIO),
+      threads_in_shard_query(this, c_threads_in_shard_query, THREADS_SHARD_QUERY),
+      shard_query_timeout(this, c_shard_query_timeout, uint64_t(0)),
+      threads_in_fsck(this, c_threads_in_fsck, THREADS_FSCK),
+      page_direct_io(this, c_page_direct_io, false),
+      page_mmap_read(this, c_page_mmap_read, true),
+      metrics(this, c_metrics, false),
       lifetime_raw(this, c_lifetime_raw, LIFETIME_RAW),
       lifetime_minute(this, c_lifetime_minute, LIFETIME_MINUTE),
       lifetime_halfhour(this, c_lifetime_halfhour, LIFETIME_HALFHOUR),
@@ -151,10 +173,13 @@ void Settings::set_default() {
   wal_cache_size.setValue(WAL_CACHE_SIZE);
   wal_file_size.setValue(WAL_FILE_SIZE);
   chunk_size.setValue(CHUNK_SIZE);
+  chunk_size_adaptive.setValue(true);
+  chunk_time_span.setValue(CHUNK_TIME_SPAN);
   memory_limit.setValue(MAXIMUM_MEMORY_LIMIT);
   strategy.setValue(STRATEGY::COMPRESSED);
   percent_when_start_droping.setValue(float(0.75));
   percent_to_drop.setValue(float(0.15));
+  memory_hugepages.setValue(false);
 }
 
 std::vector<dariadb::utils::async::ThreadPool::Params> Settings::thread_pools_params() {
@@ -231,6 +256,23 @@ void Settings::change(std::string &expression) {
   }
 }
 
+std::vector<uint32_t> Settings::chunk_size_classes() const {
+  auto base = chunk_size.value();
+  if (!chunk_size_adaptive.value()) {
+    return {base};
+  }
+  std::vector<uint32_t> result;
+  for (auto divider : {4, 2}) {
+    if (base / divider >= MIN_CHUNK_SIZE) {
+      result.push_back(base / divider);
+    }
+  }
+  result.push_back(base);
+  result.push_back(base * 2);
+  result.push_back(base * 4);
+  return result;
+}
+
 dariadb::Time Settings::lifetime_for_interval(const std::string &interval) const {
   if (interval == "raw") {
     return lifetime_raw.value();
@@ -101,18 +101,27 @@ public:
 
   Option<uint64_t> max_chunks_per_page; // work when drop from memstorage to pages.
   Option<uint32_t> chunk_size;
+  Option<bool> chunk_size_adaptive; // chunk size per id, see chunk_size_classes.
+  Option<Time> chunk_time_span;     // chunk is sealed, when covers it. 0 - unlimited.
 
   Option<STRATEGY> strategy;
 
   // memstorage options;
   Option<uint32_t> memory_limit;            // in bytes;
-  Option<float> percent_when_start_droping; // fill percent, when start dropping.
-  Option<float> percent_to_drop;            // how many chunk drop.
+  Option<float> percent_when_start_droping; // high watermark: eviction starts.
+  Option<float> percent_to_drop;            // low watermark is high one minus it.
+  Option<bool> memory_hugepages;            // back memstorage slabs by huge pages.
   // pages per level.
   Option<uint16_t> max_pages_in_level;
 
-  Option<size_t> threads_in_common; // threads count in pool 'COMMON'
-  Option<size_t> threads_in_diskio; // threads count in pool 'DISK_IO'
+  Option<size_t> threads_in_common;      // threads count in pool 'COMMON'
+  Option<size_t> threads_in_diskio;      // threads count in pool 'DISK_IO'
+  Option<size_t> threads_in_shard_query; // threads count for parallel shard queries.
+  Option<uint64_t> shard_query_timeout;  // query deadline in ms. 0 - unlimited.
+  Option<size_t> threads_in_fsck;        // threads to check pages. 0 - all cores.
+  Option<bool> page_direct_io; // write new pages with O_DIRECT, if supported.
+  Option<bool> page_mmap_read; // read pages through memory mapping.
+  Option<bool> metrics;        // collect latencies and counters, see utils/metrics.h.
 
   Option<Time> lifetime_raw;      // store interval for raw values.
   Option<Time> lifetime_minute;   // store interval for 'minute' values.
@@ -131,6 +140,8 @@ public:
   Option<STRATEGY> strategy_week;     // strategy for 'week' values.
   Option<STRATEGY> strategy_month;    // strategy for 'month' values.
 
+  /// sizes of chunk buffers: from chunk_size/4 to chunk_size*4, if adaptive.
+  EXPORT std::vector<uint32_t> chunk_size_classes() const;
   EXPORT Time lifetime_for_interval(const std::string &interval) const;
   EXPORT STRATEGY strategy_for_interval(const std::string &interval) const;
 
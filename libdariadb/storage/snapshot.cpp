@@ -0,0 +1,97 @@
+#include <libdariadb/storage/magic.h>
+#include <libdariadb/storage/snapshot.h>
+#include <libdariadb/utils/crc.h>
+#include <libdariadb/utils/fs.h>
+#include <libdariadb/utils/logger.h>
+
+#include <boost/filesystem.hpp>
+#include <fstream>
+
+using namespace dariadb;
+using namespace dariadb::storage;
+
+namespace {
+#pragma pack(push, 1)
+struct SnapshotHeader {
+  uint64_t magic;
+  uint32_t version;
+  uint32_t crc; // of kind and body
+  uint64_t body_size;
+};
+#pragma pack(pop)
+
+uint32_t snapshot_crc(const std::string &kind, const std::string &body) {
+  auto kind_crc = utils::crc32(kind.data(), kind.size());
+  auto body_crc = utils::crc32(body.data(), body.size());
+  return kind_crc ^ body_crc;
+}
+}
+
+bool snapshot::write(const std::string &fname, const std::string &kind,
+                     const std::string &body) {
+  SnapshotHeader hdr;
+  hdr.magic = MAGIC_NUMBER_DARIADB;
+  hdr.version = SNAPSHOT_VERSION;
+  hdr.crc = snapshot_crc(kind, body);
+  hdr.body_size = body.size();
+
+  auto tmp_name = fname + ".tmp";
+  {
+    std::ofstream out(tmp_name, std::ios::binary | std::ios::trunc);
+    if (!out) {
+      logger_fatal("snapshot: can`t open ", tmp_name);
+      return false;
+    }
+    out.write(reinterpret_cast<const char *>(&hdr), sizeof(hdr));
+    out.write(kind.data(), kind.size());
+    out.write(body.data(), body.size());
+    out.flush();
+    if (!out) {
+      logger_fatal("snapshot: write error ", tmp_name);
+      return false;
+    }
+  }
+  boost::system::error_code ec;
+  boost::filesystem::rename(tmp_name, fname, ec);
+  if (ec) {
+    logger_fatal("snapshot: rename error ", tmp_name, ": ", ec.message());
+    utils::fs::rm(tmp_name);
+    return false;
+  }
+  return true;
+}
+
+bool snapshot::read(const std::string &fname, const std::string &kind,
+                    std::string *body) {
+  if (!utils::fs::file_exists(fname)) {
+    return false;
+  }
+  std::ifstream in(fname, std::ios::binary | std::ios::ate);
+  uint64_t file_size = in.tellg();
+  in.seekg(0);
+  SnapshotHeader hdr;
+  if (!in.read(reinterpret_cast<char *>(&hdr), sizeof(hdr))) {
+    return false;
+  }
+  if (hdr.magic != MAGIC_NUMBER_DARIADB || hdr.version != SNAPSHOT_VERSION) {
+    logger_info("snapshot: ", fname, " has unknown format - ignored.");
+    return false;
+  }
+  if (file_size != sizeof(hdr) + kind.size() + hdr.body_size) {
+    logger_info("snapshot: ", fname, " is truncated - ignored.");
+    return false;
+  }
+  std::string readed_kind(kind.size(), '\0');
+  if (!in.read(&readed_kind[0], kind.size()) || readed_kind != kind) {
+    return false;
+  }
+  body->resize(hdr.body_size);
+  if (hdr.body_size != 0 && !in.read(&(*body)[0], hdr.body_size)) {
+    return false;
+  }
+  if (snapshot_crc(kind, *body) != hdr.crc) {
+    logger_info("snapshot: ", fname, " is broken - ignored.");
+    return false;
+  }
+  return true;
+}
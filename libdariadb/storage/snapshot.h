@@ -0,0 +1,74 @@
+#pragma once
+
+#include <libdariadb/st_exports.h>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+
+namespace dariadb {
+namespace storage {
+
+/// checkpoint of in-memory state of a storage (page footers, min/max...).
+/// used to avoid reading of every file on startup.
+namespace snapshot {
+
+const uint32_t SNAPSHOT_VERSION = 1;
+
+/// serialize POD values and strings to a binary buffer.
+class Writer {
+public:
+  template <class T> void put(const T &v) {
+    static_assert(std::is_standard_layout<T>::value, "T must be a POD");
+    auto ptr = reinterpret_cast<const char *>(&v);
+    data.append(ptr, ptr + sizeof(T));
+  }
+
+  void put_string(const std::string &s) {
+    put(uint32_t(s.size()));
+    data.append(s);
+  }
+
+  std::string data;
+};
+
+/// read values, writed by Writer. all methods return false on end of buffer.
+class Reader {
+public:
+  Reader(const std::string &d) : data(d), pos(0) {}
+
+  template <class T> bool get(T *v) {
+    static_assert(std::is_standard_layout<T>::value, "T must be a POD");
+    if (pos + sizeof(T) > data.size()) {
+      return false;
+    }
+    std::memcpy(static_cast<void *>(v), data.data() + pos, sizeof(T));
+    pos += sizeof(T);
+    return true;
+  }
+
+  bool get_string(std::string *s) {
+    uint32_t sz = 0;
+    if (!get(&sz) || pos + sz > data.size()) {
+      return false;
+    }
+    s->assign(data.data() + pos, sz);
+    pos += sz;
+    return true;
+  }
+
+  bool eof() const { return pos == data.size(); }
+
+private:
+  const std::string &data;
+  size_t pos;
+};
+
+/// write body to file atomically: to temporary file and rename.
+EXPORT bool write(const std::string &fname, const std::string &kind,
+                  const std::string &body);
+/// false if file not exists, was writed by other version or is broken.
+EXPORT bool read(const std::string &fname, const std::string &kind, std::string *body);
+}
+}
+}
@@ -1,4 +1,5 @@
 #include <libdariadb/storage/subscribe.h>
+#include <libdariadb/utils/logger.h>
 #include <libdariadb/utils/utils.h>
 #include <algorithm>
 
@@ -10,40 +11,191 @@ SubscribeInfo::SubscribeInfo(const IdArray &i, const Flag &f, const ReaderCallba
 
 bool SubscribeInfo::isYours(const dariadb::Meas &m) const {
   if ((ids.size() == 0) || (std::find(ids.cbegin(), ids.cend(), m.id) != ids.end())) {
-    if ((flag == 0) || (flag == m.flag)) {
+    if (inFlag(m)) {
       return true;
     }
   }
   return false;
 }
 
+SubscribeNotificator::SubscribeNotificator() : _queue(INGRESS_QUEUE_SIZE) {
+  _is_stoped = true;
+  _index = std::make_shared<SubscribeIndex>();
+  _subscribes_count = 0;
+  _pushed = 0;
+  _ingress_dropped = 0;
+  _popped = 0;
+  _delivered = 0;
+  _stop_flag = false;
+  _delivery_waits = false;
+}
+
 SubscribeNotificator::~SubscribeNotificator() {
-  if (!is_stoped) {
+  if (!_is_stoped) {
     this->stop();
   }
 }
 
 void SubscribeNotificator::start() {
   std::lock_guard<std::mutex> lg(_locker);
-  is_stoped = false;
+  _is_stoped = false;
+  _stop_flag = false;
+  _delivery_thread = std::thread{&SubscribeNotificator::delivery_logic, this};
 }
 
 void SubscribeNotificator::stop() {
   std::lock_guard<std::mutex> lg(_locker);
-  is_stoped = true;
+  if (_is_stoped) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> dlg(_delivery_locker);
+    _stop_flag = true;
+  }
+  _delivery_cond.notify_all();
+  _delivery_thread.join();
+  _is_stoped = true;
 }
 
 void SubscribeNotificator::add(const SubscribeInfo_ptr &n) {
   std::lock_guard<std::mutex> lg(_locker);
-  ENSURE(!is_stoped);
-  _subscribes.push_back(n);
+  ENSURE(!_is_stoped);
+  ENSURE(n->clbk != nullptr);
+  auto new_index = std::make_shared<SubscribeIndex>(*std::atomic_load(&_index));
+  if (n->ids.empty()) {
+    new_index->all_ids.push_back(n);
+  } else {
+    for (auto id : n->ids) {
+      auto &target = new_index->by_id[id];
+      if (std::find(target.begin(), target.end(), n) == target.end()) {
+        target.push_back(n);
+      }
+    }
+  }
+  std::atomic_store(&_index, SubscribeIndex_ptr(new_index));
+  _subscribes_count++;
+}
+
+void SubscribeNotificator::on_append(const dariadb::Meas &m) {
+  if (_subscribes_count.load(std::memory_order_relaxed) == size_t(0)) {
+    return;
+  }
+  if (!_queue.bounded_push(m)) {
+    // delivery thread is blocked by a slow subscriber.
+    _ingress_dropped++;
+    return;
+  }
+  _pushed++;
+  // pairs with the fence in delivery_logic, so a push is not missed by the waiter.
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (_delivery_waits.load()) {
+    std::lock_guard<std::mutex> lg(_delivery_locker);
+    _delivery_cond.notify_one();
+  }
+}
+
+void SubscribeNotificator::flush() {
+  auto target = _pushed.load();
+  std::unique_lock<std::mutex> lock(_delivery_locker);
+  _flush_cond.wait(lock, [this, target]() {
+    return _delivered.load() >= target || _stop_flag.load();
+  });
+}
+
+size_t SubscribeNotificator::dispatch(std::vector<SubscribeInfo_ptr> &receivers) {
+  auto index = std::atomic_load(&_index);
+  size_t count = 0;
+  Meas m;
+  auto to_subscriber = [&receivers, &m, this](const SubscribeInfo_ptr &si) {
+    if (!si->inFlag(m)) {
+      return;
+    }
+    if (si->pending.empty()) {
+      receivers.push_back(si);
+    } else if (si->pending.size() >= SUBSCRIBER_QUEUE_SIZE) {
+      // subscriber is too slow, the oldest value is lost.
+      si->pending.pop_front();
+      si->dropped++;
+    }
+    si->pending.emplace_back(_popped, m);
+  };
+
+  while (count < SUBSCRIBER_QUEUE_SIZE && _queue.pop(m)) {
+    ++count;
+    ++_popped;
+    auto it = index->by_id.find(m.id);
+    if (it != index->by_id.end()) {
+      for (auto &si : it->second) {
+        to_subscriber(si);
+      }
+    }
+    for (auto &si : index->all_ids) {
+      to_subscriber(si);
+    }
+  }
+  return count;
 }
 
-void SubscribeNotificator::on_append(const dariadb::Meas &m) const {
-  for (auto si : _subscribes) {
-    ENSURE(si->clbk != nullptr);
-    if (si->isYours(m)) {
-      si->clbk->apply(m);
+void SubscribeNotificator::delivery_logic() {
+  std::vector<SubscribeInfo_ptr> receivers;
+  MeasArray batch;
+  batch.reserve(DELIVERY_BATCH_SIZE);
+
+  while (true) {
+    dispatch(receivers);
+    auto ingress_dropped = _ingress_dropped.exchange(0);
+    if (ingress_dropped != 0) {
+      logger_info("engine: subscribers are too slow, dropped ", ingress_dropped,
+                  " values.");
+    }
+
+    if (receivers.empty()) {
+      {
+        std::unique_lock<std::mutex> lock(_delivery_locker);
+        _delivered = _popped;
+        _flush_cond.notify_all();
+        if (_stop_flag.load() && _queue.empty()) {
+          break;
+        }
+        _delivery_waits = true;
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (_queue.empty() && !_stop_flag.load()) {
+          _delivery_cond.wait(lock);
+        }
+        _delivery_waits = false;
+      }
+      continue;
+    }
+
+    for (auto &si : receivers) {
+      auto count = std::min(si->pending.size(), size_t(DELIVERY_BATCH_SIZE));
+      batch.clear();
+      for (size_t i = 0; i < count; ++i) {
+        batch.push_back(si->pending[i].second);
+      }
+      si->pending.erase(si->pending.begin(), si->pending.begin() + count);
+      if (si->dropped != 0) {
+        logger_info("engine: subscriber is too slow, dropped ", si->dropped, " values.");
+        si->dropped = 0;
+      }
+      try {
+        si->clbk->apply_batch(batch);
+      } catch (std::exception &ex) {
+        logger_fatal("engine: subscriber error - ", ex.what());
+      }
+    }
+    receivers.erase(std::remove_if(receivers.begin(), receivers.end(),
+                                   [](const SubscribeInfo_ptr &si) {
+                                     return si->pending.empty();
+                                   }),
+                    receivers.end());
+
+    auto delivered = _popped;
+    for (auto &si : receivers) {
+      delivered = std::min(delivered, si->pending.front().first - 1);
     }
+    std::lock_guard<std::mutex> lg(_delivery_locker);
+    _delivered = delivered;
+    _flush_cond.notify_all();
   }
 }
@@ -3,7 +3,16 @@
 #include <libdariadb/meas.h>
 #include <libdariadb/storage/callbacks.h>
 #include <libdariadb/utils/async/locker.h>
+#include <boost/lockfree/queue.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
 #include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 namespace dariadb {
 namespace storage {
@@ -15,21 +24,74 @@ struct SubscribeInfo {
   Flag flag;
   mutable ReaderCallback_ptr clbk;
   bool isYours(const dariadb::Meas &m) const;
+  bool inFlag(const dariadb::Meas &m) const { return (flag == 0) || (flag == m.flag); }
+
+  /// values waiting for delivery with their ingress numbers.
+  /// used by the delivery thread only.
+  mutable std::deque<std::pair<size_t, Meas>> pending;
+  mutable size_t dropped = 0;
 };
 
 typedef std::shared_ptr<SubscribeInfo> SubscribeInfo_ptr;
 
-struct SubscribeNotificator {
-  std::list<SubscribeInfo_ptr> _subscribes;
-  bool is_stoped;
-  std::mutex _locker;
+/// immutable, replaced on each SubscribeNotificator::add.
+struct SubscribeIndex {
+  std::unordered_map<Id, std::vector<SubscribeInfo_ptr>> by_id;
+  std::vector<SubscribeInfo_ptr> all_ids; // subscribers with empty ids.
+};
+
+typedef std::shared_ptr<const SubscribeIndex> SubscribeIndex_ptr;
+
+/**
+on_append only puts the value to a bounded lock-free queue, so writers do not
+wait for each other. The delivery thread moves values from it to a bounded
+queue of each matched subscriber and sends them in batches. When a subscriber
+is too slow, the oldest values from its queue are dropped. When the delivery
+thread is blocked by a subscriber and the ingress queue is full, new values
+are dropped.
+*/
+class SubscribeNotificator {
+public:
+  /// max values sended to one subscriber at once.
+  static const size_t DELIVERY_BATCH_SIZE = 4096;
+  /// max values waiting for delivery to one subscriber.
+  static const size_t SUBSCRIBER_QUEUE_SIZE = DELIVERY_BATCH_SIZE * 16;
+  /// max values waiting in the ingress queue.
+  static const size_t INGRESS_QUEUE_SIZE = SUBSCRIBER_QUEUE_SIZE;
 
-  SubscribeNotificator() = default;
+  SubscribeNotificator();
   ~SubscribeNotificator();
   void start();
   void stop();
   void add(const SubscribeInfo_ptr &n);
-  void on_append(const dariadb::Meas &m) const;
+  void on_append(const dariadb::Meas &m);
+  /// wait until all appended values are delivered or dropped.
+  void flush();
+
+protected:
+  /// move values from the ingress queue to subscriber queues.
+  size_t dispatch(std::vector<SubscribeInfo_ptr> &receivers);
+  void delivery_logic();
+
+  std::mutex _locker;
+  bool _is_stoped;
+  SubscribeIndex_ptr _index;
+  std::atomic_size_t _subscribes_count;
+
+  boost::lockfree::queue<Meas> _queue;
+  std::atomic_size_t _pushed;
+  std::atomic_size_t _ingress_dropped;
+  /// values taken from the ingress queue. delivery thread only.
+  size_t _popped;
+  /// all values with ingress number less or equal are delivered or dropped.
+  std::atomic_size_t _delivered;
+
+  std::thread _delivery_thread;
+  std::atomic_bool _stop_flag;
+  std::atomic_bool _delivery_waits;
+  std::mutex _delivery_locker;
+  std::condition_variable _delivery_cond;
+  std::condition_variable _flush_cond;
 };
 }
 }
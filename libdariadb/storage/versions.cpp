@@ -0,0 +1,114 @@
+#include <libdariadb/storage/versions.h>
+#include <libdariadb/utils/fs.h>
+#include <libdariadb/utils/logger.h>
+
+using namespace dariadb;
+using namespace dariadb::storage;
+
+StorageVersion::~StorageVersion() {
+  for (auto &f : _to_remove) {
+    try {
+      utils::fs::rm(f);
+    } catch (std::exception &ex) {
+      logger_fatal("versions: can`t remove ", f, ": ", ex.what());
+    }
+  }
+  // release chain of outdated versions without recursion.
+  auto next = std::move(_next);
+  while (next != nullptr && next.use_count() == long(1)) {
+    auto tmp = std::move(next->_next);
+    next = std::move(tmp);
+  }
+}
+
+VersionManager::VersionManager() : _seq(0), _current(new StorageVersion(0)) {}
+
+VersionManager::~VersionManager() {
+  ENSURE(_pending_remove.empty());
+}
+
+StorageVersion_Ptr VersionManager::pin() const {
+  while (true) {
+    auto s = _seq.load();
+    if (s % 2 == 0) {
+      auto v = std::atomic_load(&_current);
+      if (v->_number * 2 == s) {
+        return v;
+      }
+      continue;
+    }
+    std::unique_lock<std::mutex> ul(_seq_locker);
+    _seq_cond.wait(ul, [this]() { return _seq.load() % 2 == 0; });
+  }
+}
+
+bool VersionManager::isCurrent(const StorageVersion_Ptr &v) const {
+  return _seq.load() == v->_number * 2;
+}
+
+uint64_t VersionManager::current() const {
+  return std::atomic_load(&_current)->_number;
+}
+
+void VersionManager::publish(const std::function<void()> &change) {
+  if (inPublish()) {
+    change();
+    return;
+  }
+  std::exception_ptr error;
+  std::list<std::function<void()>> after;
+  {
+    std::lock_guard<std::shared_mutex> lg(_publish_locker);
+    _publisher.store(std::this_thread::get_id());
+    _seq++;
+
+    try {
+      change();
+    } catch (...) {
+      error = std::current_exception();
+    }
+
+    auto old = std::atomic_load(&_current);
+    StorageVersion_Ptr new_version{new StorageVersion(old->_number + 1)};
+    old->_to_remove = std::move(_pending_remove);
+    _pending_remove.clear();
+    old->_next = new_version;
+    std::atomic_store(&_current, new_version);
+    {
+      std::lock_guard<std::mutex> slg(_seq_locker);
+      _seq++;
+    }
+    _publisher.store(std::thread::id());
+    std::swap(after, _after_publish);
+  }
+  _seq_cond.notify_all();
+
+  for (auto &f : after) {
+    try {
+      f();
+    } catch (...) {
+      if (error == nullptr) {
+        error = std::current_exception();
+      }
+    }
+  }
+  if (error != nullptr) {
+    std::rethrow_exception(error);
+  }
+}
+
+void VersionManager::removeLater(const std::string &fname) {
+  if (!inPublish()) {
+    publish([this, &fname]() { _pending_remove.push_back(fname); });
+    return;
+  }
+  _pending_remove.push_back(fname);
+}
+
+void VersionManager::afterPublish(const std::function<void()> &f) {
+  if (!inPublish()) {
+    f();
+    return;
+  }
+  _after_publish.push_back(f);
+}
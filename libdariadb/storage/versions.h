@@ -0,0 +1,101 @@
+#pragma once
+
+#include <libdariadb/st_exports.h>
+#include <libdariadb/utils/async/thread_manager.h>
+#include <libdariadb/utils/utils.h>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+
+namespace dariadb {
+namespace storage {
+
+class StorageVersion;
+using StorageVersion_Ptr = std::shared_ptr<StorageVersion>;
+
+/// published state of storage (pages, wal files and memstorage chunks).
+/// files removed by newer versions stay on disk, while a reader holds this one.
+class StorageVersion : public utils::NonCopy {
+public:
+  EXPORT ~StorageVersion();
+  uint64_t number() const { return _number; }
+
+private:
+  friend class VersionManager;
+  StorageVersion(uint64_t number) : _number(number) {}
+
+  uint64_t _number;
+  std::list<std::string> _to_remove; // not exists in next version.
+  StorageVersion_Ptr _next;          // keep newer versions alive.
+};
+
+/**
+MVCC of storage state.
+readers pin() current version without locks, read from managers and check
+isCurrent(); if drop or compaction published a new version meanwhile, the
+read is repeated, READ_RETRIES times at most, then it is done under the lock,
+which excludes publish. writers change the set of files and chunks in publish():
+it is exclusive, so the heavy work (compression, page writing) must be done
+before and only the switch (insert of page, erase of wal) is done inside.
+i/o of the switch (manifest, snapshots) goes to afterPublish().
+*/
+class VersionManager : public utils::NonCopy {
+public:
+  static const size_t READ_RETRIES = 3;
+
+  EXPORT VersionManager();
+  EXPORT ~VersionManager();
+
+  /// waits, while publish is in progress.
+  EXPORT StorageVersion_Ptr pin() const;
+  EXPORT bool isCurrent(const StorageVersion_Ptr &v) const;
+  EXPORT uint64_t current() const;
+
+  /// nested calls from the same thread are part of the outer publish.
+  EXPORT void publish(const std::function<void()> &change);
+  /// remove file, when all versions which can see it are released.
+  EXPORT void removeLater(const std::string &fname);
+  /// run after the outer publish is done, out of the exclusive section.
+  EXPORT void afterPublish(const std::function<void()> &f);
+
+  /// runs `read` until it is not overlapped by publish. `read` must not publish.
+  template <class F> auto read(F read_logic) const -> decltype(read_logic()) {
+    if (inPublish()) {
+      return read_logic();
+    }
+    for (size_t i = 0; i < READ_RETRIES; ++i) {
+      auto v = pin();
+      auto result = read_logic();
+      if (isCurrent(v)) {
+        return result;
+      }
+    }
+    // publishes are too frequent for this read. publish can wait in a pool thread,
+    // so the read does not wait for pools.
+    std::shared_lock<std::shared_mutex> lg(_publish_locker);
+    utils::async::ThreadManager::InlineGuard ig;
+    return read_logic();
+  }
+
+private:
+  bool inPublish() const { return _publisher.load() == std::this_thread::get_id(); }
+
+  std::atomic<uint64_t> _seq; // odd while publish is in progress.
+  StorageVersion_Ptr _current;
+  mutable std::shared_mutex _publish_locker; // exclusive - publish, shared - read.
+  std::atomic<std::thread::id> _publisher;
+  std::list<std::string> _pending_remove;
+  std::list<std::function<void()>> _after_publish;
+
+  mutable std::mutex _seq_locker;
+  mutable std::condition_variable _seq_cond; // publish is done.
+};
+}
+}
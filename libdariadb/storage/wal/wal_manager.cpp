@@ -1,8 +1,11 @@
 #include <libdariadb/flags.h>
+#include <libdariadb/storage/bloom_filter.h>
 #include <libdariadb/storage/callbacks.h>
 #include <libdariadb/storage/cursors.h>
 #include <libdariadb/storage/manifest.h>
 #include <libdariadb/storage/settings.h>
+#include <libdariadb/storage/snapshot.h>
+#include <libdariadb/storage/versions.h>
 #include <libdariadb/storage/wal/wal_manager.h>
 #include <libdariadb/utils/async/thread_manager.h>
 #include <libdariadb/utils/exception.h>
@@ -19,8 +22,16 @@ using namespace dariadb::utils::async;
 
 EXPORT WALManager *WALManager::_instance = nullptr;
 
+namespace {
+const std::string WAL_SNAPSHOT_FILE = "wal.snapshot";
+const std::string WAL_SNAPSHOT_KIND = "wal";
+}
+
 WALManager::~WALManager() {
   this->flush();
+  if (_snapshot_changes.load() != 0) {
+    writeSnapshot();
+  }
 }
 
 WALManager_ptr WALManager::create(const EngineEnvironment_ptr env) {
@@ -31,10 +42,15 @@ WALManager::WALManager(const EngineEnvironment_ptr env) {
   _env = env;
   _settings = _env->getResourceObject<Settings>(EngineEnvironment::Resource::SETTINGS);
   _down = nullptr;
+  _snapshot_changes = 0;
+  _flush_latency = utils::metrics::Registry::instance()->histogram("wal.flush_ns");
+  _flushed = utils::metrics::Registry::instance()->counter("wal.flushed");
   auto manifest =
       _env->getResourceObject<Manifest>(EngineEnvironment::Resource::MANIFEST);
   if (dariadb::utils::fs::path_exists(_settings->raw_path.value())) {
+    auto snapshot = readSnapshot();
     auto wals = manifest->wal_list();
+    size_t from_snapshot = 0;
     for (auto f : wals) {
       auto full_filename = utils::fs::append_path(_settings->raw_path.value(), f.fname);
 
@@ -43,18 +59,30 @@ WALManager::WALManager(const EngineEnvironment_ptr env) {
       if (writed == 0) {
         p = nullptr;
         this->erase(f.fname);
+        continue;
+      }
+      // file is not changed after snapshot, if size is the same.
+      auto sres = snapshot.find(f.fname);
+      if (sres != snapshot.end() && sres->second.writed == writed) {
+        _file2minmax[full_filename] = std::move(sres->second);
+        ++from_snapshot;
+      } else {
+        _file2minmax[full_filename] = describe(*p->readAll());
+        _snapshot_changes++;
       }
-      _file2minmax[full_filename].minTime = p->minTime();
-      _file2minmax[full_filename].maxTime = p->maxTime();
-      _file2minmax[full_filename].bloom_id = p->id_bloom();
 
-      if (WALFile::writed(full_filename) != _settings->wal_file_size.value()) {
+      if (writed != _settings->wal_file_size.value()) {
         logger_info("engine", _settings->alias, ": WalManager open exist file ", f.fname);
         auto bd =
             std::make_shared<BufferDescription>(p, _settings->wal_cache_size.value());
         _buffers.insert(p->id_from_first(), bd);
       }
     }
+    if (from_snapshot != snapshot.size()) {
+      _snapshot_changes++;
+    }
+    logger_info("engine", _settings->alias, ": wal files - ", wals.size(),
+                ", from snapshot - ", from_snapshot);
   }
 
   //_buffer.resize(_settings->wal_cache_size.value());
@@ -63,16 +91,23 @@ WALManager::WALManager(const EngineEnvironment_ptr env) {
 
 WALFile_Ptr WALManager::create_new(BufferDescription_Ptr bd, dariadb::Id id) {
   if (bd->walfile != nullptr) {
-    std::lock_guard<std::mutex> lg(_file2mm_locker);
-    auto walfile_ptr = bd->walfile;
-    auto f = walfile_ptr->filename();
-    _file2minmax[f].minTime = walfile_ptr->minTime();
-    _file2minmax[f].maxTime = walfile_ptr->maxTime();
-    _file2minmax[f].bloom_id = walfile_ptr->id_bloom();
-    if (_settings->strategy.value() != STRATEGY::WAL) {
-      dropFile(f);
+    {
+      std::lock_guard<std::mutex> lg(_file2mm_locker);
+      auto walfile_ptr = bd->walfile;
+      auto f = walfile_ptr->filename();
+      TimeMinMax description;
+      description.minTime = walfile_ptr->minTime();
+      description.maxTime = walfile_ptr->maxTime();
+      description.bloom_id = walfile_ptr->id_bloom();
+      description.writed = walfile_ptr->writed();
+      _file2minmax[f] = std::move(description);
+      _snapshot_changes++;
+      if (_settings->strategy.value() != STRATEGY::WAL) {
+        dropFile(f);
+      }
+      bd->walfile = nullptr;
     }
-    bd->walfile = nullptr;
+    writeSnapshotIfNeeded();
   }
 
   auto result = WALFile::create(_env, id);
@@ -577,6 +612,7 @@ void WALManager::flush_buffer_logic(const BufferDescription_Ptr &bd) {
     bd->locker.unlock();
     return;
   }
+  utils::metrics::ScopedTimer timer(_flush_latency);
   dariadb::Id id = bd->buffer.front().id;
   size_t pos = 0;
   size_t total_writed = 0;
@@ -609,6 +645,7 @@ void WALManager::flush_buffer_logic(const BufferDescription_Ptr &bd) {
     }
   }
   bd->pos = size_t(0);
+  _flushed->add(total_writed);
 
   bd->locker.unlock();
   return;
@@ -653,22 +690,160 @@ size_t WALManager::filesCount() const {
 }
 
 void WALManager::erase(const std::string &fname) {
-  std::lock_guard<std::mutex> lg(_file2mm_locker);
-  auto full_path = utils::fs::append_path(_settings->raw_path.value(), fname);
-  _env->getResourceObject<Manifest>(EngineEnvironment::Resource::MANIFEST)->wal_rm(fname);
-  _file2minmax.erase(full_path);
-  utils::fs::rm(full_path);
+  auto versions =
+      _env->getResourceObject<VersionManager>(EngineEnvironment::Resource::VERSIONS);
+  versions->publish([this, versions, &fname]() {
+    std::lock_guard<std::mutex> lg(_file2mm_locker);
+    auto full_path = utils::fs::append_path(_settings->raw_path.value(), fname);
+    _file2minmax.erase(full_path);
+    versions->removeLater(full_path);
+    _snapshot_changes++;
+    versions->afterPublish([this, fname]() {
+      _env->getResourceObject<Manifest>(EngineEnvironment::Resource::MANIFEST)
+          ->wal_rm(fname);
+      writeSnapshotIfNeeded();
+    });
+  });
+}
+
+WALManager::TimeMinMax WALManager::describe(const MeasArray &values) {
+  TimeMinMax result;
+  result.minTime = MAX_TIME;
+  result.maxTime = MIN_TIME;
+  result.bloom_id = bloom_empty<Id>();
+  result.writed = values.size();
+  result.has_minmax = true;
+
+  Id2MinMax id2mm;
+  for (const auto &val : values) {
+    result.minTime = std::min(result.minTime, val.time);
+    result.maxTime = std::max(result.maxTime, val.time);
+    result.bloom_id = bloom_add<Id>(result.bloom_id, val.id);
+
+    auto fres = id2mm.find_bucket(val.id);
+    fres.v->second.updateMax(val);
+    fres.v->second.updateMin(val);
+  }
+  id2mm.apply([&result](const Id2MinMax::value_type &v) { result.minmax.push_back(v); });
+  return result;
+}
+
+std::unordered_map<std::string, WALManager::TimeMinMax> WALManager::readSnapshot() {
+  std::unordered_map<std::string, TimeMinMax> result;
+  std::string body;
+  auto fname = utils::fs::append_path(_settings->raw_path.value(), WAL_SNAPSHOT_FILE);
+  if (!snapshot::read(fname, WAL_SNAPSHOT_KIND, &body)) {
+    return result;
+  }
+  snapshot::Reader reader(body);
+  uint64_t count = 0;
+  bool ok = reader.get(&count);
+  for (uint64_t i = 0; ok && i < count; ++i) {
+    std::string name;
+    TimeMinMax tmm;
+    uint64_t writed = 0;
+    uint8_t has_minmax = 0;
+    ok = reader.get_string(&name) && reader.get(&tmm.minTime) &&
+         reader.get(&tmm.maxTime) && reader.get(&tmm.bloom_id) && reader.get(&writed) &&
+         reader.get(&has_minmax);
+    tmm.writed = size_t(writed);
+    if (ok && has_minmax != 0) {
+      uint32_t mm_count = 0;
+      ok = reader.get(&mm_count);
+      for (uint32_t j = 0; ok && j < mm_count; ++j) {
+        std::pair<Id, MeasMinMax> mm;
+        ok = reader.get(&mm.first) && reader.get(&mm.second);
+        tmm.minmax.push_back(mm);
+      }
+      tmm.has_minmax = true;
+    }
+    if (ok) {
+      result.emplace(name, std::move(tmm));
+    }
+  }
+  if (!ok || !reader.eof()) {
+    logger_info("engine", _settings->alias, ": bad wal snapshot - ignored.");
+    result.clear();
+  }
+  return result;
+}
+
+void WALManager::writeSnapshot() {
+  if (!utils::fs::path_exists(_settings->raw_path.value())) {
+    return;
+  }
+  std::lock_guard<std::mutex> slg(_snapshot_lock);
+  snapshot::Writer writer;
+  {
+    std::lock_guard<std::mutex> lg(_file2mm_locker);
+    _snapshot_changes = 0;
+    writer.put(uint64_t(_file2minmax.size()));
+    for (auto &kv : _file2minmax) {
+      writer.put_string(utils::fs::extract_filename(kv.first));
+      writer.put(kv.second.minTime);
+      writer.put(kv.second.maxTime);
+      writer.put(kv.second.bloom_id);
+      writer.put(uint64_t(kv.second.writed));
+      if (!kv.second.has_minmax) {
+        writer.put(uint8_t(0));
+        continue;
+      }
+      writer.put(uint8_t(1));
+      writer.put(uint32_t(kv.second.minmax.size()));
+      for (auto &mm : kv.second.minmax) {
+        writer.put(mm.first);
+        writer.put(mm.second);
+      }
+    }
+  }
+  auto fname = utils::fs::append_path(_settings->raw_path.value(), WAL_SNAPSHOT_FILE);
+  snapshot::write(fname, WAL_SNAPSHOT_KIND, writer.data);
+}
+
+void WALManager::writeSnapshotIfNeeded() {
+  size_t files = 0;
+  {
+    std::lock_guard<std::mutex> lg(_file2mm_locker);
+    files = _file2minmax.size();
+  }
+  if (_snapshot_changes.load() >= std::max(size_t(64), files / 8)) {
+    writeSnapshot();
+  }
 }
 
+/// min/max of not changed files are cached.
 Id2MinMax_Ptr WALManager::loadMinMax() {
   auto files = wal_files_all();
 
   auto result = std::make_shared<dariadb::Id2MinMax>();
   for (const auto &f : files) {
+    auto writed = WALFile::writed(f);
+    {
+      std::lock_guard<std::mutex> lg(_file2mm_locker);
+      auto fres = _file2minmax.find(f);
+      if (fres != _file2minmax.end() && fres->second.has_minmax &&
+          fres->second.writed == writed) {
+        for (auto &mm : fres->second.minmax) {
+          auto rres = result->find_bucket(mm.first);
+          rres.v->second.updateMax(mm.second.max);
+          rres.v->second.updateMin(mm.second.min);
+        }
+        continue;
+      }
+    }
     auto c = WALFile::open(_env, f, true);
-    auto sub_res = c->loadMinMax();
-
-    minmax_append(result, sub_res);
+    auto description = describe(*c->readAll());
+    for (auto &mm : description.minmax) {
+      auto rres = result->find_bucket(mm.first);
+      rres.v->second.updateMax(mm.second.max);
+      rres.v->second.updateMin(mm.second.min);
+    }
+    std::lock_guard<std::mutex> lg(_file2mm_locker);
+    auto fres = _file2minmax.find(f);
+    if (fres != _file2minmax.end()) { // file may be erased while reading.
+      fres->second = std::move(description);
+      _snapshot_changes++;
+    }
   }
 
   _buffers.apply([this, &result](const Id2Buffer::value_type &kv) {
@@ -7,10 +7,12 @@
 #include <libdariadb/storage/settings.h>
 #include <libdariadb/storage/wal/walfile.h>
 #include <libdariadb/utils/async/locker.h>
+#include <libdariadb/utils/metrics.h>
 #include <libdariadb/utils/striped_map.h>
 #include <libdariadb/utils/utils.h>
 #include <vector>
 
+#include <atomic>
 #include <mutex>
 #include <shared_mutex>
 namespace dariadb {
@@ -95,9 +97,22 @@ private:
     Time minTime;
     Time maxTime;
     Id bloom_id;
+    size_t writed = 0;       // values in file, when description was created.
+    bool has_minmax = false; // result of loadMinMax is cached.
+    std::vector<std::pair<Id, MeasMinMax>> minmax;
   };
+  static TimeMinMax describe(const MeasArray &values);
+  std::unordered_map<std::string, TimeMinMax> readSnapshot();
+  void writeSnapshot();
+  void writeSnapshotIfNeeded();
+
   std::unordered_map<std::string, TimeMinMax> _file2minmax;
   std::mutex _file2mm_locker;
+  std::atomic<size_t> _snapshot_changes;
+  std::mutex _snapshot_lock;
+
+  utils::metrics::Histogram *_flush_latency;
+  utils::metrics::Counter *_flushed;
 };
 } // namespace storage
 } // namespace dariadb
@@ -3,7 +3,6 @@
 #include <cstring>
 
 #include "boost/date_time/gregorian/gregorian.hpp"
-#include <boost/date_time/gregorian/greg_weekday.hpp>
 #include <boost/date_time/posix_time/posix_time.hpp>
 
 namespace dariadb {
@@ -36,36 +35,43 @@ boost::posix_time::ptime to_ptime(Time timestamp) {
   return ptime;
 }
 
-DateTime to_datetime(Time t) {
-  using namespace boost::gregorian;
-  using namespace boost::posix_time;
+namespace {
+const Time MS_IN_MINUTE = Time(60) * 1000;
+const Time MS_IN_HALFHOUR = MS_IN_MINUTE * 30;
+const Time MS_IN_HOUR = MS_IN_MINUTE * 60;
+const Time MS_IN_DAY = MS_IN_HOUR * 24;
+const Time MS_IN_WEEK = MS_IN_DAY * 7;
+
+static_assert(days_from_civil(1970, 1, 1) == 0, "epoch");
+static_assert(days_from_civil(2000, 3, 1) == 11017, "after leap day");
+static_assert(civil_from_days(11016).day == 29, "leap day");
+
+Time from_days_since_epoch(int64_t days) {
+  return Time(days) * MS_IN_DAY;
+}
+} // namespace
 
-  auto ptime = to_ptime(t);
-  auto date = ptime.date();
-  auto time = ptime.time_of_day();
-  auto ymd = gregorian_calendar::from_day_number(date.day_number());
+DateTime to_datetime(Time t) {
+  auto days = int64_t(t / MS_IN_DAY);
+  auto ms_of_day = t % MS_IN_DAY;
+  auto civil = civil_from_days(days);
 
   DateTime result;
-  result.year = ymd.year;
-  result.month = (uint8_t)ymd.month;
-  result.day = ymd.day;
-  result.day_of_year = date.day_of_year();
-  result.hour = (uint8_t)time.hours();
-  result.minute = (uint8_t)time.minutes();
-  result.second = (uint8_t)time.seconds();
-  result.millisecond = (uint16_t)(time.total_milliseconds() % 1000);
+  result.year = (uint16_t)civil.year;
+  result.month = (uint8_t)civil.month;
+  result.day = (uint16_t)civil.day;
+  result.day_of_year = (uint16_t)(days - days_from_civil(civil.year, 1, 1) + 1);
+  result.hour = (uint8_t)(ms_of_day / MS_IN_HOUR);
+  result.minute = (uint8_t)(ms_of_day % MS_IN_HOUR / MS_IN_MINUTE);
+  result.second = (uint8_t)(ms_of_day % MS_IN_MINUTE / 1000);
+  result.millisecond = (uint16_t)(ms_of_day % 1000);
   return result;
 }
 
 Time from_datetime(const DateTime &dt) {
-  using namespace boost::gregorian;
-  using namespace boost::posix_time;
-
-  date d(dt.year, (date::month_type)dt.month, dt.day);
-  ptime pt(d,
-           hours(dt.hour) + minutes(dt.minute) + seconds(dt.second) +
-               milliseconds(dt.millisecond));
-  return from_ptime(pt);
+  return from_days_since_epoch(days_from_civil(dt.year, dt.month, dt.day)) +
+         dt.hour * MS_IN_HOUR + dt.minute * MS_IN_MINUTE + Time(dt.second) * 1000 +
+         dt.millisecond;
 }
 
 int to_string(char *buffer, size_t buffer_size, Time t) {
@@ -170,95 +176,96 @@ bool intervalsLessCmp(const std::string &l, const std::string &r) {
   return ltime < rtime;
 }
 
-namespace {
-Time last_moment(const boost::gregorian::date &d) {
-  using namespace boost::posix_time;
-  ptime pt(d, hours(23) + minutes(59) + seconds(59) + milliseconds(999));
-  Time result = from_ptime(pt);
-  return result;
-}
-
-Time first_moment(const boost::gregorian::date &d) {
-  using namespace boost::posix_time;
-  ptime pt(d, hours(0) + minutes(0) + seconds(0) + milliseconds(0));
-  Time result = from_ptime(pt);
-  return result;
+PERIOD period_from_string(const std::string &period) {
+  if (period == "minute") {
+    return PERIOD::MINUTE;
+  }
+  if (period == "halfhour") {
+    return PERIOD::HALFHOUR;
+  }
+  if (period == "hour") {
+    return PERIOD::HOUR;
+  }
+  if (period == "day") {
+    return PERIOD::DAY;
+  }
+  if (period == "week") {
+    return PERIOD::WEEK;
+  }
+  if (period == "month") {
+    return PERIOD::MONTH;
+  }
+  if (period == "year") {
+    return PERIOD::YEAR;
+  }
+  return PERIOD::UNKNOWN;
 }
-} // namespace
 
 std::pair<Time, Time> target_interval(const std::string &period, Time currentTime) {
-  using namespace boost::gregorian;
-  using namespace boost::posix_time;
-  DateTime dt = to_datetime(currentTime);
-  const time_duration last_sec = seconds(59) + milliseconds(999);
-  const time_duration first_sec = seconds(0) + milliseconds(0);
-  if (period == "minute") { // 59:999 sec of each minute
-    date d(dt.year, (date::month_type)dt.month, dt.day);
-    ptime pt_start(d, hours(dt.hour) + minutes(dt.minute) + first_sec);
-    ptime pt_end(d, hours(dt.hour) + minutes(dt.minute) + last_sec);
-    auto result = std::make_pair(from_ptime(pt_start), from_ptime(pt_end));
-    return result;
-  }
+  return target_interval(period_from_string(period), currentTime);
+}
 
-  if (period == "halfhour") { // 29:59:999 or 59:59:999
-    date d(dt.year, (date::month_type)dt.month, dt.day);
-    minutes mints_end(59);
-    minutes mints_start(30);
-    if (dt.minute < 30) {
-      mints_end = minutes(29);
-      mints_start = minutes(0);
-    }
-    ptime pt_end(d, hours(dt.hour) + mints_end + last_sec);
-    ptime pt_start(d, hours(dt.hour) + mints_start + first_sec);
-    return std::make_pair(from_ptime(pt_start), from_ptime(pt_end));
+std::pair<Time, Time> target_interval(PERIOD period, Time currentTime) {
+  Time start, length;
+  switch (period) {
+  case PERIOD::MINUTE:
+    length = MS_IN_MINUTE;
+    start = currentTime - currentTime % length;
+    break;
+  case PERIOD::HALFHOUR: // 29:59:999 or 59:59:999
+    length = MS_IN_HALFHOUR;
+    start = currentTime - currentTime % length;
+    break;
+  case PERIOD::HOUR:
+    length = MS_IN_HOUR;
+    start = currentTime - currentTime % length;
+    break;
+  case PERIOD::DAY:
+    length = MS_IN_DAY;
+    start = currentTime - currentTime % length;
+    break;
+  case PERIOD::WEEK: { // from monday to 23:59:59.999 of sunday
+    auto days = int64_t(currentTime / MS_IN_DAY);
+    auto from_monday = (days + 3) % 7; // 1970-01-01 is thursday.
+    length = MS_IN_WEEK;
+    start = from_days_since_epoch(days - from_monday);
+    break;
   }
-
-  if (period == "hour") { // 59:59:999 of each hour
-    date d(dt.year, (date::month_type)dt.month, dt.day);
-    ptime pt_end(d, hours(dt.hour) + minutes(59) + last_sec);
-    ptime pt_start(d, hours(dt.hour) + minutes(0) + first_sec);
-    return std::make_pair(from_ptime(pt_start), from_ptime(pt_end));
+  case PERIOD::MONTH: {
+    auto civil = civil_from_days(int64_t(currentTime / MS_IN_DAY));
+    auto first = days_from_civil(civil.year, civil.month, 1);
+    auto next = civil.month == 12 ? days_from_civil(civil.year + 1, 1, 1)
+                                  : days_from_civil(civil.year, civil.month + 1, 1);
+    start = from_days_since_epoch(first);
+    length = from_days_since_epoch(next) - start;
+    break;
   }
-
-  if (period == "day") { // 23:59:999 of each day
-    date d(dt.year, (date::month_type)dt.month, dt.day);
-    return std::make_pair(first_moment(d), last_moment(d));
+  case PERIOD::YEAR: {
+    auto civil = civil_from_days(int64_t(currentTime / MS_IN_DAY));
+    start = from_days_since_epoch(days_from_civil(civil.year, 1, 1));
+    length = from_days_since_epoch(days_from_civil(civil.year + 1, 1, 1)) - start;
+    break;
   }
-
-  if (period == "week") { // 23::59::59:99 of sanday
-    date end_day(dt.year, (date::month_type)dt.month, dt.day);
-    while (true) {
-      auto dow = end_day.day_of_week();
-      if (dow == greg_weekday(boost::date_time::Sunday)) {
-        break;
-      }
-      end_day += days(1);
-    }
-
-    date start_day(dt.year, (date::month_type)dt.month, dt.day);
-    while (true) {
-      auto dow = start_day.day_of_week();
-      if (dow == greg_weekday(boost::date_time::Monday)) {
-        break;
-      }
-      start_day -= days(1);
-    }
-    return std::make_pair(first_moment(start_day), last_moment(end_day));
+  default:
+    return std::make_pair(MAX_TIME, MAX_TIME);
   }
+  return std::make_pair(start, start + length - 1);
+}
 
-  if (period == "month") { // 23.59.59 of each last day of month
-    date d(dt.year, (date::month_type)dt.month, dt.day);
-    date d_start(dt.year, (date::month_type)dt.month, 1);
-    auto d_end = d.end_of_month();
-    return std::make_pair(first_moment(d_start), last_moment(d_end));
+std::vector<std::pair<Time, Time>> bucketize(PERIOD period, const Time *times,
+                                             size_t count) {
+  std::vector<std::pair<Time, Time>> result;
+  if (period == PERIOD::UNKNOWN) {
+    return result;
   }
-
-  if (period == "year") {
-    date d_start(dt.year, 1, 1);
-    date d_end(dt.year, 12, 31);
-    return std::make_pair(first_moment(d_start), last_moment(d_end));
+  for (size_t i = 0; i < count; ++i) {
+    auto t = times[i];
+    if (!result.empty() && result.back().first <= t && t <= result.back().second) {
+      continue;
+    }
+    result.push_back(target_interval(period, t));
   }
-  return std::make_pair(MAX_TIME, MAX_TIME);
+  return result;
 }
 
 } // namespace timeutil
@@ -3,6 +3,7 @@
 #include <libdariadb/meas.h>
 #include <libdariadb/st_exports.h>
 #include <chrono>
+#include <cstdint>
 #include <vector>
 
 namespace dariadb {
@@ -19,6 +20,42 @@ struct DateTime {
   uint16_t millisecond;
 };
 
+/// date of proleptic gregorian calendar.
+struct CivilDate {
+  int64_t year;
+  unsigned month; /// [1, 12]
+  unsigned day;   /// [1, 31]
+};
+
+/// days since 1970-01-01. works without tables and allocations.
+constexpr int64_t days_from_civil(int64_t y, unsigned m, unsigned d) {
+  y -= m <= 2 ? 1 : 0;
+  const int64_t era = (y >= 0 ? y : y - 399) / 400;
+  const unsigned yoe = static_cast<unsigned>(y - era * 400);
+  const unsigned doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+  const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+  return era * 146097 + static_cast<int64_t>(doe) - 719468;
+}
+
+/// inverse of days_from_civil.
+constexpr CivilDate civil_from_days(int64_t z) {
+  z += 719468;
+  const int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+  const unsigned doe = static_cast<unsigned>(z - era * 146097);
+  const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+  const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+  const unsigned mp = (5 * doy + 2) / 153;
+  const unsigned d = doy - (153 * mp + 2) / 5 + 1;
+  const unsigned m = mp < 10 ? mp + 3 : mp - 9;
+  return CivilDate{static_cast<int64_t>(yoe) + era * 400 + (m <= 2 ? 1 : 0), m, d};
+}
+
+/// predefined intervals of aggregation.
+enum class PERIOD : uint8_t { MINUTE, HALFHOUR, HOUR, DAY, WEEK, MONTH, YEAR, UNKNOWN };
+
+/// "minute" -> PERIOD::MINUTE. PERIOD::UNKNOWN for not predefined names.
+EXPORT PERIOD period_from_string(const std::string &period);
+
 /// current timestamp with nanosecond.
 EXPORT Time current_time();
 
@@ -65,6 +102,16 @@ EXPORT Time intervalName2time(const std::string &interval);
 
 EXPORT bool intervalsLessCmp(const std::string &l, const std::string &r);
 EXPORT std::vector<std::string> predefinedIntervals();
+/// first and last moment of period with currentTime.
 EXPORT std::pair<Time, Time> target_interval(const std::string &period, Time currentTime);
+EXPORT std::pair<Time, Time> target_interval(PERIOD period, Time currentTime);
+
+/**
+intervals of times; a time from the previous interval does not add a new one.
+so for sorted times result is distinct and the calendar is computed once per
+interval, not once per time.
+*/
+EXPORT std::vector<std::pair<Time, Time>> bucketize(PERIOD period, const Time *times,
+                                                    size_t count);
 }
 }
@@ -5,6 +5,18 @@ using namespace dariadb::utils::async;
 
 ThreadManager *ThreadManager::_instance = nullptr;
 
+namespace {
+thread_local bool inline_tasks = false;
+}
+
+ThreadManager::InlineGuard::InlineGuard() : _prev(inline_tasks) {
+  inline_tasks = true;
+}
+
+ThreadManager::InlineGuard::~InlineGuard() {
+  inline_tasks = _prev;
+}
+
 void ThreadManager::start(const ThreadManager::Params &params) {
   if (_instance == nullptr) {
     _instance = new ThreadManager(params);
@@ -38,6 +50,12 @@ TaskResult_Ptr ThreadManager::post(const ThreadKind kind, const AsyncTaskWrap_Pt
   if (target == _pools.end()) {
     throw MAKE_EXCEPTION("unknow kind.");
   }
+  if (inline_tasks) {
+    ThreadInfo ti{kind, 0};
+    while (task->apply(ti)) {
+    }
+    return task->result();
+  }
   return target->second->post(task);
 }
 
@@ -12,6 +12,17 @@ namespace async {
 class ThreadManager : public utils::NonCopy {
 
 public:
+  /// tasks posted by the current thread are run by it, while the guard is alive.
+  /// thread, which holds a lock taken by pool threads, can`t wait for them.
+  class InlineGuard : public utils::NonCopy {
+  public:
+    EXPORT InlineGuard();
+    EXPORT ~InlineGuard();
+
+  private:
+    bool _prev;
+  };
+
   struct Params {
     std::vector<ThreadPool::Params> pools;
     Params(std::vector<ThreadPool::Params> _pools) { pools = _pools; }
@@ -5,9 +5,29 @@
 using namespace dariadb::utils;
 using namespace dariadb::utils::async;
 
+namespace {
+std::string kind_name(ThreadKind kind) {
+  switch ((THREAD_KINDS)kind) {
+  case THREAD_KINDS::DISK_IO:
+    return "disk_io";
+  case THREAD_KINDS::COMMON:
+    return "common";
+  case THREAD_KINDS::SHARD_QUERY:
+    return "shard_query";
+  case THREAD_KINDS::FSCK:
+    return "fsck";
+  case THREAD_KINDS::HTTP:
+    return "http";
+  default:
+    return std::to_string(kind);
+  }
+}
+} // namespace
+
 AsyncTaskWrap::AsyncTaskWrap(AsyncTask &t, const std::string &_function,
                              const std::string &file, int line) {
   priority = TASK_PRIORITY::DEFAULT;
+  enqueued = 0;
   _task = t;
   _parent_function = _function;
   _code_file = file;
@@ -53,6 +73,10 @@ ThreadPool::ThreadPool(const Params &p) : _params(p) {
   _stop_flag = false;
   _is_stoped = false;
   _task_runned = size_t(0);
+  auto prefix = "threadpool." + kind_name(_params.kind);
+  _queue_delay = metrics::Registry::instance()->histogram(prefix + ".queue_ns");
+  _tasks = metrics::Registry::instance()->counter(prefix + ".tasks");
+  _queue_length = metrics::Registry::instance()->gauge(prefix + ".queue");
   _threads.resize(_params.threads_count);
   for (size_t i = 0; i < _params.threads_count; ++i) {
     _threads[i] = std::thread{&ThreadPool::_pool_logic, this, i};
@@ -107,8 +131,10 @@ void ThreadPool::flush() {
 
 void ThreadPool::pushTaskToQueue(const AsyncTaskWrap_Ptr &at) {
   {
+    at->enqueued = metrics::enabled() ? metrics::now_ns() : uint64_t(0);
     std::unique_lock<std::shared_mutex> lock(_queue_mutex);
     _in_queue.push_back(at);
+    _queue_length->set(int64_t(_in_queue.size()));
   }
   _condition.notify_all();
 }
@@ -143,7 +169,12 @@ void ThreadPool::_pool_logic(size_t num) {
         }
       }
       this->_in_queue.erase(std::find(_in_queue.begin(), _in_queue.end(), task));
+      _queue_length->set(int64_t(_in_queue.size()));
+    }
+    if (task->enqueued != uint64_t(0)) {
+      _queue_delay->record(metrics::now_ns() - task->enqueued);
     }
+    _tasks->add();
 
     // if queue is empty and task is coroutine, it will be run in cycle.
     while (true) {
@@ -2,6 +2,7 @@
 
 #include <libdariadb/st_exports.h>
 #include <libdariadb/utils/async/locker.h>
+#include <libdariadb/utils/metrics.h>
 #include <libdariadb/utils/utils.h>
 #include <atomic>
 #include <condition_variable>
@@ -18,7 +19,7 @@ namespace async {
 
 using ThreadKind = uint16_t;
 
-enum class THREAD_KINDS : ThreadKind { DISK_IO = 1, COMMON };
+enum class THREAD_KINDS : ThreadKind { DISK_IO = 1, COMMON, SHARD_QUERY, FSCK, HTTP };
 
 enum class TASK_PRIORITY : uint8_t {
   DEFAULT = 0,
@@ -76,6 +77,7 @@ public:
   EXPORT TaskResult_Ptr result() const;
 
   TASK_PRIORITY priority;
+  uint64_t enqueued; // now_ns() of push to queue. 0 - metrics are disabled.
 
 private:
   /// return true if need recall.
@@ -141,6 +143,10 @@ protected:
   bool _stop_flag;                 // true - pool under stop.
   bool _is_stoped;                 // true - already stopped.
   std::atomic_size_t _task_runned; // count of runned tasks.
+
+  metrics::Histogram *_queue_delay; // from push to start of task.
+  metrics::Counter *_tasks;
+  metrics::Gauge *_queue_length;
 };
 }
 }
@@ -1,10 +1,132 @@
 #include <libdariadb/utils/crc.h>
 #include <boost/crc.hpp>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define DARIADB_CRC32C_SSE42
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <nmmintrin.h>
+#endif
+#endif
+
+namespace {
+const uint32_t CRC32_POLY = 0xEDB88320;  // reflected 0x04C11DB7
+const uint32_t CRC32C_POLY = 0x82F63B78; // reflected 0x1EDC6F41
+
+/// tables for slicing-by-8.
+struct CrcTables {
+  uint32_t t[8][256];
+
+  explicit CrcTables(uint32_t poly) {
+    for (uint32_t i = 0; i < 256; ++i) {
+      uint32_t c = i;
+      for (int k = 0; k < 8; ++k) {
+        c = (c & 1) ? (c >> 1) ^ poly : (c >> 1);
+      }
+      t[0][i] = c;
+    }
+    for (uint32_t i = 0; i < 256; ++i) {
+      for (int s = 1; s < 8; ++s) {
+        t[s][i] = (t[s - 1][i] >> 8) ^ t[0][t[s - 1][i] & 0xFF];
+      }
+    }
+  }
+};
+
+uint32_t crc_slicing8(const CrcTables &tables, const uint8_t *p, size_t size,
+                      uint32_t crc) {
+  const auto &t = tables.t;
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+  // slicing reads words as little-endian.
+#else
+  while (size >= 8) {
+    uint32_t one, two;
+    std::memcpy(&one, p, sizeof(one));
+    std::memcpy(&two, p + 4, sizeof(two));
+    one ^= crc;
+    crc = t[7][one & 0xFF] ^ t[6][(one >> 8) & 0xFF] ^ t[5][(one >> 16) & 0xFF] ^
+          t[4][one >> 24] ^ t[3][two & 0xFF] ^ t[2][(two >> 8) & 0xFF] ^
+          t[1][(two >> 16) & 0xFF] ^ t[0][two >> 24];
+    p += 8;
+    size -= 8;
+  }
+#endif
+  while (size-- != 0) {
+    crc = t[0][(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+  }
+  return crc;
+}
+
+const CrcTables &crc32_tables() {
+  static const CrcTables tables(CRC32_POLY);
+  return tables;
+}
+
+const CrcTables &crc32c_tables() {
+  static const CrcTables tables(CRC32C_POLY);
+  return tables;
+}
+
+#ifdef DARIADB_CRC32C_SSE42
+#ifndef _MSC_VER
+__attribute__((target("sse4.2")))
+#endif
+uint32_t crc32c_sse42(const uint8_t *p, size_t size, uint32_t crc) {
+  while (size != 0 && (reinterpret_cast<uintptr_t>(p) & 7) != 0) {
+    crc = _mm_crc32_u8(crc, *p++);
+    --size;
+  }
+  uint64_t crc64 = crc;
+  while (size >= 8) {
+    uint64_t word;
+    std::memcpy(&word, p, sizeof(word));
+    crc64 = _mm_crc32_u64(crc64, word);
+    p += 8;
+    size -= 8;
+  }
+  crc = static_cast<uint32_t>(crc64);
+  while (size-- != 0) {
+    crc = _mm_crc32_u8(crc, *p++);
+  }
+  return crc;
+}
+
+bool cpu_has_sse42() {
+#ifdef _MSC_VER
+  int info[4];
+  __cpuid(info, 1);
+  return (info[2] & (1 << 20)) != 0;
+#else
+  return __builtin_cpu_supports("sse4.2");
+#endif
+}
+#endif
+}
 
 uint32_t dariadb::utils::crc32(const void *buffer, const size_t size) {
-  boost::crc_32_type result;
-  result.process_bytes(buffer, size);
-  return static_cast<uint32_t>(result.checksum());
+  auto p = static_cast<const uint8_t *>(buffer);
+  return ~crc_slicing8(crc32_tables(), p, size, 0xFFFFFFFF);
+}
+
+uint32_t dariadb::utils::crc32c(const void *buffer, const size_t size) {
+  auto p = static_cast<const uint8_t *>(buffer);
+#ifdef DARIADB_CRC32C_SSE42
+  static const bool use_sse42 = cpu_has_sse42();
+  if (use_sse42) {
+    return ~crc32c_sse42(p, size, 0xFFFFFFFF);
+  }
+#endif
+  return ~crc_slicing8(crc32c_tables(), p, size, 0xFFFFFFFF);
+}
+
+bool dariadb::utils::crc32c_hardware() {
+#ifdef DARIADB_CRC32C_SSE42
+  return cpu_has_sse42();
+#else
+  return false;
+#endif
 }
 
 uint16_t dariadb::utils::crc16(const void *buffer, const size_t size) {
@@ -6,7 +6,12 @@
 
 namespace dariadb {
 namespace utils {
+/// CRC-32 (IEEE 802.3), slicing-by-8.
 EXPORT uint32_t crc32(const void *buffer, const size_t size);
+/// CRC-32C (Castagnoli). uses SSE4.2 instruction, if cpu supports it.
+EXPORT uint32_t crc32c(const void *buffer, const size_t size);
+/// true if crc32c is hardware accelerated.
+EXPORT bool crc32c_hardware();
 EXPORT uint16_t crc16(const void *buffer, const size_t size);
 }
 }
@@ -2,6 +2,8 @@
 #include <libdariadb/utils/exception.h>
 #include <libdariadb/utils/fs.h>
 #include <boost/filesystem.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
 #include <fstream>
 #include <iterator>
 
@@ -134,6 +136,44 @@ std::string read_file(const std::string &fname) {
   fs.close();
   return ss.str();
 }
+
+struct MappedFile::Private {
+  boost::interprocess::file_mapping file;
+  boost::interprocess::mapped_region region;
+};
+
+MappedFile::MappedFile() : _impl(new Private), _data(nullptr), _size(0) {}
+
+MappedFile::~MappedFile() {}
+
+MappedFile_Ptr MappedFile::open(const std::string &fname, ACCESS_PATTERN hint) {
+  namespace bip = boost::interprocess;
+  MappedFile_Ptr result{new MappedFile()};
+  try {
+    auto size = boost::filesystem::file_size(fname);
+    if (size != 0) { // empty file can`t be mapped.
+      result->_impl->file = bip::file_mapping(fname.c_str(), bip::read_only);
+      result->_impl->region = bip::mapped_region(result->_impl->file, bip::read_only);
+      result->_data = static_cast<const uint8_t *>(result->_impl->region.get_address());
+      result->_size = result->_impl->region.get_size();
+      result->advise(hint);
+    }
+  } catch (std::exception &ex) {
+    THROW_EXCEPTION("can`t map file ", fname, ": ", ex.what());
+  }
+  return result;
+}
+
+void MappedFile::advise(ACCESS_PATTERN hint) {
+  namespace bip = boost::interprocess;
+  if (_size == 0) {
+    return;
+  }
+  // only a hint: result is ignored.
+  _impl->region.advise(hint == ACCESS_PATTERN::SEQUENTIAL
+                           ? bip::mapped_region::advice_sequential
+                           : bip::mapped_region::advice_random);
+}
+}
 }
 }
-}
\ No newline at end of file
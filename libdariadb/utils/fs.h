@@ -27,6 +27,30 @@ EXPORT bool file_exists(const std::string &fname);
 EXPORT void mkdir(const std::string &path);
 
 EXPORT std::string read_file(const std::string &fname);
+
+class MappedFile;
+using MappedFile_Ptr = std::shared_ptr<MappedFile>;
+/// read-only memory mapping of a file.
+/// data is valid while MappedFile exists (even if file was removed).
+class MappedFile {
+public:
+  enum class ACCESS_PATTERN { SEQUENTIAL, RANDOM };
+
+  EXPORT static MappedFile_Ptr open(const std::string &fname, ACCESS_PATTERN hint);
+  EXPORT ~MappedFile();
+  /// hint for os (madvise), how data will be readed.
+  EXPORT void advise(ACCESS_PATTERN hint);
+
+  const uint8_t *data() const { return _data; }
+  size_t size() const { return _size; }
+
+private:
+  MappedFile();
+  struct Private;
+  std::unique_ptr<Private> _impl;
+  const uint8_t *_data;
+  size_t _size;
+};
 }
 }
 }
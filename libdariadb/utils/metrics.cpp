@@ -0,0 +1,171 @@
+#include <libdariadb/utils/metrics.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <thread>
+
+using namespace dariadb::utils::metrics;
+
+std::atomic<bool> dariadb::utils::metrics::inner::enabled_flag{false};
+
+void dariadb::utils::metrics::enable(bool flag) {
+  inner::enabled_flag.store(flag);
+}
+
+size_t dariadb::utils::metrics::shard_index() {
+  static std::atomic<size_t> next_shard{0};
+  thread_local size_t shard = next_shard.fetch_add(1) % SHARDS;
+  return shard;
+}
+
+Counter::Counter() {
+  for (auto &s : _shards) {
+    s.value.store(0);
+  }
+}
+
+uint64_t Counter::value() const {
+  uint64_t result = 0;
+  for (auto &s : _shards) {
+    result += s.value.load(std::memory_order_relaxed);
+  }
+  return result;
+}
+
+uint64_t HistogramSnapshot::percentile(double p) const {
+  if (count == 0) {
+    return 0;
+  }
+  auto rank = uint64_t(std::ceil(std::min(std::max(p, 0.0), 1.0) * count));
+  rank = std::max(rank, uint64_t(1));
+  uint64_t seen = 0;
+  for (size_t i = 0; i < buckets.size(); ++i) {
+    seen += buckets[i];
+    if (seen >= rank) {
+      return std::min(std::max(Histogram::bucket_upper(i), min), max);
+    }
+  }
+  return max;
+}
+
+struct alignas(64) Histogram::Shard {
+  std::atomic<uint64_t> sum;
+  std::atomic<uint64_t> min;
+  std::atomic<uint64_t> max;
+  std::array<std::atomic<uint64_t>, BUCKETS> buckets;
+
+  Shard() : sum(0), min(std::numeric_limits<uint64_t>::max()), max(0) {
+    for (auto &b : buckets) {
+      b.store(0);
+    }
+  }
+};
+
+Histogram::Histogram() : _shards(new Shard[SHARDS]) {}
+
+Histogram::~Histogram() {}
+
+size_t Histogram::bucket_of(uint64_t v) {
+  if (v < SUB_BUCKETS) {
+    return size_t(v);
+  }
+  size_t log2 = 63;
+  while ((v >> log2) == 0) {
+    --log2;
+  }
+  // log2 >= 3: top 3 bits after the leading one are number of sub bucket.
+  auto sub = size_t(v >> (log2 - 3)) & (SUB_BUCKETS - 1);
+  return (log2 - 2) * SUB_BUCKETS + sub;
+}
+
+uint64_t Histogram::bucket_upper(size_t b) {
+  if (b < SUB_BUCKETS) {
+    return uint64_t(b);
+  }
+  auto log2 = b / SUB_BUCKETS + 2;
+  auto sub = uint64_t(b % SUB_BUCKETS);
+  auto width = uint64_t(1) << (log2 - 3);
+  return ((SUB_BUCKETS + sub) << (log2 - 3)) + (width - 1);
+}
+
+void Histogram::record_always(uint64_t v) {
+  auto &s = _shards[shard_index()];
+  s.buckets[bucket_of(v)].fetch_add(1, std::memory_order_relaxed);
+  s.sum.fetch_add(v, std::memory_order_relaxed);
+  auto cur_min = s.min.load(std::memory_order_relaxed);
+  while (v < cur_min &&
+         !s.min.compare_exchange_weak(cur_min, v, std::memory_order_relaxed)) {
+  }
+  auto cur_max = s.max.load(std::memory_order_relaxed);
+  while (v > cur_max &&
+         !s.max.compare_exchange_weak(cur_max, v, std::memory_order_relaxed)) {
+  }
+}
+
+HistogramSnapshot Histogram::snapshot() const {
+  HistogramSnapshot result;
+  result.buckets.resize(BUCKETS);
+  result.min = std::numeric_limits<uint64_t>::max();
+  for (size_t i = 0; i < SHARDS; ++i) {
+    auto &s = _shards[i];
+    for (size_t b = 0; b < BUCKETS; ++b) {
+      auto c = s.buckets[b].load(std::memory_order_relaxed);
+      result.buckets[b] += c;
+      result.count += c;
+    }
+    result.sum += s.sum.load(std::memory_order_relaxed);
+    result.min = std::min(result.min, s.min.load(std::memory_order_relaxed));
+    result.max = std::max(result.max, s.max.load(std::memory_order_relaxed));
+  }
+  if (result.count == 0) {
+    result.min = 0;
+  }
+  return result;
+}
+
+Registry *Registry::instance() {
+  static Registry registry;
+  return &registry;
+}
+
+Counter *Registry::counter(const std::string &name) {
+  std::lock_guard<std::mutex> lg(_locker);
+  auto &result = _counters[name];
+  if (result == nullptr) {
+    result = std::make_unique<Counter>();
+  }
+  return result.get();
+}
+
+Gauge *Registry::gauge(const std::string &name) {
+  std::lock_guard<std::mutex> lg(_locker);
+  auto &result = _gauges[name];
+  if (result == nullptr) {
+    result = std::make_unique<Gauge>();
+  }
+  return result.get();
+}
+
+Histogram *Registry::histogram(const std::string &name) {
+  std::lock_guard<std::mutex> lg(_locker);
+  auto &result = _histograms[name];
+  if (result == nullptr) {
+    result = std::make_unique<Histogram>();
+  }
+  return result.get();
+}
+
+Snapshot Registry::snapshot() const {
+  Snapshot result;
+  std::lock_guard<std::mutex> lg(_locker);
+  for (auto &kv : _counters) {
+    result.counters[kv.first] = kv.second->value();
+  }
+  for (auto &kv : _gauges) {
+    result.gauges[kv.first] = kv.second->value();
+  }
+  for (auto &kv : _histograms) {
+    result.histograms[kv.first] = kv.second->snapshot();
+  }
+  return result;
+}
@@ -0,0 +1,167 @@
+#pragma once
+
+#include <libdariadb/st_exports.h>
+#include <libdariadb/utils/utils.h>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace dariadb {
+namespace utils {
+namespace metrics {
+
+/// writers from different threads use different shards, so they don't share
+/// cache lines. readers sum all shards.
+const size_t SHARDS = 8;
+
+namespace inner {
+EXPORT extern std::atomic<bool> enabled_flag;
+}
+
+/// probes do nothing, while metrics are disabled. costs one relaxed load.
+inline bool enabled() {
+  return inner::enabled_flag.load(std::memory_order_relaxed);
+}
+EXPORT void enable(bool flag);
+
+/// shard of the calling thread.
+EXPORT size_t shard_index();
+
+inline uint64_t now_ns() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+class Counter : public NonCopy {
+public:
+  EXPORT Counter();
+  void add(uint64_t v = 1) {
+    if (enabled()) {
+      _shards[shard_index()].value.fetch_add(v, std::memory_order_relaxed);
+    }
+  }
+  EXPORT uint64_t value() const;
+
+private:
+  struct alignas(64) Shard {
+    std::atomic<uint64_t> value;
+  };
+  std::array<Shard, SHARDS> _shards;
+};
+
+/// the last set value, not sharded.
+class Gauge : public NonCopy {
+public:
+  Gauge() : _value(0) {}
+  void set(int64_t v) {
+    if (enabled()) {
+      _value.store(v, std::memory_order_relaxed);
+    }
+  }
+  void add(int64_t v) {
+    if (enabled()) {
+      _value.fetch_add(v, std::memory_order_relaxed);
+    }
+  }
+  int64_t value() const { return _value.load(std::memory_order_relaxed); }
+
+private:
+  std::atomic<int64_t> _value;
+};
+
+struct HistogramSnapshot {
+  uint64_t count;
+  uint64_t sum;
+  uint64_t min;
+  uint64_t max;
+  std::vector<uint64_t> buckets;
+
+  HistogramSnapshot() { count = sum = min = max = uint64_t(0); }
+  /// upper bound of bucket with p-th value. p in [0, 1].
+  EXPORT uint64_t percentile(double p) const;
+  double mean() const { return count == 0 ? 0.0 : double(sum) / count; }
+};
+
+/**
+HDR-style histogram: each power of two range is split into SUB_BUCKETS linear
+buckets, so a recorded value is known with relative error below 1/SUB_BUCKETS.
+values below SUB_BUCKETS are exact. record() is wait-free except min/max CAS.
+*/
+class Histogram : public NonCopy {
+public:
+  static constexpr size_t SUB_BUCKETS = 8;
+  static constexpr size_t BUCKETS = (64 - 2) * SUB_BUCKETS;
+
+  EXPORT Histogram();
+  EXPORT ~Histogram();
+
+  void record(uint64_t v) {
+    if (enabled()) {
+      record_always(v);
+    }
+  }
+  EXPORT void record_always(uint64_t v);
+  EXPORT HistogramSnapshot snapshot() const;
+
+  EXPORT static size_t bucket_of(uint64_t v);
+  /// maximum value of bucket.
+  EXPORT static uint64_t bucket_upper(size_t b);
+
+private:
+  struct Shard;
+  std::unique_ptr<Shard[]> _shards;
+};
+
+struct Snapshot {
+  std::map<std::string, uint64_t> counters;
+  std::map<std::string, int64_t> gauges;
+  std::map<std::string, HistogramSnapshot> histograms;
+};
+
+/// named metrics of process. creation is locked, probes are lock-free.
+class Registry : public NonCopy {
+public:
+  EXPORT static Registry *instance();
+
+  /// the same object for the same name. lives until exit of process.
+  EXPORT Counter *counter(const std::string &name);
+  EXPORT Gauge *gauge(const std::string &name);
+  EXPORT Histogram *histogram(const std::string &name);
+
+  EXPORT Snapshot snapshot() const;
+
+private:
+  Registry() = default;
+
+  mutable std::mutex _locker;
+  std::map<std::string, std::unique_ptr<Counter>> _counters;
+  std::map<std::string, std::unique_ptr<Gauge>> _gauges;
+  std::map<std::string, std::unique_ptr<Histogram>> _histograms;
+};
+
+/// records elapsed nanoseconds. the clock isn't read, while metrics are disabled.
+class ScopedTimer : public NonCopy {
+public:
+  explicit ScopedTimer(Histogram *h) : _h(enabled() ? h : nullptr) {
+    _start = _h != nullptr ? now_ns() : uint64_t(0);
+  }
+  ~ScopedTimer() {
+    if (_h != nullptr) {
+      _h->record_always(now_ns() - _start);
+    }
+  }
+
+private:
+  Histogram *_h;
+  uint64_t _start;
+};
+} // namespace metrics
+} // namespace utils
+} // namespace dariadb
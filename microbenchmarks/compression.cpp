@@ -1,9 +1,11 @@
+#include <libdariadb/compression/codecs.h>
 #include <libdariadb/compression/compression.h>
 #include <libdariadb/compression/delta.h>
 #include <libdariadb/compression/flag.h>
 #include <libdariadb/compression/xor.h>
 
 #include <benchmark/benchmark_api.h>
+#include <cmath>
 
 class Compression : public benchmark::Fixture {
   virtual void SetUp(const ::benchmark::State &) {
@@ -249,6 +251,82 @@ BENCHMARK_DEFINE_F(Compression, MeasUnpack)(benchmark::State &state) {
   }
 }
 
+namespace {
+const size_t codec_column_size = 10000;
+const char *column_kinds[] = {"regular_time", "jitter_time", "decimal_value",
+                              "random_value", "flag_runs"};
+
+dariadb::compression::Column make_column(int64_t kind, size_t count) {
+  dariadb::compression::Column result(count);
+  for (size_t i = 0; i < count; ++i) {
+    dariadb::Value v = 0;
+    switch (kind) {
+    case 0:
+      result[i] = 1000 * i;
+      continue;
+    case 1:
+      result[i] = 1000 * i + (i * 7919) % 13;
+      continue;
+    case 2:
+      v = dariadb::Value(int(i * 37 % 1000)) / 10;
+      break;
+    case 3:
+      v = std::sin(dariadb::Value(i)) * 1e6;
+      break;
+    default:
+      result[i] = i / 1000;
+      continue;
+    }
+    result[i] = uint64_t(dariadb::compression::inner::flat_double_to_int(v));
+  }
+  return result;
+}
+
+/// codec index x column kind.
+void codec_args(benchmark::internal::Benchmark *b) {
+  auto codecs = dariadb::compression::CodecRegistry::codecs().size();
+  for (int64_t c = 0; c < int64_t(codecs); ++c) {
+    for (int64_t k = 0; k < int64_t(sizeof(column_kinds) / sizeof(char *)); ++k) {
+      b->Args({c, k});
+    }
+  }
+}
+} // namespace
+
+BENCHMARK_DEFINE_F(Compression, CodecPack)(benchmark::State &state) {
+  auto codec = dariadb::compression::CodecRegistry::codecs()[state.range(0)];
+  auto column = make_column(state.range(1), codec_column_size);
+  std::vector<uint8_t> out;
+  state.SetLabel(std::string(codec->name()) + "/" + column_kinds[state.range(1)]);
+  if (!codec->encode(column, out)) {
+    state.SkipWithError("codec is not applicable");
+    return;
+  }
+  while (state.KeepRunning()) {
+    out.clear();
+    codec->encode(column, out);
+  }
+  state.counters["bytes/value"] = double(out.size()) / column.size();
+  state.SetItemsProcessed(state.iterations() * column.size());
+}
+
+BENCHMARK_DEFINE_F(Compression, CodecUnpack)(benchmark::State &state) {
+  auto codec = dariadb::compression::CodecRegistry::codecs()[state.range(0)];
+  auto column = make_column(state.range(1), codec_column_size);
+  std::vector<uint8_t> out;
+  state.SetLabel(std::string(codec->name()) + "/" + column_kinds[state.range(1)]);
+  if (!codec->encode(column, out)) {
+    state.SkipWithError("codec is not applicable");
+    return;
+  }
+  dariadb::compression::Column readed(column.size());
+  while (state.KeepRunning()) {
+    codec->decode(out.data(), out.data() + out.size(), readed.size(), readed.data());
+  }
+  state.counters["bytes/value"] = double(out.size()) / column.size();
+  state.SetItemsProcessed(state.iterations() * column.size());
+}
+
 BENCHMARK_REGISTER_F(Compression, DeltaPack)->Arg(100)->Arg(10000);
 BENCHMARK_REGISTER_F(Compression, DeltaUnpack)->Arg(100)->Arg(10000);
 
@@ -260,3 +338,6 @@ BENCHMARK_REGISTER_F(Compression, FlagUnpack)->Arg(100)->Arg(10000);
 
 BENCHMARK_REGISTER_F(Compression, MeasPack)->Arg(100)->Arg(10000);
 BENCHMARK_REGISTER_F(Compression, MeasUnpack)->Arg(100)->Arg(10000);
+
+BENCHMARK_REGISTER_F(Compression, CodecPack)->Apply(codec_args);
+BENCHMARK_REGISTER_F(Compression, CodecUnpack)->Apply(codec_args);
@@ -1,13 +1,18 @@
 #include <libdariadb/utils/crc.h>
 #include <benchmark/benchmark_api.h>
+#include <boost/crc.hpp>
 
 const size_t CRC_SMALL_BENCHMARK_BUFFER = 1024;
 const size_t CRC_BIG_BENCHMARK_BUFFER = CRC_SMALL_BENCHMARK_BUFFER * 10;
+const size_t CRC_PAGE_BENCHMARK_BUFFER = CRC_SMALL_BENCHMARK_BUFFER * 1024;
 
 class CRC : public benchmark::Fixture {
   virtual void SetUp(const ::benchmark::State &st) {
     buffer = new char[st.range(0)];
     size = st.range(0);
+    for (size_t i = 0; i < size; ++i) {
+      buffer[i] = char(i);
+    }
   }
 
   virtual void TearDown(const ::benchmark::State &) {
@@ -24,6 +29,32 @@ BENCHMARK_DEFINE_F(CRC, BufferParam)(benchmark::State &state) {
   while (state.KeepRunning()) {
     benchmark::DoNotOptimize(dariadb::utils::crc32(buffer, size));
   }
+  state.SetBytesProcessed(int64_t(state.iterations()) * size);
 }
 BENCHMARK_REGISTER_F(CRC, BufferParam)->Arg(CRC_SMALL_BENCHMARK_BUFFER);
-BENCHMARK_REGISTER_F(CRC, BufferParam)->Arg(CRC_BIG_BENCHMARK_BUFFER);
\ No newline at end of file
+BENCHMARK_REGISTER_F(CRC, BufferParam)->Arg(CRC_BIG_BENCHMARK_BUFFER);
+BENCHMARK_REGISTER_F(CRC, BufferParam)->Arg(CRC_PAGE_BENCHMARK_BUFFER);
+
+BENCHMARK_DEFINE_F(CRC, CRC32C)(benchmark::State &state) {
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(dariadb::utils::crc32c(buffer, size));
+  }
+  state.SetBytesProcessed(int64_t(state.iterations()) * size);
+  state.SetLabel(dariadb::utils::crc32c_hardware() ? "sse4.2" : "portable");
+}
+BENCHMARK_REGISTER_F(CRC, CRC32C)->Arg(CRC_SMALL_BENCHMARK_BUFFER);
+BENCHMARK_REGISTER_F(CRC, CRC32C)->Arg(CRC_BIG_BENCHMARK_BUFFER);
+BENCHMARK_REGISTER_F(CRC, CRC32C)->Arg(CRC_PAGE_BENCHMARK_BUFFER);
+
+// byte-at-a-time implementation, was used before.
+BENCHMARK_DEFINE_F(CRC, Boost)(benchmark::State &state) {
+  while (state.KeepRunning()) {
+    boost::crc_32_type result;
+    result.process_bytes(buffer, size);
+    benchmark::DoNotOptimize(result.checksum());
+  }
+  state.SetBytesProcessed(int64_t(state.iterations()) * size);
+}
+BENCHMARK_REGISTER_F(CRC, Boost)->Arg(CRC_SMALL_BENCHMARK_BUFFER);
+BENCHMARK_REGISTER_F(CRC, Boost)->Arg(CRC_BIG_BENCHMARK_BUFFER);
+BENCHMARK_REGISTER_F(CRC, Boost)->Arg(CRC_PAGE_BENCHMARK_BUFFER);
@@ -31,7 +31,8 @@ BENCHMARK_DEFINE_F(Cursors, Colapse)(benchmark::State &state) {
 BENCHMARK_REGISTER_F(Cursors, Colapse)
     ->Args({10, 100})
     ->Args({100, 100})
-    ->Args({1000, 1000});
+    ->Args({1000, 1000})
+    ->Args({10000, 100});
 
 BENCHMARK_DEFINE_F(Cursors, MergeReaderCreate)(benchmark::State &state) {
   while (state.KeepRunning()) {
@@ -0,0 +1,28 @@
+#include <libdariadb/utils/metrics.h>
+#include <benchmark/benchmark_api.h>
+
+using namespace dariadb::utils::metrics;
+
+/// arg: 0 - metrics are disabled, 1 - enabled.
+static void Metrics_ScopedTimer(benchmark::State &state) {
+  auto was_enabled = enabled();
+  enable(state.range(0) != 0);
+  auto h = Registry::instance()->histogram("benchmark.scoped_timer");
+  while (state.KeepRunning()) {
+    ScopedTimer timer(h);
+    benchmark::DoNotOptimize(h);
+  }
+  enable(was_enabled);
+}
+BENCHMARK(Metrics_ScopedTimer)->Arg(0)->Arg(1);
+
+static void Metrics_Counter(benchmark::State &state) {
+  auto was_enabled = enabled();
+  enable(state.range(0) != 0);
+  auto c = Registry::instance()->counter("benchmark.counter");
+  while (state.KeepRunning()) {
+    c->add();
+  }
+  enable(was_enabled);
+}
+BENCHMARK(Metrics_Counter)->Arg(0)->Arg(1)->Threads(1)->Threads(4);
@@ -54,7 +54,8 @@ BENCHMARK_REGISTER_F(StatisticFunction, Average)
     ->Arg(10)
     ->Arg(100)
     ->Arg(1000)
-    ->Arg(10000);
+    ->Arg(10000)
+    ->Arg(1000000);
 
 BENCHMARK_DEFINE_F(StatisticFunction, Percentile)(benchmark::State &state) {
   while (state.KeepRunning()) {
@@ -74,7 +75,52 @@ BENCHMARK_DEFINE_F(StatisticFunction, Sigma)(benchmark::State &state) {
     benchmark::DoNotOptimize(sigma->apply(ma));
   }
 }
-BENCHMARK_REGISTER_F(StatisticFunction, Sigma)->Arg(10)->Arg(100)->Arg(1000)->Arg(10000);
+BENCHMARK_REGISTER_F(StatisticFunction, Sigma)
+    ->Arg(10)
+    ->Arg(100)
+    ->Arg(1000)
+    ->Arg(10000)
+    ->Arg(1000000);
+
+BENCHMARK_DEFINE_F(StatisticFunction, Kernel)(benchmark::State &state) {
+  std::vector<dariadb::Value> values(ma.size());
+  for (size_t i = 0; i < ma.size(); ++i) {
+    values[i] = ma[i].value;
+  }
+  state.SetLabel(kernels::isa());
+  dariadb::Value sum, min, max;
+  while (state.KeepRunning()) {
+    kernels::sum_min_max(values.data(), values.size(), &sum, &min, &max);
+    benchmark::DoNotOptimize(sum);
+    benchmark::DoNotOptimize(min);
+    benchmark::DoNotOptimize(max);
+  }
+}
+BENCHMARK_REGISTER_F(StatisticFunction, Kernel)->Arg(1000)->Arg(1000000);
+
+const std::vector<std::string> fused_functions = {"average", "minimum", "maximum",
+                                                  "count", "sigma"};
+
+BENCHMARK_DEFINE_F(StatisticFunction, Separate)(benchmark::State &state) {
+  auto functions = FunctionFactory::make(fused_functions);
+  while (state.KeepRunning()) {
+    for (auto &f : functions) {
+      benchmark::DoNotOptimize(f->apply(ma));
+    }
+  }
+}
+BENCHMARK_REGISTER_F(StatisticFunction, Separate)->Arg(1000)->Arg(1000000);
+
+BENCHMARK_DEFINE_F(StatisticFunction, Fused)(benchmark::State &state) {
+  auto functions = FunctionFactory::make(fused_functions);
+  while (state.KeepRunning()) {
+    auto summary = summarize(ma, true);
+    for (auto &f : functions) {
+      benchmark::DoNotOptimize(f->result(summary));
+    }
+  }
+}
+BENCHMARK_REGISTER_F(StatisticFunction, Fused)->Arg(1000)->Arg(1000000);
 
 BENCHMARK_DEFINE_F(StatisticCalculation, Calculation)(benchmark::State &state) {
   dariadb::statistic::Calculator calc(storage);
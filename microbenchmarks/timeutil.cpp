@@ -1,6 +1,99 @@
 #include <libdariadb/timeutil.h>
 #include <benchmark/benchmark_api.h>
 
+#include <boost/date_time/gregorian/gregorian.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <set>
+
+namespace {
+/// previous implementation by boost::posix_time, to compare with.
+namespace reference {
+using namespace boost::gregorian;
+using namespace boost::posix_time;
+
+const ptime START = from_time_t(0);
+
+dariadb::Time from_ptime(ptime timestamp) {
+  return (timestamp - START).total_milliseconds();
+}
+
+dariadb::timeutil::DateTime to_datetime(dariadb::Time t) {
+  auto pt = START + milliseconds(t);
+  auto date = pt.date();
+  auto time = pt.time_of_day();
+  auto ymd = gregorian_calendar::from_day_number(date.day_number());
+
+  dariadb::timeutil::DateTime result;
+  result.year = ymd.year;
+  result.month = (uint8_t)ymd.month;
+  result.day = ymd.day;
+  result.day_of_year = date.day_of_year();
+  result.hour = (uint8_t)time.hours();
+  result.minute = (uint8_t)time.minutes();
+  result.second = (uint8_t)time.seconds();
+  result.millisecond = (uint16_t)(time.total_milliseconds() % 1000);
+  return result;
+}
+
+std::pair<dariadb::Time, dariadb::Time> day_bounds(const date &first, const date &last) {
+  auto end_of_day = hours(23) + minutes(59) + seconds(59) + milliseconds(999);
+  return std::make_pair(from_ptime(ptime(first)), from_ptime(ptime(last, end_of_day)));
+}
+
+std::pair<dariadb::Time, dariadb::Time> target_interval(const std::string &period,
+                                                        dariadb::Time t) {
+  auto dt = to_datetime(t);
+  date d(dt.year, (date::month_type)dt.month, dt.day);
+  const time_duration last_sec = seconds(59) + milliseconds(999);
+  if (period == "minute") {
+    auto m = hours(dt.hour) + minutes(dt.minute);
+    return std::make_pair(from_ptime(ptime(d, m)), from_ptime(ptime(d, m + last_sec)));
+  }
+  if (period == "halfhour") {
+    auto m = hours(dt.hour) + minutes(dt.minute < 30 ? 0 : 30);
+    return std::make_pair(from_ptime(ptime(d, m)),
+                          from_ptime(ptime(d, m + minutes(29) + last_sec)));
+  }
+  if (period == "hour") {
+    auto h = hours(dt.hour);
+    return std::make_pair(from_ptime(ptime(d, h)),
+                          from_ptime(ptime(d, h + minutes(59) + last_sec)));
+  }
+  if (period == "day") {
+    return day_bounds(d, d);
+  }
+  if (period == "week") {
+    date end_day = d;
+    while (end_day.day_of_week() != greg_weekday(boost::date_time::Sunday)) {
+      end_day += days(1);
+    }
+    date start_day = d;
+    while (start_day.day_of_week() != greg_weekday(boost::date_time::Monday)) {
+      start_day -= days(1);
+    }
+    return day_bounds(start_day, end_day);
+  }
+  if (period == "month") {
+    return day_bounds(date(dt.year, (date::month_type)dt.month, 1), d.end_of_month());
+  }
+  if (period == "year") {
+    return day_bounds(date(dt.year, 1, 1), date(dt.year, 12, 31));
+  }
+  return std::make_pair(dariadb::MAX_TIME, dariadb::MAX_TIME);
+}
+} // namespace reference
+
+/// one value per second, as aggregator reads raw values.
+std::vector<dariadb::Time> sorted_times(size_t count) {
+  std::vector<dariadb::Time> result(count);
+  auto t = dariadb::timeutil::current_time();
+  for (size_t i = 0; i < count; ++i) {
+    result[i] = t + i * 1000;
+  }
+  return result;
+}
+} // namespace
+
 static void Time_to_datetime(benchmark::State &state) {
   auto t = dariadb::timeutil::current_time();
   while (state.KeepRunning()) {
@@ -9,6 +102,14 @@ static void Time_to_datetime(benchmark::State &state) {
 }
 BENCHMARK(Time_to_datetime);
 
+static void Time_to_datetime_boost(benchmark::State &state) {
+  auto t = dariadb::timeutil::current_time();
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(reference::to_datetime(t));
+  }
+}
+BENCHMARK(Time_to_datetime_boost);
+
 static void Time_from_datetime(benchmark::State &state) {
   auto t = dariadb::timeutil::current_time();
   auto dt = dariadb::timeutil::to_datetime(t);
@@ -44,3 +145,35 @@ static void Time_target_interval(benchmark::State &state) {
   }
 }
 BENCHMARK(Time_target_interval);
+
+static void Time_target_interval_boost(benchmark::State &state) {
+  auto all_intervals = dariadb::timeutil::predefinedIntervals();
+  auto t = dariadb::timeutil::current_time();
+  while (state.KeepRunning()) {
+    for (auto &i : all_intervals)
+      benchmark::DoNotOptimize(reference::target_interval(i, t));
+  }
+}
+BENCHMARK(Time_target_interval_boost);
+
+static void Time_bucketize(benchmark::State &state) {
+  auto times = sorted_times(state.range(0));
+  auto period = dariadb::timeutil::period_from_string("minute");
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(
+        dariadb::timeutil::bucketize(period, times.data(), times.size()));
+  }
+}
+BENCHMARK(Time_bucketize)->Arg(10000)->Arg(1000000);
+
+static void Time_bucketize_boost(benchmark::State &state) {
+  auto times = sorted_times(state.range(0));
+  while (state.KeepRunning()) {
+    std::set<std::pair<dariadb::Time, dariadb::Time>> intervals;
+    for (auto t : times) {
+      intervals.insert(reference::target_interval("minute", t));
+    }
+    benchmark::DoNotOptimize(intervals);
+  }
+}
+BENCHMARK(Time_bucketize_boost)->Arg(10000)->Arg(1000000);
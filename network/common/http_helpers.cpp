@@ -1,6 +1,7 @@
 #include <libdariadb/utils/logger.h>
 #include <boost/asio.hpp>
 #include <common/http_helpers.h>
+#include <algorithm>
 
 using boost::asio::ip::tcp;
 
@@ -160,6 +161,98 @@ http_response GET(boost::asio::io_service &service, const std::string &port,
   return result;
 }
 
+session::session(boost::asio::io_service &service, const std::string &port)
+    : _socket(service) {
+  tcp::resolver resolver(service);
+  tcp::resolver::query query("localhost", port);
+  boost::asio::connect(_socket, resolver.resolve(query));
+}
+
+http_response session::POST(const std::string &json_query) {
+  http_response result;
+  result.code = 0;
+
+  boost::asio::streambuf request;
+  std::ostream request_stream(&request);
+
+  request_stream << "POST / HTTP/1.1\r\n";
+  request_stream << "Host: localhost\r\n";
+  request_stream << "Content-Type: application/json; charset=utf-8\r\n";
+  request_stream << "Content-Length: " << json_query.length() << "\r\n";
+  request_stream << "\r\n";
+  request_stream << json_query;
+
+  boost::asio::write(_socket, request);
+
+  boost::asio::read_until(_socket, _response, "\r\n\r\n");
+  std::istream response_stream(&_response);
+  std::string http_version;
+  response_stream >> http_version;
+  unsigned int status_code;
+  response_stream >> status_code;
+  std::string status_message;
+  std::getline(response_stream, status_message);
+  if (!response_stream || http_version.substr(0, 5) != "HTTP/") {
+    logger_fatal("Invalid response");
+    result.code = -1;
+    return result;
+  }
+  result.code = status_code;
+
+  size_t content_length = 0;
+  bool chunked = false;
+  bool has_length = false;
+  std::string header;
+  while (std::getline(response_stream, header) && header != "\r") {
+    std::transform(header.begin(), header.end(), header.begin(), ::tolower);
+    if (header.find("content-length:") == 0) {
+      content_length = std::stoull(header.substr(15));
+      has_length = true;
+    }
+    if (header.find("transfer-encoding: chunked") == 0) {
+      chunked = true;
+    }
+  }
+
+  auto read_exactly = [this](size_t length) {
+    if (_response.size() < length) {
+      boost::asio::read(_socket, _response,
+                        boost::asio::transfer_exactly(length - _response.size()));
+    }
+    auto data = _response.data();
+    std::string res(boost::asio::buffers_begin(data),
+                    boost::asio::buffers_begin(data) + length);
+    _response.consume(length);
+    return res;
+  };
+
+  if (chunked) {
+    while (true) {
+      boost::asio::read_until(_socket, _response, "\r\n");
+      std::string size_line;
+      std::getline(response_stream, size_line);
+      auto chunk_size = std::stoull(size_line, nullptr, 16);
+      result.answer += read_exactly(chunk_size);
+      read_exactly(2); // crlf after chunk.
+      if (chunk_size == 0) {
+        break;
+      }
+    }
+  } else if (has_length) {
+    result.answer = read_exactly(content_length);
+  } else {
+    boost::system::error_code error;
+    while (boost::asio::read(_socket, _response, boost::asio::transfer_at_least(1),
+                             error)) {
+    }
+    result.answer = read_exactly(_response.size());
+  }
+  if (status_code != 200) {
+    logger_fatal("Response returned with status code ", status_code);
+  }
+  return result;
+}
+
 } // namespace http
 } // namespace net
 } // namespace dariadb
\ No newline at end of file
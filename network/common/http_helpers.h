@@ -16,6 +16,18 @@ CM_EXPORT http_response POST(boost::asio::io_service &service, const std::string
                              const std::string &json_query);
 CM_EXPORT http_response GET(boost::asio::io_service &service, const std::string &port,
                             const std::string &path);
+
+/// Persistent (keep-alive) connection to the http server.
+/// Unlike POST(...), answer contains only the body of reply.
+class session {
+public:
+  CM_EXPORT session(boost::asio::io_service &service, const std::string &port);
+  CM_EXPORT http_response POST(const std::string &json_query);
+
+private:
+  boost::asio::ip::tcp::socket _socket;
+  boost::asio::streambuf _response;
+};
 } // namespace http
 } // namespace net
 } // namespace dariadb
\ No newline at end of file
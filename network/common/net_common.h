@@ -7,7 +7,7 @@
 namespace dariadb {
 namespace net {
 
-const uint32_t PROTOCOL_VERSION = 1;
+const uint32_t PROTOCOL_VERSION = 3;
 
 enum class DATA_KINDS : uint8_t {
   OK = 0,
@@ -21,6 +21,7 @@ enum class DATA_KINDS : uint8_t {
   READ_TIMEPOINT,
   CURRENT_VALUE,
   SUBSCRIBE,
+  SLOW_DOWN, // OK for append, but storage can't write so fast.
 };
 
 enum class CLIENT_STATE {
@@ -34,6 +35,7 @@ enum class ERRORS : uint16_t {
   WRONG_PROTOCOL_VERSION,
   WRONG_QUERY_PARAM_FROM_GE_TO, // if in readInterval from>=to
   APPEND_ERROR,                 // some error on append new value to storage
+  NOT_CONNECTED,                // connection is closed before server answer
 };
 
 // CM_EXPORT std::ostream &operator<<(std::ostream &stream, const CLIENT_STATE &state);
@@ -67,6 +67,8 @@ struct QueryInterval_header {
   Time from;
   Time to;
   Flag flag;
+  Time step;          /// 0 - without downsampling.
+  uint8_t downsample; /// DOWNSAMPLE.
   uint16_t ids_count;
 };
 
@@ -19,6 +19,8 @@ std::string storage_path = "dariadb_storage";
 unsigned short server_port = 2001;
 unsigned short server_http_port = 2002;
 size_t server_threads_count = dariadb::net::SERVER_IO_THREADS_DEFAULT;
+size_t server_http_workers = dariadb::net::SERVER_HTTP_WORKERS_DEFAULT;
+size_t server_http_max_request_size = dariadb::net::SERVER_HTTP_MAX_REQUEST_SIZE_DEFAULT;
 STRATEGY strategy = STRATEGY::COMPRESSED;
 ServerLogger::Params p;
 size_t memory_limit = 0;
@@ -77,6 +79,14 @@ int main(int argc, char **argv) {
       "io-threads",
       po::value<size_t>(&server_threads_count)->default_value(server_threads_count),
       "server threads for query processing.");
+  srv_options(
+      "http-workers",
+      po::value<size_t>(&server_http_workers)->default_value(server_http_workers),
+      "threads for http requests handling (0 - handle in io threads).");
+  srv_options("http-max-request-size",
+              po::value<size_t>(&server_http_max_request_size)
+                  ->default_value(server_http_max_request_size),
+              "max size of http request in bytes.");
   desc.add(server_params);
 
   po::variables_map vm;
@@ -215,6 +225,8 @@ int main(int argc, char **argv) {
 
   dariadb::net::Server::Param server_param(server_port, server_http_port,
                                            server_threads_count);
+  server_param.http_workers = server_http_workers;
+  server_param.http_max_request_size = server_http_max_request_size;
   dariadb::net::Server s(server_param);
   s.set_storage(stor);
 
@@ -8,9 +8,13 @@
 #include <common/net_common.h>
 
 #include <boost/asio.hpp>
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
 #include <functional>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <thread>
 
@@ -27,12 +31,39 @@ using namespace dariadb::net::client;
 
 typedef boost::shared_ptr<ip::tcp::socket> socket_ptr;
 
+namespace client_inner {
+/// one call of appendAsync.
+struct AppendTask {
+  std::promise<AppendResult> promise;
+  AppendCallback clbk;
+  AppendResult result;
+  size_t unsended; // values, which are not packed to queries yet.
+  size_t parts;    // sended queries without server answer.
+};
+using AppendTask_ptr = std::shared_ptr<AppendTask>;
+
+void complete_append(const AppendTask_ptr &t) {
+  if (t->clbk != nullptr) {
+    t->clbk(t->result);
+  }
+  t->promise.set_value(t->result);
+}
+} // namespace client_inner
+
+using namespace client_inner;
+
 class Client::Private {
 public:
   Private(const Client::Param &p) : _params(p) {
     _query_num = 1;
     _state = CLIENT_STATE::CONNECT;
     _pings_answers = 0;
+    _append_pending_pos = 0;
+    _append_closed = false;
+    _append_window = std::max(p.append_window, size_t(1));
+    if (p.append_max_pending == size_t(0)) {
+      THROW_EXCEPTION("client: append_max_pending must be greater than zero.");
+    }
     AsyncConnection::onDataRecvHandler on_d = [this](const NetData_ptr &d, bool &cancel) {
       onDataRecv(d, cancel);
     };
@@ -49,6 +80,7 @@ public:
 
       _service.stop();
       _thread_handler.join();
+      failAppends();
     } catch (std::exception &ex) {
       THROW_EXCEPTION("client: #", _async_connection->id(), ex.what());
     }
@@ -67,6 +99,9 @@ public:
   }
 
   void disconnect() {
+    if (_state == CLIENT_STATE::WORK) {
+      flushAppends();
+    }
     if (_socket->is_open()) {
       auto nd = std::make_shared<NetData>(DATA_KINDS::DISCONNECT);
       this->_async_connection->send(nd);
@@ -135,6 +170,7 @@ public:
 
   void onNetworkError(const boost::system::error_code &err) {
     if (this->_state != CLIENT_STATE::DISCONNECTED) {
+      failAppends();
       THROW_EXCEPTION("client: #", _async_connection->id(), " ", err.message());
     }
   }
@@ -158,6 +194,9 @@ public:
       if (this->_state != CLIENT_STATE::WORK) {
         THROW_EXCEPTION("(this->_state != CLIENT_STATE::WORK)", this->_state);
       }
+      if (onAppendAnswer(query_num, false, ERRORS::APPEND_ERROR, false)) {
+        break;
+      }
 
       auto subres_it = this->_query_results.find(query_num);
       if (subres_it != this->_query_results.end()) {
@@ -176,6 +215,12 @@ public:
       ERRORS err = (ERRORS)qh_e->error_code;
       logger_info("client: #", _async_connection->id(), " query #", query_num,
                   " error:", err);
+      if (err == ERRORS::WRONG_PROTOCOL_VERSION) {
+        THROW_EXCEPTION("client: server refused protocol version ", PROTOCOL_VERSION);
+      }
+      if (onAppendAnswer(query_num, true, err, false)) {
+        break;
+      }
       if (this->state() == CLIENT_STATE::WORK) {
         auto subres = this->_query_results[qh_e->id];
         subres->is_closed = true;
@@ -186,6 +231,13 @@ public:
       }
       break;
     }
+    case DATA_KINDS::SLOW_DOWN: {
+      auto qh_ok = reinterpret_cast<QueryOk_header *>(d->data);
+      logger_info("client: #", _async_connection->id(), " query #", qh_ok->id,
+                  " accepted. server asks to slow down.");
+      onAppendAnswer(qh_ok->id, false, ERRORS::APPEND_ERROR, true);
+      break;
+    }
     case DATA_KINDS::APPEND: {
       auto qw = reinterpret_cast<QueryAppend_header *>(d->data);
       logger_info("client: #", _async_connection->id(), " recv ", qw->count,
@@ -218,6 +270,7 @@ public:
       logger_info("client: #", _async_connection->id(), " disconnection.");
       try {
         _state = CLIENT_STATE::DISCONNECTED;
+        failAppends();
         this->_async_connection->full_stop();
         this->_socket->close();
       } catch (...) {
@@ -245,40 +298,166 @@ public:
   CLIENT_STATE state() const { return _state; }
 
   void append(const MeasArray &ma) {
-    this->_locker.lock();
     logger_info("client: send ", ma.size());
-    size_t writed = 0;
+    auto result = appendAsync(ma, nullptr).get();
+    if (result.is_error) {
+      logger_info("client: #", _async_connection->id(), " append error:", result.errc);
+    }
+  }
+
+  std::future<AppendResult> appendAsync(const MeasArray &ma, const AppendCallback &clbk) {
+    auto task = std::make_shared<AppendTask>();
+    task->clbk = clbk;
+    task->result.count = ma.size();
+    task->unsended = ma.size();
+    task->parts = 0;
+    auto result = task->promise.get_future();
+    if (ma.empty()) {
+      complete_append(task);
+      return result;
+    }
+
+    std::unique_lock<std::mutex> lock(_append_locker);
+    _append_cond.wait(lock, [this]() {
+      return pendingCount() < _params.append_max_pending || _append_closed ||
+             _state != CLIENT_STATE::WORK;
+    });
+    if (_append_closed || _state != CLIENT_STATE::WORK) {
+      lock.unlock();
+      logger_info("client: #", _async_connection->id(), " append is rejected: ",
+                  _state);
+      task->result.is_error = true;
+      task->result.errc = ERRORS::NOT_CONNECTED;
+      complete_append(task);
+      return result;
+    }
+    _append_pending.insert(_append_pending.end(), ma.begin(), ma.end());
+    _append_owners.push_back(task);
+    sendPendingAppends();
+    return result;
+  }
+
+  void flushAppends() {
+    std::unique_lock<std::mutex> lock(_append_locker);
+    _append_cond.wait(lock, [this]() {
+      return (pendingCount() == size_t(0) && _append_inflight.empty()) ||
+             _append_closed || _state == CLIENT_STATE::DISCONNECTED;
+    });
+  }
 
-    while (writed != ma.size()) {
+  size_t pendingCount() const { return _append_pending.size() - _append_pending_pos; }
+
+  /// connection is closed: waiting and sended batches will never be answered.
+  void failAppends() {
+    std::vector<AppendTask_ptr> failed;
+    {
+      std::lock_guard<std::mutex> lg(_append_locker);
+      _append_closed = true;
+      for (auto &kv : _append_inflight) {
+        failed.insert(failed.end(), kv.second.begin(), kv.second.end());
+      }
+      failed.insert(failed.end(), _append_owners.begin(), _append_owners.end());
+      _append_inflight.clear();
+      _append_owners.clear();
+      _append_pending.clear();
+      _append_pending_pos = 0;
+      _append_cond.notify_all();
+    }
+    // task can be in many queries.
+    std::sort(failed.begin(), failed.end());
+    failed.erase(std::unique(failed.begin(), failed.end()), failed.end());
+    for (auto &t : failed) {
+      t->result.is_error = true;
+      t->result.errc = ERRORS::NOT_CONNECTED;
+      complete_append(t);
+    }
+  }
+
+  /// pack pending values to queries, while the window is not full.
+  /// _append_locker must be locked.
+  void sendPendingAppends() {
+    while (_append_inflight.size() < _append_window && pendingCount() != size_t(0)) {
+      _locker.lock();
       auto cur_id = _query_num;
       _query_num += 1;
-
-      auto qres = std::make_shared<ReadResult>();
-      qres->id = cur_id;
-      qres->kind = DATA_KINDS::APPEND;
-      this->_query_results[qres->id] = qres;
+      _locker.unlock();
 
       auto nd = std::make_shared<NetData>(DATA_KINDS::APPEND);
-      nd->size = sizeof(QueryAppend_header);
-
       auto hdr = reinterpret_cast<QueryAppend_header *>(&nd->data);
       hdr->id = cur_id;
       size_t space_left = 0;
-      QueryAppend_header::make_query(hdr, ma.data(), ma.size(), writed, &space_left);
-
+      QueryAppend_header::make_query(hdr, _append_pending.data(), _append_pending.size(),
+                                     _append_pending_pos, &space_left);
+      nd->size = NetData::MAX_MESSAGE_SIZE - MARKER_SIZE - space_left;
+      _append_pending_pos += hdr->count;
       logger_info("client: pack count: ", hdr->count);
 
-      nd->size = NetData::MAX_MESSAGE_SIZE - MARKER_SIZE - space_left;
-      writed += hdr->count;
+      // values of one task can be sended in many queries and
+      // one query can contain values of many tasks.
+      auto &query_tasks = _append_inflight[cur_id];
+      size_t not_assigned = hdr->count;
+      while (not_assigned != size_t(0)) {
+        auto owner = _append_owners.front();
+        auto part = std::min(owner->unsended, not_assigned);
+        owner->unsended -= part;
+        owner->parts++;
+        not_assigned -= part;
+        query_tasks.push_back(owner);
+        if (owner->unsended == size_t(0)) {
+          _append_owners.pop_front();
+        }
+      }
+
+      if (_append_pending_pos == _append_pending.size()) {
+        _append_pending.clear();
+        _append_pending_pos = 0;
+      } else if (_append_pending_pos > _append_pending.size() / 2) {
+        _append_pending.erase(_append_pending.begin(),
+                              _append_pending.begin() + _append_pending_pos);
+        _append_pending_pos = 0;
+      }
 
       _async_connection->send(nd);
+    }
+    _append_cond.notify_all();
+  }
+
+  /// return false, if query_num is not an append query.
+  bool onAppendAnswer(QueryNumber query_num, bool is_error, ERRORS err, bool slow_down) {
+    std::vector<AppendTask_ptr> completed;
+    {
+      std::lock_guard<std::mutex> lg(_append_locker);
+      auto it = _append_inflight.find(query_num);
+      if (it == _append_inflight.end()) {
+        return false;
+      }
+      for (auto &t : it->second) {
+        if (is_error) {
+          t->result.is_error = true;
+          t->result.errc = err;
+        }
+        if (slow_down) {
+          t->result.slow_down = true;
+        }
+        t->parts--;
+        if (t->parts == size_t(0) && t->unsended == size_t(0)) {
+          completed.push_back(t);
+        }
+      }
+      _append_inflight.erase(it);
 
-      while (!qres->is_ok && !qres->is_error) {
-        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+      // additive increase, multiplicative decrease.
+      if (slow_down) {
+        _append_window = std::max(_append_window / 2, size_t(1));
+      } else if (_append_window < _params.append_window) {
+        _append_window++;
       }
-      this->_query_results.erase(qres->id);
+      sendPendingAppends();
+    }
+    for (auto &t : completed) {
+      complete_append(t);
     }
-    this->_locker.unlock();
+    return true;
   }
 
   ReadResult_ptr readInterval(const QueryInterval &qi, ReadResult::callback &clbk) {
@@ -300,6 +479,8 @@ public:
     p_header->flag = qi.flag;
     p_header->from = qi.from;
     p_header->to = qi.to;
+    p_header->step = qi.step;
+    p_header->downsample = static_cast<uint8_t>(qi.downsample);
 
     auto id_size = sizeof(Id) * qi.ids.size();
     if ((id_size + nd->size) > NetData::MAX_MESSAGE_SIZE) {
@@ -506,6 +687,15 @@ public:
 
   QueryNumber _query_num;
   MeasArray in_buffer_values;
+
+  std::mutex _append_locker;
+  std::condition_variable _append_cond;
+  MeasArray _append_pending; // values, waiting to be sended.
+  size_t _append_pending_pos;
+  std::deque<AppendTask_ptr> _append_owners; // tasks of values from _append_pending.
+  std::map<QueryNumber, std::vector<AppendTask_ptr>> _append_inflight;
+  size_t _append_window;
+  bool _append_closed; // connection is closed, appends are rejected.
   std::map<QueryNumber, ReadResult_ptr> _query_results;
   std::shared_ptr<AsyncConnection> _async_connection;
 };
@@ -538,6 +728,15 @@ void Client::append(const MeasArray &ma) {
   _Impl->append(ma);
 }
 
+std::future<AppendResult> Client::appendAsync(const MeasArray &ma,
+                                              const AppendCallback &clbk) {
+  return _Impl->appendAsync(ma, clbk);
+}
+
+void Client::flushAppends() {
+  _Impl->flushAppends();
+}
+
 MeasArray Client::readInterval(const QueryInterval &qi) {
   return _Impl->readInterval(qi);
 }
@@ -8,6 +8,7 @@
 #include <libdariadb/utils/async/locker.h>
 #include <common/net_common.h>
 #include <functional>
+#include <future>
 #include <memory>
 #include <string>
 
@@ -36,16 +37,41 @@ struct ReadResult {
 };
 using ReadResult_ptr = std::shared_ptr<ReadResult>;
 
+/// Result of Client::appendAsync.
+struct AppendResult {
+  size_t count;   // values in the batch.
+  bool is_error;  // true - if server refused some values. 'errc' contain error type.
+  ERRORS errc;
+  bool slow_down; // true - if server asked to slow down while the batch was writed.
+  AppendResult() {
+    count = size_t(0);
+    is_error = false;
+    errc = ERRORS::APPEND_ERROR;
+    slow_down = false;
+  }
+};
+using AppendCallback = std::function<void(const AppendResult &)>;
+
+const size_t CLIENT_APPEND_WINDOW_DEFAULT = 8;
+const size_t CLIENT_APPEND_MAX_PENDING_DEFAULT = 1024 * 1024;
+
 class Client {
 public:
   struct Param {
     std::string host;
     unsigned short port;
     unsigned short http_port;
+    /// max count of append queries, sended but not confirmed by server.
+    size_t append_window;
+    /// max count of values waiting to be sended, > 0. appendAsync blocks, when it is
+    /// reached.
+    size_t append_max_pending;
     Param(const std::string &_host, unsigned short _port, unsigned short _http_port) {
       host = _host;
       port = _port;
       http_port = _http_port;
+      append_window = CLIENT_APPEND_WINDOW_DEFAULT;
+      append_max_pending = CLIENT_APPEND_MAX_PENDING_DEFAULT;
     }
   };
   CL_EXPORT Client(const Param &p);
@@ -61,6 +87,13 @@ public:
   CL_EXPORT int id() const;
 
   CL_EXPORT void append(const MeasArray &ma);
+  /// Values are coalesced with appends from other threads and sended
+  /// when the window of outstanding queries has a free slot.
+  /// Result has ERRORS::NOT_CONNECTED, if connection is closed before server answer.
+  CL_EXPORT std::future<AppendResult> appendAsync(const MeasArray &ma,
+                                                  const AppendCallback &clbk = nullptr);
+  /// Wait while all appended values are confirmed by server.
+  CL_EXPORT void flushAppends();
   CL_EXPORT MeasArray readInterval(const QueryInterval &qi);
   CL_EXPORT ReadResult_ptr readInterval(const QueryInterval &qi,
                                         ReadResult::callback &clbk);
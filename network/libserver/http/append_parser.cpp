@@ -0,0 +1,395 @@
+#include <libdariadb/utils/exception.h>
+#include <libserver/http/append_parser.h>
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+using namespace dariadb;
+using namespace dariadb::net::http;
+
+append_parser::append_parser(const dariadb::scheme::IScheme_Ptr &scheme,
+                             const std::string &query)
+    : _scheme(scheme), _query(query) {
+  _pos = _query.data();
+  _end = _query.data() + _query.size();
+}
+
+void append_parser::error(const char *msg) const {
+  auto offset = size_t(_pos - _query.data());
+  throw std::invalid_argument(std::string("append parser: ") + msg + " at " +
+                              std::to_string(offset));
+}
+
+void append_parser::skip_ws() {
+  while (_pos != _end &&
+         (*_pos == ' ' || *_pos == '\n' || *_pos == '\r' || *_pos == '\t')) {
+    ++_pos;
+  }
+}
+
+bool append_parser::next_is(char c) {
+  skip_ws();
+  if (_pos != _end && *_pos == c) {
+    ++_pos;
+    return true;
+  }
+  return false;
+}
+
+void append_parser::expect(char c) {
+  if (!next_is(c)) {
+    error("unexpected symbol");
+  }
+}
+
+void append_parser::read_string(std::string &out) {
+  expect('"');
+  out.clear();
+  while (_pos != _end && *_pos != '"') {
+    if (*_pos != '\\') {
+      out.push_back(*_pos++);
+      continue;
+    }
+    ++_pos;
+    if (_pos == _end) {
+      break;
+    }
+    switch (*_pos++) {
+    case '"':
+      out.push_back('"');
+      break;
+    case '\\':
+      out.push_back('\\');
+      break;
+    case '/':
+      out.push_back('/');
+      break;
+    case 'b':
+      out.push_back('\b');
+      break;
+    case 'f':
+      out.push_back('\f');
+      break;
+    case 'n':
+      out.push_back('\n');
+      break;
+    case 'r':
+      out.push_back('\r');
+      break;
+    case 't':
+      out.push_back('\t');
+      break;
+    case 'u': {
+      if (_end - _pos < 4) {
+        error("bad unicode escape");
+      }
+      char hex[5] = {_pos[0], _pos[1], _pos[2], _pos[3], 0};
+      _pos += 4;
+      auto code = std::strtoul(hex, nullptr, 16);
+      // to utf-8. surrogate pairs are not used in parameter names.
+      if (code < 0x80) {
+        out.push_back(char(code));
+      } else if (code < 0x800) {
+        out.push_back(char(0xC0 | (code >> 6)));
+        out.push_back(char(0x80 | (code & 0x3F)));
+      } else {
+        out.push_back(char(0xE0 | (code >> 12)));
+        out.push_back(char(0x80 | ((code >> 6) & 0x3F)));
+        out.push_back(char(0x80 | (code & 0x3F)));
+      }
+      break;
+    }
+    default:
+      error("bad escape");
+    }
+  }
+  if (_pos == _end) {
+    error("unterminated string");
+  }
+  ++_pos;
+}
+
+void append_parser::skip_value() {
+  skip_ws();
+  if (_pos == _end) {
+    error("unexpected end");
+  }
+  switch (*_pos) {
+  case '"': {
+    std::string unused;
+    read_string(unused);
+    return;
+  }
+  case '{': {
+    ++_pos;
+    if (next_is('}')) {
+      return;
+    }
+    std::string unused;
+    do {
+      read_string(unused);
+      expect(':');
+      skip_value();
+    } while (next_is(','));
+    expect('}');
+    return;
+  }
+  case '[': {
+    ++_pos;
+    if (next_is(']')) {
+      return;
+    }
+    do {
+      skip_value();
+    } while (next_is(','));
+    expect(']');
+    return;
+  }
+  default: { // number, true, false, null
+    auto start = _pos;
+    while (_pos != _end && *_pos != ',' && *_pos != '}' && *_pos != ']' &&
+           *_pos != ' ' && *_pos != '\n' && *_pos != '\r' && *_pos != '\t') {
+      ++_pos;
+    }
+    if (start == _pos) {
+      error("value expected");
+    }
+  }
+  }
+}
+
+uint64_t append_parser::read_uint(uint64_t max) {
+  skip_ws();
+  uint64_t result = 0;
+  auto start = _pos;
+  while (_pos != _end && *_pos >= '0' && *_pos <= '9') {
+    auto digit = uint64_t(*_pos - '0');
+    if (result > (max - digit) / 10) {
+      error("number is out of range");
+    }
+    result = result * 10 + digit;
+    ++_pos;
+  }
+  if (_pos != _end && (*_pos == '.' || *_pos == 'e' || *_pos == 'E')) {
+    // written as floating point number.
+    _pos = start;
+    auto value = read_value();
+    if (value < 0 || value >= Value(max) + 1 || std::floor(value) != value) {
+      error("unsigned number expected");
+    }
+    return uint64_t(value);
+  }
+  if (start == _pos || (*start == '0' && _pos - start > 1)) {
+    error("unsigned number expected");
+  }
+  return result;
+}
+
+const char *append_parser::skip_digits(const char *it) const {
+  while (it != _end && *it >= '0' && *it <= '9') {
+    ++it;
+  }
+  return it;
+}
+
+Value append_parser::read_value() {
+  skip_ws();
+  // json number: -?(0|[1-9][0-9]*)(.[0-9]+)?([eE][+-]?[0-9]+)?
+  auto it = _pos;
+  if (it != _end && *it == '-') {
+    ++it;
+  }
+  if (it == _end || *it < '0' || *it > '9') {
+    error("number expected");
+  }
+  it = (*it == '0') ? it + 1 : skip_digits(it);
+  if (it != _end && *it == '.') {
+    auto frac = ++it;
+    it = skip_digits(it);
+    if (it == frac) {
+      error("bad number");
+    }
+  }
+  if (it != _end && (*it == 'e' || *it == 'E')) {
+    ++it;
+    if (it != _end && (*it == '+' || *it == '-')) {
+      ++it;
+    }
+    auto exp = it;
+    it = skip_digits(it);
+    if (it == exp) {
+      error("bad number");
+    }
+  }
+
+  // query is std::string, so strtod will stop on terminating zero.
+  errno = 0;
+  char *num_end = nullptr;
+  auto result = std::strtod(_pos, &num_end);
+  // overflow, not underflow. std::isinf is not used: release build is -Ofast.
+  if (num_end != it || (errno == ERANGE && std::fabs(result) > 1)) {
+    error("number is out of range");
+  }
+  _pos = it;
+  return result;
+}
+
+void append_parser::read_values_of_id(MeasArray *result, id_range *range) {
+  range->begin = result->size();
+  size_t count = std::numeric_limits<size_t>::max();
+  size_t arrays_readed = 0;
+  std::string key;
+  expect('{');
+  if (next_is('}')) {
+    range->end = range->begin;
+    return;
+  }
+  do {
+    read_string(key);
+    expect(':');
+    if (key != "F" && key != "V" && key != "T") {
+      skip_value();
+      continue;
+    }
+    ++arrays_readed;
+    expect('[');
+    size_t pos = range->begin;
+    if (!next_is(']')) {
+      do {
+        if (pos == result->size()) {
+          if (count != std::numeric_limits<size_t>::max()) {
+            THROW_EXCEPTION("bad query format: ", key, " array is too long for ",
+                            range->name);
+          }
+          result->emplace_back();
+        }
+        auto &m = (*result)[pos++];
+        switch (key[0]) {
+        case 'F':
+          m.flag = static_cast<Flag>(read_uint(std::numeric_limits<Flag>::max()));
+          break;
+        case 'T':
+          m.time = read_uint(std::numeric_limits<Time>::max());
+          break;
+        default:
+          m.value = read_value();
+          break;
+        }
+      } while (next_is(','));
+      expect(']');
+    }
+    auto readed = pos - range->begin;
+    if (count == std::numeric_limits<size_t>::max()) {
+      count = readed;
+    } else if (count != readed) {
+      THROW_EXCEPTION("bad query format: size of ", key, " is ", readed, ", expected ",
+                      count, " for ", range->name);
+    }
+  } while (next_is(','));
+  expect('}');
+  if (arrays_readed != 3 && count != 0 && count != std::numeric_limits<size_t>::max()) {
+    THROW_EXCEPTION("bad query format: F, V and T are expected for ", range->name);
+  }
+  range->end = result->size();
+}
+
+void append_parser::read_values(MeasArray *result) {
+  expect('{');
+  if (next_is('}')) {
+    return;
+  }
+  do {
+    id_range range;
+    read_string(range.name);
+    expect(':');
+    read_values_of_id(result, &range);
+    _ranges.push_back(range);
+  } while (next_is(','));
+  expect('}');
+}
+
+void append_parser::read_single_value(MeasArray *result, id_range *range) {
+  range->begin = result->size();
+  result->emplace_back();
+  auto &m = result->back();
+  std::string key;
+  bool has_id = false, has_flag = false, has_time = false, has_value = false;
+  expect('{');
+  if (!next_is('}')) {
+    do {
+      read_string(key);
+      expect(':');
+      if (key == "I") {
+        read_string(range->name);
+        has_id = !range->name.empty();
+      } else if (key == "F") {
+        m.flag = static_cast<Flag>(read_uint(std::numeric_limits<Flag>::max()));
+        has_flag = true;
+      } else if (key == "T") {
+        m.time = read_uint(std::numeric_limits<Time>::max());
+        has_time = true;
+      } else if (key == "V") {
+        m.value = read_value();
+        has_value = true;
+      } else {
+        skip_value();
+      }
+    } while (next_is(','));
+    expect('}');
+  }
+  if (!has_id || !has_flag || !has_time || !has_value) {
+    THROW_EXCEPTION("bad query format: I, F, V and T are expected in append_value");
+  }
+  range->end = result->size();
+}
+
+bool append_parser::parse(MeasArray *result) {
+  std::string type;
+  std::string key;
+  bool values_found = false;
+  expect('{');
+  if (!next_is('}')) {
+    do {
+      read_string(key);
+      expect(':');
+      if (key == "type") {
+        read_string(type);
+        if (type != "append") {
+          // other queries are parsed by json DOM.
+          return false;
+        }
+      } else if (key == "append_values") {
+        // every value takes at least three numbers with delimiters.
+        auto commas = size_t(std::count(_pos, _end, ','));
+        result->reserve(result->size() + commas / 3 + 1);
+        read_values(result);
+        values_found = true;
+      } else if (key == "append_value") {
+        id_range range;
+        read_single_value(result, &range);
+        _ranges.push_back(range);
+        values_found = true;
+      } else {
+        skip_value();
+      }
+    } while (next_is(','));
+    expect('}');
+  }
+
+  if (type != "append" || !values_found) {
+    return false;
+  }
+
+  // names are registered only when query is known to be correct.
+  for (auto &r : _ranges) {
+    auto id = _scheme->addParam(r.name);
+    for (auto i = r.begin; i < r.end; ++i) {
+      (*result)[i].id = id;
+    }
+  }
+  return true;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <libdariadb/meas.h>
+#include <libdariadb/scheme/ischeme.h>
+#include <libserver/net_srv_exports.h>
+#include <string>
+
+namespace dariadb {
+namespace net {
+namespace http {
+
+/**
+Streaming parser for 'append' query:
+{"type":"append", "append_values":{"name":{"F":[...],"V":[...],"T":[...]},...}}
+{"type":"append", "append_value":{"I":"name","F":..,"V":..,"T":..}}
+Values are decoded straight into result without building of json DOM.
+*/
+class append_parser {
+public:
+  SRV_EXPORT append_parser(const dariadb::scheme::IScheme_Ptr &scheme,
+                           const std::string &query);
+  /// return false, if query is not 'append'. throw exception on bad format.
+  SRV_EXPORT bool parse(MeasArray *result);
+
+private:
+  struct id_range {
+    std::string name;
+    size_t begin;
+    size_t end;
+  };
+
+  [[noreturn]] void error(const char *msg) const;
+  void skip_ws();
+  bool next_is(char c);
+  void expect(char c);
+  void read_string(std::string &out);
+  void skip_value();
+  /// throw exception, if number is negative, fractional or bigger than 'max'.
+  uint64_t read_uint(uint64_t max);
+  const char *skip_digits(const char *it) const;
+  /// only json number syntax is accepted (no nan, inf or hex).
+  Value read_value();
+
+  void read_values(MeasArray *result);
+  void read_values_of_id(MeasArray *result, id_range *range);
+  void read_single_value(MeasArray *result, id_range *range);
+
+  dariadb::scheme::IScheme_Ptr _scheme;
+  const std::string &_query;
+  const char *_pos;
+  const char *_end;
+  std::vector<id_range> _ranges;
+};
+
+} // namespace http
+} // namespace net
+} // namespace dariadb
@@ -1,18 +1,23 @@
+#include <libdariadb/utils/logger.h>
 #include <libserver/http/connection.h>
 #include <libserver/http/connection_manager.h>
 #include <libserver/http/request_handler.h>
 #include <boost/asio.hpp>
+#include <algorithm>
 #include <iterator>
 #include <string>
 #include <utility>
 #include <vector>
 
 using namespace dariadb::net::http;
+using namespace dariadb::utils::async;
 
 connection::connection(boost::asio::ip::tcp::socket socket, connection_manager &manager,
-                       request_handler &handler)
+                       request_handler &handler, utils::async::ThreadPool *workers,
+                       size_t max_request_size)
     : socket_(std::move(socket)), connection_manager_(manager),
-      request_handler_(handler) {}
+      request_handler_(handler), workers_(workers), max_request_size_(max_request_size),
+      _request_buf(max_headers_size + max_request_size) {}
 
 void connection::start() {
   do_headers_read();
@@ -29,136 +34,288 @@ void connection::do_headers_read() {
   boost::asio::async_read_until(
       socket_, _request_buf, header_delim,
       [this, self](boost::system::error_code ec, std::size_t bytes_transferred) {
-        if (!ec) {
-          std::istream request_stream(&_request_buf);
-
-          // parse status line "POST / HTTP/1.1\r\n"
-          std::string status_line;
-          std::getline(request_stream, status_line);
-
-          size_t prev_pos = 0;
-          size_t status_word_num = 0;
-          for (size_t i = 0; i < status_line.size(); ++i) {
-            if (status_line[i] == ' ') {
-              auto begin = status_line.begin() + prev_pos;
-              auto end = status_line.begin() + i;
-              std::string value(begin, end);
-              switch (status_word_num) {
-              case size_t(0): // POST||GET
-                this->request_.method = value;
-                break;
-              case size_t(1): // uri
-                this->request_.uri = std::string(value.begin() + 1, value.end());
-                break;
-              }
-              prev_pos = i;
-              status_word_num++;
-              if (status_word_num > 1) {
-                // already read POST and path. protocol version unneeded to us.
-                break;
-              }
-            }
-          }
+        if (ec == boost::asio::error::not_found) {
+          // the buffer is full, but headers are not ended.
+          keep_alive_ = false;
+          reply_ =
+              reply::stock_reply("headers too large", reply::status_type::bad_request);
+          do_write();
+          return;
+        }
+        if (ec) {
+          on_error(ec);
+          return;
+        }
 
-          // parse headers and find content length.
-          std::string header_record;
-          bool content_length_exists = false;
-          bool parse_error = false;
-          std::string content_length;
-          while (request_stream.good() && header_record != "\r") {
-            std::getline(request_stream, header_record);
-
-            // to lower case
-            std::transform(header_record.begin(), header_record.end(),
-                           header_record.begin(), ::tolower);
-
-            if (header_record != "\r") {
-              auto delim_pos = std::find(header_record.begin(), header_record.end(), ':');
-              if (delim_pos == header_record.end()) {
-                parse_error = true;
-                break;
-              }
-              std::string name(header_record.begin(), delim_pos);
-              delim_pos++;
-              delim_pos++;
-              std::string value(delim_pos, header_record.end());
-              header hr;
-              hr.name = name;
-              hr.value = value;
-              this->request_.headers.push_back(hr);
-              if (name == "content-length") {
-                content_length_exists = true;
-                content_length = value;
-              }
-            }
-          }
-          if (request_.method == "POST") {
-
-            if (!content_length_exists) {
-              reply_ = reply::stock_reply("content-length not exists.",
-                                          reply::status_type::not_found);
-              do_write();
-              return;
-            }
-            if (parse_error) {
-              reply_ =
-                  reply::stock_reply("header parse error", reply::status_type::not_found);
-              do_write();
-              return;
-            }
-            auto query_length = std::atoll(content_length.c_str());
-            do_query_read(query_length - _request_buf.size());
-
-          } else { // GET query
-            request_handler_.handle_request(request_, reply_);
-            do_write();
+        std::istream request_stream(&_request_buf);
+        size_t content_length = 0;
+        if (!parse_headers(request_stream, &content_length)) {
+          do_write();
+          return;
+        }
+
+        if (request_.method == "POST") {
+          // body (or its part) can be already readed with headers.
+          if (_request_buf.size() >= content_length) {
+            on_query_readed(content_length);
+          } else {
+            do_query_read(content_length);
           }
-        } else if (ec != boost::asio::error::operation_aborted) {
-          auto error_message = ec.message();
-          logger_fatal("http: error ", error_message);
-          connection_manager_.stop(shared_from_this());
+        } else { // GET query
+          do_handle();
         }
       });
 }
 
+bool connection::parse_headers(std::istream &request_stream, size_t *content_length) {
+  // parse status line "POST / HTTP/1.1\r\n"
+  std::string status_line;
+  std::getline(request_stream, status_line);
+
+  size_t prev_pos = 0;
+  size_t status_word_num = 0;
+  for (size_t i = 0; i < status_line.size(); ++i) {
+    if (status_line[i] == ' ') {
+      auto begin = status_line.begin() + prev_pos;
+      auto end = status_line.begin() + i;
+      std::string value(begin, end);
+      switch (status_word_num) {
+      case size_t(0): // POST||GET
+        this->request_.method = value;
+        break;
+      case size_t(1): // uri
+        this->request_.uri = std::string(value.begin() + 1, value.end());
+        break;
+      }
+      prev_pos = i;
+      status_word_num++;
+      if (status_word_num > 1) {
+        // already read POST and path.
+        break;
+      }
+    }
+  }
+  // protocol version is needed to select transfer-encoding of reply.
+  if (status_word_num > 1 && prev_pos < status_line.size()) {
+    std::string version(status_line.begin() + prev_pos + 1, status_line.end());
+    if (!version.empty() && version.back() == '\r') {
+      version.pop_back();
+    }
+    this->request_.version = version;
+  }
+  // HTTP/1.1 connections are persistent by default.
+  keep_alive_ = request_.version == "HTTP/1.1";
+
+  // parse headers and find content length.
+  std::string header_record;
+  bool content_length_exists = false;
+  bool parse_error = false;
+  std::string content_length_str;
+  while (request_stream.good() && header_record != "\r") {
+    std::getline(request_stream, header_record);
+
+    // to lower case
+    std::transform(header_record.begin(), header_record.end(), header_record.begin(),
+                   ::tolower);
+
+    if (header_record != "\r") {
+      auto delim_pos = std::find(header_record.begin(), header_record.end(), ':');
+      if (delim_pos == header_record.end()) {
+        parse_error = true;
+        break;
+      }
+      std::string name(header_record.begin(), delim_pos);
+      delim_pos++;
+      while (delim_pos != header_record.end() && *delim_pos == ' ') {
+        delim_pos++;
+      }
+      std::string value(delim_pos, header_record.end());
+      if (!value.empty() && value.back() == '\r') {
+        value.pop_back();
+      }
+      header hr;
+      hr.name = name;
+      hr.value = value;
+      this->request_.headers.push_back(hr);
+      if (name == "content-length") {
+        content_length_exists = true;
+        content_length_str = value;
+      }
+      if (name == "connection") {
+        if (value == "close") {
+          keep_alive_ = false;
+        }
+        if (value == "keep-alive") {
+          keep_alive_ = true;
+        }
+      }
+    }
+  }
+
+  if (request_.method == "POST") {
+    if (!content_length_exists) {
+      keep_alive_ = false;
+      reply_ =
+          reply::stock_reply("content-length not exists.", reply::status_type::not_found);
+      return false;
+    }
+    if (parse_error) {
+      keep_alive_ = false;
+      reply_ = reply::stock_reply("header parse error", reply::status_type::not_found);
+      return false;
+    }
+    auto query_length = std::atoll(content_length_str.c_str());
+    if (query_length < 0 || size_t(query_length) > max_request_size_) {
+      // the body is not readed, so the connection can't be reused.
+      keep_alive_ = false;
+      reply_ = reply::stock_reply("request is too large",
+                                  reply::status_type::request_entity_too_large);
+      return false;
+    }
+    *content_length = size_t(query_length);
+  }
+  return true;
+}
+
 void connection::do_query_read(size_t length) {
   auto self(shared_from_this());
 
   boost::asio::async_read(
-      socket_, _request_buf, boost::asio::transfer_at_least(length),
-      [this, self](boost::system::error_code ec, std::size_t bytes_transferred) {
+      socket_, _request_buf, boost::asio::transfer_exactly(length - _request_buf.size()),
+      [this, self, length](boost::system::error_code ec, std::size_t bytes_transferred) {
         if (!ec) {
-          std::istream request_stream(&_request_buf);
-
-          std::string line;
-          while (request_stream.good()) {
-            std::getline(request_stream, line);
-            request_.query += line + "\n";
-          }
-          request_handler_.handle_request(request_, reply_);
-          do_write();
-        } else if (ec != boost::asio::error::operation_aborted) {
-          auto error_message = ec.message();
-          logger_fatal("http: error ", error_message);
-          connection_manager_.stop(shared_from_this());
+          on_query_readed(length);
+        } else {
+          on_error(ec);
         }
-
       });
 }
 
+void connection::on_query_readed(size_t length) {
+  // the buffer can contain the next pipelined request after the body.
+  auto body = _request_buf.data();
+  auto body_begin = boost::asio::buffers_begin(body);
+  request_.query.assign(body_begin, body_begin + length);
+  _request_buf.consume(length);
+  do_handle();
+}
+
+void connection::do_handle() {
+  if (workers_ == nullptr) {
+    request_handler_.handle_request(request_, reply_);
+    do_write();
+    return;
+  }
+
+  auto self(shared_from_this());
+  AsyncTask at = [this, self](const ThreadInfo &ti) {
+    TKIND_CHECK(THREAD_KINDS::HTTP, ti.kind);
+    try {
+      request_handler_.handle_request(request_, reply_);
+    } catch (const std::exception &ex) {
+      logger_fatal("http: request handling error: ", ex.what());
+      keep_alive_ = false;
+      reply_ =
+          reply::stock_reply(ex.what(), reply::status_type::internal_server_error);
+    }
+    // socket is used by io threads only.
+    boost::asio::post(socket_.get_executor(), [this, self]() { do_write(); });
+    return false;
+  };
+  workers_->post(AT(at));
+}
+
 void connection::do_write() {
   auto self(shared_from_this());
-  boost::asio::async_write(
-      socket_, reply_.to_buffers(),
-      [this, self](boost::system::error_code ec, std::size_t) {
-        if (!ec) {
-          // Initiate graceful connection closure.
-          boost::system::error_code ignored_ec;
-          socket_.shutdown(boost::asio::ip::tcp::socket::shutdown_both, ignored_ec);
-        }
+  if (reply_.body_source != nullptr) {
+    // chunked encoding is not allowed for HTTP/1.0 clients.
+    reply_.chunked = request_.version != "HTTP/1.0";
+    if (!reply_.chunked) {
+      // the end of body is marked by connection closing.
+      keep_alive_ = false;
+    }
+  }
+  if (!keep_alive_) {
+    reply_.headers.push_back(header{"Connection", "close"});
+  } else if (request_.version == "HTTP/1.0") {
+    reply_.headers.push_back(header{"Connection", "keep-alive"});
+  }
+  boost::asio::async_write(socket_, reply_.to_buffers(),
+                           [this, self](boost::system::error_code ec, std::size_t) {
+                             if (!ec && reply_.body_source != nullptr) {
+                               do_write_body();
+                               return;
+                             }
+                             on_reply_writed(ec);
+                           });
+}
 
-        if (ec != boost::asio::error::operation_aborted) {
-          connection_manager_.stop(shared_from_this());
-        }
-      });
+void connection::do_write_body() {
+  if (workers_ == nullptr) {
+    write_body_buffers(reply_.next_body_buffers());
+    return;
+  }
+  // body source reads the storage, so io thread does not wait for it.
+  auto self(shared_from_this());
+  AsyncTask at = [this, self](const ThreadInfo &ti) {
+    TKIND_CHECK(THREAD_KINDS::HTTP, ti.kind);
+    auto buffers = reply_.next_body_buffers();
+    boost::asio::post(socket_.get_executor(),
+                      [this, self, buffers]() { write_body_buffers(buffers); });
+    return false;
+  };
+  workers_->post(AT(at));
+}
+
+void connection::write_body_buffers(
+    const std::vector<boost::asio::const_buffer> &buffers) {
+  auto self(shared_from_this());
+  if (buffers.empty() && reply_.body_failed()) {
+    // abort without terminating chunk, so client sees a truncated body.
+    connection_manager_.stop(self);
+    return;
+  }
+  if (buffers.empty()) {
+    on_reply_writed(boost::system::error_code());
+    return;
+  }
+  boost::asio::async_write(socket_, buffers,
+                           [this, self](boost::system::error_code ec, std::size_t) {
+                             if (!ec) {
+                               do_write_body();
+                               return;
+                             }
+                             on_reply_writed(ec);
+                           });
+}
+
+void connection::on_reply_writed(const boost::system::error_code &ec) {
+  if (!ec && keep_alive_) {
+    request_ = request();
+    reply_ = reply();
+    do_headers_read();
+    return;
+  }
+
+  if (!ec) {
+    // Initiate graceful connection closure.
+    boost::system::error_code ignored_ec;
+    socket_.shutdown(boost::asio::ip::tcp::socket::shutdown_both, ignored_ec);
+  }
+
+  if (ec != boost::asio::error::operation_aborted) {
+    connection_manager_.stop(shared_from_this());
+  }
+}
+
+void connection::on_error(const boost::system::error_code &ec) {
+  if (ec == boost::asio::error::operation_aborted) {
+    return;
+  }
+  // client closes an idle keep-alive connection.
+  if (ec != boost::asio::error::eof) {
+    auto error_message = ec.message();
+    logger_fatal("http: error ", error_message);
+  }
+  connection_manager_.stop(shared_from_this());
 }
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <libdariadb/utils/async/thread_pool.h>
 #include <libserver/http/reply.h>
 #include <libserver/http/request.h>
 #include <libserver/http/request_handler.h>
@@ -14,6 +15,9 @@ namespace http {
 
 class connection_manager;
 const size_t reques_buffer_size = 8192;
+/// max size of status line with all headers.
+const size_t max_headers_size = 64 * 1024;
+
 /// Represents a single connection from a client.
 class connection : public std::enable_shared_from_this<connection> {
 public:
@@ -21,8 +25,10 @@ public:
   connection &operator=(const connection &) = delete;
 
   /// Construct a connection with the given socket.
+  /// If 'workers' is not null, requests are handled in it, not in io thread.
   explicit connection(boost::asio::ip::tcp::socket socket, connection_manager &manager,
-                      request_handler &handler);
+                      request_handler &handler, utils::async::ThreadPool *workers,
+                      size_t max_request_size);
 
   /// Start the first asynchronous operation for the connection.
   void start();
@@ -34,9 +40,27 @@ private:
   void do_query_read(size_t length);
   void do_headers_read();
 
+  /// Parse status line and headers. Returns false, if reply_ is ready to send.
+  bool parse_headers(std::istream &request_stream, size_t *content_length);
+
+  /// Copy a body of the query from the buffer and handle it.
+  void on_query_readed(size_t length);
+
+  /// Run request_handler in a worker pool, then send a reply.
+  void do_handle();
+
   /// Perform an asynchronous write operation.
   void do_write();
 
+  /// Pull next part of streamed reply body (in a worker) and write it.
+  void do_write_body();
+  void write_body_buffers(const std::vector<boost::asio::const_buffer> &buffers);
+
+  /// Read next request or close connection after the reply was sent.
+  void on_reply_writed(const boost::system::error_code &ec);
+
+  void on_error(const boost::system::error_code &ec);
+
   /// Socket for the connection.
   boost::asio::ip::tcp::socket socket_;
 
@@ -46,6 +70,9 @@ private:
   /// The handler used to process the incoming request.
   request_handler &request_handler_;
 
+  utils::async::ThreadPool *workers_;
+  size_t max_request_size_;
+
   boost::asio::streambuf _request_buf;
 
   /// The incoming request.
@@ -53,10 +80,13 @@ private:
 
   /// The reply to be sent back to the client.
   reply reply_;
+
+  /// Wait a next request after reply was sent.
+  bool keep_alive_ = false;
 };
 
 typedef std::shared_ptr<connection> connection_ptr;
 
 } // namespace http
 } // namespace net
-} // namespace dariadb
\ No newline at end of file
+} // namespace dariadb
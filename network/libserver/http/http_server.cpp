@@ -1,17 +1,24 @@
 #include <libdariadb/utils/logger.h>
 #include <libserver/http/http_server.h>
+#include <future>
 #include <signal.h>
 #include <utility>
 
 using namespace dariadb::net;
 using namespace dariadb::net::http;
+using namespace dariadb::utils::async;
 
 http_server::http_server(const std::string &address, const std::string &port,
                          boost::asio::io_service *io_service_,
-                         IClientManager *client_manager)
+                         IClientManager *client_manager, size_t workers,
+                         size_t max_request_size)
     : io_service_(io_service_), acceptor_(*io_service_), connection_manager_(),
-      socket_(*io_service_) {
+      socket_(*io_service_), max_request_size_(max_request_size) {
   this->request_handler_.set_clientmanager(client_manager);
+  if (workers != 0) {
+    workers_ = std::make_unique<ThreadPool>(
+        ThreadPool::Params(workers, (ThreadKind)THREAD_KINDS::HTTP));
+  }
   // Open the acceptor with the option to reuse the address (i.e. SO_REUSEADDR).
   boost::asio::ip::tcp::resolver resolver(*io_service_);
   boost::asio::ip::tcp::endpoint endpoint = *resolver.resolve({address, port});
@@ -21,7 +28,7 @@ http_server::http_server(const std::string &address, const std::string &port,
   acceptor_.listen();
 
   do_accept();
-  logger_info("http_server: started on port=", port);
+  logger_info("http_server: started on port=", port, " workers=", workers);
 }
 
 void http_server::do_accept() {
@@ -34,7 +41,8 @@ void http_server::do_accept() {
 
     if (!ec) {
       connection_manager_.start(std::make_shared<connection>(
-          std::move(socket_), connection_manager_, request_handler_));
+          std::move(socket_), connection_manager_, request_handler_, workers_.get(),
+          max_request_size_));
     }
 
     do_accept();
@@ -43,7 +51,21 @@ void http_server::do_accept() {
 
 void http_server::do_stop() {
   logger_info("http_server: do_stop started.");
-  acceptor_.close();
-  connection_manager_.stop_all();
+  // acceptor and sockets are used by io threads only.
+  std::promise<void> stopped;
+  auto stop_logic = [this, &stopped]() {
+    acceptor_.close();
+    connection_manager_.stop_all();
+    stopped.set_value();
+  };
+  if (io_service_->stopped() || io_service_->get_executor().running_in_this_thread()) {
+    stop_logic();
+  } else {
+    boost::asio::post(*io_service_, stop_logic);
+    stopped.get_future().wait();
+  }
+  if (workers_ != nullptr) {
+    workers_->stop();
+  }
   logger_info("http_server: do_stop end.");
 }
@@ -4,7 +4,9 @@
 #include <libserver/http/connection_manager.h>
 #include <libserver/http/request_handler.h>
 #include <libserver/iclientmanager.h>
+#include <libdariadb/utils/async/thread_pool.h>
 #include <boost/asio.hpp>
+#include <memory>
 #include <string>
 
 namespace dariadb {
@@ -17,11 +19,12 @@ public:
   http_server(const http_server &) = delete;
   http_server &operator=(const http_server &) = delete;
 
-  /// Construct the server to listen on the specified TCP address and port, and
-  /// serve up files from the given directory.
+  /// Construct the server to listen on the specified TCP address and port.
+  /// Requests are handled in 'workers' threads (in io threads, if workers==0).
   explicit http_server(const std::string &address, const std::string &port,
                        boost::asio::io_service *io_service_,
-                       IClientManager *client_manager);
+                       IClientManager *client_manager, size_t workers,
+                       size_t max_request_size);
 
   void set_storage(dariadb::IEngine_Ptr &storage_engine) {
     request_handler_.set_storage(storage_engine);
@@ -38,6 +41,8 @@ private:
   connection_manager connection_manager_;
   boost::asio::ip::tcp::socket socket_;
   request_handler request_handler_;
+  size_t max_request_size_;
+  std::unique_ptr<utils::async::ThreadPool> workers_;
 };
 
 } // namespace http
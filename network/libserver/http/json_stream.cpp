@@ -0,0 +1,143 @@
+#include <libserver/http/json_stream.h>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+using namespace dariadb;
+using namespace dariadb::net::http;
+
+void dariadb::net::http::write_json_string(std::string &out, const std::string &s) {
+  out.push_back('"');
+  for (auto c : s) {
+    switch (c) {
+    case '"':
+      out.append("\\\"");
+      break;
+    case '\\':
+      out.append("\\\\");
+      break;
+    case '\n':
+      out.append("\\n");
+      break;
+    case '\r':
+      out.append("\\r");
+      break;
+    case '\t':
+      out.append("\\t");
+      break;
+    default:
+      if (static_cast<unsigned char>(c) < 0x20) {
+        char buf[8];
+        auto len = std::snprintf(buf, sizeof(buf), "\\u%04x", int(c));
+        out.append(buf, len);
+      } else {
+        out.push_back(c);
+      }
+    }
+  }
+  out.push_back('"');
+}
+
+void dariadb::net::http::write_json_number(std::string &out, dariadb::Value v) {
+  if (!std::isfinite(v)) {
+    out.append("null");
+    return;
+  }
+  char buf[32];
+  // shortest form, which can be readed back without precision lost.
+  auto len = std::snprintf(buf, sizeof(buf), "%.15g", v);
+  if (std::strtod(buf, nullptr) != v) {
+    len = std::snprintf(buf, sizeof(buf), "%.17g", v);
+  }
+  out.append(buf, len);
+}
+
+void dariadb::net::http::write_json_meas(std::string &out, const dariadb::Meas &m) {
+  out.append("{\"F\":");
+  out.append(std::to_string(m.flag));
+  out.append(",\"T\":");
+  out.append(std::to_string(m.time));
+  out.append(",\"V\":");
+  write_json_number(out, m.value);
+  out.push_back('}');
+}
+
+meas_json_writer::meas_json_writer(const dariadb::scheme::DescriptionMap &names,
+                                   std::string *out)
+    : _names(names), _out(out) {
+  _opened = _closed = _has_id = false;
+  _current_id = MAX_ID;
+}
+
+void meas_json_writer::open() {
+  if (!_opened) {
+    _out->push_back('{');
+    _opened = true;
+  }
+}
+
+void meas_json_writer::apply(const Meas &m) {
+  open();
+  if (!_has_id || m.id != _current_id) {
+    if (_has_id) {
+      _out->append("],");
+    }
+    auto fres = _names.find(m.id);
+    write_json_string(*_out, fres == _names.end() ? std::string() : fres->second.name);
+    _out->append(":[");
+    _has_id = true;
+    _current_id = m.id;
+  } else {
+    _out->push_back(',');
+  }
+  write_json_meas(*_out, m);
+}
+
+void meas_json_writer::is_end() {
+  if (!_closed) {
+    open();
+    if (_has_id) {
+      _out->push_back(']');
+    }
+    _out->push_back('}');
+    _closed = true;
+  }
+  IReadCallback::is_end();
+}
+
+interval_json_source::interval_json_source(const dariadb::scheme::DescriptionMap &names,
+                                           const QueryInterval &q,
+                                           const Id2Cursor &readers)
+    : _q(q), _readers(readers), _writer(names, nullptr) {
+  _id_pos = 0;
+  _finished = false;
+}
+
+bool interval_json_source::next_chunk(std::string &out) {
+  if (_finished) {
+    return false;
+  }
+  _writer.set_output(&out);
+  while (_id_pos < _q.ids.size() && out.size() < reply_chunk_size) {
+    auto fres = _readers.find(_q.ids[_id_pos]);
+    if (fres == _readers.end() || fres->second->is_end()) {
+      ++_id_pos;
+      continue;
+    }
+    auto cursor = fres->second;
+    while (!cursor->is_end() && out.size() < reply_chunk_size) {
+      auto v = cursor->readNext();
+      if (v.inQuery(_q.ids, _q.flag, _q.from, _q.to)) {
+        _writer.apply(v);
+      }
+    }
+  }
+
+  if (_id_pos < _q.ids.size()) {
+    return true;
+  }
+  _writer.is_end();
+  _readers.clear();
+  _finished = true;
+  return false;
+}
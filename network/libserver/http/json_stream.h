@@ -0,0 +1,67 @@
+#pragma once
+
+#include <libdariadb/interfaces/icallbacks.h>
+#include <libdariadb/interfaces/icursor.h>
+#include <libdariadb/query.h>
+#include <libdariadb/scheme/ischeme.h>
+#include <libserver/http/reply.h>
+#include <libserver/net_srv_exports.h>
+#include <string>
+
+namespace dariadb {
+namespace net {
+namespace http {
+
+/// Size of one part of streamed reply body.
+const size_t reply_chunk_size = 64 * 1024;
+
+SRV_EXPORT void write_json_string(std::string &out, const std::string &s);
+SRV_EXPORT void write_json_number(std::string &out, dariadb::Value v);
+/// write {"F":flag,"T":time,"V":value}
+SRV_EXPORT void write_json_meas(std::string &out, const dariadb::Meas &m);
+
+/**
+Serialize values to {"name":[{"F":..,"T":..,"V":..},...],...} without
+building of json DOM. Values of one id must be applied one after another.
+Not thread safety.
+*/
+class meas_json_writer : public IReadCallback {
+public:
+  SRV_EXPORT meas_json_writer(const dariadb::scheme::DescriptionMap &names,
+                              std::string *out);
+  SRV_EXPORT void apply(const Meas &m) override;
+  /// close json object.
+  SRV_EXPORT void is_end() override;
+
+  void set_output(std::string *out) { _out = out; }
+
+private:
+  void open();
+
+  dariadb::scheme::DescriptionMap _names;
+  std::string *_out;
+  bool _opened;
+  bool _closed;
+  bool _has_id;
+  Id _current_id;
+};
+
+/// Streamed body of 'readInterval' reply. Values are pulled from cursors
+/// by reply_chunk_size parts, while previous part is sended.
+class interval_json_source : public reply_body_source {
+public:
+  SRV_EXPORT interval_json_source(const dariadb::scheme::DescriptionMap &names,
+                                  const QueryInterval &q, const Id2Cursor &readers);
+  SRV_EXPORT bool next_chunk(std::string &out) override;
+
+private:
+  QueryInterval _q;
+  Id2Cursor _readers;
+  meas_json_writer _writer;
+  size_t _id_pos;
+  bool _finished;
+};
+
+} // namespace http
+} // namespace net
+} // namespace dariadb
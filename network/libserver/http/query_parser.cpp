@@ -1,8 +1,11 @@
 #include <libdariadb/timeutil.h>
 #include <libdariadb/utils/logger.h>
 #include <libdariadb/utils/utils.h>
+#include <libserver/http/append_parser.h>
+#include <libserver/http/json_stream.h>
 #include <libserver/http/query_parser.h>
 #include <extern/json/src/json.hpp>
+#include <sstream>
 
 using json = nlohmann::json;
 
@@ -82,6 +85,19 @@ dariadb::net::http::parse_query(const dariadb::scheme::IScheme_Ptr &scheme,
                                 const std::string &query) {
   http_query result;
   result.type = http_query_type::unknow;
+
+  // the most frequent and the biggest query is parsed without json DOM.
+  if (query.find("\"append_value") != std::string::npos) {
+    auto values = std::make_shared<dariadb::MeasArray>();
+    append_parser fast_parser(scheme, query);
+    if (fast_parser.parse(values.get())) {
+      logger("append query: ", values->size(), " values.");
+      result.type = http_query_type::append;
+      result.append_query = values;
+      return result;
+    }
+  }
+
   json js = json::parse(query);
 
   auto find_iter = js.find("type");
@@ -122,6 +138,16 @@ dariadb::net::http::parse_query(const dariadb::scheme::IScheme_Ptr &scheme,
       ids.push_back(name_map.idByParam(v));
     }
     result.interval_query = std::make_shared<QueryInterval>(ids, flag, from, to);
+    auto step = js.find("step");
+    if (step != js.end()) {
+      result.interval_query->step = *step;
+    }
+    auto downsample = js.find("downsample");
+    if (downsample != js.end()) {
+      std::stringstream ss;
+      ss << downsample->get<std::string>();
+      ss >> result.interval_query->downsample;
+    }
     return result;
   }
 
@@ -229,25 +255,18 @@ std::string dariadb::net::http::scheme2string(const dariadb::scheme::Description
 
 std::string dariadb::net::http::meases2string(const dariadb::scheme::IScheme_Ptr &scheme,
                                               const dariadb::MeasArray &ma) {
-  auto nameMap = scheme->ls();
-  std::map<dariadb::Id, dariadb::MeasArray> values;
-  for (auto &m : ma) {
-    values[m.id].push_back(m);
-  }
-
-  json js_result;
-  for (auto &kv : values) {
-    std::list<json> js_values;
-    for (auto v : kv.second) {
-      json value_js;
-      value_js["F"] = v.flag;
-      value_js["T"] = v.time;
-      value_js["V"] = v.value;
-      js_values.push_back(value_js);
-    }
-    js_result[nameMap[kv.first].name] = js_values;
+  // writer needs values of one id side by side.
+  dariadb::MeasArray sorted(ma);
+  std::stable_sort(
+      sorted.begin(), sorted.end(),
+      [](const dariadb::Meas &l, const dariadb::Meas &r) { return l.id < r.id; });
+
+  std::string result;
+  meas_json_writer writer(scheme->ls(), &result);
+  for (auto &m : sorted) {
+    writer.apply(m);
   }
-  auto result = js_result.dump(1);
+  writer.is_end();
   return result;
 }
 
@@ -287,21 +306,53 @@ dariadb::net::http::available_functions2string(const std::vector<std::string> &f
   return result.dump(1);
 }
 
+std::string
+dariadb::net::http::metrics2string(const dariadb::utils::metrics::Snapshot &s) {
+  json result;
+  result["enabled"] = dariadb::utils::metrics::enabled();
+  result["counters"] = json::object();
+  for (auto &kv : s.counters) {
+    result["counters"][kv.first] = kv.second;
+  }
+  result["gauges"] = json::object();
+  for (auto &kv : s.gauges) {
+    result["gauges"][kv.first] = kv.second;
+  }
+  result["histograms"] = json::object();
+  for (auto &kv : s.histograms) {
+    auto &h = kv.second;
+    json js;
+    js["count"] = h.count;
+    js["sum"] = h.sum;
+    js["min"] = h.min;
+    js["max"] = h.max;
+    js["mean"] = h.mean();
+    js["p50"] = h.percentile(0.5);
+    js["p90"] = h.percentile(0.9);
+    js["p99"] = h.percentile(0.99);
+    js["p999"] = h.percentile(0.999);
+    result["histograms"][kv.first] = js;
+  }
+  return result.dump(1);
+}
+
 std::string dariadb::net::http::statCalculationResult2string(
     const dariadb::scheme::IScheme_Ptr &scheme, const dariadb::MeasArray &ma,
     const std::vector<std::string> &funcs) {
-  json result;
   if (ma.empty()) {
     return std::string();
   }
   ENSURE(ma.size() == funcs.size());
-  auto nameMap = scheme->ls();
+  std::string result;
+  result.push_back('{');
   for (size_t i = 0; i < ma.size(); ++i) {
-    json func_res;
-    func_res["F"] = ma[i].flag;
-    func_res["T"] = ma[i].time;
-    func_res["V"] = ma[i].value;
-    result[funcs[i]] = func_res;
+    if (i != 0) {
+      result.push_back(',');
+    }
+    write_json_string(result, funcs[i]);
+    result.push_back(':');
+    write_json_meas(result, ma[i]);
   }
-  return result.dump(1);
+  result.push_back('}');
+  return result;
 }
@@ -5,6 +5,7 @@
 #include <libdariadb/scheme/ischeme.h>
 #include <libdariadb/stat.h>
 #include <libdariadb/status.h>
+#include <libdariadb/utils/metrics.h>
 #include <libserver/net_srv_exports.h>
 #include <string>
 
@@ -59,6 +60,8 @@ using Name2IdPair = std::pair<std::string, dariadb::Id>;
 SRV_EXPORT std::string newScheme2string(const std::list<Name2IdPair> &new_names);
 
 SRV_EXPORT std::string available_functions2string(const std::vector<std::string> &funcs);
+/// histograms are reduced to count, sum, min, max, mean and percentiles.
+SRV_EXPORT std::string metrics2string(const dariadb::utils::metrics::Snapshot &s);
 SRV_EXPORT std::string
 statCalculationResult2string(const dariadb::scheme::IScheme_Ptr &scheme,
                              const dariadb::MeasArray &ma,
@@ -1,4 +1,6 @@
+#include <libdariadb/utils/logger.h>
 #include <libserver/http/reply.h>
+#include <cstdio>
 #include <string>
 
 namespace dariadb {
@@ -7,22 +9,23 @@ namespace http {
 
 namespace status_strings {
 
-const std::string ok = "HTTP/1.0 200 OK\r\n";
-const std::string created = "HTTP/1.0 201 Created\r\n";
-const std::string accepted = "HTTP/1.0 202 Accepted\r\n";
-const std::string no_content = "HTTP/1.0 204 No Content\r\n";
-const std::string multiple_choices = "HTTP/1.0 300 Multiple Choices\r\n";
-const std::string moved_permanently = "HTTP/1.0 301 Moved Permanently\r\n";
-const std::string moved_temporarily = "HTTP/1.0 302 Moved Temporarily\r\n";
-const std::string not_modified = "HTTP/1.0 304 Not Modified\r\n";
-const std::string bad_request = "HTTP/1.0 400 Bad Request\r\n";
-const std::string unauthorized = "HTTP/1.0 401 Unauthorized\r\n";
-const std::string forbidden = "HTTP/1.0 403 Forbidden\r\n";
-const std::string not_found = "HTTP/1.0 404 Not Found\r\n";
-const std::string internal_server_error = "HTTP/1.0 500 Internal Server Error\r\n";
-const std::string not_implemented = "HTTP/1.0 501 Not Implemented\r\n";
-const std::string bad_gateway = "HTTP/1.0 502 Bad Gateway\r\n";
-const std::string service_unavailable = "HTTP/1.0 503 Service Unavailable\r\n";
+const std::string ok = "HTTP/1.1 200 OK\r\n";
+const std::string created = "HTTP/1.1 201 Created\r\n";
+const std::string accepted = "HTTP/1.1 202 Accepted\r\n";
+const std::string no_content = "HTTP/1.1 204 No Content\r\n";
+const std::string multiple_choices = "HTTP/1.1 300 Multiple Choices\r\n";
+const std::string moved_permanently = "HTTP/1.1 301 Moved Permanently\r\n";
+const std::string moved_temporarily = "HTTP/1.1 302 Moved Temporarily\r\n";
+const std::string not_modified = "HTTP/1.1 304 Not Modified\r\n";
+const std::string bad_request = "HTTP/1.1 400 Bad Request\r\n";
+const std::string unauthorized = "HTTP/1.1 401 Unauthorized\r\n";
+const std::string forbidden = "HTTP/1.1 403 Forbidden\r\n";
+const std::string not_found = "HTTP/1.1 404 Not Found\r\n";
+const std::string request_entity_too_large = "HTTP/1.1 413 Request Entity Too Large\r\n";
+const std::string internal_server_error = "HTTP/1.1 500 Internal Server Error\r\n";
+const std::string not_implemented = "HTTP/1.1 501 Not Implemented\r\n";
+const std::string bad_gateway = "HTTP/1.1 502 Bad Gateway\r\n";
+const std::string service_unavailable = "HTTP/1.1 503 Service Unavailable\r\n";
 
 boost::asio::const_buffer to_buffer(reply::status_type status) {
   switch (status) {
@@ -50,6 +53,8 @@ boost::asio::const_buffer to_buffer(reply::status_type status) {
     return boost::asio::buffer(forbidden);
   case reply::status_type::not_found:
     return boost::asio::buffer(not_found);
+  case reply::status_type::request_entity_too_large:
+    return boost::asio::buffer(request_entity_too_large);
   case reply::status_type::internal_server_error:
     return boost::asio::buffer(internal_server_error);
   case reply::status_type::not_implemented:
@@ -69,6 +74,8 @@ namespace misc_strings {
 
 const char name_value_separator[] = {':', ' '};
 const char crlf[] = {'\r', '\n'};
+const char last_chunk[] = {'0', '\r', '\n', '\r', '\n'};
+const std::string transfer_encoding_chunked = "Transfer-Encoding: chunked\r\n";
 
 } // namespace misc_strings
 
@@ -82,11 +89,58 @@ std::vector<boost::asio::const_buffer> reply::to_buffers() {
     buffers.push_back(boost::asio::buffer(h.value));
     buffers.push_back(boost::asio::buffer(misc_strings::crlf));
   }
+  if (body_source != nullptr) {
+    if (chunked) {
+      buffers.push_back(boost::asio::buffer(misc_strings::transfer_encoding_chunked));
+    }
+    buffers.push_back(boost::asio::buffer(misc_strings::crlf));
+    return buffers;
+  }
   buffers.push_back(boost::asio::buffer(misc_strings::crlf));
   buffers.push_back(boost::asio::buffer(content));
   return buffers;
 }
 
+std::vector<boost::asio::const_buffer> reply::next_body_buffers() {
+  std::vector<boost::asio::const_buffer> buffers;
+  if (body_source == nullptr || body_finished_) {
+    return buffers;
+  }
+
+  body_chunk_.clear();
+  while (body_chunk_.empty() && !body_finished_) {
+    try {
+      body_finished_ = !body_source->next_chunk(body_chunk_);
+    } catch (const std::exception &ex) {
+      // status line is already sent, so the body must not look complete.
+      logger_fatal("http: reply body error: ", ex.what());
+      body_finished_ = true;
+      body_failed_ = true;
+      return buffers;
+    }
+  }
+
+  if (!chunked) {
+    if (!body_chunk_.empty()) {
+      buffers.push_back(boost::asio::buffer(body_chunk_));
+    }
+    return buffers;
+  }
+
+  if (!body_chunk_.empty()) {
+    char size_line[32];
+    auto len = std::snprintf(size_line, sizeof(size_line), "%zx\r\n", body_chunk_.size());
+    chunk_size_line_.assign(size_line, len);
+    buffers.push_back(boost::asio::buffer(chunk_size_line_));
+    buffers.push_back(boost::asio::buffer(body_chunk_));
+    buffers.push_back(boost::asio::buffer(misc_strings::crlf));
+  }
+  if (body_finished_) {
+    buffers.push_back(boost::asio::buffer(misc_strings::last_chunk));
+  }
+  return buffers;
+}
+
 reply reply::stock_reply(const std::string &content, reply::status_type status) {
   reply rep;
   rep.status = status;
@@ -99,6 +153,16 @@ reply reply::stock_reply(const std::string &content, reply::status_type status)
   return rep;
 }
 
+reply reply::stream_reply(const reply_body_source_ptr &source, status_type status) {
+  reply rep;
+  rep.status = status;
+  rep.body_source = source;
+  rep.headers.resize(1);
+  rep.headers[0].name = "Content-Type";
+  rep.headers[0].value = "application/json";
+  return rep;
+}
+
 } // namespace http
 } // namespace net
 } // namespace dariadb
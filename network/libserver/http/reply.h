@@ -1,6 +1,7 @@
 #pragma once
 #include <libserver/http/header.h>
 #include <boost/asio.hpp>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -8,6 +9,16 @@ namespace dariadb {
 namespace net {
 namespace http {
 
+/// Source of a reply body, which is generated while the reply is sent.
+class reply_body_source {
+public:
+  virtual ~reply_body_source() {}
+  /// Append next part of the body to 'out'. Return false, when body is over.
+  virtual bool next_chunk(std::string &out) = 0;
+};
+
+using reply_body_source_ptr = std::shared_ptr<reply_body_source>;
+
 /// A reply to be sent to a client.
 struct reply {
   /// The status of the reply.
@@ -24,6 +35,7 @@ struct reply {
     unauthorized = 401,
     forbidden = 403,
     not_found = 404,
+    request_entity_too_large = 413,
     internal_server_error = 500,
     not_implemented = 501,
     bad_gateway = 502,
@@ -36,13 +48,37 @@ struct reply {
   /// The content to be sent in the reply.
   std::string content;
 
+  /// If not null, 'content' is ignored and the body is read from the source.
+  reply_body_source_ptr body_source;
+
+  /// Send body_source with chunked transfer-encoding. Otherwise the end of
+  /// body is marked by connection closing (HTTP/1.0 clients).
+  bool chunked = false;
+
   /// Convert the reply into a vector of buffers. The buffers do not own the
   /// underlying memory blocks, therefore the reply object must remain valid and
   /// not be changed until the write operation has completed.
+  /// For a streamed reply only the status line and headers are returned.
   std::vector<boost::asio::const_buffer> to_buffers();
 
+  /// Next part of streamed body. Empty, when all body was returned or
+  /// the body source failed.
+  std::vector<boost::asio::const_buffer> next_body_buffers();
+
+  /// True, if the body source failed and the body is not complete.
+  bool body_failed() const { return body_failed_; }
+
   /// Get a stock reply.
   static reply stock_reply(const std::string &content, status_type status);
+
+  /// Get a reply with body generated by the source.
+  static reply stream_reply(const reply_body_source_ptr &source, status_type status);
+
+private:
+  std::string body_chunk_;
+  std::string chunk_size_line_;
+  bool body_finished_ = false;
+  bool body_failed_ = false;
 };
 
 } // namespace http
@@ -11,6 +11,7 @@ namespace http {
 struct request {
   std::string method;
   std::string uri;
+  std::string version; // "HTTP/1.0" or "HTTP/1.1"
   std::vector<header> headers;
 
   std::string query; // all values after headers.
@@ -1,6 +1,7 @@
 #include <libdariadb/statistic/calculator.h>
 #include <libdariadb/timeutil.h>
 #include <libdariadb/utils/logger.h>
+#include <libserver/http/json_stream.h>
 #include <libserver/http/query_parser.h>
 #include <libserver/http/reply.h>
 #include <libserver/http/request.h>
@@ -33,8 +34,10 @@ void interval_query(dariadb::scheme::IScheme_Ptr scheme,
                   dariadb::timeutil::to_string(q.interval_query->from),
                   " to:", dariadb::timeutil::to_string(q.interval_query->to));
 
-  auto values = storage_engine->readInterval(*q.interval_query.get());
-  rep = reply::stock_reply(meases2string(scheme, values), reply::status_type::ok);
+  auto readers = storage_engine->intervalReader(*q.interval_query.get());
+  auto body =
+      std::make_shared<interval_json_source>(scheme->ls(), *q.interval_query, readers);
+  rep = reply::stream_reply(body, reply::status_type::ok);
 }
 
 void timepoint_query(dariadb::scheme::IScheme_Ptr scheme,
@@ -185,6 +188,11 @@ void request_handler::handle_request(const request &req, reply &rep) {
         return;
       }
     }
+    if (req.uri == "/metrics") {
+      auto answer = metrics2string(_storage_engine->metrics());
+      rep = reply::stock_reply(answer, reply::status_type::ok);
+      return;
+    }
     if (req.uri == "/statfuncs") {
       auto available_funcstions = dariadb::statistic::FunctionFactory::functions();
       auto answer = available_functions2string(available_funcstions);
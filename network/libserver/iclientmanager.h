@@ -11,6 +11,8 @@ public:
   virtual void write_end() = 0;
   virtual bool server_begin_stopping() const = 0;
   virtual void addWritedCount(size_t count) = 0;
+  /// true - if drop queues of storage are saturated.
+  virtual bool storage_overloaded() const = 0;
   virtual ~IClientManager() {}
 };
 }
@@ -290,8 +290,16 @@ void IOClient::sendOk(QueryNumber query_num) {
   _async_connection->send(ok_nd);
 }
 
+void IOClient::sendSlowDown(QueryNumber query_num) {
+  auto nd = std::make_shared<NetData>(DATA_KINDS::SLOW_DOWN);
+  auto qh = reinterpret_cast<QueryOk_header *>(nd->data);
+  qh->id = query_num;
+  nd->size = sizeof(QueryOk_header);
+  _async_connection->send(nd);
+}
+
 void IOClient::sendError(QueryNumber query_num, const ERRORS &err) {
-  auto err_nd = std::make_shared<NetData>(DATA_KINDS::OK);
+  auto err_nd = std::make_shared<NetData>(DATA_KINDS::ERR);
   auto qh = reinterpret_cast<QueryError_header *>(err_nd->data);
   qh->id = query_num;
   qh->error_code = (uint16_t)err;
@@ -311,6 +319,8 @@ void IOClient::append(const NetData_ptr &d) {
   if (ar.ignored != size_t(0)) {
     logger_info("server: write error - ", ar.error);
     sendError(hdr->id, ERRORS::APPEND_ERROR);
+  } else if (env->srv->storage_overloaded()) {
+    sendSlowDown(hdr->id);
   } else {
     sendOk(hdr->id);
   }
@@ -337,7 +347,9 @@ void IOClient::readInterval(const NetData_ptr &d) {
     sendError(query_num, ERRORS::WRONG_QUERY_PARAM_FROM_GE_TO);
   } else {
 
-    auto qi = new QueryInterval{all_ids, query_hdr->flag, query_hdr->from, query_hdr->to};
+    auto qi = new QueryInterval{all_ids,         query_hdr->flag,
+                                query_hdr->from, query_hdr->to,
+                                query_hdr->step, DOWNSAMPLE(query_hdr->downsample)};
 
     auto cdr = new ClientDataReader(this, query_num);
     cdr->linked_query_interval = qi;
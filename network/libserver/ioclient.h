@@ -65,6 +65,7 @@ struct IOClient {
   void currentValue(const NetData_ptr &d);
   void subscribe(const NetData_ptr &d);
   void sendOk(QueryNumber query_num);
+  void sendSlowDown(QueryNumber query_num);
   void sendError(QueryNumber query_num, const ERRORS &err);
 
   void readerAdd(const ReaderCallback_ptr &cdr);
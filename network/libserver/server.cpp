@@ -22,19 +22,21 @@ using namespace dariadb::net;
 typedef boost::shared_ptr<ip::tcp::acceptor> acceptor_ptr;
 
 const int INFO_TIMER_INTERVAL = 10000;
+const int OVERLOAD_TIMER_INTERVAL = 100;
 const int MAX_MISSED_PINGS = 100;
 
 class Server::Private : public IClientManager {
 public:
   Private(const Server::Param &p)
       : _signals(_service, SIGINT, SIGTERM, SIGABRT), _params(p), _is_runned_flag(false),
-        _ping_timer(_service), _info_timer(_service) {
+        _ping_timer(_service), _info_timer(_service), _overload_timer(_service) {
     _active_workers.store(0);
     _stop_flag = false;
     _in_stop_logic = false;
     _next_client_id = 1;
     _connections_accepted.store(0);
     _writes_in_progress.store(0);
+    _storage_overloaded.store(false);
 
     _env.srv = this;
     _env.service = &_service;
@@ -44,7 +46,8 @@ public:
     _signals.async_wait(std::bind(&Server::Private::signal_handler, this, _1, _2));
 
     _http_server = std::make_unique<http::http_server>(
-        "localhost", std::to_string(p.http_port), &_service, this);
+        "localhost", std::to_string(p.http_port), &_service, this, p.http_workers,
+        p.http_max_request_size);
   }
 
   ~Private() {
@@ -75,6 +78,7 @@ public:
     _ping_timer.cancel();
     logger("server: stop info timer...");
     _info_timer.cancel();
+    _overload_timer.cancel();
     while (_writes_in_progress.load() != 0) {
       dariadb::utils::sleep_mls(300);
       logger_info("server: writes in progress ", _writes_in_progress.load());
@@ -131,6 +135,7 @@ public:
 
     reset_ping_timer();
     reset_info_timer();
+    reset_overload_timer();
 
     ip::tcp::endpoint ep(ip::tcp::v4(), _params.port);
     _acc = acceptor_ptr{new ip::tcp::acceptor(_service, ep)};
@@ -253,6 +258,7 @@ public:
   void write_begin() override { _writes_in_progress++; }
   void write_end() override { _writes_in_progress--; }
   bool server_begin_stopping() const override { return _in_stop_logic; }
+  bool storage_overloaded() const override { return _storage_overloaded.load(); }
 
   void reset_ping_timer() {
     try {
@@ -332,6 +338,42 @@ public:
     reset_info_timer();
   }
 
+  void reset_overload_timer() {
+    try {
+      _overload_timer.expires_from_now(
+          boost::posix_time::millisec(OVERLOAD_TIMER_INTERVAL));
+      _overload_timer.async_wait(std::bind(&Server::Private::check_overload, this, _1));
+    } catch (std::exception &ex) {
+      THROW_EXCEPTION("server: reset_overload_timer - ", ex.what());
+    }
+  }
+
+  /// clients get SLOW_DOWN instead of OK, while the storage can't drop
+  /// values to disk so fast as they are writed.
+  void check_overload(const boost::system::error_code &ec) {
+    if (ec == boost::asio::error::operation_aborted || _in_stop_logic) {
+      return;
+    }
+    auto storage = _env.storage;
+    bool overloaded = false;
+    if (storage != nullptr) {
+      auto d = storage->description();
+      if (d.dropper.wal >= _params.overload_wal_queue) {
+        overloaded = true;
+      }
+      if (d.memstorage.allocator_capacity_bytes != size_t(0) &&
+          d.memstorage.allocated_bytes + d.memstorage.cached_bytes >=
+              d.memstorage.allocator_capacity_bytes * _params.overload_memory_fill) {
+        overloaded = true;
+      }
+    }
+    if (overloaded != _storage_overloaded.load()) {
+      logger_info("server: storage overloaded - ", overloaded);
+    }
+    _storage_overloaded.store(overloaded);
+    reset_overload_timer();
+  }
+
   io_service _service;
   boost::asio::signal_set _signals;
   acceptor_ptr _acc;
@@ -352,6 +394,8 @@ public:
 
   deadline_timer _ping_timer;
   deadline_timer _info_timer;
+  deadline_timer _overload_timer;
+  std::atomic_bool _storage_overloaded;
 
   IOClient::Environment _env;
   std::atomic_int _writes_in_progress;
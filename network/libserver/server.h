@@ -9,6 +9,10 @@ namespace dariadb {
 namespace net {
 
 const size_t SERVER_IO_THREADS_DEFAULT = 3;
+const size_t SERVER_HTTP_WORKERS_DEFAULT = 3;
+const size_t SERVER_HTTP_MAX_REQUEST_SIZE_DEFAULT = 64 * 1024 * 1024;
+const size_t SERVER_OVERLOAD_WAL_QUEUE_DEFAULT = 4;
+const float SERVER_OVERLOAD_MEMORY_FILL_DEFAULT = 0.95f;
 
 class Server {
 public:
@@ -16,16 +20,32 @@ public:
     unsigned short port;
     unsigned short http_port;
     size_t io_threads;
+    /// threads for http requests handling. if 0, requests handled in io threads.
+    size_t http_workers;
+    /// max size of http request body in bytes.
+    size_t http_max_request_size;
+    /// wal files waiting for drop, when clients are asked to slow down.
+    size_t overload_wal_queue;
+    /// memstorage fill percent, when clients are asked to slow down.
+    float overload_memory_fill;
     Param(unsigned short _port, unsigned short _http_port) {
       port = _port;
       http_port = _http_port;
       io_threads = SERVER_IO_THREADS_DEFAULT;
+      http_workers = SERVER_HTTP_WORKERS_DEFAULT;
+      http_max_request_size = SERVER_HTTP_MAX_REQUEST_SIZE_DEFAULT;
+      overload_wal_queue = SERVER_OVERLOAD_WAL_QUEUE_DEFAULT;
+      overload_memory_fill = SERVER_OVERLOAD_MEMORY_FILL_DEFAULT;
     }
 
     Param(unsigned short _port, unsigned short _http_port, size_t io_threads_count) {
       port = _port;
       http_port = _http_port;
       io_threads = io_threads_count;
+      http_workers = SERVER_HTTP_WORKERS_DEFAULT;
+      http_max_request_size = SERVER_HTTP_MAX_REQUEST_SIZE_DEFAULT;
+      overload_wal_queue = SERVER_OVERLOAD_WAL_QUEUE_DEFAULT;
+      overload_memory_fill = SERVER_OVERLOAD_MEMORY_FILL_DEFAULT;
     }
   };
   SRV_EXPORT Server(const Param &p);
@@ -16,4 +16,20 @@ void SubscribeCallback::send_buffer(const Meas &m) {
   nd->size = static_cast<NetData::MessageSize>(size_to_write);
 
   _parent->_async_connection->send(nd);
-}
\ No newline at end of file
+}
+
+void SubscribeCallback::apply_batch(const MeasArray &ma) {
+  size_t pos = 0;
+  while (pos < ma.size()) {
+    auto nd = std::make_shared<NetData>(DATA_KINDS::APPEND);
+    auto hdr = reinterpret_cast<QueryAppend_header *>(&nd->data);
+    hdr->id = _query_num;
+    size_t space_left = 0;
+    pos += QueryAppend_header::make_query(hdr, ma.data(), ma.size(), pos, &space_left);
+
+    auto size_to_write = NetData::MAX_MESSAGE_SIZE - MARKER_SIZE - space_left;
+    nd->size = static_cast<NetData::MessageSize>(size_to_write);
+
+    _parent->_async_connection->send(nd);
+  }
+}
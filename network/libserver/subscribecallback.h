@@ -18,6 +18,8 @@ struct SubscribeCallback : public IReadCallback {
   }
   ~SubscribeCallback() {}
   void apply(const Meas &m) override { send_buffer(m); }
+  /// values are packed to as few frames as possible.
+  void apply_batch(const MeasArray &ma) override;
   void is_end() override { IReadCallback::is_end(); }
   void send_buffer(const Meas &m);
 };
@@ -1,6 +1,7 @@
 #include <gtest/gtest.h>
 
 #include <libdariadb/compression/bytebuffer.h>
+#include <libdariadb/compression/codecs.h>
 #include <libdariadb/compression/compression.h>
 #include <libdariadb/compression/delta.h>
 #include <libdariadb/compression/flag.h>
@@ -9,6 +10,7 @@
 
 #include <algorithm>
 #include <chrono>
+#include <cmath>
 #include <iterator>
 
 using dariadb::compression::ByteBuffer;
@@ -492,3 +494,76 @@ TEST(Compression, CompressedBlockV2Test) {
     EXPECT_TRUE(m.value == r_m.value);
   }
 }
+
+TEST(Compression, ColumnCodecs) {
+  using dariadb::compression::CODEC;
+  using dariadb::compression::CodecRegistry;
+  using dariadb::compression::Column;
+
+  auto flat = [](double v) {
+    return uint64_t(dariadb::compression::inner::flat_double_to_int(v));
+  };
+
+  std::vector<std::pair<Column, CODEC>> columns;
+  Column regular, constant, jitter, decimal, randoms;
+  auto t = dariadb::timeutil::current_time();
+  for (uint64_t i = 0; i < 200; ++i) {
+    regular.push_back(t + i * 1000);
+    constant.push_back(flat(36.6));
+    jitter.push_back(t + i * 1000 + (i % 7) + (i == 100 ? 1000000 : 0));
+    decimal.push_back(flat(double(int(i * 37 % 1000) - 500) / 100));
+    randoms.push_back(flat(std::sin(double(i)) * 1e10 / 3));
+  }
+  columns.push_back({regular, CODEC::REGULAR});
+  // constant decimal is scaled to constant integer: zero width deltas.
+  columns.push_back({constant, CODEC::SCALED_FOR});
+  columns.push_back({jitter, CODEC::DELTA_FOR});
+  columns.push_back({decimal, CODEC::SCALED_FOR});
+  columns.push_back({randoms, CODEC::XOR});
+  columns.push_back({Column{flat(-0.0), flat(1.5)}, CODEC::XOR});
+
+  for (auto &kv : columns) {
+    auto &c = kv.first;
+    // each codec decodes own result.
+    for (auto codec : CodecRegistry::codecs()) {
+      std::vector<uint8_t> out;
+      if (!codec->encode(c, out)) {
+        continue;
+      }
+      Column readed(c.size());
+      auto end = codec->decode(out.data(), out.data() + out.size(), c.size(),
+                               readed.data());
+      EXPECT_EQ(end, out.data() + out.size()) << codec->name();
+      EXPECT_EQ(readed, c) << codec->name();
+    }
+    std::vector<uint8_t> best;
+    auto kind = CodecRegistry::encodeBest(c, best);
+    if (kv.second != CODEC::XOR) {
+      EXPECT_EQ(kind, kv.second);
+    }
+    EXPECT_EQ(best.front(), uint8_t(kind));
+    EXPECT_LT(best.size(), c.size() * sizeof(uint64_t));
+  }
+  EXPECT_THROW(CodecRegistry::get(CODEC(0)), std::exception);
+
+  dariadb::MeasArray ma;
+  for (size_t i = 0; i < regular.size(); ++i) {
+    dariadb::Meas m(2);
+    m.time = regular[i];
+    m.value = dariadb::Value(i % 3);
+    m.flag = dariadb::Flag(i / 50);
+    ma.push_back(m);
+  }
+  std::vector<uint8_t> packed(3, uint8_t(0xff)); // columns are readed from the end.
+  dariadb::compression::packColumns(ma, packed);
+  EXPECT_LT(packed.size(), size_t(100));
+  auto readed = dariadb::compression::unpackColumns(
+      2, packed.data(), packed.data() + packed.size(), ma.size());
+  ASSERT_EQ(readed.size(), ma.size());
+  for (size_t i = 0; i < ma.size(); ++i) {
+    EXPECT_EQ(readed[i].id, ma[i].id);
+    EXPECT_EQ(readed[i].time, ma[i].time);
+    EXPECT_EQ(readed[i].value, ma[i].value);
+    EXPECT_EQ(readed[i].flag, ma[i].flag);
+  }
+}
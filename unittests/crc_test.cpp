@@ -1,6 +1,9 @@
 #include <libdariadb/utils/crc.h>
 #include <gtest/gtest.h>
 
+#include <string>
+#include <vector>
+
 class CrcTest : public testing::Test {
 protected:
   virtual void SetUp() {
@@ -25,3 +28,36 @@ TEST_F(CrcTest, NotEqualToSourc) {
 
   EXPECT_NE(crc32_1, uint32_t(value));
 }
+
+TEST_F(CrcTest, KnownValues) {
+  const std::string check = "123456789";
+  EXPECT_EQ(dariadb::utils::crc32(check.data(), check.size()), uint32_t(0xCBF43926));
+  EXPECT_EQ(dariadb::utils::crc32c(check.data(), check.size()), uint32_t(0xE3069283));
+  EXPECT_EQ(dariadb::utils::crc32(check.data(), 0), uint32_t(0));
+  EXPECT_EQ(dariadb::utils::crc32c(check.data(), 0), uint32_t(0));
+}
+
+TEST_F(CrcTest, UnalignedBuffers) {
+  // bitwise implementation as reference.
+  auto reference = [](const uint8_t *p, size_t sz, uint32_t poly) {
+    uint32_t crc = 0xFFFFFFFF;
+    for (size_t i = 0; i < sz; ++i) {
+      crc ^= p[i];
+      for (int k = 0; k < 8; ++k) {
+        crc = (crc & 1) ? (crc >> 1) ^ poly : (crc >> 1);
+      }
+    }
+    return ~crc;
+  };
+  std::vector<uint8_t> data(1031);
+  for (size_t i = 0; i < data.size(); ++i) {
+    data[i] = uint8_t(i * 131 + 7);
+  }
+  for (size_t offset = 0; offset < 9; ++offset) {
+    for (size_t sz : {0, 1, 7, 8, 63, 1000}) {
+      auto p = data.data() + offset;
+      EXPECT_EQ(dariadb::utils::crc32(p, sz), reference(p, sz, 0xEDB88320));
+      EXPECT_EQ(dariadb::utils::crc32c(p, sz), reference(p, sz, 0x82F63B78));
+    }
+  }
+}
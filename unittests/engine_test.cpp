@@ -7,12 +7,14 @@
 #include <libdariadb/timeutil.h>
 #include <libdariadb/utils/fs.h>
 #include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <iostream>
 
 class BenchCallback : public dariadb::IReadCallback {
 public:
   BenchCallback() { count = 0; }
-  void call(const dariadb::Meas &) { count++; }
+  void apply(const dariadb::Meas &) override { count++; }
   size_t count;
 };
 
@@ -79,6 +81,8 @@ TEST(Engine, Common_test) {
     ms->fsck();
 
     ms->wait_all_asyncs();
+    // readers do not wait for the dropper, so all wal files are dropped explicitly.
+    ms->compress_all();
 
     // check first id, because that Id placed in compressed pages.
     auto values = ms->readInterval(QueryInterval({dariadb::Id(0)}, 0, from, to));
@@ -160,6 +164,40 @@ TEST(Engine, Subscribe) {
   }
 }
 
+class SlowSubscribeClbk : public dariadb::IReadCallback {
+public:
+  SlowSubscribeClbk() { calls = 0; }
+  void apply(const dariadb::Meas &) override {}
+  void apply_batch(const dariadb::MeasArray &ma) override {
+    dariadb::utils::sleep_mls(300);
+    calls += ma.size();
+  }
+  std::atomic_size_t calls;
+};
+
+TEST(Engine, SubscribeSlowClient) {
+  auto settings = dariadb::storage::Settings::create();
+  dariadb::IEngine_Ptr ms = std::make_shared<dariadb::Engine>(settings);
+
+  auto slow = std::make_shared<SlowSubscribeClbk>();
+  ms->subscribe(dariadb::IdArray{}, 0, slow);
+
+  const size_t total_count = 1000;
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < total_count; ++i) {
+    dariadb::Meas m;
+    m.id = dariadb::Id(i % 10);
+    m.time = dariadb::Time(i);
+    ms->append(m);
+  }
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  // ingest does not wait the subscriber.
+  EXPECT_LT(std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count(), 250);
+
+  ms->flush();
+  EXPECT_EQ(slow->calls.load(), total_count);
+}
+
 TEST(Engine, MemStorage_common_test) {
   const std::string storage_path = "testStorage";
   const size_t chunk_size = 128;
@@ -231,6 +269,42 @@ TEST(Engine, MemOnlyStorage_common_test) {
   }
 }
 
+TEST(Engine, Downsampling) {
+  using namespace dariadb;
+  using namespace dariadb::storage;
+
+  auto settings = dariadb::storage::Settings::create();
+  settings->chunk_size.setValue(128);
+  dariadb::IEngine_Ptr ms{new Engine(settings)};
+  auto m = Meas(1);
+  for (Time t = 0; t < 10000; ++t) {
+    m.time = t;
+    m.value = Value(t % 100);
+    ms->append(m);
+  }
+
+  QueryInterval q({Id(1)}, Flag(0), Time(0), Time(9999), Time(1000));
+  auto avg = ms->readInterval(q);
+  ASSERT_EQ(avg.size(), size_t(10));
+  for (size_t i = 0; i < avg.size(); ++i) {
+    EXPECT_EQ(avg[i].time, Time(i * 1000));
+    EXPECT_NEAR(avg[i].value, 49.5, 0.0001);
+  }
+
+  q.downsample = DOWNSAMPLE::M4;
+  auto m4 = ms->readInterval(q);
+  // first, min (first too), max and last of every bucket.
+  ASSERT_EQ(m4.size(), size_t(30));
+  EXPECT_EQ(m4[0].time, Time(0));
+  EXPECT_EQ(m4[1].value, Value(99));
+  EXPECT_EQ(m4[2].time, Time(999));
+
+  BenchCallback clbk;
+  ms->foreach (q, &clbk);
+  clbk.wait();
+  EXPECT_EQ(clbk.count, m4.size());
+}
+
 TEST(Engine, Cache_common_test) {
   const std::string storage_path = "testStorage";
 
@@ -260,6 +334,7 @@ TEST(Engine, Cache_common_test) {
     test_statistic_on_engine(ms);
     auto descr = ms->description();
     EXPECT_GT(descr.pages_count, size_t(0));
+    ms->compress_all();
 
     {
       ms->eraseOld(dariadb::Id(0), dariadb::MAX_TIME);
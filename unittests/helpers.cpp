@@ -469,6 +469,8 @@ void subscribe_test(dariadb::IEngine *ms) {
     m.value = 0;
     ms->append(m);
   }
+  // subscribers are notified asynchronously.
+  ms->flush();
   if (c1->values.size() != total_count) {
     THROW_EXCEPTION("c1->values.size() != total_count", c1->values.size(), total_count);
   }
@@ -13,9 +13,14 @@ using json = nlohmann::json;
 
 #include "../network/common/net_data.h"
 #include <libdariadb/dariadb.h>
+#include <libdariadb/storage/cursors.h>
+#include <libserver/http/append_parser.h>
+#include <libserver/http/json_stream.h>
+#include <libserver/http/reply.h>
 #include <libserver/server.h>
 
 #include <istream>
+#include <limits>
 #include <ostream>
 #include <string>
 
@@ -401,6 +406,13 @@ TEST(Http, Test) {
                 std::string::npos);
   }
 
+  {
+    auto metrics_res = GET(test_service, http_port, "/metrics");
+    EXPECT_TRUE(metrics_res.answer.find("histograms") != std::string::npos);
+    EXPECT_TRUE(metrics_res.answer.find("engine.append_ns") != std::string::npos);
+    EXPECT_TRUE(metrics_res.answer.find("engine.wal_files") != std::string::npos);
+  }
+
   { // statistic calculator
     json stat_js;
     stat_js["type"] = "statistic";
@@ -443,6 +455,65 @@ TEST(Http, Test) {
     EXPECT_EQ(post_result.code, 204); // no content
   }
 
+  { // keep-alive connection with pipelined requests
+    tcp::resolver resolver(test_service);
+    tcp::socket socket(test_service);
+    boost::asio::connect(socket,
+                         resolver.resolve(tcp::resolver::query("localhost", http_port)));
+
+    auto make_request = [](const std::string &body) {
+      std::stringstream ss;
+      ss << "POST / HTTP/1.1\r\n";
+      ss << "Host: localhost\r\n";
+      ss << "Content-Length: " << body.size() << "\r\n\r\n";
+      ss << body;
+      return ss.str();
+    };
+
+    boost::asio::streambuf response;
+    auto read_reply = [&socket, &response]() {
+      boost::asio::read_until(socket, response, "\r\n\r\n");
+      std::istream response_stream(&response);
+      std::string http_version;
+      int status_code;
+      response_stream >> http_version >> status_code;
+      EXPECT_EQ(status_code, 200);
+      std::string header;
+      size_t content_length = 0;
+      std::getline(response_stream, header);
+      while (std::getline(response_stream, header) && header != "\r") {
+        EXPECT_TRUE(header.find("Connection: close") == std::string::npos);
+        if (header.find("Content-Length: ") == 0) {
+          content_length = std::stoull(header.substr(16));
+        }
+      }
+      if (response.size() < content_length) {
+        auto rest = content_length - response.size();
+        boost::asio::read(socket, response, boost::asio::transfer_exactly(rest));
+      }
+      auto data = response.data();
+      std::string body(boost::asio::buffers_begin(data),
+                       boost::asio::buffers_begin(data) + content_length);
+      response.consume(content_length);
+      return body;
+    };
+
+    json add_param_js;
+    add_param_js["type"] = "scheme";
+    add_param_js["add"] = {"pipelined1"};
+    auto pipelined = make_request(add_param_js.dump());
+    add_param_js["add"] = {"pipelined2"};
+    pipelined += make_request(add_param_js.dump());
+    boost::asio::write(socket, boost::asio::buffer(pipelined));
+
+    EXPECT_TRUE(read_reply().find("pipelined1") != std::string::npos);
+    EXPECT_TRUE(read_reply().find("pipelined2") != std::string::npos);
+
+    add_param_js["add"] = {"pipelined3"};
+    boost::asio::write(socket, boost::asio::buffer(make_request(add_param_js.dump())));
+    EXPECT_TRUE(read_reply().find("pipelined3") != std::string::npos);
+  }
+
   //// bad query
   // try {
   //  json stat_js;
@@ -461,3 +532,196 @@ TEST(Http, Test) {
   http_server_instance->stop();
   server_thread.join();
 }
+
+TEST(Http, JsonStream) {
+  dariadb::scheme::DescriptionMap names;
+  names[0].name = "first";
+  names[1].name = "second\"quoted";
+
+  // big enough for several chunks.
+  const size_t count = 10000;
+  dariadb::MeasArray ma0, ma1;
+  for (size_t i = 0; i < count; ++i) {
+    dariadb::Meas m;
+    m.id = 0;
+    m.time = i;
+    m.flag = dariadb::Flag(i % 3);
+    m.value = dariadb::Value(i) / 3.0;
+    ma0.push_back(m);
+    m.id = 1;
+    ma1.push_back(m);
+  }
+
+  dariadb::Id2Cursor readers;
+  readers[0] = std::make_shared<dariadb::storage::FullCursor>(ma0);
+  readers[1] = std::make_shared<dariadb::storage::FullCursor>(ma1);
+
+  dariadb::QueryInterval qi({0, 1}, 0, dariadb::MIN_TIME, dariadb::MAX_TIME);
+  dariadb::net::http::interval_json_source source(names, qi, readers);
+
+  std::string body;
+  size_t chunks = 0;
+  while (true) {
+    std::string chunk;
+    auto has_more = source.next_chunk(chunk);
+    EXPECT_LE(chunk.size(), dariadb::net::http::reply_chunk_size * 2);
+    body += chunk;
+    chunks++;
+    if (!has_more) {
+      break;
+    }
+  }
+  EXPECT_GT(chunks, size_t(1));
+
+  auto js = json::parse(body);
+  auto first = js["first"];
+  auto second = js["second\"quoted"];
+  EXPECT_EQ(first.size(), count);
+  EXPECT_EQ(second.size(), count);
+  for (size_t i = 0; i < count; ++i) {
+    dariadb::Time t = first[i]["T"];
+    dariadb::Flag f = first[i]["F"];
+    dariadb::Value v = first[i]["V"];
+    EXPECT_EQ(t, ma0[i].time);
+    EXPECT_EQ(f, ma0[i].flag);
+    EXPECT_EQ(v, ma0[i].value);
+  }
+
+  std::string empty_body;
+  dariadb::net::http::interval_json_source empty_source(names, qi, dariadb::Id2Cursor());
+  EXPECT_FALSE(empty_source.next_chunk(empty_body));
+  EXPECT_EQ(empty_body, "{}");
+}
+
+TEST(Http, ReplyBodyError) {
+  struct failed_source : public dariadb::net::http::reply_body_source {
+    bool next_chunk(std::string &out) override {
+      if (calls++ != 0) {
+        out += "partial";
+        throw std::logic_error("failed source");
+      }
+      out += "first";
+      return true;
+    }
+    size_t calls = 0;
+  };
+
+  auto rep = dariadb::net::http::reply::stream_reply(
+      std::make_shared<failed_source>(), dariadb::net::http::reply::status_type::ok);
+  rep.chunked = true;
+  EXPECT_EQ(rep.next_body_buffers().size(), size_t(3));
+  EXPECT_FALSE(rep.body_failed());
+
+  EXPECT_TRUE(rep.next_body_buffers().empty());
+  EXPECT_TRUE(rep.body_failed());
+  EXPECT_TRUE(rep.next_body_buffers().empty());
+}
+
+TEST(Http, AppendParser) {
+  auto settings = dariadb::storage::Settings::create();
+  auto data_scheme = dariadb::scheme::Scheme::create(settings);
+
+  const size_t count = 1000;
+  std::vector<dariadb::Flag> flags;
+  std::vector<dariadb::Value> vals;
+  std::vector<dariadb::Time> times;
+  for (size_t i = 0; i < count; ++i) {
+    flags.push_back(dariadb::Flag(i));
+    vals.push_back(dariadb::Value(i) / 7.0);
+    times.push_back(dariadb::MAX_TIME - i);
+  }
+
+  json js;
+  json js_values;
+  // times before flags: order of arrays is not fixed.
+  js_values["first"]["T"] = times;
+  js_values["first"]["F"] = flags;
+  js_values["first"]["V"] = vals;
+  js_values["sec\"ond"]["V"] = vals;
+  js_values["sec\"ond"]["T"] = times;
+  js_values["sec\"ond"]["F"] = flags;
+  js_values["empty"]["V"] = std::vector<dariadb::Value>();
+  js["append_values"] = js_values;
+  js["type"] = "append";
+
+  auto query = js.dump(1);
+  dariadb::MeasArray result;
+  dariadb::net::http::append_parser parser(data_scheme, query);
+  EXPECT_TRUE(parser.parse(&result));
+  EXPECT_EQ(result.size(), count * 2);
+
+  auto names = data_scheme->ls();
+  auto first_id = names.idByParam("first");
+  auto second_id = names.idByParam("sec\"ond");
+  EXPECT_NE(first_id, dariadb::MAX_ID);
+  EXPECT_NE(second_id, dariadb::MAX_ID);
+
+  size_t first_count = 0, second_count = 0;
+  for (auto &m : result) {
+    size_t i = dariadb::MAX_TIME - m.time;
+    EXPECT_LT(i, count);
+    EXPECT_EQ(m.flag, flags[i]);
+    EXPECT_EQ(m.value, vals[i]);
+    if (m.id == first_id) {
+      first_count++;
+    } else {
+      EXPECT_EQ(m.id, second_id);
+      second_count++;
+    }
+  }
+  EXPECT_EQ(first_count, count);
+  EXPECT_EQ(second_count, count);
+
+  { // single value
+    json single_js;
+    single_js["type"] = "append";
+    single_js["append_value"] = {{"T", 10}, {"F", 2}, {"V", 3.5}, {"I", "single"}};
+    auto single_query = single_js.dump();
+    dariadb::MeasArray single_result;
+    dariadb::net::http::append_parser single_parser(data_scheme, single_query);
+    EXPECT_TRUE(single_parser.parse(&single_result));
+    EXPECT_EQ(single_result.size(), size_t(1));
+    EXPECT_EQ(single_result.front().id, data_scheme->ls().idByParam("single"));
+    EXPECT_EQ(single_result.front().time, dariadb::Time(10));
+    EXPECT_EQ(single_result.front().flag, dariadb::Flag(2));
+    EXPECT_EQ(single_result.front().value, dariadb::Value(3.5));
+  }
+
+  { // not append
+    std::string other_query = "{\"type\":\"stat\", \"id\":\"first\", \"from\":0}";
+    dariadb::MeasArray other_result;
+    dariadb::net::http::append_parser other_parser(data_scheme, other_query);
+    EXPECT_FALSE(other_parser.parse(&other_result));
+  }
+
+  { // bad json
+    std::string bad_query = "{\"type\":\"append\", \"append_values\":{\"first\":[}";
+    dariadb::MeasArray bad_result;
+    dariadb::net::http::append_parser bad_parser(data_scheme, bad_query);
+    EXPECT_THROW(bad_parser.parse(&bad_result), std::exception);
+  }
+
+  { // not json numbers and out of range values
+    std::vector<std::string> bad_values = {
+        "\"V\":nan", "\"V\":inf", "\"V\":-Infinity", "\"V\":0x10", "\"V\":1e999",
+        "\"V\":.5",  "\"V\":1.",  "\"V\":01",        "\"F\":-1",   "\"F\":4294967296",
+        "\"F\":1.5", "\"F\":1e10", "\"T\":18446744073709551616", "\"T\":1e20"};
+    for (auto &bad_value : bad_values) {
+      std::string bad_query =
+          "{\"type\":\"append\", \"append_value\":{\"I\":\"single\"," + bad_value + "}}";
+      dariadb::MeasArray bad_result;
+      dariadb::net::http::append_parser bad_parser(data_scheme, bad_query);
+      EXPECT_THROW(bad_parser.parse(&bad_result), std::exception) << bad_value;
+    }
+
+    std::string good_query =
+        "{\"type\":\"append\", \"append_value\":{\"I\":\"single\","
+        "\"F\":4294967295,\"T\":18446744073709551615,\"V\":-1.5e-3}}";
+    dariadb::MeasArray good_result;
+    dariadb::net::http::append_parser good_parser(data_scheme, good_query);
+    EXPECT_TRUE(good_parser.parse(&good_result));
+    EXPECT_EQ(good_result.front().flag, std::numeric_limits<dariadb::Flag>::max());
+    EXPECT_EQ(good_result.front().time, std::numeric_limits<dariadb::Time>::max());
+    EXPECT_EQ(good_result.front().value, dariadb::Value(-1.5e-3));
+  }
+}
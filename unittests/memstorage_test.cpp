@@ -4,11 +4,15 @@
 #include <libdariadb/storage/callbacks.h>
 #include <libdariadb/storage/engine_environment.h>
 #include <libdariadb/storage/memstorage/memstorage.h>
+#include <libdariadb/storage/memstorage/timetrack.h>
 #include <libdariadb/storage/settings.h>
 #include <libdariadb/utils/async/thread_manager.h>
 #include <libdariadb/utils/fs.h>
 
 #include <boost/date_time/posix_time/posix_time.hpp>
+#include <mutex>
+#include <set>
+#include <thread>
 
 #include "helpers.h"
 
@@ -51,15 +55,15 @@ struct MocDiskStorage : public dariadb::IMeasWriter {
   virtual void flush() override {}
 };
 
-TEST(MemoryStorage, RegionAllocatorTest) {
-  const size_t buffer_size = 100;
+TEST(MemoryStorage, SlabAllocatorFillTest) {
+  const std::vector<uint32_t> size_classes{100};
   const size_t max_size = 1024;
-  dariadb::storage::RegionChunkAllocator allocator(max_size, buffer_size);
+  dariadb::storage::SlabChunkAllocator allocator(max_size, size_classes, 100);
   std::set<dariadb::storage::ChunkHeader *> allocated_headers;
   std::set<uint8_t *> allocated_buffers;
   std::set<size_t> positions;
 
-  dariadb::storage::RegionChunkAllocator::AllocatedData last;
+  dariadb::storage::SlabChunkAllocator::AllocatedData last;
   do {
     auto allocated = allocator.allocate();
     auto hdr = allocated.header;
@@ -83,6 +87,146 @@ TEST(MemoryStorage, RegionAllocatorTest) {
   EXPECT_EQ(new_obj.position, last.position);
 }
 
+TEST(MemoryStorage, SlabAllocatorCachedSlotsTest) {
+  const std::vector<uint32_t> size_classes{128, 256};
+  const size_t slot_128 = sizeof(dariadb::storage::ChunkHeader) + 128;
+  dariadb::storage::SlabChunkAllocator allocator(256 * 1024, size_classes, 128);
+
+  std::vector<dariadb::storage::IMemoryAllocator::AllocatedData> allocated;
+  while (true) {
+    auto a = allocator.allocate(128);
+    if (a.header == nullptr) {
+      break;
+    }
+    allocated.push_back(a);
+  }
+  dariadb::storage::memstorage::Description d;
+  allocator.describe(d);
+  EXPECT_EQ(d.slabs_used, d.slabs_count);
+  EXPECT_EQ(d.cached_bytes, size_t(0));
+
+  // slot is parked in the cache of other thread.
+  auto freed = allocated.back();
+  allocated.pop_back();
+  std::thread t([&allocator, &freed]() { allocator.free(freed); });
+  t.join();
+  allocator.describe(d);
+  EXPECT_EQ(d.cached_bytes, slot_128);
+  EXPECT_EQ(allocator.used_bytes(), d.allocated_bytes + slot_128);
+
+  auto other = allocator.allocate(256);
+  EXPECT_TRUE(other.header != nullptr);
+  EXPECT_EQ(other.position, freed.position);
+  EXPECT_EQ(other.size, uint32_t(128));
+  allocator.describe(d);
+  EXPECT_EQ(d.cached_bytes, size_t(0));
+
+  allocated.push_back(other);
+  for (auto &a : allocated) {
+    allocator.free(a);
+  }
+  EXPECT_EQ(allocator._allocated_bytes.load(), size_t(0));
+  allocator.flush_caches();
+  EXPECT_EQ(allocator.used_bytes(), size_t(0));
+  EXPECT_EQ(allocator.slabs_used(), size_t(0));
+}
+
+TEST(MemoryStorage, SlabAllocatorTest) {
+  const std::vector<uint32_t> size_classes{64, 128, 256};
+  const size_t limit = 1024 * 1024;
+  dariadb::storage::SlabChunkAllocator allocator(limit, size_classes, 128);
+  EXPECT_GE(allocator.numa_nodes(), size_t(1));
+  EXPECT_LE(allocator.capacity_bytes(), limit);
+  EXPECT_EQ(allocator.slabs_used(), size_t(0));
+
+  std::set<size_t> positions;
+  std::vector<dariadb::storage::IMemoryAllocator::AllocatedData> allocated;
+  for (size_t i = 0; i < 300; ++i) {
+    auto a = allocator.allocate(uint32_t(size_classes[i % size_classes.size()]));
+    EXPECT_TRUE(a.header != nullptr);
+    EXPECT_EQ(a.size, size_classes[i % size_classes.size()]);
+    EXPECT_EQ(a.header->id, uint64_t(0));
+    positions.insert(a.position);
+    std::fill_n(a.buffer, a.size, uint8_t(0xff));
+    allocated.push_back(a);
+  }
+  EXPECT_EQ(positions.size(), allocated.size());
+  // one slab per class at least.
+  EXPECT_GE(allocator.slabs_used(), size_classes.size());
+
+  dariadb::storage::memstorage::Description d;
+  allocator.describe(d);
+  EXPECT_EQ(d.allocated, allocated.size());
+  EXPECT_EQ(d.slab_size, allocator.slab_size());
+  EXPECT_EQ(d.slabs_used, allocator.slabs_used());
+  EXPECT_EQ(d.slabs_count * d.slab_size, allocator.capacity_bytes());
+  EXPECT_GT(d.occupancy, float(0));
+  EXPECT_GE(d.fragmentation, float(0));
+  EXPECT_LT(d.fragmentation, float(1));
+
+  for (auto &a : allocated) {
+    allocator.free(a);
+  }
+  EXPECT_EQ(allocator._allocated.load(), size_t(0));
+  EXPECT_EQ(allocator._allocated_bytes.load(), size_t(0));
+  allocator.flush_caches();
+  EXPECT_EQ(allocator.slabs_used(), size_t(0));
+
+  // all memory can be used by one class.
+  allocated.clear();
+  while (true) {
+    auto a = allocator.allocate(256);
+    if (a.header == nullptr) {
+      break;
+    }
+    allocated.push_back(a);
+  }
+  EXPECT_EQ(allocator.slabs_used(), d.slabs_count);
+  for (auto &a : allocated) {
+    allocator.free(a);
+  }
+  allocator.flush_caches();
+  EXPECT_EQ(allocator.slabs_used(), size_t(0));
+}
+
+TEST(MemoryStorage, AdaptiveChunkSizeTest) {
+  struct MokContainer : public dariadb::storage::MemoryChunkContainer {
+    void addChunk(dariadb::storage::MemChunk_Ptr &) override {}
+    void freeChunk(dariadb::storage::MemChunk_Ptr &) override {}
+  } mcc;
+  const std::vector<uint32_t> size_classes{64, 128, 256, 512, 1024};
+  const dariadb::Time span = 1000;
+  auto allocator =
+      std::make_shared<dariadb::storage::UnlimitMemoryAllocator>(size_classes, 256);
+  auto fast = std::make_shared<dariadb::storage::TimeTrack>(&mcc, dariadb::Time(0), 1,
+                                                            allocator, span);
+  auto slow = std::make_shared<dariadb::storage::TimeTrack>(&mcc, dariadb::Time(0), 2,
+                                                            allocator, span);
+  dariadb::Meas m;
+  for (dariadb::Time t = 0; t < 10000; ++t) {
+    m.id = 1;
+    m.time = t;
+    m.value = dariadb::Value(t % 17);
+    fast->append(m);
+    if (t % 100 == 0) {
+      m.id = 2;
+      slow->append(m);
+    }
+  }
+  // fast series fills chunk before span is over.
+  EXPECT_EQ(fast->_cur_chunk->header->size, size_classes.back());
+  // slow series: chunks are sealed by time and smaller, than default.
+  EXPECT_LT(slow->_cur_chunk->header->size, uint32_t(256));
+  EXPECT_FALSE(slow->_index.empty());
+  for (auto &kv : slow->_index) {
+    auto &stat = kv.second->header->stat;
+    EXPECT_LT(stat.maxTime - stat.minTime, span);
+  }
+  fast = nullptr;
+  slow = nullptr;
+  EXPECT_EQ(allocator->_allocated.load(), size_t(0));
+}
+
 TEST(MemoryStorage, CommonTest) {
   auto storage_path = "testMemoryStorage";
   if (dariadb::utils::fs::path_exists(storage_path)) {
@@ -146,6 +290,106 @@ TEST(MemoryStorage, DropByLimitTest) {
   }
 }
 
+TEST(MemoryStorage, WatermarkEvictionTest) {
+  struct MokIdWriter : public MokChunkWriter {
+    std::mutex locker;
+    std::vector<dariadb::Id> ids;
+    void appendChunks(const std::vector<dariadb::storage::Chunk *> &a) override {
+      std::lock_guard<std::mutex> lg(locker);
+      for (auto c : a) {
+        ids.push_back(c->header->meas_id);
+      }
+      MokChunkWriter::appendChunks(a);
+    }
+  };
+
+  auto storage_path = "testMemoryStorage";
+  if (dariadb::utils::fs::path_exists(storage_path)) {
+    dariadb::utils::fs::rm(storage_path);
+  }
+  MokIdWriter *cw = new MokIdWriter;
+  {
+    auto settings = dariadb::storage::Settings::create(storage_path);
+    settings->strategy.setValue(dariadb::STRATEGY::MEMORY);
+    settings->memory_limit.setValue(1024 * 1024);
+    settings->chunk_size.setValue(128);
+    settings->max_chunks_per_page.setValue(4);
+    auto _engine_env = dariadb::storage::EngineEnvironment::create();
+    _engine_env->addResource(dariadb::storage::EngineEnvironment::Resource::SETTINGS,
+                             settings.get());
+    dariadb::utils::async::ThreadManager::start(settings->thread_pools_params());
+
+    auto ms = dariadb::storage::MemStorage::create(_engine_env, size_t(0));
+    ms->setDownLevel(cw);
+
+    // id 1 is older, than id 2: its chunks must be evicted first.
+    const dariadb::Time shift = 1000000000;
+    auto e = dariadb::Meas();
+    while (cw->droped == 0) {
+      e.time++;
+      e.id = 1;
+      ms->append(e);
+      e.id = 2;
+      e.time += shift;
+      ms->append(e);
+      e.time -= shift;
+    }
+    auto high = settings->percent_when_start_droping.value();
+    auto d = ms->description();
+    EXPECT_LE(d.allocated_bytes, d.allocator_capacity_bytes);
+    EXPECT_GE(d.allocated_bytes, size_t(d.allocator_capacity_bytes * high / 2));
+    {
+      std::lock_guard<std::mutex> lg(cw->locker);
+      EXPECT_FALSE(cw->ids.empty());
+      for (auto id : cw->ids) {
+        EXPECT_EQ(id, dariadb::Id(1));
+      }
+    }
+  }
+  delete cw;
+  dariadb::utils::async::ThreadManager::stop();
+  if (dariadb::utils::fs::path_exists(storage_path)) {
+    dariadb::utils::fs::rm(storage_path);
+  }
+}
+
+TEST(MemoryStorage, EvictionOnBadAllocTest) {
+  auto storage_path = "testMemoryStorage";
+  if (dariadb::utils::fs::path_exists(storage_path)) {
+    dariadb::utils::fs::rm(storage_path);
+  }
+  MokChunkWriter *cw = new MokChunkWriter;
+  {
+    auto settings = dariadb::storage::Settings::create(storage_path);
+    settings->strategy.setValue(dariadb::STRATEGY::MEMORY);
+    settings->memory_limit.setValue(256 * 1024);
+    settings->chunk_size.setValue(128);
+    settings->max_chunks_per_page.setValue(4);
+    // high watermark is never reached: only writers can start eviction.
+    settings->percent_when_start_droping.setValue(float(2.0));
+    auto _engine_env = dariadb::storage::EngineEnvironment::create();
+    _engine_env->addResource(dariadb::storage::EngineEnvironment::Resource::SETTINGS,
+                             settings.get());
+    dariadb::utils::async::ThreadManager::start(settings->thread_pools_params());
+
+    auto ms = dariadb::storage::MemStorage::create(_engine_env, size_t(0));
+    ms->setDownLevel(cw);
+
+    auto e = dariadb::Meas();
+    for (size_t i = 0; cw->droped == 0; ++i) {
+      e.time++;
+      e.id = dariadb::Id(i % 10);
+      EXPECT_EQ(ms->append(e).writed, size_t(1));
+    }
+    EXPECT_GT(cw->droped, size_t(0));
+  }
+  delete cw;
+  dariadb::utils::async::ThreadManager::stop();
+  if (dariadb::utils::fs::path_exists(storage_path)) {
+    dariadb::utils::fs::rm(storage_path);
+  }
+}
+
 TEST(MemoryStorage, CacheTest) {
   auto storage_path = "testMemoryStorage";
   if (dariadb::utils::fs::path_exists(storage_path)) {
@@ -13,6 +13,7 @@
 #include <libdariadb/storage/wal/walfile.h>
 #include <libdariadb/utils/fs.h>
 #include <libdariadb/utils/logger.h>
+#include <libserver/http/query_parser.h>
 #include <libserver/server.h>
 
 const dariadb::net::Server::Param binary_server_param(2001, 2002);
@@ -397,3 +398,123 @@ TEST(Network, SchemeTest) {
     server_thread.join();
   }
 }
+
+TEST(Network, AsyncAppendTest) {
+  dariadb::logger("********** AsyncAppendTest **********");
+
+  using namespace dariadb;
+  using namespace dariadb::storage;
+
+  auto settings = dariadb::storage::Settings::create();
+  IEngine_Ptr stor{new Engine(settings)};
+
+  // storage is always 'overloaded', so each append is answered by SLOW_DOWN.
+  dariadb::net::Server::Param server_param(2001, 2002);
+  server_param.overload_wal_queue = 0;
+  std::thread server_thread{[&server_param]() {
+    dariadb::net::Server s(server_param);
+    binary_server_instance = &s;
+    s.start();
+    binary_server_instance = nullptr;
+  }};
+
+  while (binary_server_instance == nullptr || !binary_server_instance->is_runned()) {
+    dariadb::utils::sleep_mls(300);
+  }
+  binary_server_instance->set_storage(stor);
+  dariadb::utils::sleep_mls(300);
+
+  dariadb::net::client::Client::Param p = client_param;
+  p.append_window = 2;
+  dariadb::net::client::Client c1(p);
+  c1.connect();
+
+  const size_t threads_count = 4;
+  const size_t appends_per_thread = 100;
+  const size_t values_per_append = 10;
+  std::atomic_size_t callbacks_called{0};
+  std::atomic_size_t slow_downs{0};
+
+  auto writer = [&](size_t thread_num) {
+    std::vector<std::future<dariadb::net::client::AppendResult>> results;
+    dariadb::net::client::AppendCallback clbk =
+        [&callbacks_called](const dariadb::net::client::AppendResult &) {
+          callbacks_called++;
+        };
+    for (size_t i = 0; i < appends_per_thread; ++i) {
+      dariadb::MeasArray ma(values_per_append);
+      for (size_t j = 0; j < values_per_append; ++j) {
+        ma[j].id = dariadb::Id(thread_num);
+        ma[j].time = dariadb::Time(i * values_per_append + j);
+        ma[j].value = dariadb::Value(j);
+      }
+      results.push_back(c1.appendAsync(ma, clbk));
+    }
+    for (auto &f : results) {
+      auto r = f.get();
+      EXPECT_EQ(r.count, values_per_append);
+      EXPECT_FALSE(r.is_error);
+      if (r.slow_down) {
+        slow_downs++;
+      }
+    }
+  };
+
+  std::vector<std::thread> writers(threads_count);
+  for (size_t i = 0; i < threads_count; ++i) {
+    writers[i] = std::thread{writer, i};
+  }
+  for (auto &t : writers) {
+    t.join();
+  }
+  c1.flushAppends();
+
+  EXPECT_EQ(callbacks_called.load(), threads_count * appends_per_thread);
+  EXPECT_EQ(slow_downs.load(), threads_count * appends_per_thread);
+
+  dariadb::IdArray ids;
+  for (size_t i = 0; i < threads_count; ++i) {
+    ids.push_back(dariadb::Id(i));
+  }
+  dariadb::QueryInterval qi{ids, 0, dariadb::MIN_TIME, dariadb::MAX_TIME};
+  auto result = c1.readInterval(qi);
+  EXPECT_EQ(result.size(), threads_count * appends_per_thread * values_per_append);
+
+  c1.disconnect();
+  while (c1.state() != dariadb::net::CLIENT_STATE::DISCONNECTED) {
+    dariadb::utils::sleep_mls(300);
+  }
+  // closed connection does not block appends.
+  auto late = c1.appendAsync(dariadb::MeasArray(values_per_append)).get();
+  EXPECT_TRUE(late.is_error);
+  EXPECT_EQ(late.errc, dariadb::net::ERRORS::NOT_CONNECTED);
+
+  p.append_max_pending = 0;
+  EXPECT_THROW(dariadb::net::client::Client bad_param(p), std::exception);
+
+  binary_server_instance->stop();
+  server_thread.join();
+}
+
+TEST(Network, HttpAppendValueMissingKeys) {
+  auto settings = dariadb::storage::Settings::create();
+  auto data_scheme = dariadb::scheme::Scheme::create(settings);
+
+  std::vector<std::string> bad_queries = {
+      "{\"type\":\"append\",\"append_value\":{\"T\":1,\"V\":2}}",
+      "{\"type\":\"append\",\"append_value\":{\"I\":\"\",\"F\":0,\"T\":1,\"V\":2}}",
+      "{\"type\":\"append\",\"append_value\":{\"I\":\"p\",\"T\":1,\"V\":2}}",
+      "{\"type\":\"append\",\"append_value\":{\"I\":\"p\",\"F\":0,\"V\":2}}",
+      "{\"type\":\"append\",\"append_value\":{\"I\":\"p\",\"F\":0,\"T\":1}}"};
+  for (auto &q : bad_queries) {
+    EXPECT_THROW(dariadb::net::http::parse_query(data_scheme, q), std::exception) << q;
+  }
+  // nothing is registered by bad queries.
+  EXPECT_EQ(data_scheme->ls().size(), size_t(0));
+
+  auto good = dariadb::net::http::parse_query(
+      data_scheme,
+      "{\"type\":\"append\",\"append_value\":{\"I\":\"p\",\"F\":0,\"T\":1,\"V\":2}}");
+  EXPECT_EQ(good.append_query->size(), size_t(1));
+  EXPECT_EQ(data_scheme->ls().size(), size_t(1));
+}
@@ -3,7 +3,9 @@
 #include "helpers.h"
 
 #include <algorithm>
+#include <fstream>
 #include <iostream>
+#include <iterator>
 
 #include <libdariadb/flags.h>
 #include <libdariadb/storage/bloom_filter.h>
@@ -96,6 +98,16 @@ TEST(PageManager, ReadWriteWithContinue) {
       dariadb::QueryTimePoint(dariadb::IdArray{1}, 0, pm->minTime()));
   EXPECT_GE(mintime_chunks.size(), size_t(1));
 
+  index_files = dariadb::utils::fs::ls(storagePath, ".pagei");
+  for (auto &f : index_files) {
+    dariadb::utils::fs::rm(f);
+  }
+  pm->fsck(true);
+  EXPECT_EQ(pm->files_count(), size_t(1));
+  mintime_chunks = pm->valuesBeforeTimePoint(
+      dariadb::QueryTimePoint(dariadb::IdArray{1}, 0, pm->minTime()));
+  EXPECT_GE(mintime_chunks.size(), size_t(1));
+
   pm = nullptr;
   manifest = nullptr;
   dariadb::utils::async::ThreadManager::stop();
@@ -194,6 +206,33 @@ TEST(PageManager, MultiPageRead) {
   auto mm = pm->loadMinMax();
   EXPECT_EQ(mm->size(), size_t(1));
 
+  { // reopen from snapshot and from broken snapshot.
+    auto snapshot_file =
+        dariadb::utils::fs::append_path(settings->raw_path.value(), "pages.snapshot");
+    pm = nullptr;
+    EXPECT_TRUE(dariadb::utils::fs::file_exists(snapshot_file));
+    for (int i = 0; i < 2; ++i) {
+      if (i == 1) {
+        std::ofstream broken(snapshot_file, std::ios::binary | std::ios::trunc);
+        broken << "broken snapshot";
+      }
+      pm = dariadb::storage::PageManager::create(_engine_env);
+      dariadb::Time reopenMin, reopenMax;
+      EXPECT_TRUE(pm->minMaxTime(1, &reopenMin, &reopenMax));
+      EXPECT_EQ(reopenMin, minTime);
+      EXPECT_EQ(reopenMax, maxTime);
+      auto reopen_mm = pm->loadMinMax();
+      EXPECT_EQ(reopen_mm->size(), size_t(1));
+      dariadb::MeasMinMax before, after;
+      EXPECT_TRUE(mm->find(1, &before));
+      EXPECT_TRUE(reopen_mm->find(1, &after));
+      EXPECT_EQ(before.max.time, after.max.time);
+      EXPECT_EQ(pm->valuesBeforeTimePoint(qt)[1].time, id2meas[1].time);
+      pm = nullptr;
+    }
+    pm = dariadb::storage::PageManager::create(_engine_env);
+  }
+
   auto page_before_erase =
       dariadb::utils::fs::ls(settings->raw_path.value(), dariadb::storage::PAGE_FILE_EXT)
           .size();
@@ -309,7 +348,9 @@ TEST(PageManager, BulkWrite) {
   }
   EXPECT_TRUE(dariadb::utils::fs::path_exists(storagePath));
   using namespace dariadb::utils;
-  EXPECT_EQ(fs::ls(fs::append_path(storagePath, "raw")).size(), size_t(2)); // page +index
+  // page + index + snapshot
+  EXPECT_EQ(fs::ls(fs::append_path(storagePath, "raw")).size(), size_t(3));
+  EXPECT_EQ(fs::ls(fs::append_path(storagePath, "raw"), ".snapshot").size(), size_t(1));
   manifest = nullptr;
   dariadb::utils::async::ThreadManager::stop();
 
@@ -412,9 +453,39 @@ TEST(PageManager, Repack) {
   }
 
   auto pages_before = dariadb::utils::fs::ls(settings->raw_path.value(), ".page");
+  EXPECT_EQ(pm->files_count(), pages_before.size());
+  EXPECT_EQ(pm->minTime(), dariadb::Time(1));
+  EXPECT_EQ(pm->maxTime(), dariadb::Time(count));
   pm->repack(dariadb::Id(0));
   auto pages_after = dariadb::utils::fs::ls(settings->raw_path.value(), ".page");
   EXPECT_LT(pages_after.size(), pages_before.size());
+  EXPECT_EQ(pm->files_count(), pages_after.size());
+  EXPECT_EQ(pm->minTime(), dariadb::Time(1));
+  EXPECT_EQ(pm->maxTime(), dariadb::Time(count));
+  for (dariadb::Id id : {dariadb::Id(0), dariadb::Id(1)}) {
+    dariadb::Time minT, maxT;
+    EXPECT_TRUE(pm->minMaxTime(id, &minT, &maxT));
+    EXPECT_EQ(minT, dariadb::Time(1));
+    EXPECT_EQ(maxT, dariadb::Time(count));
+  }
+  { // time-point index
+    auto tp_res = pm->valuesBeforeTimePoint(dariadb::QueryTimePoint({1}, 0, 50));
+    EXPECT_EQ(tp_res[1].time, dariadb::Time(50));
+    EXPECT_EQ(tp_res[1].value, dariadb::Value(49));
+
+    tp_res = pm->valuesBeforeTimePoint(dariadb::QueryTimePoint({1}, 0, 0));
+    EXPECT_EQ(tp_res[1].flag, dariadb::FLAGS::_NO_DATA);
+
+    for (size_t i = 0; i < 2; ++i) { // second query reads cached last values.
+      tp_res = pm->valuesBeforeTimePoint(
+          dariadb::QueryTimePoint({0, 1, 2}, 0, dariadb::Time(count * 2)));
+      EXPECT_EQ(tp_res.size(), size_t(3));
+      EXPECT_EQ(tp_res[0].time, dariadb::Time(count));
+      EXPECT_EQ(tp_res[1].time, dariadb::Time(count));
+      EXPECT_EQ(tp_res[1].value, dariadb::Value(count - 1));
+      EXPECT_EQ(tp_res[2].flag, dariadb::FLAGS::_NO_DATA);
+    }
+  }
   { // id==0
     dariadb::QueryInterval qi({0}, 0, 0, dariadb::MAX_TIME);
 
@@ -639,3 +710,181 @@ TEST(PageManager, Compact) {
     dariadb::utils::fs::rm(storagePath);
   }
 }
+
+TEST(PageManager, PageWriter) {
+  auto read_file = [](const std::string &fname) {
+    std::ifstream in(fname, std::ios::binary);
+    return std::string((std::istreambuf_iterator<char>(in)),
+                       std::istreambuf_iterator<char>());
+  };
+  const std::string storagePath = "testStorage";
+  if (dariadb::utils::fs::path_exists(storagePath)) {
+    dariadb::utils::fs::rm(storagePath);
+  }
+  dariadb::utils::fs::mkdir(storagePath);
+
+  std::vector<uint8_t> data(dariadb::storage::PageWriter::BUFFER_SIZE * 2 + 123);
+  for (size_t i = 0; i < data.size(); ++i) {
+    data[i] = uint8_t(i * 7 + i / 256);
+  }
+
+  for (auto direct_io : {false, true}) {
+    auto fname = dariadb::utils::fs::append_path(storagePath, "writer.page");
+    {
+      dariadb::storage::PageWriter writer(fname, direct_io);
+      size_t pos = 0;
+      size_t step = 1;
+      while (pos < data.size()) {
+        auto sz = std::min(step, data.size() - pos);
+        writer.write(data.data() + pos, sz);
+        pos += sz;
+        step = step * 3 + 1;
+      }
+      EXPECT_EQ(writer.size(), data.size());
+      writer.close();
+    }
+    auto readed = read_file(fname);
+    EXPECT_EQ(readed.size(), data.size());
+    EXPECT_TRUE(std::equal(data.begin(), data.end(), readed.begin(),
+                           [](uint8_t l, char r) { return l == uint8_t(r); }));
+    // append to existing file.
+    {
+      dariadb::storage::PageWriter writer(fname, direct_io);
+      writer.write(data.data(), 10);
+      writer.close();
+    }
+    EXPECT_EQ(read_file(fname).size(), data.size() + 10);
+    dariadb::utils::fs::rm(fname);
+  }
+  dariadb::utils::fs::rm(storagePath);
+}
+
+TEST(PageManager, MMapRead) {
+  const std::string storagePath = "testStorage";
+  if (dariadb::utils::fs::path_exists(storagePath)) {
+    dariadb::utils::fs::rm(storagePath);
+  }
+  dariadb::utils::fs::mkdir(storagePath);
+  auto fname = dariadb::utils::fs::append_path(storagePath, "mmap.page");
+
+  const size_t chunks_count = 5;
+  const uint32_t chunk_size = 128;
+  std::vector<dariadb::storage::ChunkHeader> headers(chunks_count);
+  std::vector<uint8_t> buffers(chunks_count * chunk_size);
+  std::vector<dariadb::storage::Chunk_Ptr> chunks;
+  std::vector<dariadb::storage::Chunk *> raw_chunks;
+  size_t writed = 0;
+  dariadb::Meas m;
+  m.id = 1;
+  for (size_t i = 0; i < chunks_count; ++i) {
+    auto c = dariadb::storage::Chunk::create(&headers[i], buffers.data() + i * chunk_size,
+                                             chunk_size, m);
+    writed++;
+    m.time++;
+    while (c->append(m)) {
+      writed++;
+      m.time++;
+    }
+    chunks.push_back(c);
+    raw_chunks.push_back(c.get());
+  }
+  dariadb::storage::Page::create(fname, 0, 0, raw_chunks, raw_chunks.size());
+
+  dariadb::QueryInterval qi({1}, 0, 0, m.time);
+  auto copy_page = dariadb::storage::Page::open(fname, false);
+  auto mapped_page = dariadb::storage::Page::open(fname, true);
+  EXPECT_EQ(memcmp(&copy_page->footer, &mapped_page->footer,
+                   sizeof(dariadb::storage::PageFooter)),
+            0);
+  EXPECT_TRUE(mapped_page->checksum());
+  EXPECT_EQ(copy_page->intervalReader(qi)[1]->count(),
+            mapped_page->intervalReader(qi)[1]->count());
+  EXPECT_EQ(mapped_page->stat(1, 0, m.time).count, writed);
+
+  // cursor keeps the mapping alive after page closing and erasing of files.
+  auto cursor = mapped_page->intervalReader(qi)[1];
+  copy_page = nullptr;
+  mapped_page = nullptr;
+  dariadb::utils::fs::rm(storagePath);
+  size_t readed = 0;
+  while (!cursor->is_end()) {
+    cursor->readNext();
+    readed++;
+  }
+  EXPECT_EQ(readed, writed);
+}
+
+TEST(PageManager, SortedIndex) {
+  using dariadb::storage::IndexReccord;
+  const std::string storagePath = "testStorage";
+  if (dariadb::utils::fs::path_exists(storagePath)) {
+    dariadb::utils::fs::rm(storagePath);
+  }
+  dariadb::utils::fs::mkdir(storagePath);
+  auto fname = dariadb::utils::fs::append_path(storagePath, "sorted.page");
+
+  // chunks of different ids are interleaved, like in pages from memstorage.
+  const size_t chunks_count = dariadb::storage::INDEX_BLOCK_SIZE * 5 + 7;
+  const size_t ids_count = 7;
+  const uint32_t chunk_size = 64;
+  std::vector<dariadb::storage::ChunkHeader> headers(chunks_count);
+  std::vector<uint8_t> buffers(chunks_count * chunk_size);
+  std::vector<dariadb::storage::Chunk_Ptr> chunks;
+  std::vector<dariadb::storage::Chunk *> raw_chunks;
+  std::vector<dariadb::Time> id2time(ids_count);
+  for (size_t i = 0; i < chunks_count; ++i) {
+    dariadb::Meas m;
+    m.id = dariadb::Id(i * 3 % ids_count);
+    m.flag = dariadb::Flag(i % 2);
+    m.time = id2time[m.id];
+    auto c = dariadb::storage::Chunk::create(&headers[i], buffers.data() + i * chunk_size,
+                                             chunk_size, m);
+    for (size_t j = 0; j < 5; ++j) {
+      m.time++;
+      c->append(m);
+    }
+    id2time[m.id] = m.time + 1;
+    chunks.push_back(c);
+    raw_chunks.push_back(c.get());
+  }
+  dariadb::storage::Page::create(fname, 0, 0, raw_chunks, raw_chunks.size());
+
+  auto check = [](const IndexReccord &r, dariadb::Id id, dariadb::Time from,
+                  dariadb::Time to, dariadb::Flag flag) {
+    return r.target_id == id && r.stat.maxTime >= from && r.stat.minTime <= to &&
+           (flag == 0 || dariadb::storage::bloom_check(r.stat.flag_bloom, flag));
+  };
+  auto ifname = dariadb::storage::PageIndex::index_name_from_page_name(fname);
+  for (auto mmap_read : {false, true}) {
+    auto index = dariadb::storage::PageIndex::open(ifname, mmap_read);
+    EXPECT_TRUE(index->iheader.sorted());
+    EXPECT_EQ(index->iheader.recs_count, chunks_count);
+    auto reccords = index->readReccords();
+    EXPECT_EQ(index->readBlocks().size(),
+              dariadb::storage::PageIndex::blocks_count(chunks_count));
+
+    for (dariadb::Id id = 0; id <= ids_count; ++id) {
+      for (auto interval : {std::make_pair(dariadb::Time(0), dariadb::MAX_TIME),
+                            std::make_pair(dariadb::Time(10), dariadb::Time(40)),
+                            std::make_pair(dariadb::Time(33), dariadb::Time(33))}) {
+        for (dariadb::Flag flag : {0, 1}) {
+          auto links = index->get_chunks_links({id, id}, interval.first, interval.second,
+                                               flag);
+          size_t expected = 0;
+          for (auto &r : reccords) {
+            if (check(r, id, interval.first, interval.second, flag)) {
+              expected++;
+            }
+          }
+          EXPECT_EQ(links.size(), expected);
+          for (auto &l : links) {
+            auto &r = reccords[l.index_rec_number];
+            EXPECT_TRUE(check(r, id, interval.first, interval.second, flag));
+            EXPECT_EQ(r.chunk_id, l.id);
+          }
+        }
+      }
+    }
+  }
+  dariadb::utils::fs::rm(storagePath);
+}
@@ -295,4 +295,75 @@ TEST(Shard, AutomaticShardCreation) {
   if (dariadb::utils::fs::path_exists(storage_path_shard1)) {
     dariadb::utils::fs::rm(storage_path_shard1);
   }
-}
\ No newline at end of file
+}
+TEST(Shard, BatchAppend) {
+  const std::string storage_path = "testStorage";
+  const std::string storage_path_shard1 = "testStorage_shard1";
+  const std::string storage_path_shard2 = "testStorage_shard2";
+
+  using namespace dariadb;
+  using namespace dariadb::storage;
+  for (auto p : {storage_path, storage_path_shard1, storage_path_shard2}) {
+    if (dariadb::utils::fs::path_exists(p)) {
+      dariadb::utils::fs::rm(p);
+    }
+  }
+  for (auto p : {storage_path_shard1, storage_path_shard2}) {
+    auto settings = dariadb::storage::Settings::create(p);
+    settings->strategy.setValue(dariadb::STRATEGY::MEMORY);
+    settings->save();
+  }
+  {
+    auto shard_storage = ShardEngine::create(storage_path);
+    shard_storage->shardAdd({storage_path_shard1, "shard1", {Id(0), Id(1)}});
+    shard_storage->shardAdd({storage_path_shard2, "shard2", IdSet()});
+
+    const size_t ids_count = 4;
+    const size_t values_per_id = 100;
+    MeasArray ma;
+    for (size_t i = 0; i < values_per_id; ++i) {
+      for (Id id = 0; id < ids_count; ++id) {
+        auto m = Meas(id);
+        m.time = Time(i);
+        m.value = Value(i);
+        ma.push_back(m);
+      }
+    }
+    auto status = shard_storage->append(ma.begin(), ma.end());
+    EXPECT_EQ(status.writed, ma.size());
+    EXPECT_EQ(status.ignored, size_t(0));
+
+    for (Id id = 0; id < ids_count; ++id) {
+      auto values = shard_storage->readInterval(
+          QueryInterval({id}, 0, dariadb::MIN_TIME, dariadb::MAX_TIME));
+      EXPECT_EQ(values.size(), values_per_id);
+    }
+    { // one query for all shards.
+      QueryInterval qi({Id(0), Id(1), Id(2), Id(3)}, 0, dariadb::MIN_TIME,
+                       dariadb::MAX_TIME);
+      qi.timeout = 10000;
+      auto values = shard_storage->readInterval(qi);
+      EXPECT_EQ(values.size(), values_per_id * ids_count);
+
+      QueryTimePoint qt({Id(0), Id(1), Id(2), Id(3)}, 0, Time(values_per_id / 2));
+      qt.timeout = 10000;
+      auto points = shard_storage->readTimePoint(qt);
+      EXPECT_EQ(points.size(), ids_count);
+      for (auto &kv : points) {
+        EXPECT_EQ(kv.second.time, Time(values_per_id / 2));
+      }
+    }
+    // routes are republished after removing a shard.
+    shard_storage->shardRm("shard1", false);
+    status = shard_storage->append(ma.begin(), ma.end());
+    EXPECT_EQ(status.writed, ma.size());
+    auto values = shard_storage->readInterval(
+        QueryInterval({Id(0)}, 0, dariadb::MIN_TIME, dariadb::MAX_TIME));
+    EXPECT_EQ(values.size(), values_per_id);
+  }
+  for (auto p : {storage_path, storage_path_shard1, storage_path_shard2}) {
+    if (dariadb::utils::fs::path_exists(p)) {
+      dariadb::utils::fs::rm(p);
+    }
+  }
+}
@@ -1,6 +1,7 @@
 #include <libdariadb/dariadb.h>
 #include <libdariadb/statistic/calculator.h>
 #include <gtest/gtest.h>
+#include <cmath>
 
 void check_function_factory(const std::vector<std::string> &tested) {
   auto result = dariadb::statistic::FunctionFactory::make(tested);
@@ -219,3 +220,55 @@ TEST(Statistic, Calculator) {
 
   EXPECT_EQ(result.back().value, 0);
 }
+
+TEST(Statistic, FusedKernels) {
+  using dariadb::statistic::summarize;
+  // length is not multiple of vector width, extremums are repeated.
+  const size_t count = 1003;
+  const dariadb::Value offset = 1e9;
+  dariadb::MeasArray ma(count);
+  for (size_t i = 0; i < count; ++i) {
+    ma[i].id = dariadb::Id(i % 3);
+    ma[i].time = dariadb::Time(count - i);
+    ma[i].value = offset + dariadb::Value(i % 7);
+  }
+
+  dariadb::Value sum = 0;
+  for (auto &m : ma) {
+    sum += m.value - offset;
+  }
+  auto mean = sum / count;
+  dariadb::Value m2 = 0;
+  for (auto &m : ma) {
+    m2 += (m.value - offset - mean) * (m.value - offset - mean);
+  }
+
+  auto s = summarize(ma, true);
+  EXPECT_EQ(s.count, count);
+  EXPECT_EQ(s.min, offset);
+  EXPECT_EQ(s.max, offset + 6);
+  EXPECT_EQ(s.min_time, dariadb::Time(count - 1001));
+  EXPECT_EQ(s.max_time, dariadb::Time(count - 1000));
+  EXPECT_EQ(s.newest, dariadb::Time(count));
+  EXPECT_EQ(s.last_time, dariadb::Time(1));
+  EXPECT_EQ(s.last_id, ma.back().id);
+  EXPECT_NEAR(s.sum / count, offset + mean, 1e-6);
+  // large offset must not break sigma.
+  EXPECT_NEAR(s.sigma, std::sqrt(m2 / count), 1e-6);
+
+  // fused and per function results are equal.
+  auto functions = dariadb::statistic::FunctionFactory::make(
+      {"average", "minimum", "maximum", "count", "sigma"});
+  for (auto &f : functions) {
+    EXPECT_TRUE(f->is_fused());
+    auto expected = f->apply(ma);
+    auto fused = f->result(s);
+    EXPECT_EQ(expected.value, fused.value) << f->kind();
+    EXPECT_EQ(expected.time, fused.time) << f->kind();
+    EXPECT_EQ(expected.id, fused.id) << f->kind();
+  }
+
+  auto empty = summarize(dariadb::MeasArray(), true);
+  EXPECT_EQ(empty.count, size_t(0));
+  EXPECT_EQ(functions.front()->result(empty).value, dariadb::Value());
+}
@@ -7,9 +7,20 @@
 #include <libdariadb/storage/chunk.h>
 #include <libdariadb/storage/cursors.h>
 #include <libdariadb/storage/manifest.h>
+#include <libdariadb/storage/subscribe.h>
+#include <libdariadb/storage/versions.h>
+#include <libdariadb/utils/crc.h>
 #include <libdariadb/utils/fs.h>
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <fstream>
 #include <iostream>
+#include <map>
+#include <set>
+#include <thread>
 
 TEST(Common, MeasTest) {
   dariadb::Meas m;
@@ -268,6 +279,87 @@ TEST(Common, ChunkTest) {
   }
 }
 
+TEST(Common, ChunkChecksumKind) {
+  using dariadb::storage::CHECKSUM_KIND;
+  // checksum_kind use unused bits of old is_sorted byte.
+  EXPECT_EQ(sizeof(dariadb::storage::ChunkHeader),
+            offsetof(dariadb::storage::ChunkHeader, stat) +
+                sizeof(dariadb::Statistic) + sizeof(uint8_t));
+
+  dariadb::storage::ChunkHeader hdr;
+  uint8_t buff[512];
+  std::fill_n(buff, sizeof(buff), uint8_t(0));
+  auto m = dariadb::Meas();
+  auto ch = dariadb::storage::Chunk::create(&hdr, buff, sizeof(buff), m);
+  while (!ch->isFull()) {
+    ch->append(m);
+    m.time++;
+  }
+  ch->close();
+  EXPECT_EQ(hdr.checksum_kind, uint8_t(dariadb::storage::CHECKSUM_DEFAULT));
+  dariadb::storage::Chunk::updateChecksum(hdr, buff);
+  EXPECT_EQ(hdr.crc, dariadb::utils::crc32c(buff, hdr.size));
+  EXPECT_TRUE(ch->checkChecksum());
+
+  // chunk from old page.
+  hdr.checksum_kind = uint8_t(CHECKSUM_KIND::CRC32);
+  EXPECT_FALSE(ch->checkChecksum());
+  dariadb::storage::Chunk::updateChecksum(hdr, buff);
+  EXPECT_EQ(hdr.crc, dariadb::utils::crc32(buff, hdr.size));
+  EXPECT_TRUE(ch->checkChecksum());
+  EXPECT_EQ(hdr.is_sorted, uint8_t(1));
+
+  hdr.checksum_kind = uint8_t(7);
+  EXPECT_THROW(ch->checkChecksum(), std::exception);
+}
+
+TEST(Common, ChunkCodecs) {
+  using dariadb::compression::CHUNK_CODEC;
+  const size_t buffer_size = 1024;
+  for (auto sorted : {true, false}) {
+    dariadb::storage::ChunkHeader hdr;
+    uint8_t buff[buffer_size];
+    std::fill_n(buff, buffer_size, uint8_t(0));
+    auto m = dariadb::Meas(3);
+    m.time = sorted ? 0 : 1505;
+    auto ch = dariadb::storage::Chunk::create(&hdr, buff, buffer_size, m);
+    dariadb::MeasArray writed{m};
+    for (int i = 1; i < 300; ++i) {
+      m.time = dariadb::Time(i * 10);
+      m.value = dariadb::Value(i % 20) / 4;
+      m.flag = dariadb::Flag(1);
+      if (!ch->append(m)) {
+        break;
+      }
+      writed.push_back(m);
+    }
+    EXPECT_EQ(CHUNK_CODEC(hdr.codec), CHUNK_CODEC::DELTA_XOR);
+    auto streaming_size = hdr.size - hdr.bw_pos;
+    ch->close();
+    EXPECT_EQ(CHUNK_CODEC(hdr.codec), CHUNK_CODEC::COLUMNS);
+    EXPECT_LT(hdr.size - hdr.bw_pos, streaming_size);
+    EXPECT_EQ(hdr.is_sorted, uint8_t(sorted));
+
+    std::sort(writed.begin(), writed.end(), dariadb::meas_time_compare_less());
+    auto skip_size = dariadb::storage::Chunk::compact(&hdr);
+    dariadb::storage::Chunk::updateChecksum(hdr, buff + skip_size);
+    auto opened = dariadb::storage::Chunk::open(&hdr, buff + skip_size);
+    EXPECT_TRUE(opened->checkChecksum());
+    auto rdr = opened->getReader();
+    size_t pos = 0;
+    while (!rdr->is_end()) {
+      auto readed = rdr->readNext();
+      ASSERT_LT(pos, writed.size());
+      EXPECT_EQ(readed.id, writed[pos].id);
+      EXPECT_EQ(readed.time, writed[pos].time);
+      EXPECT_EQ(readed.value, writed[pos].value);
+      EXPECT_EQ(readed.flag, writed[pos].flag);
+      pos++;
+    }
+    EXPECT_EQ(pos, writed.size());
+  }
+}
+
 TEST(Common, FullCursorTest) {
   {
     dariadb::MeasArray ma;
@@ -445,4 +537,281 @@ TEST(Common, ReaderColapse3Test) {
   while (msr->is_end()) {
     msr->readNext();
   }
-}
\ No newline at end of file
+}
+
+TEST(Common, ReaderColapseManyTest) {
+  using namespace dariadb::storage;
+  using namespace dariadb;
+  std::set<Time> expected;
+  CursorsList readers;
+  for (size_t i = 0; i < 300; ++i) {
+    // every 10th reader overlaps with a few next readers.
+    auto len = (i % 10 == 0) ? 35 : 3;
+    MeasArray ma;
+    for (Time t = i * 4; t < Time(i * 4 + len); ++t) {
+      ma.push_back(Meas());
+      ma.back().time = t;
+      expected.insert(t);
+    }
+    readers.push_back(Cursor_Ptr{new FullCursor(ma)});
+  }
+  readers.reverse();
+
+  auto colapsed = CursorWrapperFactory::colapseCursors(readers);
+  auto lsr = dynamic_cast<LinearCursor *>(colapsed.get());
+  ASSERT_TRUE(lsr != nullptr);
+  EXPECT_LT(lsr->_readers.size(), readers.size());
+  Time prev_max = MIN_TIME;
+  for (auto &r : lsr->_readers) {
+    EXPECT_TRUE(prev_max == MIN_TIME || r->minTime() > prev_max);
+    prev_max = r->maxTime();
+  }
+
+  std::vector<Time> readed;
+  while (!colapsed->is_end()) {
+    readed.push_back(colapsed->readNext().time);
+  }
+  EXPECT_EQ(readed.size(), expected.size());
+  EXPECT_TRUE(std::equal(readed.begin(), readed.end(), expected.begin()));
+}
+
+TEST(Common, DownsampleCursorTest) {
+  using namespace dariadb::storage;
+  using namespace dariadb;
+  const size_t buffer_size = 4096;
+  const size_t chunks_count = 4;
+  std::vector<ChunkHeader> headers(chunks_count);
+  std::vector<std::vector<uint8_t>> buffers(chunks_count,
+                                            std::vector<uint8_t>(buffer_size));
+  std::vector<Chunk_Ptr> chunks;
+  MeasArray all;
+  for (size_t i = 0; i < chunks_count; ++i) {
+    auto m = Meas(1);
+    m.time = i * 1000;
+    m.value = Value(i);
+    auto ch = Chunk::create(&headers[i], buffers[i].data(), buffer_size, m);
+    all.push_back(m);
+    for (Time t = m.time + 10; t < Time((i + 1) * 1000); t += 10) {
+      m.time = t;
+      m.value = Value(t % 77);
+      ASSERT_TRUE(ch->append(m));
+      all.push_back(m);
+    }
+    // closed and streaming chunks are summarized both.
+    if (i % 2 == 0) {
+      ch->close();
+    }
+    chunks.push_back(ch);
+  }
+
+  auto reader = [&chunks]() {
+    CursorsList readers;
+    for (auto &c : chunks) {
+      readers.push_back(c->getReader());
+    }
+    return CursorWrapperFactory::colapseCursors(readers);
+  };
+
+  // step 1000 - whole chunks in buckets, 300 - buckets inside chunks.
+  for (auto step : {Time(1000), Time(300)}) {
+    for (auto kind : {DOWNSAMPLE::AVG, DOWNSAMPLE::MIN, DOWNSAMPLE::MAX,
+                      DOWNSAMPLE::FIRST, DOWNSAMPLE::LAST, DOWNSAMPLE::M4}) {
+      QueryInterval q({Id(1)}, Flag(0), Time(0), Time(3500), step, kind);
+
+      std::map<Time, MeasArray> buckets;
+      for (auto &m : all) {
+        if (m.inInterval(q.from, q.to)) {
+          buckets[q.from + (m.time - q.from) / step * step].push_back(m);
+        }
+      }
+      MeasArray expected;
+      for (auto &kv : buckets) {
+        auto &b = kv.second;
+        auto min_max = std::minmax_element(
+            b.begin(), b.end(),
+            [](const Meas &l, const Meas &r) { return l.value < r.value; });
+        auto v = b.front();
+        v.time = kv.first;
+        switch (kind) {
+        case DOWNSAMPLE::AVG: {
+          Value sum = 0;
+          for (auto &m : b) {
+            sum += m.value;
+          }
+          v.value = sum / b.size();
+          break;
+        }
+        case DOWNSAMPLE::MIN:
+          v.value = min_max.first->value;
+          break;
+        case DOWNSAMPLE::MAX:
+          v.value = min_max.second->value;
+          break;
+        case DOWNSAMPLE::FIRST:
+          break;
+        case DOWNSAMPLE::LAST:
+          v.value = b.back().value;
+          break;
+        case DOWNSAMPLE::M4: {
+          std::set<Meas, meas_time_compare_less> points{b.front(), *min_max.first,
+                                                        *min_max.second, b.back()};
+          expected.insert(expected.end(), points.begin(), points.end());
+          continue;
+        }
+        }
+        expected.push_back(v);
+      }
+
+      DownsampleCursor dc(reader(), q);
+      EXPECT_GE(dc.count(), expected.size());
+      size_t pos = 0;
+      while (!dc.is_end()) {
+        auto m = dc.readNext();
+        ASSERT_LT(pos, expected.size());
+        EXPECT_EQ(m.time, expected[pos].time) << to_string(kind) << " step " << step;
+        EXPECT_NEAR(m.value, expected[pos].value, 0.0001) << to_string(kind);
+        pos++;
+      }
+      EXPECT_EQ(pos, expected.size()) << to_string(kind) << " step " << step;
+    }
+  }
+}
+
+TEST(Common, StorageVersions) {
+  using namespace dariadb::storage;
+  const std::string storage_path = "testStorage";
+  if (dariadb::utils::fs::path_exists(storage_path)) {
+    dariadb::utils::fs::rm(storage_path);
+  }
+  dariadb::utils::fs::mkdir(storage_path);
+  auto fname = dariadb::utils::fs::append_path(storage_path, "1.wal");
+  std::ofstream(fname) << "data";
+
+  VersionManager versions;
+  auto pinned = versions.pin();
+  EXPECT_TRUE(versions.isCurrent(pinned));
+
+  versions.publish([&versions, &fname]() {
+    // nested publish is a part of the outer one.
+    versions.publish([&versions, &fname]() { versions.removeLater(fname); });
+  });
+  EXPECT_EQ(versions.current(), pinned->number() + 1);
+  EXPECT_FALSE(versions.isCurrent(pinned));
+
+  auto second = versions.pin();
+  versions.publish([]() {});
+  // file is visible to the first version.
+  EXPECT_TRUE(dariadb::utils::fs::file_exists(fname));
+  second = nullptr;
+  EXPECT_TRUE(dariadb::utils::fs::file_exists(fname));
+  pinned = nullptr;
+  EXPECT_FALSE(dariadb::utils::fs::file_exists(fname));
+
+  size_t attempts = 0;
+  auto readed = versions.read([&versions, &attempts]() {
+    if (attempts++ == 0) {
+      versions.publish([]() {});
+    }
+    return attempts;
+  });
+  EXPECT_EQ(readed, size_t(2));
+
+  // too many publishes: last attempt is done under the lock.
+  attempts = 0;
+  readed = versions.read([&versions, &attempts]() {
+    if (attempts++ < VersionManager::READ_RETRIES) {
+      versions.publish([]() {});
+    }
+    return attempts;
+  });
+  EXPECT_EQ(readed, VersionManager::READ_RETRIES + 1);
+
+  bool in_publish = false;
+  bool after_called = false;
+  versions.publish([&]() {
+    in_publish = true;
+    versions.afterPublish([&]() { after_called = !in_publish; });
+    EXPECT_FALSE(after_called);
+    in_publish = false;
+  });
+  EXPECT_TRUE(after_called);
+
+  // pin() waits for the end of publish.
+  std::atomic_bool started{false};
+  auto before = versions.current();
+  std::thread publisher([&versions, &started]() {
+    versions.publish([&started]() {
+      started.store(true);
+      std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    });
+  });
+  while (!started.load()) {
+    std::this_thread::yield();
+  }
+  EXPECT_EQ(versions.pin()->number(), before + 1);
+  publisher.join();
+
+  dariadb::utils::fs::rm(storage_path);
+}
+
+TEST(Common, SubscribeNotificator) {
+  using namespace dariadb::storage;
+  struct SlowCallback : public dariadb::IReadCallback {
+    void apply(const dariadb::Meas &) override {}
+    void apply_batch(const dariadb::MeasArray &ma) override {
+      // first two batches wait for the test.
+      auto number = calls.load();
+      calls++;
+      while (number < 2 && released.load() <= number) {
+        std::this_thread::yield();
+      }
+      count += ma.size();
+      last = ma.back().time;
+    }
+    std::atomic_size_t calls{0};
+    std::atomic_size_t released{0};
+    std::atomic_size_t count{0};
+    dariadb::Time last = 0;
+  };
+
+  auto clbk = std::make_shared<SlowCallback>();
+  SubscribeNotificator notify;
+  notify.start();
+  notify.add(std::make_shared<SubscribeInfo>(dariadb::IdArray{1}, 0, clbk));
+
+  const size_t queue_size = SubscribeNotificator::SUBSCRIBER_QUEUE_SIZE;
+  const size_t batch_size = SubscribeNotificator::DELIVERY_BATCH_SIZE;
+  auto m = dariadb::Meas();
+  m.id = 1;
+  notify.on_append(m);
+  while (clbk->calls.load() != 1) {
+    std::this_thread::yield();
+  }
+
+  // not subscribed id is not delivered.
+  m.id = 2;
+  notify.on_append(m);
+
+  // ingress queue is full, so the newest values are dropped.
+  m.id = 1;
+  for (size_t i = 0; i < queue_size + 10; ++i) {
+    m.time = i + 1;
+    notify.on_append(m);
+  }
+  clbk->released = 1;
+  while (clbk->calls.load() != 2) {
+    std::this_thread::yield();
+  }
+
+  // subscriber queue is full, so the oldest values are dropped.
+  for (size_t i = 0; i < queue_size; ++i) {
+    m.time = queue_size * 2 + i;
+    notify.on_append(m);
+  }
+  clbk->released = 2;
+  notify.flush();
+
+  EXPECT_EQ(clbk->count.load(), 1 + batch_size + queue_size);
+  EXPECT_EQ(clbk->last, dariadb::Time(queue_size * 3 - 1));
+  notify.stop();
+}
@@ -285,4 +285,69 @@ TEST(Time, TargetInterval) {
     EXPECT_EQ(result_dt.second, 0);
     EXPECT_EQ(result_dt.millisecond, 0);
   }
-}
\ No newline at end of file
+}
+TEST(Time, CivilCalendar) {
+  using namespace dariadb::timeutil;
+  EXPECT_EQ(days_from_civil(1970, 1, 1), int64_t(0));
+  EXPECT_EQ(days_from_civil(2016, 12, 31) - days_from_civil(2016, 1, 1), int64_t(365));
+  EXPECT_EQ(days_from_civil(2100, 3, 1) - days_from_civil(2100, 2, 28), int64_t(1));
+
+  // round trip of each day from 1970 to 2200.
+  auto last = days_from_civil(2200, 1, 1);
+  for (int64_t d = 0; d < last; ++d) {
+    auto civil = civil_from_days(d);
+    ASSERT_EQ(days_from_civil(civil.year, civil.month, civil.day), d);
+  }
+
+  DateTime dt = to_datetime(from_datetime({2016, 12, 31, 0, 23, 59, 58, 7}));
+  EXPECT_EQ(dt.year, 2016);
+  EXPECT_EQ(dt.month, 12);
+  EXPECT_EQ(dt.day, 31);
+  EXPECT_EQ(dt.day_of_year, 366);
+  EXPECT_EQ(dt.hour, 23);
+  EXPECT_EQ(dt.minute, 59);
+  EXPECT_EQ(dt.second, 58);
+  EXPECT_EQ(dt.millisecond, 7);
+}
+
+TEST(Time, Bucketize) {
+  using namespace dariadb::timeutil;
+  const dariadb::Time day = from_days(1);
+  // 2017-02-27 is monday, 2017 is not a leap year.
+  const dariadb::Time t = from_datetime({2017, 3, 1, 0, 12, 45, 3, 4});
+
+  auto week = target_interval(PERIOD::WEEK, t);
+  EXPECT_EQ(to_datetime(week.first).day, 27);
+  EXPECT_EQ(week.second - week.first + 1, day * 7);
+  auto sunday = to_datetime(week.second);
+  EXPECT_EQ(sunday.day, 5);
+  EXPECT_EQ(sunday.hour, 23);
+  EXPECT_EQ(sunday.millisecond, 999);
+
+  auto february = target_interval(PERIOD::MONTH, t - day);
+  EXPECT_EQ(february.second - february.first + 1, day * 28);
+  auto year = target_interval(PERIOD::YEAR, t);
+  EXPECT_EQ(year.second - year.first + 1, day * 365);
+  EXPECT_EQ(target_interval(PERIOD::UNKNOWN, t).first, dariadb::MAX_TIME);
+
+  // each interval contains time and next one starts after its end.
+  std::vector<dariadb::Time> times;
+  for (dariadb::Time i = 0; i < 5000; ++i) {
+    times.push_back(t + i * i * 997);
+  }
+  for (auto p : predefinedIntervals()) {
+    auto period = period_from_string(p);
+    EXPECT_NE(period, PERIOD::UNKNOWN);
+    std::vector<std::pair<dariadb::Time, dariadb::Time>> expected;
+    for (auto v : times) {
+      auto i = target_interval(period, v);
+      EXPECT_TRUE(i.first <= v && v <= i.second);
+      EXPECT_EQ(target_interval(period, i.second + 1).first, i.second + 1);
+      EXPECT_EQ(target_interval(p, v), i);
+      if (expected.empty() || expected.back() != i) {
+        expected.push_back(i);
+      }
+    }
+    EXPECT_EQ(bucketize(period, times.data(), times.size()), expected) << p;
+  }
+}
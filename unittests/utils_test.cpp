@@ -5,6 +5,7 @@
 #include <libdariadb/utils/cz.h>
 #include <libdariadb/utils/fs.h>
 #include <libdariadb/utils/in_interval.h>
+#include <libdariadb/utils/metrics.h>
 #include <libdariadb/utils/strings.h>
 #include <libdariadb/utils/utils.h>
 
@@ -201,3 +202,67 @@ TEST(Utils, ThreadsManager) {
     ThreadManager::instance()->stop();
   }
 }
+
+TEST(Utils, Metrics) {
+  using namespace dariadb::utils::metrics;
+  using dariadb::utils::metrics::Histogram;
+
+  // bucket bounds: exact below SUB_BUCKETS, relative error below 1/SUB_BUCKETS.
+  for (uint64_t v = 0; v < 100000; v += (v / 64) + 1) {
+    auto b = Histogram::bucket_of(v);
+    EXPECT_LT(b, Histogram::BUCKETS);
+    EXPECT_GE(Histogram::bucket_upper(b), v);
+    if (v < Histogram::SUB_BUCKETS) {
+      EXPECT_EQ(Histogram::bucket_upper(b), v);
+    } else {
+      EXPECT_LT(Histogram::bucket_upper(b) - v, v / Histogram::SUB_BUCKETS + 1);
+    }
+    if (b > 0) {
+      EXPECT_LT(Histogram::bucket_upper(b - 1), v);
+    }
+  }
+  EXPECT_EQ(Histogram::bucket_of(std::numeric_limits<uint64_t>::max()),
+            Histogram::BUCKETS - 1);
+
+  auto was_enabled = enabled();
+  auto registry = Registry::instance();
+  auto counter = registry->counter("test.counter");
+  auto histogram = registry->histogram("test.histogram");
+  EXPECT_EQ(registry->counter("test.counter"), counter);
+
+  enable(false);
+  counter->add(10);
+  histogram->record(10);
+  EXPECT_EQ(counter->value(), uint64_t(0));
+  EXPECT_EQ(histogram->snapshot().count, uint64_t(0));
+
+  enable(true);
+  const size_t threads_count = 4;
+  const uint64_t values = 1000;
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < threads_count; ++i) {
+    threads.emplace_back([counter, histogram, values]() {
+      for (uint64_t v = 1; v <= values; ++v) {
+        counter->add();
+        histogram->record(v);
+      }
+    });
+  }
+  for (auto &t : threads) {
+    t.join();
+  }
+  enable(was_enabled);
+
+  EXPECT_EQ(counter->value(), threads_count * values);
+  auto snapshot = registry->snapshot();
+  EXPECT_EQ(snapshot.counters["test.counter"], threads_count * values);
+  auto h = snapshot.histograms["test.histogram"];
+  EXPECT_EQ(h.count, threads_count * values);
+  EXPECT_EQ(h.sum, threads_count * values * (values + 1) / 2);
+  EXPECT_EQ(h.min, uint64_t(1));
+  EXPECT_EQ(h.max, values);
+  auto p50 = h.percentile(0.5);
+  EXPECT_GE(p50, values / 2);
+  EXPECT_LE(p50, values / 2 + values / 2 / Histogram::SUB_BUCKETS);
+  EXPECT_EQ(h.percentile(1.0), values);
+}